@@ -19,6 +19,8 @@
 #include "ConditionalOperator.h"
 #include "RefFunction.h"
 #include "DefaultCommands.h"
+#include "NativeOperatorCommands.hpp"
+#include "ScriptCompiler.h"
 
 #include "BasicOperators.hpp"
 
@@ -111,178 +113,197 @@ namespace ffscript {
 		return pArray;
 	}
 
+	// register an operator and the specialized command that runs it directly on the context memory
+	template <class Rt, class T, Rt(*f)(T)>
+	int registNativeOperator(FunctionRegisterHelper& fb, const char* name, const char* functionParams, const char* returnType) {
+		int functionId = fb.registPredefinedOperators(name, functionParams, returnType, createFunctionDelegate<Rt, T>(f));
+		if (functionId >= 0) {
+			fb.getSriptCompiler()->registNativeCommand(functionId, std::make_shared<DefaultNativeCommandFactory<UnaryOperatorCommand<Rt, T, f>>>());
+		}
+		return functionId;
+	}
+
+	template <class Rt, class T1, class T2, Rt(*f)(T1, T2)>
+	int registNativeOperator(FunctionRegisterHelper& fb, const char* name, const char* functionParams, const char* returnType) {
+		int functionId = fb.registPredefinedOperators(name, functionParams, returnType, createFunctionDelegate<Rt, T1, T2>(f));
+		if (functionId >= 0) {
+			fb.getSriptCompiler()->registNativeCommand(functionId, std::make_shared<DefaultNativeCommandFactory<BinaryOperatorCommand<Rt, T1, T2, f>>>());
+		}
+		return functionId;
+	}
+
 	void importBasicfunction(FunctionRegisterHelper& fb) {
 
 #pragma region integer operators only
-		fb.registPredefinedOperators("+", "int,int", "int", createFunctionDelegate<int, int, int>(add));
-		fb.registPredefinedOperators("-", "int,int", "int", createFunctionDelegate<int, int, int>(sub));
-		fb.registPredefinedOperators("*", "int,int", "int", createFunctionDelegate<int, int, int>(mul));
-		fb.registPredefinedOperators("/", "int,int", "int", createFunctionDelegate<int, int, int>(div));
-		fb.registPredefinedOperators("%", "int,int", "int", createFunctionDelegate<int, int, int>(mod));
+		registNativeOperator<int, int, int, add>(fb, "+", "int,int", "int");
+		registNativeOperator<int, int, int, sub>(fb, "-", "int,int", "int");
+		registNativeOperator<int, int, int, mul>(fb, "*", "int,int", "int");
+		registNativeOperator<int, int, int, div>(fb, "/", "int,int", "int");
+		registNativeOperator<int, int, int, mod>(fb, "%", "int,int", "int");
 		//negative operator
 		
 		//assigment operator
-		fb.registPredefinedOperators("=", "int&,int", "int", createFunctionDelegate(assign<int, int, int>));
+		registNativeOperator<int, int&, int, assign<int, int, int>>(fb, "=", "int&,int", "int");
 		//bitwises
-		fb.registPredefinedOperators("&", "int,int", "int", createFunctionDelegate<int, int, int>(bitwise_and));
-		fb.registPredefinedOperators("|", "int,int", "int", createFunctionDelegate<int, int, int>(bitwise_or));
-		fb.registPredefinedOperators("^", "int,int", "int", createFunctionDelegate<int, int, int>(bitwise_xor));
-		fb.registPredefinedOperators("<<", "int,int", "int", createFunctionDelegate<int, int, int>(bitwise_shiftLeft));
-		fb.registPredefinedOperators(">>", "int,int", "int", createFunctionDelegate<int, int, int>(bitwise_shiftRight));
+		registNativeOperator<int, int, int, bitwise_and>(fb, "&", "int,int", "int");
+		registNativeOperator<int, int, int, bitwise_or>(fb, "|", "int,int", "int");
+		registNativeOperator<int, int, int, bitwise_xor>(fb, "^", "int,int", "int");
+		registNativeOperator<int, int, int, bitwise_shiftLeft>(fb, "<<", "int,int", "int");
+		registNativeOperator<int, int, int, bitwise_shiftRight>(fb, ">>", "int,int", "int");
 		//pre-post fix operators
-		fb.registPredefinedOperators("neg", "int", "int", createFunctionDelegate<int, int>(neg));
-		fb.registPredefinedOperators("~", "int", "int", createFunctionDelegate<int, int>(bitwise_not));
-		fb.registPredefinedOperators("post_fix_increase", "int&", "int", createFunctionDelegate<int, int&>(post_inc));
-		fb.registPredefinedOperators("++", "int&", "int", createFunctionDelegate<int, int&>(pre_inc));
-		fb.registPredefinedOperators("post_fix_decrease", "int&", "int", createFunctionDelegate<int, int&>(post_dec));
-		fb.registPredefinedOperators("--", "int&", "int", createFunctionDelegate<int, int&>(pre_dec));
+		registNativeOperator<int, int, neg>(fb, "neg", "int", "int");
+		registNativeOperator<int, int, bitwise_not>(fb, "~", "int", "int");
+		registNativeOperator<int, int&, post_inc>(fb, "post_fix_increase", "int&", "int");
+		registNativeOperator<int, int&, pre_inc>(fb, "++", "int&", "int");
+		registNativeOperator<int, int&, post_dec>(fb, "post_fix_decrease", "int&", "int");
+		registNativeOperator<int, int&, pre_dec>(fb, "--", "int&", "int");
 		//compound operators
-		fb.registPredefinedOperators("+=", "int&,int", "void", createFunctionDelegate<void, int&, int>(add_comp));
-		fb.registPredefinedOperators("-=", "int&,int", "void", createFunctionDelegate<void, int&, int>(sub_comp));
-		fb.registPredefinedOperators("*=", "int&,int", "void", createFunctionDelegate<void, int&, int>(mul_comp));
-		fb.registPredefinedOperators("/=", "int&,int", "void", createFunctionDelegate<void, int&, int>(div_comp));
-		fb.registPredefinedOperators("%=", "int&,int", "void", createFunctionDelegate<void, int&, int>(mod_comp));
-		fb.registPredefinedOperators("&=", "int&,int", "void", createFunctionDelegate<void, int&, int>(and_comp));
-		fb.registPredefinedOperators("|=", "int&,int", "void", createFunctionDelegate<void, int&, int>(or_comp));
-		fb.registPredefinedOperators("^=", "int&,int", "void", createFunctionDelegate<void, int&, int>(xor_comp));
-		fb.registPredefinedOperators("<<=", "int&,int", "void", createFunctionDelegate<void, int&, int>(shiftLeft_comp));
-		fb.registPredefinedOperators(">>=", "int&,int", "void", createFunctionDelegate<void, int&, int>(shiftRight_comp));
+		registNativeOperator<void, int&, int, add_comp>(fb, "+=", "int&,int", "void");
+		registNativeOperator<void, int&, int, sub_comp>(fb, "-=", "int&,int", "void");
+		registNativeOperator<void, int&, int, mul_comp>(fb, "*=", "int&,int", "void");
+		registNativeOperator<void, int&, int, div_comp>(fb, "/=", "int&,int", "void");
+		registNativeOperator<void, int&, int, mod_comp>(fb, "%=", "int&,int", "void");
+		registNativeOperator<void, int&, int, and_comp>(fb, "&=", "int&,int", "void");
+		registNativeOperator<void, int&, int, or_comp>(fb, "|=", "int&,int", "void");
+		registNativeOperator<void, int&, int, xor_comp>(fb, "^=", "int&,int", "void");
+		registNativeOperator<void, int&, int, shiftLeft_comp>(fb, "<<=", "int&,int", "void");
+		registNativeOperator<void, int&, int, shiftRight_comp>(fb, ">>=", "int&,int", "void");
 		//comparision operators
-		fb.registPredefinedOperators("<", "int,int", "bool", createFunctionDelegate<bool, int, int>(operators::less));
-		fb.registPredefinedOperators("<=", "int,int", "bool", createFunctionDelegate<bool, int, int>(operators::less_or_equal));
-		fb.registPredefinedOperators(">", "int,int", "bool", createFunctionDelegate<bool, int, int>(operators::great));
-		fb.registPredefinedOperators(">=", "int,int", "bool", createFunctionDelegate<bool, int, int>(operators::great_or_equal));
-		fb.registPredefinedOperators("==", "int,int", "bool", createFunctionDelegate<bool, int, int>(operators::equal));
-		fb.registPredefinedOperators("!=", "int,int", "bool", createFunctionDelegate<bool, int, int>(operators::not_equal));
+		registNativeOperator<bool, int, int, operators::less>(fb, "<", "int,int", "bool");
+		registNativeOperator<bool, int, int, operators::less_or_equal>(fb, "<=", "int,int", "bool");
+		registNativeOperator<bool, int, int, operators::great>(fb, ">", "int,int", "bool");
+		registNativeOperator<bool, int, int, operators::great_or_equal>(fb, ">=", "int,int", "bool");
+		registNativeOperator<bool, int, int, operators::equal>(fb, "==", "int,int", "bool");
+		registNativeOperator<bool, int, int, operators::not_equal>(fb, "!=", "int,int", "bool");
 		//logic operators
-		fb.registPredefinedOperators("&&", "int,int", "bool", createFunctionDelegate<bool, int, int>(logic_and));
-		fb.registPredefinedOperators("||", "int,int", "bool", createFunctionDelegate<bool, int, int>(logic_or));
-		fb.registPredefinedOperators("!", "int", "bool", createFunctionDelegate<bool, int>(logic_not));
+		registNativeOperator<bool, int, int, logic_and>(fb, "&&", "int,int", "bool");
+		registNativeOperator<bool, int, int, logic_or>(fb, "||", "int,int", "bool");
+		registNativeOperator<bool, int, logic_not>(fb, "!", "int", "bool");
 #pragma endregion
 
 #pragma region long operators only
-		fb.registPredefinedOperators("+", "long,long", "long", createFunctionDelegate<long long, long long, long long>(add));
-		fb.registPredefinedOperators("-", "long,long", "long", createFunctionDelegate<long long, long long, long long>(sub));
-		fb.registPredefinedOperators("*", "long,long", "long", createFunctionDelegate<long long, long long, long long>(mul));
-		fb.registPredefinedOperators("/", "long,long", "long", createFunctionDelegate<long long, long long, long long>(div));
-		fb.registPredefinedOperators("%", "long,long", "long", createFunctionDelegate<long long, long long, long long>(mod));
+		registNativeOperator<long long, long long, long long, add>(fb, "+", "long,long", "long");
+		registNativeOperator<long long, long long, long long, sub>(fb, "-", "long,long", "long");
+		registNativeOperator<long long, long long, long long, mul>(fb, "*", "long,long", "long");
+		registNativeOperator<long long, long long, long long, div>(fb, "/", "long,long", "long");
+		registNativeOperator<long long, long long, long long, mod>(fb, "%", "long,long", "long");
 		//negative operator
 
 		//assigment operator
-		fb.registPredefinedOperators("=", "long&,long", "long", createFunctionDelegate(assign<long long, long long, long long>));
+		registNativeOperator<long long, long long&, long long, assign<long long, long long, long long>>(fb, "=", "long&,long", "long");
 		//bitwises
-		fb.registPredefinedOperators("&", "long,long", "long", createFunctionDelegate<long long, long long, long long>(bitwise_and));
-		fb.registPredefinedOperators("|", "long,long", "long", createFunctionDelegate<long long, long long, long long>(bitwise_or));
-		fb.registPredefinedOperators("^", "long,long", "long", createFunctionDelegate<long long, long long, long long>(bitwise_xor));
-		fb.registPredefinedOperators("<<", "long,long", "long", createFunctionDelegate<long long, long long, long long>(bitwise_shiftLeft));
-		fb.registPredefinedOperators(">>", "long,long", "long", createFunctionDelegate<long long, long long, long long>(bitwise_shiftRight));
+		registNativeOperator<long long, long long, long long, bitwise_and>(fb, "&", "long,long", "long");
+		registNativeOperator<long long, long long, long long, bitwise_or>(fb, "|", "long,long", "long");
+		registNativeOperator<long long, long long, long long, bitwise_xor>(fb, "^", "long,long", "long");
+		registNativeOperator<long long, long long, long long, bitwise_shiftLeft>(fb, "<<", "long,long", "long");
+		registNativeOperator<long long, long long, long long, bitwise_shiftRight>(fb, ">>", "long,long", "long");
 		//pre-post fix operators
-		fb.registPredefinedOperators("neg",					"long", "long", createFunctionDelegate<long long, long long>(neg));
-		fb.registPredefinedOperators("~",					"long", "long", createFunctionDelegate<long long, long long>(bitwise_not));
-		fb.registPredefinedOperators("post_fix_increase", "long&", "long", createFunctionDelegate<long long, long long&>(post_inc));
-		fb.registPredefinedOperators("++", "long&", "long", createFunctionDelegate<long long, long long&>(pre_inc));
-		fb.registPredefinedOperators("post_fix_decrease", "long&", "long", createFunctionDelegate<long long, long long&>(post_dec));
-		fb.registPredefinedOperators("--", "long&", "long", createFunctionDelegate<long long, long long&>(pre_dec));
+		registNativeOperator<long long, long long, neg>(fb, "neg", "long", "long");
+		registNativeOperator<long long, long long, bitwise_not>(fb, "~", "long", "long");
+		registNativeOperator<long long, long long&, post_inc>(fb, "post_fix_increase", "long&", "long");
+		registNativeOperator<long long, long long&, pre_inc>(fb, "++", "long&", "long");
+		registNativeOperator<long long, long long&, post_dec>(fb, "post_fix_decrease", "long&", "long");
+		registNativeOperator<long long, long long&, pre_dec>(fb, "--", "long&", "long");
 		//compound operators
-		fb.registPredefinedOperators("+=", "long&,long", "void", createFunctionDelegate<void, long long&, long long>(add_comp));
-		fb.registPredefinedOperators("-=", "long&,long", "void", createFunctionDelegate<void, long long&, long long>(sub_comp));
-		fb.registPredefinedOperators("*=", "long&,long", "void", createFunctionDelegate<void, long long&, long long>(mul_comp));
-		fb.registPredefinedOperators("/=", "long&,long", "void", createFunctionDelegate<void, long long&, long long>(div_comp));
-		fb.registPredefinedOperators("%=", "long&,long", "void", createFunctionDelegate<void, long long&, long long>(mod_comp));
-		fb.registPredefinedOperators("&=", "long&,long", "void", createFunctionDelegate<void, long long&, long long>(and_comp));
-		fb.registPredefinedOperators("|=", "long&,long", "void", createFunctionDelegate<void, long long&, long long>(or_comp));
-		fb.registPredefinedOperators("^=", "long&,long", "void", createFunctionDelegate<void, long long&, long long>(xor_comp));
-		fb.registPredefinedOperators("<<=", "long&,long", "void", createFunctionDelegate<void, long long&, long long>(shiftLeft_comp));
-		fb.registPredefinedOperators(">>=", "long&,long", "void", createFunctionDelegate<void, long long&, long long>(shiftRight_comp));
+		registNativeOperator<void, long long&, long long, add_comp>(fb, "+=", "long&,long", "void");
+		registNativeOperator<void, long long&, long long, sub_comp>(fb, "-=", "long&,long", "void");
+		registNativeOperator<void, long long&, long long, mul_comp>(fb, "*=", "long&,long", "void");
+		registNativeOperator<void, long long&, long long, div_comp>(fb, "/=", "long&,long", "void");
+		registNativeOperator<void, long long&, long long, mod_comp>(fb, "%=", "long&,long", "void");
+		registNativeOperator<void, long long&, long long, and_comp>(fb, "&=", "long&,long", "void");
+		registNativeOperator<void, long long&, long long, or_comp>(fb, "|=", "long&,long", "void");
+		registNativeOperator<void, long long&, long long, xor_comp>(fb, "^=", "long&,long", "void");
+		registNativeOperator<void, long long&, long long, shiftLeft_comp>(fb, "<<=", "long&,long", "void");
+		registNativeOperator<void, long long&, long long, shiftRight_comp>(fb, ">>=", "long&,long", "void");
 		//comparision operators
-		fb.registPredefinedOperators("<", "long,long", "bool", createFunctionDelegate<bool, long long, long long>(operators::less));
-		fb.registPredefinedOperators("<=", "long,long", "bool", createFunctionDelegate<bool, long long, long long>(less_or_equal));
-		fb.registPredefinedOperators(">", "long,long", "bool", createFunctionDelegate<bool, long long, long long>(great));
-		fb.registPredefinedOperators(">=", "long,long", "bool", createFunctionDelegate<bool, long long, long long>(great_or_equal));
-		fb.registPredefinedOperators("==", "long,long", "bool", createFunctionDelegate<bool, long long, long long>(equal));
-		fb.registPredefinedOperators("!=", "long,long", "bool", createFunctionDelegate<bool, long long, long long>(not_equal));
+		registNativeOperator<bool, long long, long long, operators::less>(fb, "<", "long,long", "bool");
+		registNativeOperator<bool, long long, long long, less_or_equal>(fb, "<=", "long,long", "bool");
+		registNativeOperator<bool, long long, long long, great>(fb, ">", "long,long", "bool");
+		registNativeOperator<bool, long long, long long, great_or_equal>(fb, ">=", "long,long", "bool");
+		registNativeOperator<bool, long long, long long, equal>(fb, "==", "long,long", "bool");
+		registNativeOperator<bool, long long, long long, not_equal>(fb, "!=", "long,long", "bool");
 		//logic operators
-		fb.registPredefinedOperators("&&", "long,long", "bool", createFunctionDelegate<bool, long long, long long>(logic_and));
-		fb.registPredefinedOperators("||", "long,long", "bool", createFunctionDelegate<bool, long long, long long>(logic_or));
-		fb.registPredefinedOperators("!", "long", "bool", createFunctionDelegate<bool, long long>(logic_not));
+		registNativeOperator<bool, long long, long long, logic_and>(fb, "&&", "long,long", "bool");
+		registNativeOperator<bool, long long, long long, logic_or>(fb, "||", "long,long", "bool");
+		registNativeOperator<bool, long long, logic_not>(fb, "!", "long", "bool");
 #pragma endregion
 
 #pragma region float operators only
-		fb.registPredefinedOperators("+", "float,float", "float", createFunctionDelegate<float, float, float>(add));
-		fb.registPredefinedOperators("-", "float,float", "float", createFunctionDelegate<float, float, float>(sub));
-		fb.registPredefinedOperators("*", "float,float", "float", createFunctionDelegate<float, float, float>(mul));
-		fb.registPredefinedOperators("/", "float,float", "float", createFunctionDelegate<float, float, float>(div));
+		registNativeOperator<float, float, float, add>(fb, "+", "float,float", "float");
+		registNativeOperator<float, float, float, sub>(fb, "-", "float,float", "float");
+		registNativeOperator<float, float, float, mul>(fb, "*", "float,float", "float");
+		registNativeOperator<float, float, float, div>(fb, "/", "float,float", "float");
 
 		//assigment operator
-		fb.registPredefinedOperators("=", "float&,float", "float", createFunctionDelegate(assign<float, float&, float>));
+		registNativeOperator<float, float&, float, assign<float, float&, float>>(fb, "=", "float&,float", "float");
 		//pre-post fix operators
-		fb.registPredefinedOperators("neg", "float", "float", createFunctionDelegate<float, float>(neg));
-		fb.registPredefinedOperators("post_fix_increase", "float&", "float", createFunctionDelegate<float, float&>(post_inc));
-		fb.registPredefinedOperators("++", "float&", "float", createFunctionDelegate<float, float&>(pre_inc));
-		fb.registPredefinedOperators("post_fix_decrease", "float&", "float", createFunctionDelegate<float, float&>(post_dec));
-		fb.registPredefinedOperators("--", "float&", "float", createFunctionDelegate<float, float&>(pre_dec));
+		registNativeOperator<float, float, neg>(fb, "neg", "float", "float");
+		registNativeOperator<float, float&, post_inc>(fb, "post_fix_increase", "float&", "float");
+		registNativeOperator<float, float&, pre_inc>(fb, "++", "float&", "float");
+		registNativeOperator<float, float&, post_dec>(fb, "post_fix_decrease", "float&", "float");
+		registNativeOperator<float, float&, pre_dec>(fb, "--", "float&", "float");
 		//compound operators
-		fb.registPredefinedOperators("+=", "float&, float", "void", createFunctionDelegate<void, float&, float>(add_comp));
-		fb.registPredefinedOperators("-=", "float&, float", "void", createFunctionDelegate<void, float&, float>(sub_comp));
-		fb.registPredefinedOperators("*=", "float&, float", "void", createFunctionDelegate<void, float&, float>(mul_comp));
-		fb.registPredefinedOperators("/=", "float&, float", "void", createFunctionDelegate<void, float&, float>(div_comp));
+		registNativeOperator<void, float&, float, add_comp>(fb, "+=", "float&, float", "void");
+		registNativeOperator<void, float&, float, sub_comp>(fb, "-=", "float&, float", "void");
+		registNativeOperator<void, float&, float, mul_comp>(fb, "*=", "float&, float", "void");
+		registNativeOperator<void, float&, float, div_comp>(fb, "/=", "float&, float", "void");
 
 		//comparision operators
-		fb.registPredefinedOperators("<", "float, float", "bool", createFunctionDelegate<bool, float, float>(operators::less));
-		fb.registPredefinedOperators("<=", "float, float", "bool", createFunctionDelegate<bool, float, float>(less_or_equal));
-		fb.registPredefinedOperators(">", "float, float", "bool", createFunctionDelegate<bool, float, float>(great));
-		fb.registPredefinedOperators(">=", "float, float", "bool", createFunctionDelegate<bool, float, float>(great_or_equal));
-		fb.registPredefinedOperators("==", "float, float", "bool", createFunctionDelegate<bool, float, float>(equal));
-		fb.registPredefinedOperators("!=", "float, float", "bool", createFunctionDelegate<bool, float, float>(not_equal));
+		registNativeOperator<bool, float, float, operators::less>(fb, "<", "float, float", "bool");
+		registNativeOperator<bool, float, float, less_or_equal>(fb, "<=", "float, float", "bool");
+		registNativeOperator<bool, float, float, great>(fb, ">", "float, float", "bool");
+		registNativeOperator<bool, float, float, great_or_equal>(fb, ">=", "float, float", "bool");
+		registNativeOperator<bool, float, float, equal>(fb, "==", "float, float", "bool");
+		registNativeOperator<bool, float, float, not_equal>(fb, "!=", "float, float", "bool");
 		//logic operators
-		fb.registPredefinedOperators("&&", "float, float", "bool", createFunctionDelegate<bool, float, float>(logic_and));
-		fb.registPredefinedOperators("||", "float, float", "bool", createFunctionDelegate<bool, float, float>(logic_or));
-		fb.registPredefinedOperators("!", "float", "bool", createFunctionDelegate<bool, float>(logic_not));
+		registNativeOperator<bool, float, float, logic_and>(fb, "&&", "float, float", "bool");
+		registNativeOperator<bool, float, float, logic_or>(fb, "||", "float, float", "bool");
+		registNativeOperator<bool, float, logic_not>(fb, "!", "float", "bool");
 #pragma endregion
 
 #pragma region double operators only
-		fb.registPredefinedOperators("+", "double,double", "double", createFunctionDelegate<double, double, double>(add));
-		fb.registPredefinedOperators("-", "double,double", "double", createFunctionDelegate<double, double, double>(sub));
-		fb.registPredefinedOperators("*", "double,double", "double", createFunctionDelegate<double, double, double>(mul));
-		fb.registPredefinedOperators("/", "double,double", "double", createFunctionDelegate<double, double, double>(div));
+		registNativeOperator<double, double, double, add>(fb, "+", "double,double", "double");
+		registNativeOperator<double, double, double, sub>(fb, "-", "double,double", "double");
+		registNativeOperator<double, double, double, mul>(fb, "*", "double,double", "double");
+		registNativeOperator<double, double, double, div>(fb, "/", "double,double", "double");
 
 		//assigment operator
-		fb.registPredefinedOperators("=", "double&,double", "double", createFunctionDelegate(assign<double, double, double>));
+		registNativeOperator<double, double&, double, assign<double, double, double>>(fb, "=", "double&,double", "double");
 		//pre-post fix operators
-		fb.registPredefinedOperators("neg", "double", "double", createFunctionDelegate<double, double>(neg));
-		fb.registPredefinedOperators("post_fix_increase", "double&", "double", createFunctionDelegate<double, double&>(post_inc));
-		fb.registPredefinedOperators("++", "double&", "double", createFunctionDelegate<double, double&>(pre_inc));
-		fb.registPredefinedOperators("post_fix_decrease", "double&", "double", createFunctionDelegate<double, double&>(post_dec));
-		fb.registPredefinedOperators("--", "double&", "double", createFunctionDelegate<double, double&>(pre_dec));
+		registNativeOperator<double, double, neg>(fb, "neg", "double", "double");
+		registNativeOperator<double, double&, post_inc>(fb, "post_fix_increase", "double&", "double");
+		registNativeOperator<double, double&, pre_inc>(fb, "++", "double&", "double");
+		registNativeOperator<double, double&, post_dec>(fb, "post_fix_decrease", "double&", "double");
+		registNativeOperator<double, double&, pre_dec>(fb, "--", "double&", "double");
 		//compound operators
-		fb.registPredefinedOperators("+=", "double&,double", "void", createFunctionDelegate<void, double&, double>(add_comp));
-		fb.registPredefinedOperators("-=", "double&,double", "void", createFunctionDelegate<void, double&, double>(sub_comp));
-		fb.registPredefinedOperators("*=", "double&,double", "void", createFunctionDelegate<void, double&, double>(mul_comp));
-		fb.registPredefinedOperators("/=", "double&,double", "void", createFunctionDelegate<void, double&, double>(div_comp));
+		registNativeOperator<void, double&, double, add_comp>(fb, "+=", "double&,double", "void");
+		registNativeOperator<void, double&, double, sub_comp>(fb, "-=", "double&,double", "void");
+		registNativeOperator<void, double&, double, mul_comp>(fb, "*=", "double&,double", "void");
+		registNativeOperator<void, double&, double, div_comp>(fb, "/=", "double&,double", "void");
 
 		//comparision operators
-		fb.registPredefinedOperators("<", "double,double", "bool", createFunctionDelegate<bool, double, double>(operators::less));
-		fb.registPredefinedOperators("<=", "double,double", "bool", createFunctionDelegate<bool, double, double>(less_or_equal));
-		fb.registPredefinedOperators(">", "double,double", "bool", createFunctionDelegate<bool, double, double>(great));
-		fb.registPredefinedOperators(">=", "double,double", "bool", createFunctionDelegate<bool, double, double>(great_or_equal));
-		fb.registPredefinedOperators("==", "double,double", "bool", createFunctionDelegate<bool, double, double>(equal));
-		fb.registPredefinedOperators("!=", "double,double", "bool", createFunctionDelegate<bool, double, double>(not_equal));
+		registNativeOperator<bool, double, double, operators::less>(fb, "<", "double,double", "bool");
+		registNativeOperator<bool, double, double, less_or_equal>(fb, "<=", "double,double", "bool");
+		registNativeOperator<bool, double, double, great>(fb, ">", "double,double", "bool");
+		registNativeOperator<bool, double, double, great_or_equal>(fb, ">=", "double,double", "bool");
+		registNativeOperator<bool, double, double, equal>(fb, "==", "double,double", "bool");
+		registNativeOperator<bool, double, double, not_equal>(fb, "!=", "double,double", "bool");
 		//logic operators
-		fb.registPredefinedOperators("&&", "double,double", "bool", createFunctionDelegate<bool, double, double>(logic_and));
-		fb.registPredefinedOperators("||", "double,double", "bool", createFunctionDelegate<bool, double, double>(logic_or));
-		fb.registPredefinedOperators("!", "double", "bool", createFunctionDelegate<bool, double>(logic_not));
+		registNativeOperator<bool, double, double, logic_and>(fb, "&&", "double,double", "bool");
+		registNativeOperator<bool, double, double, logic_or>(fb, "||", "double,double", "bool");
+		registNativeOperator<bool, double, logic_not>(fb, "!", "double", "bool");
 #pragma endregion
 
 #pragma region bool operators only
 		//assigment operator
-		fb.registPredefinedOperators("=", "bool&,bool", "bool", createFunctionDelegate(assign<bool, bool, bool>));
+		registNativeOperator<bool, bool&, bool, assign<bool, bool, bool>>(fb, "=", "bool&,bool", "bool");
 		//comparision operators
-		fb.registPredefinedOperators("==", "bool,bool", "bool", createFunctionDelegate<bool, bool, bool>(operators::equal));
-		fb.registPredefinedOperators("!=", "bool,bool", "bool", createFunctionDelegate<bool, bool, bool>(operators::not_equal));
+		registNativeOperator<bool, bool, bool, operators::equal>(fb, "==", "bool,bool", "bool");
+		registNativeOperator<bool, bool, bool, operators::not_equal>(fb, "!=", "bool,bool", "bool");
 		//logic operators
-		fb.registPredefinedOperators("&&", "bool,bool", "bool", createFunctionDelegate<bool, bool, bool>(logic_and));
-		fb.registPredefinedOperators("||", "bool,bool", "bool", createFunctionDelegate<bool, bool, bool>(logic_or));
-		fb.registPredefinedOperators("!", "bool", "bool", createFunctionDelegate<bool, bool>(logic_not));
+		registNativeOperator<bool, bool, bool, logic_and>(fb, "&&", "bool,bool", "bool");
+		registNativeOperator<bool, bool, bool, logic_or>(fb, "||", "bool,bool", "bool");
+		registNativeOperator<bool, bool, logic_not>(fb, "!", "bool", "bool");
 #pragma endregion
 
 #pragma region integer and long operators
@@ -0,0 +1,107 @@
+/******************************************************************
+* File:        ClosureAllocator.cpp
+* Description: implement ClosureAllocator class. A class that allocates
+*              captured data blocks of lambda functions. Small blocks
+*              are recycled through free lists of the running thread,
+*              so creating lambdas in loops does not hit the global
+*              heap every time.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "ClosureAllocator.h"
+#include <stdlib.h>
+
+// size of the smallest block class, each next class doubles the size
+#define CLOSURE_MIN_BLOCK_SIZE 16
+#define CLOSURE_SIZE_CLASS_COUNT 5
+// blocks larger than this size are allocated directly in the heap
+#define CLOSURE_MAX_BLOCK_SIZE (CLOSURE_MIN_BLOCK_SIZE << (CLOSURE_SIZE_CLASS_COUNT - 1))
+// maximum number of free blocks kept for each size class in a thread
+#define CLOSURE_MAX_FREE_BLOCKS 64
+
+namespace ffscript {
+
+	struct FreeClosureBlock {
+		FreeClosureBlock* next;
+	};
+
+	// free lists are owned by each thread, so no lock is needed.
+	// a block released by a thread that did not allocate it is
+	// just moved to free lists of the releasing thread
+	struct ClosureFreeLists {
+		FreeClosureBlock* heads[CLOSURE_SIZE_CLASS_COUNT];
+		int counts[CLOSURE_SIZE_CLASS_COUNT];
+
+		ClosureFreeLists() {
+			for (int i = 0; i < CLOSURE_SIZE_CLASS_COUNT; i++) {
+				heads[i] = nullptr;
+				counts[i] = 0;
+			}
+		}
+
+		~ClosureFreeLists() {
+			for (int i = 0; i < CLOSURE_SIZE_CLASS_COUNT; i++) {
+				FreeClosureBlock* block = heads[i];
+				while (block) {
+					FreeClosureBlock* next = block->next;
+					free(block);
+					block = next;
+				}
+			}
+		}
+	};
+
+	static thread_local ClosureFreeLists s_freeLists;
+
+	static int getSizeClass(unsigned int size) {
+		int sizeClass = 0;
+		unsigned int blockSize = CLOSURE_MIN_BLOCK_SIZE;
+		while (blockSize < size) {
+			blockSize <<= 1;
+			sizeClass++;
+		}
+		return sizeClass;
+	}
+
+	void* ClosureAllocator::allocate(unsigned int size) {
+		if (size > CLOSURE_MAX_BLOCK_SIZE) {
+			return malloc(size);
+		}
+
+		int sizeClass = getSizeClass(size);
+		FreeClosureBlock*& head = s_freeLists.heads[sizeClass];
+		if (head) {
+			FreeClosureBlock* block = head;
+			head = block->next;
+			s_freeLists.counts[sizeClass]--;
+			return block;
+		}
+		// allocate full size of the class, so the block can be reused by any size in the class
+		return malloc(CLOSURE_MIN_BLOCK_SIZE << sizeClass);
+	}
+
+	void ClosureAllocator::deallocate(void* data, unsigned int size) {
+		if (data == nullptr) {
+			return;
+		}
+		if (size > CLOSURE_MAX_BLOCK_SIZE) {
+			free(data);
+			return;
+		}
+
+		int sizeClass = getSizeClass(size);
+		if (s_freeLists.counts[sizeClass] >= CLOSURE_MAX_FREE_BLOCKS) {
+			free(data);
+			return;
+		}
+		FreeClosureBlock* block = (FreeClosureBlock*)data;
+		block->next = s_freeLists.heads[sizeClass];
+		s_freeLists.heads[sizeClass] = block;
+		s_freeLists.counts[sizeClass]++;
+	}
+}
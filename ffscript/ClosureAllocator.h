@@ -0,0 +1,28 @@
+/******************************************************************
+* File:        ClosureAllocator.h
+* Description: declare ClosureAllocator class. A class that allocates
+*              captured data blocks of lambda functions. Small blocks
+*              are recycled through free lists of the running thread,
+*              so creating lambdas in loops does not hit the global
+*              heap every time.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "ffscript.h"
+
+namespace ffscript {
+	class ClosureAllocator
+	{
+	public:
+		// allocate a data block for lambda's captured data
+		static void* allocate(unsigned int size);
+		// release a data block, the size must be the size used to allocate the block
+		static void deallocate(void* data, unsigned int size);
+	};
+}
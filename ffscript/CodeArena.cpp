@@ -0,0 +1,133 @@
+/******************************************************************
+* File:        CodeArena.cpp
+* Description: implement CodeArena class. A monotonic memory arena that
+*              keeps compiled code objects of a program. Commands and
+*              constant blocks created while an arena is current for
+*              the thread are carved from its chunks and the chunks
+*              are released at once when the arena is destroyed.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "CodeArena.h"
+#include <stdlib.h>
+#include <new>
+
+// all blocks in the arena are aligned by this value
+#define CODE_ARENA_ALIGNMENT 16
+#define CODE_ARENA_ALIGN(size) (((size) + CODE_ARENA_ALIGNMENT - 1) & ~((size_t)CODE_ARENA_ALIGNMENT - 1))
+
+namespace ffscript {
+
+	// header of objects allocated by allocateObject, it tells
+	// the object is in an arena or in the heap
+	struct CodeObjectHeader {
+		CodeArena* arena;
+	};
+
+	static const size_t s_chunkHeaderSize = CODE_ARENA_ALIGN(sizeof(void*) * 2);
+	static const size_t s_objectHeaderSize = CODE_ARENA_ALIGN(sizeof(CodeObjectHeader));
+
+	static thread_local CodeArena* s_currentArena = nullptr;
+
+	CodeArena::CodeArena(size_t chunkSize) :
+		_chunks(nullptr), _current(nullptr), _end(nullptr),
+		_chunkSize(chunkSize), _allocatedSize(0) {}
+
+	CodeArena::~CodeArena() {
+		Chunk* chunk = _chunks;
+		while (chunk) {
+			Chunk* next = chunk->next;
+			free(chunk);
+			chunk = next;
+		}
+	}
+
+	void* CodeArena::allocate(size_t size) {
+		size = CODE_ARENA_ALIGN(size);
+		if (_current == nullptr || _current + size > _end) {
+			// big blocks get their own chunks, so the current chunk is still used for next blocks
+			size_t chunkSize = size > _chunkSize / 4 ? size : _chunkSize;
+			Chunk* chunk = (Chunk*)malloc(s_chunkHeaderSize + chunkSize);
+			if (chunk == nullptr) {
+				throw std::bad_alloc();
+			}
+			chunk->size = chunkSize;
+			char* chunkData = (char*)chunk + s_chunkHeaderSize;
+
+			if (chunkSize != _chunkSize && _chunks) {
+				chunk->next = _chunks->next;
+				_chunks->next = chunk;
+				_allocatedSize += size;
+				return chunkData;
+			}
+			chunk->next = _chunks;
+			_chunks = chunk;
+			_current = chunkData;
+			_end = chunkData + chunkSize;
+		}
+
+		void* data = _current;
+		_current += size;
+		_allocatedSize += size;
+		return data;
+	}
+
+	size_t CodeArena::getAllocatedSize() const {
+		return _allocatedSize;
+	}
+
+	int CodeArena::getChunkCount() const {
+		int count = 0;
+		for (Chunk* chunk = _chunks; chunk; chunk = chunk->next) {
+			count++;
+		}
+		return count;
+	}
+
+	CodeArena* CodeArena::getCurrent() {
+		return s_currentArena;
+	}
+
+	void CodeArena::setCurrent(CodeArena* arena) {
+		s_currentArena = arena;
+	}
+
+	void* CodeArena::allocateObject(size_t size) {
+		CodeObjectHeader* header;
+		if (s_currentArena) {
+			header = (CodeObjectHeader*)s_currentArena->allocate(s_objectHeaderSize + size);
+		}
+		else {
+			header = (CodeObjectHeader*)malloc(s_objectHeaderSize + size);
+			if (header == nullptr) {
+				throw std::bad_alloc();
+			}
+		}
+		header->arena = s_currentArena;
+		return (char*)header + s_objectHeaderSize;
+	}
+
+	void CodeArena::deallocateObject(void* data) {
+		if (data == nullptr) {
+			return;
+		}
+		CodeObjectHeader* header = (CodeObjectHeader*)((char*)data - s_objectHeaderSize);
+		if (header->arena == nullptr) {
+			free(header);
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	CodeArenaScope::CodeArenaScope(CodeArena* arena) : _previousArena(CodeArena::getCurrent()) {
+		CodeArena::setCurrent(arena);
+	}
+
+	CodeArenaScope::~CodeArenaScope() {
+		CodeArena::setCurrent(_previousArena);
+	}
+}
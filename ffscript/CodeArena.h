@@ -0,0 +1,64 @@
+/******************************************************************
+* File:        CodeArena.h
+* Description: declare CodeArena class. A monotonic memory arena that
+*              keeps compiled code objects of a program. Commands and
+*              constant blocks created while an arena is current for
+*              the thread are carved from its chunks and the chunks
+*              are released at once when the arena is destroyed.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include <memory>
+#include <stddef.h>
+
+namespace ffscript {
+	class CodeArena : public std::enable_shared_from_this<CodeArena>
+	{
+		struct Chunk {
+			Chunk* next;
+			size_t size;
+		};
+
+		Chunk* _chunks;
+		char* _current;
+		char* _end;
+		size_t _chunkSize;
+		size_t _allocatedSize;
+	public:
+		CodeArena(size_t chunkSize = 16 * 1024);
+		virtual ~CodeArena();
+
+		// allocate a block in the arena, the block is released when the arena is destroyed
+		void* allocate(size_t size);
+		// total size of blocks allocated in the arena
+		size_t getAllocatedSize() const;
+		int getChunkCount() const;
+
+		static CodeArena* getCurrent();
+		static void setCurrent(CodeArena* arena);
+
+		// allocate an object in the current arena of the thread
+		// or in the heap if the thread does not have a current arena
+		static void* allocateObject(size_t size);
+		// release an object allocated by allocateObject, objects in an arena
+		// are kept until the arena is destroyed
+		static void deallocateObject(void* data);
+	};
+
+	typedef std::shared_ptr<CodeArena> CodeArenaRef;
+
+	// make an arena current for the thread in a scope
+	class CodeArenaScope
+	{
+		CodeArena* _previousArena;
+	public:
+		CodeArenaScope(CodeArena* arena);
+		~CodeArenaScope();
+	};
+}
@@ -81,14 +81,12 @@ namespace ffscript {
 	}
 
 	void CodeUpdater::updateScriptFunctionObject(Program* program, RuntimeFunctionInfo* runtimeInfo, int functionId) {
-		CodeSegmentEntry* pFunctionCode = program->getFunctionPlainCode(functionId);
-		runtimeInfo->address = pFunctionCode->first;
+		runtimeInfo->address = (void*)program->getFunctionEntry(functionId);
 	}
 
 	void CodeUpdater::updateLamdaScriptFunctionObject(Program* program, CallCreateLambda* createLambdaInst, int functionId) {
-		CodeSegmentEntry* pFunctionCode = program->getFunctionPlainCode(functionId);
 		auto functionInfo = program->getFunctionInfo(functionId);
 		int capturedDataOffset = SCRIPT_FUNCTION_RETURN_STORAGE_OFFSET + functionInfo->returnStorageSize + functionInfo->paramDataSize;
-		createLambdaInst->setLambdaAddress(pFunctionCode->first, capturedDataOffset);
+		createLambdaInst->setLambdaAddress(program->getFunctionEntry(functionId), capturedDataOffset);
 	}
 }
\ No newline at end of file
@@ -49,8 +49,8 @@ namespace ffscript {
 		_command->buildCommandText(strCommands);
 	}
 
-	void FunctionCommand0P::execute() {		
-		_command->execute();
+	void FunctionCommand0P::execute(Context* context) {		
+		_command->execute(context);
 	}
 
 	int FunctionCommand0P::pushCommandParam(TargetedCommand* command) {
@@ -74,9 +74,9 @@ namespace ffscript {
 		_command->buildCommandText(strCommands);
 	}
 
-	void FunctionCommand1P::execute() {
-		_commandParam->execute();
-		_command->execute();
+	void FunctionCommand1P::execute(Context* context) {
+		_commandParam->execute(context);
+		_command->execute(context);
 	}
 
 	int FunctionCommand1P::pushCommandParam(TargetedCommand* command) {
@@ -109,10 +109,10 @@ namespace ffscript {
 		_command->buildCommandText(strCommands);
 	}
 
-	void FunctionCommand2P::execute() {
-		_commandParam1->execute();
-		_commandParam2->execute();
-		_command->execute();
+	void FunctionCommand2P::execute(Context* context) {
+		_commandParam1->execute(context);
+		_commandParam2->execute(context);
+		_command->execute(context);
 	}
 
 	int FunctionCommand2P::pushCommandParam(TargetedCommand* command) {
@@ -168,16 +168,16 @@ namespace ffscript {
 		_command->buildCommandText(strCommands);
 	}
 
-	void FunctionCommandNP::execute() {
+	void FunctionCommandNP::execute(Context* context) {
 		TargetedCommand** command = _commandParams;
 		TargetedCommand** end = command + _nParam;
 
 		while (command < end) {
-			(*command)->execute();
+			(*command)->execute(context);
 			command++;
 		}
 
-		_command->execute();
+		_command->execute(context);
 	}
 
 	int FunctionCommandNP::pushCommandParam(TargetedCommand* command) {
@@ -222,10 +222,22 @@ namespace ffscript {
 		}
 		return backupCommand;
 	}
+
+	bool OptimizedLogicCommand::testParam1(void* paramData) const {
+		return *((bool*)paramData);
+	}
+
+	bool OptimizedLogicCommand::testParam2(void* paramData) const {
+		return *((bool*)paramData);
+	}
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	LogicAndCommand::LogicAndCommand() {}
 
+	bool LogicAndCommand::getShortCutValue() const {
+		return false;
+	}
+
 	void LogicAndCommand::buildCommandText(std::list<std::string>& strCommands) {
 		_commandParam1->buildCommandText(strCommands);
 		_commandParam2->buildCommandText(strCommands);
@@ -235,10 +247,9 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void LogicAndCommand::execute() {
-		_commandParam1->execute();
+	void LogicAndCommand::execute(Context* context) {
+		_commandParam1->execute(context);
 
-		Context* context = Context::getCurrent();
 		int paramOffset = _commandParam1->getTargetOffset() + context->getCurrentOffset();
 		int returnOffset = getTargetOffset() + context->getCurrentOffset();
 		bool* paramValueRef = (bool*)context->getAbsoluteAddress(paramOffset);
@@ -248,7 +259,7 @@ namespace ffscript {
 			*resultValueRef = false;
 		}
 		else {
-			_commandParam2->execute();
+			_commandParam2->execute(context);
 			paramOffset = _commandParam2->getTargetOffset() + context->getCurrentOffset();
 			paramValueRef = (bool*)context->getAbsoluteAddress(paramOffset);
 			*resultValueRef = *paramValueRef;
@@ -258,6 +269,10 @@ namespace ffscript {
 	/////////////////////////////////////////////////////////////////////////////////////
 	LogicOrCommand::LogicOrCommand() {}
 
+	bool LogicOrCommand::getShortCutValue() const {
+		return true;
+	}
+
 	void LogicOrCommand::buildCommandText(std::list<std::string>& strCommands) {
 		_commandParam1->buildCommandText(strCommands);
 		_commandParam2->buildCommandText(strCommands);
@@ -267,10 +282,9 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void LogicOrCommand::execute() {
-		_commandParam1->execute();
+	void LogicOrCommand::execute(Context* context) {
+		_commandParam1->execute(context);
 
-		Context* context = Context::getCurrent();
 		int paramOffset = _commandParam1->getTargetOffset() + context->getCurrentOffset();
 		int returnOffset = getTargetOffset() + context->getCurrentOffset();
 		bool* paramValueRef = (bool*)context->getAbsoluteAddress(paramOffset);
@@ -280,7 +294,7 @@ namespace ffscript {
 			*resultValueRef = true;
 		}
 		else {
-			_commandParam2->execute();
+			_commandParam2->execute(context);
 			paramOffset = _commandParam2->getTargetOffset() + context->getCurrentOffset();
 			paramValueRef = (bool*)context->getAbsoluteAddress(paramOffset);
 			*resultValueRef = *paramValueRef;
@@ -312,22 +326,21 @@ namespace ffscript {
 		_elseUnit = elseUnit;
 	}
 
-	void ConditionalCommand::execute() {
+	void ConditionalCommand::execute(Context* context) {
 		//fist execute condition
-		_conditionUnit->execute();
+		_conditionUnit->execute(context);
 
 		//read condition result and evaluate
-		Context* context = Context::getCurrent();
 		int conditionOffset = _conditionUnit->getTargetOffset() + context->getCurrentOffset();
 		bool* conditionValue = (bool*)context->getAbsoluteAddress(conditionOffset);
 
 		if (*conditionValue) {
 			//execute if clause
-			_ifUnit->execute();
+			_ifUnit->execute(context);
 		}
 		else {
 			//execute else clause
-			_elseUnit->execute();
+			_elseUnit->execute(context);
 		}
 	}
 
@@ -356,25 +369,25 @@ namespace ffscript {
 		_mainCommand = mainCommand;
 	}
 
-	void TriggerCommand::setBeforeTrigger(const DelegateRef& beforeExecute, const std::string& commandName) {
+	void TriggerCommand::setBeforeTrigger(const CommandTriggerRef& beforeExecute, const std::string& commandName) {
 		_beforeExecuteFunc = beforeExecute;
 		_beforeExecuteCommandName = commandName;
 	}
 
-	void TriggerCommand::setAfterTrigger(const DelegateRef& afterExecute, const std::string& commandName) {
+	void TriggerCommand::setAfterTrigger(const CommandTriggerRef& afterExecute, const std::string& commandName) {
 		_afterExecuteFunc = afterExecute;
 		_afterExecuteCommandName = commandName;
 	}
 
-	void TriggerCommand::execute() {
+	void TriggerCommand::execute(Context* context) {
 		if (_beforeExecuteFunc) {
-			_beforeExecuteFunc->call();
+			_beforeExecuteFunc->call(context);
 		}
 
-		_mainCommand->execute();
+		_mainCommand->execute(context);
 
 		if (_afterExecuteFunc) {
- 			_afterExecuteFunc->call();
+			_afterExecuteFunc->call(context);
 		}
 	}
 
@@ -388,18 +401,17 @@ namespace ffscript {
 		TriggerCommand::buildCommandText(strCommands);
 	}
 
-	void ConditionTriggerCommand::execute() {
+	void ConditionTriggerCommand::execute(Context* context) {
 		char condition = 1;
 		if (_beforeExecuteFunc) {
-			_beforeExecuteFunc->call();
-			condition = _beforeExecuteFunc->getReturnValAsInt8();
+			condition = _beforeExecuteFunc->call(context);
 		}
 
 		if (condition) {
-			_mainCommand->execute();
+			_mainCommand->execute(context);
 
 			if (_afterExecuteFunc) {
-				_afterExecuteFunc->call();
+				_afterExecuteFunc->call(context);
 			}
 		}
 	}
@@ -19,6 +19,9 @@
 
 namespace ffscript {
 	class FunctionCommand : public TargetedCommand {
+		friend class FlatCode;
+		friend class CompareAndJump;
+		friend class ProgramCache;
 	protected:
 		TargetedCommand* _command;
 	public:
@@ -37,12 +40,15 @@ namespace ffscript {
 		virtual ~FunctionCommand0P();
 		virtual int pushCommandParam(TargetedCommand* command);
 		virtual TargetedCommand* popCommandParam();
-		virtual void execute();
+		virtual void execute(Context* context);
 		void buildCommandText(std::list<std::string>& strCommands);
 	};
 
 	////////////////////////////////////////////////////
 	class FunctionCommand1P : public FunctionCommand {
+		friend class FlatCode;
+		friend class CompareAndJump;
+		friend class ProgramCache;
 	protected:
 		TargetedCommand* _commandParam;
 	public:
@@ -50,12 +56,15 @@ namespace ffscript {
 		virtual ~FunctionCommand1P();
 		virtual int pushCommandParam(TargetedCommand* command);
 		virtual TargetedCommand* popCommandParam();
-		virtual void execute();
+		virtual void execute(Context* context);
 		void buildCommandText(std::list<std::string>& strCommands);
 	};
 
 	////////////////////////////////////////////////////
 	class FunctionCommand2P : public FunctionCommand {
+		friend class FlatCode;
+		friend class CompareAndJump;
+		friend class ProgramCache;
 	protected:
 		TargetedCommand* _commandParam1;
 		TargetedCommand* _commandParam2;
@@ -64,12 +73,14 @@ namespace ffscript {
 		virtual ~FunctionCommand2P();
 		virtual int pushCommandParam(TargetedCommand* command);
 		virtual TargetedCommand* popCommandParam();
-		virtual void execute();
+		virtual void execute(Context* context);
 		void buildCommandText(std::list<std::string>& strCommands);
 	};
 
 	////////////////////////////////////////////////////
 	class FunctionCommandNP : public FunctionCommand {
+		friend class FlatCode;
+		friend class ProgramCache;
 	protected:
 		TargetedCommand** _commandParams;
 		int _nMaxParam;
@@ -79,13 +90,14 @@ namespace ffscript {
 		virtual ~FunctionCommandNP();
 		virtual int pushCommandParam(TargetedCommand* command);
 		virtual TargetedCommand* popCommandParam();
-		virtual void execute();
+		virtual void execute(Context* context);
 		int getParamCap() const;
 		void buildCommandText(std::list<std::string>& strCommands);
 	};
 
 	////////////////////////////////////////////////////
 	class OptimizedLogicCommand : public TargetedCommand {
+		friend class FlatCode;
 	protected:
 		TargetedCommand* _commandParam1;
 		TargetedCommand* _commandParam2;
@@ -93,13 +105,19 @@ namespace ffscript {
 	public:
 		virtual int pushCommandParam(TargetedCommand* command);
 		virtual TargetedCommand* popCommandParam();
+		// read value of a param at its address in the context as a boolean value
+		virtual bool testParam1(void* paramData) const;
+		virtual bool testParam2(void* paramData) const;
+		// value of first param that decides the result without running second param
+		virtual bool getShortCutValue() const = 0;
 	};
 
 	////////////////////////////////////////////////////
 	class LogicAndCommand : public OptimizedLogicCommand {
 	public:
 		LogicAndCommand();
-		virtual void execute();
+		virtual void execute(Context* context);
+		virtual bool getShortCutValue() const;
 		void buildCommandText(std::list<std::string>& strCommands);
 	};
 
@@ -107,7 +125,8 @@ namespace ffscript {
 	class LogicOrCommand : public OptimizedLogicCommand {
 	public:
 		LogicOrCommand();
-		virtual void execute();
+		virtual void execute(Context* context);
+		virtual bool getShortCutValue() const;
 		void buildCommandText(std::list<std::string>& strCommands);
 	};
 	
@@ -121,18 +140,29 @@ public:
 	void setCommandData(TargetedCommand* conditionUnit, TargetedCommand* ifUnit, TargetedCommand* elseUnit);
 	END_INSTRUCTION_COMMAND_DECLARE(ConditionalCommand);
 
+	////////////////////////////////////////////////////
+	// a function that is run before or after the main command of a trigger command
+	// on the context that executes the trigger command
+	class CommandTrigger {
+	public:
+		virtual ~CommandTrigger() {}
+		// the return value is used as condition of a condition trigger command
+		virtual unsigned char call(Context* context) = 0;
+	};
+	typedef std::shared_ptr<CommandTrigger> CommandTriggerRef;
+
 	////////////////////////////////////////////////////
 	BEGIN_INSTRUCTION_COMMAND_DECLARE(TriggerCommand, TargetedCommand);
 protected:
 	TargetedCommand* _mainCommand;
-	DelegateRef _afterExecuteFunc;
-	DelegateRef _beforeExecuteFunc;
+	CommandTriggerRef _afterExecuteFunc;
+	CommandTriggerRef _beforeExecuteFunc;
 	std::string _beforeExecuteCommandName;
 	std::string _afterExecuteCommandName;
 public:
 	void setCommand(TargetedCommand* mainCommand);
-	void setBeforeTrigger(const DelegateRef& beforeExecuted, const std::string& commandName);
-	void setAfterTrigger(const DelegateRef& afterExecuted, const std::string& commandName);
+	void setBeforeTrigger(const CommandTriggerRef& beforeExecuted, const std::string& commandName);
+	void setAfterTrigger(const CommandTriggerRef& afterExecuted, const std::string& commandName);
 	END_INSTRUCTION_COMMAND_DECLARE(ConditionalCommand);
 
 	////////////////////////////////////////////////////
@@ -0,0 +1,174 @@
+/******************************************************************
+* File:        CompareAndJump.cpp
+* Description: implement CompareAndJump class. A command that tests
+*              a comparison of primitive values and jumps by its
+*              result.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "CompareAndJump.h"
+#include "CommandTree.h"
+#include "Context.h"
+#include <typeinfo>
+#include <sstream>
+
+namespace ffscript {
+
+	CompareAndJump::CompareAndJump(NativeOperatorCommand* comparison, ConditionFx condition) :
+		_comparison(comparison),
+		_condition(condition),
+		_targetTrue(nullptr),
+		_targetFalse(nullptr)
+	{
+		for (int i = 0; i < 2; i++) {
+			_operands[i].address = nullptr;
+			_operands[i].offset = comparison->getParamOffset(i);
+			_operands[i].directRef = comparison->isDirectRef(i);
+			_operands[i].global = false;
+		}
+	}
+
+	CompareAndJump::~CompareAndJump() {}
+
+	bool CompareAndJump::setOperand(TargetedCommand* pushCommand) {
+		ConditionOperand* operand = nullptr;
+		for (int i = 0; i < 2; i++) {
+			if (_operands[i].address == nullptr && !_operands[i].global && _operands[i].offset == pushCommand->getTargetOffset()) {
+				operand = &_operands[i];
+				break;
+			}
+		}
+		if (operand == nullptr) {
+			return false;
+		}
+
+		// the operand is read from where the push command reads it, an address stored by
+		// the push command is same as a reference operand those is accessed directly
+		const std::type_info& commandType = typeid(*pushCommand);
+		if (commandType == typeid(PushParam)) {
+			operand->address = (char*)((PushParam*)pushCommand)->_param;
+		}
+		else if (commandType == typeid(PushParamRef)) {
+			operand->address = (char*)((PushParamRef*)pushCommand)->_param;
+			operand->directRef = true;
+		}
+		else if (commandType == typeid(PushParamOffset)) {
+			operand->offset = ((PushParamOffset*)pushCommand)->_sourceOffset;
+		}
+		else if (commandType == typeid(PushParamRefOffset)) {
+			operand->offset = ((PushParamRefOffset*)pushCommand)->_sourceOffset;
+			operand->directRef = true;
+		}
+		else if (commandType == typeid(LeaOffsetToOffset)) {
+			operand->offset = ((LeaOffsetToOffset*)pushCommand)->_sourceOffset;
+			operand->directRef = true;
+		}
+		else if (commandType == typeid(PushGlobalParam)) {
+			operand->offset = ((PushGlobalParam*)pushCommand)->_sourceOffset;
+			operand->global = true;
+		}
+		else if (commandType == typeid(PushGlobalParamRef)) {
+			operand->offset = ((PushGlobalParamRef*)pushCommand)->_sourceOffset;
+			operand->directRef = true;
+			operand->global = true;
+		}
+		else {
+			return false;
+		}
+		return true;
+	}
+
+	CompareAndJump* CompareAndJump::createFromCondition(InstructionCommand* conditionCommand) {
+		// only the exact tree types, derived commands may override execute method with other behaviors
+		const std::type_info& commandType = typeid(*conditionCommand);
+		InstructionCommand* comparisonCommand = conditionCommand;
+		TargetedCommand* pushCommands[2] = { nullptr, nullptr };
+
+		if (commandType == typeid(FunctionCommand0P)) {
+			comparisonCommand = ((FunctionCommand0P*)conditionCommand)->_command;
+		}
+		else if (commandType == typeid(FunctionCommand1P)) {
+			auto functionCommand = (FunctionCommand1P*)conditionCommand;
+			comparisonCommand = functionCommand->_command;
+			pushCommands[0] = functionCommand->_commandParam;
+		}
+		else if (commandType == typeid(FunctionCommand2P)) {
+			auto functionCommand = (FunctionCommand2P*)conditionCommand;
+			comparisonCommand = functionCommand->_command;
+			pushCommands[0] = functionCommand->_commandParam1;
+			pushCommands[1] = functionCommand->_commandParam2;
+		}
+
+		auto comparison = dynamic_cast<NativeOperatorCommand*>(comparisonCommand);
+		if (comparison == nullptr || comparison->getParamCount() != 2) {
+			return nullptr;
+		}
+		auto condition = comparison->getConditionFx();
+		if (condition == nullptr) {
+			return nullptr;
+		}
+
+		CompareAndJump* command = new CompareAndJump(comparison, condition);
+		for (int i = 0; i < 2; i++) {
+			if (pushCommands[i] && !command->setOperand(pushCommands[i])) {
+				delete command;
+				return nullptr;
+			}
+		}
+		return command;
+	}
+
+	void CompareAndJump::setTargets(CommandPointer targetTrue, CommandPointer targetFalse) {
+		_targetTrue = targetTrue;
+		_targetFalse = targetFalse;
+	}
+
+	void CompareAndJump::execute(Context* context) {
+		char* frame = (char*)context->getAbsoluteAddress(context->getCurrentOffset());
+		char* globalData = (char*)context->getGlobalData();
+		auto& operand1 = _operands[0];
+		auto& operand2 = _operands[1];
+
+		bool result = _condition(operand1.address ? operand1.address : (operand1.global ? globalData : frame) + operand1.offset, operand1.directRef,
+			operand2.address ? operand2.address : (operand2.global ? globalData : frame) + operand2.offset, operand2.directRef);
+
+		// move to the jump command placed after the condition and jump from there, so
+		// a scope entered by the jump goes back to the jump command when it exits
+		context->setCurrentCommand(context->getCurrentCommand() + 1);
+		CommandPointer targetCommand = result ? _targetTrue : _targetFalse;
+		if (targetCommand) {
+			context->jump(targetCommand);
+		}
+	}
+
+	void CompareAndJump::buildCommandText(std::list<std::string>& strCommands) {
+		std::list<std::string> comparisonText;
+		_comparison->buildCommandText(comparisonText);
+
+		std::stringstream ss;
+		ss << "cmp_jmp(";
+		for (auto& text : comparisonText) {
+			ss << text;
+		}
+		for (int i = 0; i < 2; i++) {
+			ss << ", ";
+			if (_operands[i].address) {
+				ss << "0x" << std::hex << (size_t)_operands[i].address << std::dec;
+			}
+			else {
+				ss << (_operands[i].global ? "global" : "") << (_operands[i].directRef ? "[&" : "[") << _operands[i].offset << "]";
+			}
+		}
+		ss << ", 0x" << std::hex << (size_t)(_targetTrue + 1);
+		if (_targetFalse) {
+			ss << ", 0x" << (size_t)(_targetFalse + 1);
+		}
+		ss << ")";
+		strCommands.emplace_back(ss.str());
+	}
+}
@@ -0,0 +1,58 @@
+/******************************************************************
+* File:        CompareAndJump.h
+* Description: declare CompareAndJump class. A command that tests
+*              a comparison of primitive values and jumps by its
+*              result, it replaces code of a condition those is a
+*              single built-in comparison, so the condition is not
+*              stored to the frame then read back by a jump command.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "InstructionCommand.h"
+#include "NativeOperatorCommands.hpp"
+
+namespace ffscript {
+
+	class CompareAndJump : public InstructionCommand
+	{
+		friend class ProgramCache;
+
+		struct ConditionOperand {
+			// address of a constant operand, it is null if the operand is in the frame
+			char* address;
+			int offset;
+			bool directRef;
+			// the offset is relative to the global data instead of the frame
+			bool global;
+		};
+
+		NativeOperatorCommand* _comparison;
+		ConditionFx _condition;
+		ConditionOperand _operands[2];
+		CommandPointer _targetTrue;
+		CommandPointer _targetFalse;
+	private:
+		CompareAndJump(NativeOperatorCommand* comparison, ConditionFx condition);
+		bool setOperand(TargetedCommand* pushCommand);
+	public:
+		virtual ~CompareAndJump();
+
+		// create the command from the code of a condition, the code must be a comparison
+		// command those operands are read in place or pushed from constants and local
+		// variables. It returns null if the condition cannot be tested directly
+		static CompareAndJump* createFromCondition(InstructionCommand* conditionCommand);
+
+		// the commands will be run next to the target commands like commands of a jump command,
+		// if a target is null, the command after the jump command is run next
+		void setTargets(CommandPointer targetTrue, CommandPointer targetFalse);
+
+		virtual void execute(Context* context);
+		virtual void buildCommandText(std::list<std::string>& strCommands);
+	};
+}
@@ -14,6 +14,90 @@
 #include "ExpresionParser.h"
 
 namespace ffscript{
+	static const wchar_t* skipLiteral(const wchar_t* c, const wchar_t* end) {
+		wchar_t quote = *c++;
+		while (c < end && *c != quote) {
+			if (*c == '\\') c++;
+			c++;
+		}
+		return c;
+	}
+
+	// split the source to global declarations, a function or a struct ends at its
+	// closing brace, the other declarations end at a semicolon
+	static void splitDeclarations(const wchar_t* codeStart, const wchar_t* codeEnd, std::vector<SourceDeclaration>& declarations) {
+		const wchar_t* begin = codeStart;
+		const wchar_t* bodyBegin = nullptr;
+		bool hasAssignment = false;
+		int depth = 0;
+
+		auto addDeclaration = [&declarations](const wchar_t* begin, const wchar_t* bodyBegin, const wchar_t* end) {
+			SourceDeclaration declaration;
+			declaration.isFunction = bodyBegin != nullptr;
+			if (declaration.isFunction) {
+				declaration.header.assign(begin, bodyBegin);
+				declaration.body.assign(bodyBegin, end);
+			}
+			else {
+				declaration.header.assign(begin, end);
+			}
+			auto first = declaration.header.find_first_not_of(L" \t\r\n");
+			if (first == std::wstring::npos) {
+				return;
+			}
+			declaration.header.erase(0, first);
+			declaration.header.erase(declaration.header.find_last_not_of(L" \t\r\n") + 1);
+			declarations.push_back(declaration);
+		};
+
+		for (const wchar_t* c = codeStart; c < codeEnd; c++) {
+			if (*c == '"' || *c == '\'') {
+				c = skipLiteral(c, codeEnd);
+			}
+			else if (*c == '(' || *c == '[') {
+				depth++;
+			}
+			else if (*c == ')' || *c == ']') {
+				depth--;
+			}
+			else if (*c == '{') {
+				if (depth == 0 && bodyBegin == nullptr) {
+					bodyBegin = c;
+				}
+				depth++;
+			}
+			else if (*c == '}') {
+				depth--;
+				if (depth == 0 && bodyBegin) {
+					std::wstring header(begin, bodyBegin);
+					header.erase(header.find_last_not_of(L" \t\r\n") + 1);
+					auto first = header.find_first_not_of(L" \t\r\n");
+					bool isStruct = first != std::wstring::npos && header.compare(first, 6, L"struct") == 0;
+					if (isStruct) {
+						addDeclaration(begin, nullptr, c + 1);
+						begin = c + 1;
+						bodyBegin = nullptr;
+					}
+					else if (!hasAssignment && header.size() && header.back() == ')') {
+						addDeclaration(begin, bodyBegin, c + 1);
+						begin = c + 1;
+						bodyBegin = nullptr;
+					}
+				}
+			}
+			else if (depth == 0 && *c == '=' && bodyBegin == nullptr) {
+				hasAssignment = true;
+			}
+			else if (depth == 0 && *c == ';') {
+				addDeclaration(begin, nullptr, c + 1);
+				begin = c + 1;
+				bodyBegin = nullptr;
+				hasAssignment = false;
+			}
+		}
+		addDeclaration(begin, nullptr, codeEnd);
+	}
+
 	CompilerSuite::CompilerSuite()
 	{
 		_pCompiler = (ScriptCompilerRef)(new ScriptCompiler());
@@ -40,19 +124,21 @@ namespace ffscript{
 	}
 
 	Program* CompilerSuite::compileProgram(const wchar_t* codeStart, const wchar_t* codeEnd) {
+		// items of the last program are removed and items of this program are marked as user items
 		_pCompiler->clearUserLib();
+		_pCompiler->beginUserLib();
 
 		Program* program = new Program();
 		_pCompiler->bindProgram(program);
 
+		// the preprocessed code is split to declarations after the program is compiled
+		std::shared_ptr<std::wstring> newCode;
 		if (_preprocessor) {
-			auto newCode = _preprocessor->preprocess(codeStart, codeEnd);
-
-			if (_globalScopeRef->parse(newCode->c_str(), newCode->c_str() + newCode->size()) == nullptr) {
-				return nullptr;
-			}
+			newCode = _preprocessor->preprocess(codeStart, codeEnd);
+			codeStart = newCode->c_str();
+			codeEnd = newCode->c_str() + newCode->size();
 		}
-		else if (_globalScopeRef->parse(codeStart, codeEnd) == nullptr) {
+		if (_globalScopeRef->parse(codeStart, codeEnd) == nullptr) {
 			return nullptr;
 		}
 
@@ -65,9 +151,64 @@ namespace ffscript{
 			return nullptr;
 		}
 
+		_declarations.clear();
+		splitDeclarations(codeStart, codeEnd, _declarations);
+
 		return program;
 	}
 
+	bool CompilerSuite::updateProgram(Program* program, const wchar_t* codeStart, const wchar_t* codeEnd) {
+		if (_pCompiler->getProgram() != program || program == nullptr) {
+			_pCompiler->setErrorText("the program is not the last program compiled by the suite");
+			return false;
+		}
+
+		std::vector<SourceDeclaration> declarations;
+		if (_preprocessor) {
+			auto newCode = _preprocessor->preprocess(codeStart, codeEnd);
+			splitDeclarations(newCode->c_str(), newCode->c_str() + newCode->size(), declarations);
+		}
+		else {
+			splitDeclarations(codeStart, codeEnd, declarations);
+		}
+
+		// only bodies of functions can be changed
+		if (declarations.size() != _declarations.size()) {
+			_pCompiler->setErrorText("global declarations are changed");
+			return false;
+		}
+		std::list<size_t> changedFunctions;
+		for (size_t i = 0; i < declarations.size(); i++) {
+			auto& declaration = declarations[i];
+			auto& oldDeclaration = _declarations[i];
+			if (declaration.isFunction != oldDeclaration.isFunction || declaration.header != oldDeclaration.header) {
+				_pCompiler->setErrorText("global declarations are changed");
+				return false;
+			}
+			if (declaration.body != oldDeclaration.body) {
+				changedFunctions.push_back(i);
+			}
+		}
+
+		// all changed functions are compiled before any of them is swapped in
+		for (auto i : changedFunctions) {
+			auto& declaration = declarations[i];
+			std::wstring functionCode = declaration.header + declaration.body;
+			if (_globalScopeRef->recompileFunction(program, functionCode.c_str(), functionCode.c_str() + functionCode.size()) == false) {
+				_globalScopeRef->discardRecompiledFunctions(program);
+				return false;
+			}
+		}
+		if (_globalScopeRef->commitRecompiledFunctions(program) == false) {
+			return false;
+		}
+		for (auto i : changedFunctions) {
+			_declarations[i] = declarations[i];
+		}
+
+		return true;
+	}
+
 	ExpUnitExecutor* CompilerSuite::compileExpression(const wchar_t* expression) {
 		ExpressionParser parser(_pCompiler.get());
 		_pCompiler->pushScope(_globalScopeRef.get());
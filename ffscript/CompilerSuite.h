@@ -27,18 +27,37 @@
 #include "Preprocessor.h"
 
 namespace ffscript {
+	// a global declaration in the source of a compiled program
+	struct SourceDeclaration {
+		std::wstring header;
+		// body of a function, it is empty for the other declarations
+		std::wstring body;
+		bool isFunction;
+	};
+
 	class CompilerSuite
 	{
 	protected:
 		ScriptCompilerRef _pCompiler;
 		GlobalScopeRef _globalScopeRef;
 		PreprocessorRef _preprocessor;
+		// declarations of the last compiled program, they are used to find
+		// the functions those are changed when the program is updated
+		std::vector<SourceDeclaration> _declarations;
 	public:
 		CompilerSuite();
 		virtual void initialize(int globalMemSize);
 		virtual ~CompilerSuite();
 
 		Program* compileProgram(const wchar_t* codeStart, const wchar_t* codeEnd);
+		// compile only functions those bodies are changed from the last compiled source and
+		// swap their code into the program. The functions are swapped only if all of them are
+		// compiled, see GlobalScope::commitRecompiledFunctions for what running tasks see.
+		// Function objects created before the update keep calling the old code, and tasks
+		// must not be created while the program is updated. It returns false if the program
+		// is not the last compiled program or the source has other changes, the program
+		// must be compiled again in that case
+		bool updateProgram(Program* program, const wchar_t* codeStart, const wchar_t* codeEnd);
 		ExpUnitExecutor* compileExpression(const wchar_t* expression);
 		const GlobalScopeRef& getGlobalScope() const;
 		const TypeManagerRef& getTypeManager() const;
@@ -14,12 +14,16 @@
 #include <stdlib.h>
 #include "InstructionCommand.h"
 #include "ScopeRuntimeData.h"
+#include "ThreadedCode.h"
+#include "Program.h"
+#include "function/DynamicFunction2.h"
 
 #include <iomanip>
 #include <sstream>
 
 #ifdef THROW_EXCEPTION_ON_ERROR
 #include <exception>
+#include <algorithm>
 
 #define RAISE_STACK_OVERFLOW_ERROR() throw std::runtime_error("stack is overflow")
 #define RAISE_ESP_MISMATCH_ERROR() throw std::runtime_error("function calling is mismatch")
@@ -28,6 +32,13 @@
 #define RAISE_ESP_MISMATCH_ERROR() _isError = false
 #endif
 
+// use computed goto to dispatch threaded code if the compiler supports it
+#if __GNUC__
+#define USE_COMPUTED_GOTO 1
+#else
+#define USE_COMPUTED_GOTO 0
+#endif
+
 namespace ffscript {
 	
 #if _WIN32 || _WIN64
@@ -51,7 +62,11 @@ namespace ffscript {
 #ifdef REDUCE_SCOPE_ALLOCATING_MEM
 		_scopeCodeSize(RaiseStackOverflow),
 #endif
-		_contextStack(RaiseStackOverflow)
+		_contextStack(RaiseStackOverflow),
+		_constructorBitmapMark{ -1, 0 },
+		_threadedCode(nullptr),
+		_globalData(nullptr),
+		_resumePoint(nullptr)
 	{
 		Context::makeCurrent(this);
 		_threadData = (unsigned char*)malloc(_dataSize);
@@ -68,7 +83,11 @@ namespace ffscript {
 #ifdef REDUCE_SCOPE_ALLOCATING_MEM
 		_scopeCodeSize(RaiseStackOverflow),
 #endif
-		_contextStack(RaiseStackOverflow)
+		_contextStack(RaiseStackOverflow),
+		_constructorBitmapMark{ -1, 0 },
+		_threadedCode(nullptr),
+		_globalData(nullptr),
+		_resumePoint(nullptr)
 	{
 		Context::makeCurrent(this);
 		_isError = false;
@@ -151,23 +170,72 @@ namespace ffscript {
 #endif
 	}	
 
+	unsigned char* Context::allocateConstructorBitmap(unsigned int bitmapSize) {
+		auto& mark = _constructorBitmapMark;
+		unsigned int capacity = mark.block < 0 ? CONSTRUCTOR_BITMAP_BUFFER_SIZE : (unsigned int)_constructorBitmapBlocks[mark.block].size();
+		if (mark.top + bitmapSize > capacity) {
+			// blocks after the top are not used, so they can be replaced if they are too small
+			mark.block++;
+			mark.top = 0;
+			if (mark.block == (int)_constructorBitmapBlocks.size()) {
+				_constructorBitmapBlocks.emplace_back(std::max(bitmapSize, CONSTRUCTOR_BITMAP_BLOCK_SIZE));
+			}
+			else if (_constructorBitmapBlocks[mark.block].size() < bitmapSize) {
+				_constructorBitmapBlocks[mark.block].resize(bitmapSize);
+			}
+		}
+		unsigned char* bitmap = (mark.block < 0 ? _constructorBitmaps : _constructorBitmapBlocks[mark.block].data()) + mark.top;
+		mark.top += bitmapSize;
+		return bitmap;
+	}
+
 	void Context::pushContext(unsigned int scopeParam) {
-		ScopeRuntimeData* scopeData = ScopeRuntimeData::createRuntimeData(scopeParam);
-		_contextStack.push_front({_beforeJump, scopeData });
+		unsigned int bitmapSize = ScopeRuntimeData::getBitmapSize(scopeParam);
+		auto bitmapMark = _constructorBitmapMark;
+		unsigned char* executedConstructor = allocateConstructorBitmap(bitmapSize);
+		memset(executedConstructor, 0, bitmapSize);
+
+		_contextStack.push_front({_beforeJump, ScopeRuntimeData(executedConstructor, bitmapSize), _resumePoint, bitmapMark });
+		_resumePoint = nullptr;
 	}
 	
 	void Context::popContext() {
 		auto& contextInfo = _contextStack.front();
 		_currentCommand = contextInfo._command;
-		if (contextInfo._scopeData) {
-			delete contextInfo._scopeData;
-		}
+		_resumePoint = contextInfo._resumePoint;
+		_constructorBitmapMark = contextInfo._bitmapMark;
 
 		_contextStack.pop_front();
 	}
 	
-	ScopeRuntimeData* Context::getScopeRuntimeData() const {
-		return _contextStack.front()._scopeData;
+	ScopeRuntimeData* Context::getScopeRuntimeData() {
+		return &_contextStack.front()._scopeData;
+	}
+
+	void Context::saveState(ContextState& state) const {
+		state.currentOffset = _currentOffset;
+		state.allocatedSize = _allocatedStack.front();
+		state.allocatedStackSize = _allocatedStack.getSize();
+#ifdef REDUCE_SCOPE_ALLOCATING_MEM
+		state.scopeCodeStackSize = _scopeCodeSize.getSize();
+#else
+		state.scopeCodeStackSize = 0;
+#endif
+		state.contextStackSize = _contextStack.getSize();
+		state.constructorBitmapMark = _constructorBitmapMark;
+		state.resumePoint = _resumePoint;
+	}
+
+	void Context::restoreState(const ContextState& state) {
+		_currentOffset = state.currentOffset;
+		_allocatedStack.shrink(state.allocatedStackSize);
+		_allocatedStack.front() = state.allocatedSize;
+#ifdef REDUCE_SCOPE_ALLOCATING_MEM
+		_scopeCodeSize.shrink(state.scopeCodeStackSize);
+#endif
+		_contextStack.shrink(state.contextStackSize);
+		_constructorBitmapMark = state.constructorBitmapMark;
+		_resumePoint = state.resumePoint;
 	}
 	
 
@@ -245,6 +313,18 @@ namespace ffscript {
 		_endCommand = endCommand;
 	}
 
+	void Context::setThreadedCode(const ThreadedCode* threadedCode) {
+		_threadedCode = threadedCode;
+	}
+
+	const ThreadedCode* Context::getThreadedCode() const {
+		return _threadedCode;
+	}
+
+	void Context::setGlobalData(void* globalData) {
+		_globalData = (unsigned char*)globalData;
+	}
+
 	template< typename T >
 	std::string int_to_hex(T i)
 	{
@@ -259,13 +339,20 @@ namespace ffscript {
 #ifndef THROW_EXCEPTION_ON_ERROR
 		if (_isError) return;
 #endif
+		if (_threadedCode) {
+			runThreadedCode(true);
+			return;
+		}
+		// functions called at the end of statements are entered in this loop, they
+		// push their frames and come back here when they return, so the loop only
+		// stops when the frame of the function that started the loop is popped
 		int stackLevel = _allocatedStack.getSize();
 		while (_currentCommand != _endCommand) {
 			//const std::string& commandText = (*_currentCommand)->toString();
 			//Logger::WriteMessage((int_to_hex((size_t)_currentCommand) + " " + commandText).c_str());
-			(*_currentCommand)->execute();
+			(*_currentCommand)->execute(this);
 
-			if (_allocatedStack.getSize() != stackLevel
+			if (_allocatedStack.getSize() < stackLevel
 #ifndef THROW_EXCEPTION_ON_ERROR
 				|| _isError
 #endif 
@@ -278,15 +365,36 @@ namespace ffscript {
 	}
 
 	void Context::run() {
+		if (_globalData == nullptr && _currentCommand) {
+			// the owner did not bind the context to global data, so the code
+			// runs with global data of the program it belongs to
+			auto program = Program::findProgram(_currentCommand);
+			if (program && program->getGlobalData()) {
+				setGlobalData(program->getGlobalData());
+				try {
+					run();
+				}
+				catch (std::exception&) {
+					_globalData = nullptr;
+					throw;
+				}
+				_globalData = nullptr;
+				return;
+			}
+		}
 		if (_currentCommand
 #ifndef THROW_EXCEPTION_ON_ERROR
 			&& !_isError
 #endif
 			) {
+			if (_threadedCode) {
+				runThreadedCode(false);
+				return;
+			}
 			while (_currentCommand != _endCommand) {
 				//const std::string& commandText = (*_currentCommand)->toString();
 				//Logger::WriteMessage((int_to_hex((size_t)_currentCommand) + " " + commandText).c_str());
-				(*_currentCommand)->execute();
+				(*_currentCommand)->execute(this);
 #ifndef THROW_EXCEPTION_ON_ERROR
 				if (_isError) {
 					break;
@@ -296,4 +404,135 @@ namespace ffscript {
 			}
 		}
 	}
+
+	void Context::runThreadedCode(bool exitWhenFunctionReturns) {
+		const int stackLevel = _allocatedStack.getSize();
+		const CommandPointer codeBegin = _threadedCode->getCodeBegin();
+		const size_t instructionCount = (size_t)_threadedCode->getInstructionCount();
+		const ThreadedInstruction* instructions = _threadedCode->getInstructions();
+		const ThreadedInstruction* instruction;
+
+		// commands are not belong to the threaded code, such as commands of
+		// a lambda program, are run through their virtual execute method
+		ThreadedInstruction foreignInstruction;
+		foreignInstruction.opCode = ThreadedOpCode::Execute;
+
+#define THREADED_FETCH() \
+		if (_currentCommand == _endCommand) return; \
+		if ((size_t)(_currentCommand - codeBegin) < instructionCount) { \
+			instruction = instructions + (_currentCommand - codeBegin); \
+		} \
+		else { \
+			foreignInstruction.command = *_currentCommand; \
+			instruction = &foreignInstruction; \
+		}
+
+#define THREADED_CHECK_STACK() \
+		if (exitWhenFunctionReturns && _allocatedStack.getSize() < stackLevel) return
+
+#define THREADED_ADDRESS(offset) (_threadData + _currentOffset + (offset))
+
+#if USE_COMPUTED_GOTO
+		static void* const dispatchTable[] = {
+			&&op_Execute,
+			&&op_Jump,
+			&&op_JumpIf,
+			&&op_JumpIfElse,
+			&&op_PushParam,
+			&&op_PushParamRef,
+			&&op_PushParamOffset,
+			&&op_PushParamRefOffset,
+			&&op_PushGlobalParam,
+			&&op_PushGlobalParamRef,
+			&&op_CallNative,
+		};
+		static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) == (size_t)ThreadedOpCode::OpCodeCount, "dispatch table is mismatch with op codes");
+
+		// each instruction dispatches the next instruction by itself
+#define THREADED_CASE(opCode) op_##opCode
+#define THREADED_NEXT() \
+		_currentCommand++; \
+		THREADED_FETCH(); \
+		goto *dispatchTable[(int)instruction->opCode]
+
+		THREADED_FETCH();
+		goto *dispatchTable[(int)instruction->opCode];
+		{
+#else
+#define THREADED_CASE(opCode) case ThreadedOpCode::opCode
+#define THREADED_NEXT() \
+		_currentCommand++; \
+		continue
+
+		for (;;) {
+			THREADED_FETCH();
+			switch (instruction->opCode) {
+#endif
+			THREADED_CASE(Execute):
+				instruction->command->execute(this);
+#ifndef THROW_EXCEPTION_ON_ERROR
+				if (_isError) return;
+#endif
+				THREADED_CHECK_STACK();
+				THREADED_NEXT();
+
+			THREADED_CASE(Jump):
+				_beforeJump = _currentCommand;
+				_currentCommand = instruction->targetTrue;
+				THREADED_NEXT();
+
+			THREADED_CASE(JumpIf):
+				if (*(bool*)THREADED_ADDRESS(instruction->sourceOffset)) {
+					_beforeJump = _currentCommand;
+					_currentCommand = instruction->targetTrue;
+				}
+				THREADED_NEXT();
+
+			THREADED_CASE(JumpIfElse):
+				_beforeJump = _currentCommand;
+				_currentCommand = *(bool*)THREADED_ADDRESS(instruction->sourceOffset) ? instruction->targetTrue : instruction->targetFalse;
+				THREADED_NEXT();
+
+			THREADED_CASE(PushParam):
+				writeFrame(_currentOffset + instruction->targetOffset, instruction->pointer, instruction->size);
+				THREADED_NEXT();
+
+			THREADED_CASE(PushParamRef):
+				lea(_currentOffset + instruction->targetOffset, instruction->pointer);
+				THREADED_NEXT();
+
+			THREADED_CASE(PushParamOffset):
+				writeFrame(_currentOffset + instruction->targetOffset, THREADED_ADDRESS(instruction->sourceOffset), instruction->size);
+				THREADED_NEXT();
+
+			THREADED_CASE(PushParamRefOffset):
+				lea(_currentOffset + instruction->targetOffset, THREADED_ADDRESS(instruction->sourceOffset));
+				THREADED_NEXT();
+
+			THREADED_CASE(PushGlobalParam):
+				writeFrame(_currentOffset + instruction->targetOffset, _globalData + instruction->sourceOffset, instruction->size);
+				THREADED_NEXT();
+
+			THREADED_CASE(PushGlobalParamRef):
+				lea(_currentOffset + instruction->targetOffset, _globalData + instruction->sourceOffset);
+				THREADED_NEXT();
+
+			THREADED_CASE(CallNative):
+				((DFunction2*)instruction->pointer)->call(THREADED_ADDRESS(instruction->targetOffset), (void**)THREADED_ADDRESS(instruction->sourceOffset));
+				// native function may run a script function on this context
+				THREADED_CHECK_STACK();
+				THREADED_NEXT();
+#if !USE_COMPUTED_GOTO
+			default:
+				THREADED_NEXT();
+			}
+#endif
+		}
+
+#undef THREADED_FETCH
+#undef THREADED_CHECK_STACK
+#undef THREADED_ADDRESS
+#undef THREADED_CASE
+#undef THREADED_NEXT
+	}
 }
@@ -14,18 +14,34 @@
 #include "ffscript.h"
 #include "SingleList.h"
 #include "FFStack.h"
+#include "ScopeRuntimeData.h"
+#include <string.h>
+#include <vector>
 class DFunction;
 
 #define THROW_EXCEPTION_ON_ERROR
 #define REDUCE_SCOPE_ALLOCATING_MEM
+// frames are verified once when they are pushed or allocated, so commands access data
+// in their frames without checking bounds. Comment it out to check every access
+#define VERIFIED_FRAME_ACCESS
 
 namespace ffscript {
 
-	class ScopeRuntimeData;
+	class ThreadedCode;
+
+	// top of the stack of constructor bitmaps, block -1 is the buffer inside the context
+	struct ConstructorBitmapMark {
+		int block;
+		unsigned int top;
+	};
 
 	struct ContextInfo {
 		CommandPointer _command;
-		ScopeRuntimeData* _scopeData;
+		ScopeRuntimeData _scopeData;
+		// resume point of the command that entered the scope
+		const void* _resumePoint;
+		// top of the constructor bitmaps before the scope was entered
+		ConstructorBitmapMark _bitmapMark;
 	};
 
 	//typedef SingleList<unsigned int> ScopeAllocatedStack;
@@ -34,6 +50,23 @@ namespace ffscript {
 	typedef FFStack<unsigned int, 4096> ScopeAllocatedStack;
 	typedef FFStack<ContextInfo, 4096> ContextStack;
 
+	// positions of the stacks in a context, used to restore the context
+	// after a script function is stopped by an exception
+	struct ContextState {
+		unsigned int currentOffset;
+		unsigned int allocatedSize;
+		int allocatedStackSize;
+		int scopeCodeStackSize;
+		int contextStackSize;
+		ConstructorBitmapMark constructorBitmapMark;
+		const void* resumePoint;
+	};
+
+	// size of the buffer inside a context used to store executed state of constructors
+	// in running scopes, and size of the heap blocks used when the buffer is full
+	#define CONSTRUCTOR_BITMAP_BUFFER_SIZE 256
+	#define CONSTRUCTOR_BITMAP_BLOCK_SIZE 4096u
+
 	class Context
 	{
 		unsigned char* _threadData;
@@ -50,6 +83,25 @@ namespace ffscript {
 		ScopeAllocatedStack _scopeCodeSize;
 #endif
 		ContextStack _contextStack;
+		// constructor bitmaps of scopes in context stack are allocated in this buffer
+		// as a stack, so entering and leaving a scope does not need heap memory. Deep
+		// recursion continues in heap blocks, they are kept for next runs and they are
+		// not moved, so bitmaps of running scopes stay valid
+		unsigned char _constructorBitmaps[CONSTRUCTOR_BITMAP_BUFFER_SIZE];
+		std::vector<std::vector<unsigned char>> _constructorBitmapBlocks;
+		ConstructorBitmapMark _constructorBitmapMark;
+		const ThreadedCode* _threadedCode;
+		// base address of global variables of the program instance that the context is running
+		unsigned char* _globalData;
+		// where the command that called a script function in its middle continues
+		const void* _resumePoint;
+	protected:
+		void runThreadedCode(bool exitWhenFunctionReturns);
+		unsigned char* allocateConstructorBitmap(unsigned int bitmapSize);
+		// used by running loops of derived contexts, a script function has
+		// its own level in the allocated stack while it is running
+		inline void moveToNextCommand() { _currentCommand++; }
+		inline int getScopeLevel() const { return _allocatedStack.getSize(); }
 	public:
 		Context(unsigned char* threadData, unsigned int bufferSize);
 		Context(unsigned int stackSize);
@@ -67,21 +119,55 @@ namespace ffscript {
 		void popScope();
 		void pushContext(unsigned int scopeParam);
 		void popContext();
-		ScopeRuntimeData* getScopeRuntimeData() const;
+		ScopeRuntimeData* getScopeRuntimeData();
+		void saveState(ContextState& state) const;
+		void restoreState(const ContextState& state);
 		void write(unsigned int offset, const void* data, unsigned int size);
 		void read(unsigned int offset, void* data, unsigned int size);
 		void lea(unsigned int offset, void* value);
 		bool prepareWrite(unsigned int offset, unsigned int size);
 		inline void* getAbsoluteAddress(unsigned int offset) { return (void*)(_threadData + offset); }
+		// access data in a frame those was verified when it was allocated
+		inline void writeFrame(unsigned int offset, const void* data, unsigned int size) {
+#ifdef VERIFIED_FRAME_ACCESS
+			memcpy(_threadData + offset, data, size);
+#else
+			write(offset, data, size);
+#endif
+		}
+		inline void readFrame(unsigned int offset, void* data, unsigned int size) {
+#ifdef VERIFIED_FRAME_ACCESS
+			memcpy(data, _threadData + offset, size);
+#else
+			read(offset, data, size);
+#endif
+		}
 		CommandPointer getCurrentCommand() const;
 		CommandPointer getEndCommand() const;
 		void jump(CommandPointer commandPointer);
 		void setCurrentCommand(CommandPointer commandPointer);
 		void setEndCommand(CommandPointer endCommand);
+		// the threaded code is used to run the commands belong to it
+		// instead of calling virtual execute method of each command
+		void setThreadedCode(const ThreadedCode* threadedCode);
+		const ThreadedCode* getThreadedCode() const;
+		// global variables are accessed by their offsets from the global data, so
+		// a compiled program can run with global data of different instances. A new
+		// context does not have global data, its owner may set it before running code,
+		// otherwise the code runs with global data of its program or executor
+		inline unsigned char* getGlobalData() const { return _globalData; }
+		void setGlobalData(void* globalData);
+		// a command that enters a script function in its middle stores where it continues,
+		// the point is kept in the context stack while the function is running and it
+		// is restored when the function returns to the command
+		inline void setResumePoint(const void* resumePoint) { _resumePoint = resumePoint; }
+		inline const void* getResumePoint() const { return _resumePoint; }
 
 		virtual void run();
 		virtual void runFunctionScript();
 
+		// commands receive the running context through their execute method
+		// current context of the thread is still kept for native functions
 		static Context* getCurrent();
 		static void makeCurrent(Context* context);
 	};
@@ -0,0 +1,88 @@
+/******************************************************************
+* File:        ContextPool.cpp
+* Description: implement ContextPool class. A class that keeps contexts
+*              and script runners of a program to reuse them for
+*              many calls from the host. Contexts are prepared once
+*              and handed out to calling threads, runners are cached
+*              by function id, so a call does not allocate memory.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "ContextPool.h"
+#include "Context.h"
+#include "Program.h"
+
+namespace ffscript {
+	ContextPool::ContextPool(Program* program, unsigned int stackSize, int preparedCount) :
+		_program(program), _stackSize(stackSize)
+	{
+		for (int i = 0; i < preparedCount; i++) {
+			_freeContexts.push_back(createContext());
+		}
+	}
+
+	ContextPool::~ContextPool() {
+		// context's destructor resets current context of the thread
+		auto backupCurrentContext = Context::getCurrent();
+		for (auto context : _allContexts) {
+			if (context == backupCurrentContext) {
+				backupCurrentContext = nullptr;
+			}
+			delete context;
+		}
+		Context::makeCurrent(backupCurrentContext);
+
+		for (auto& it : _runners) {
+			delete it.second;
+		}
+	}
+
+	Context* ContextPool::createContext() {
+		// context's constructor makes itself current context of the thread,
+		// contexts of the pool are only used through the runners
+		auto backupCurrentContext = Context::getCurrent();
+		Context* context = new Context(_stackSize);
+		Context::makeCurrent(backupCurrentContext);
+
+		_allContexts.push_back(context);
+		return context;
+	}
+
+	Context* ContextPool::acquireContext() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_freeContexts.size()) {
+			Context* context = _freeContexts.back();
+			_freeContexts.pop_back();
+			return context;
+		}
+		// reserve space to release the new context without allocating memory
+		_freeContexts.reserve(_allContexts.size() + 1);
+		return createContext();
+	}
+
+	void ContextPool::releaseContext(Context* context) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_freeContexts.push_back(context);
+	}
+
+	ScriptRunner* ContextPool::getRunner(int functionId) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _runners.find(functionId);
+		if (it != _runners.end()) {
+			return it->second;
+		}
+		ScriptRunner* runner = new ScriptRunner(_program, functionId);
+		_runners.insert(std::make_pair(functionId, runner));
+		return runner;
+	}
+
+	int ContextPool::getContextCount() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return (int)_allContexts.size();
+	}
+}
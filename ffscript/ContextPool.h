@@ -0,0 +1,75 @@
+/******************************************************************
+* File:        ContextPool.h
+* Description: declare ContextPool class. A class that keeps contexts
+*              and script runners of a program to reuse them for
+*              many calls from the host. Contexts are prepared once
+*              and handed out to calling threads, runners are cached
+*              by function id, so a call does not allocate memory.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "ffscript.h"
+#include "ScriptRunner.h"
+#include <vector>
+#include <map>
+#include <mutex>
+
+namespace ffscript {
+	class Context;
+	class Program;
+
+	class ContextPool
+	{
+		Program* _program;
+		unsigned int _stackSize;
+		std::vector<Context*> _freeContexts;
+		std::vector<Context*> _allContexts;
+		std::map<int, ScriptRunner*> _runners;
+		std::mutex _mutex;
+	protected:
+		Context* createContext();
+	public:
+		ContextPool(Program* program, unsigned int stackSize, int preparedCount = 0);
+		virtual ~ContextPool();
+
+		// take a free context from the pool, a new one is created when all contexts are in use
+		Context* acquireContext();
+		// give the context back to the pool, the context must be acquired from this pool
+		void releaseContext(Context* context);
+		// get cached runner of the function, the runner is created at first call
+		ScriptRunner* getRunner(int functionId);
+		int getContextCount();
+
+		// run a function of the program on a context of the pool
+		template <typename Ret, typename... Args>
+		Ret invoke(int functionId, const Args&... params);
+	};
+
+	// acquire a context from the pool in its life time
+	class PooledContext
+	{
+		ContextPool* _pool;
+		Context* _context;
+	public:
+		PooledContext(ContextPool* pool) : _pool(pool), _context(pool->acquireContext()) {}
+		~PooledContext() { _pool->releaseContext(_context); }
+
+		PooledContext(const PooledContext&) = delete;
+		PooledContext& operator=(const PooledContext&) = delete;
+
+		Context* get() const { return _context; }
+	};
+
+	template <typename Ret, typename... Args>
+	Ret ContextPool::invoke(int functionId, const Args&... params) {
+		ScriptRunner* runner = getRunner(functionId);
+		PooledContext context(this);
+		return runner->invoke<Ret>(context.get(), params...);
+	}
+}
@@ -16,6 +16,7 @@
 #include "ScriptCompiler.h"
 #include "Program.h"
 #include "ScriptScope.h"
+#include "ClosureAllocator.h"
 
 #include <sstream>
 
@@ -42,11 +43,10 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void DefaultAssigmentCommand::execute() {
-		_command1->execute();
-		_command2->execute();
+	void DefaultAssigmentCommand::execute(Context* context) {
+		_command1->execute(context);
+		_command2->execute(context);
 
-		Context* context = Context::getCurrent();
 		int param2Offset = _command2->getTargetOffset() + context->getCurrentOffset();
 
 		//offset 1 contain an adress of varialble or r-value
@@ -93,11 +93,10 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void DefaultAssigmentCommandForSemiRef::execute() {
-		_command1->execute();
-		_command2->execute();
+	void DefaultAssigmentCommandForSemiRef::execute(Context* context) {
+		_command1->execute(context);
+		_command2->execute(context);
 
-		Context* context = Context::getCurrent();
 		int param2Offset = _command2->getTargetOffset() + context->getCurrentOffset();
 		void* param2Adress = context->getAbsoluteAddress(param2Offset);
 		void* source = (void*)(*((size_t*)param2Adress));
@@ -401,16 +400,15 @@ namespace ffscript {
 		constructorItems.push_back(exitOperatorConext);
 	}
 
-	void BeforeConstructorCall::call() {
-		auto context = Context::getCurrent();
+	unsigned char BeforeConstructorCall::call(Context* context) {
 		int currentOffset = context->getCurrentOffset();
 
 		//this command will move address of object to param space of constructor operator
-		if(_pushObjectToConstructorParamCommand) _pushObjectToConstructorParamCommand->execute();
+		if(_pushObjectToConstructorParamCommand) _pushObjectToConstructorParamCommand->execute(context);
 
 		//now we can read address of object from param offset
 		size_t objectAddess;
-		context->read(currentOffset + _constructObjectOffsetRef, &objectAddess, sizeof(objectAddess));
+		context->readFrame(currentOffset + _constructObjectOffsetRef, &objectAddess, sizeof(objectAddess));
 		//context->getAbsoluteAddress()
 
 		//the constructor items will be run in a new scope
@@ -439,7 +437,7 @@ namespace ffscript {
 		auto it = _constructorItems.begin();
 
 		//execute enter constructor's scope
-		(*it)->execute();
+		(*it)->execute(context);
 
 		auto constructorEnd = _constructorItems.end();
 		constructorEnd--;
@@ -448,32 +446,36 @@ namespace ffscript {
 
 		for (it++; it != constructorEnd; it++, itOffset++) {
 			*pItemAddress = (objectAddess + *itOffset);
-			(*it)->execute();
+			(*it)->execute(context);
 		}
 
 		//execute exit constructor's scope
-		(*it)->execute();
+		(*it)->execute(context);
 
 #ifdef REDUCE_SCOPE_ALLOCATING_MEM
 		context->scopeUnallocate(_currentScopeCodeSize, 0);
 #endif
+		return 1;
 	}
 
 	/////////////////////////////////////////
 	void dummyOperator(void*) {}
 
-	void afterCallConstructor(int contructorIndex) {
-		Context* context = Context::getCurrent();
+	AfterConstructorCall::AfterConstructorCall(int contructorIndex) : _contructorIndex(contructorIndex) {}
+
+	unsigned char AfterConstructorCall::call(Context* context) {
 		auto scopeRuntimeData = context->getScopeRuntimeData();
 
-		scopeRuntimeData->markContructorExecuted(contructorIndex);
+		scopeRuntimeData->markContructorExecuted(_contructorIndex);
+		return 1;
 	}
 
-	unsigned char beforeCallDestructor(int contructorIndex) {
-		Context* context = Context::getCurrent();
+	BeforeDestructorCall::BeforeDestructorCall(int contructorIndex) : _contructorIndex(contructorIndex) {}
+
+	unsigned char BeforeDestructorCall::call(Context* context) {
 		auto scopeRuntimeData = context->getScopeRuntimeData();
 
-		return scopeRuntimeData->isContructorExecuted(contructorIndex);
+		return scopeRuntimeData->isContructorExecuted(_contructorIndex);
 	}
 
 	void defaultRuntimeFunctionInfoConstructor(RuntimeFunctionInfo* obj) {
@@ -484,7 +486,7 @@ namespace ffscript {
 		memcpy_s(obj1, sizeof(RuntimeFunctionInfo), obj2, sizeof(RuntimeFunctionInfo));
 		auto& anoynymousInfo = obj2->anoynymousInfo;
 		if (anoynymousInfo.data && anoynymousInfo.dataSize) {
-			obj1->anoynymousInfo.data = malloc(anoynymousInfo.dataSize);
+			obj1->anoynymousInfo.data = ClosureAllocator::allocate(anoynymousInfo.dataSize);
 			memcpy_s(obj1->anoynymousInfo.data, anoynymousInfo.dataSize, anoynymousInfo.data, anoynymousInfo.dataSize);
 		}
 	}
@@ -495,7 +497,7 @@ namespace ffscript {
 
 	void runtimeFunctionInfoDestructor(RuntimeFunctionInfo* obj) {
 		if (obj->anoynymousInfo.data) {
-			free(obj->anoynymousInfo.data);
+			ClosureAllocator::deallocate(obj->anoynymousInfo.data, obj->anoynymousInfo.dataSize);
 			obj->anoynymousInfo.data = nullptr;
 		}
 	}
@@ -510,10 +512,18 @@ namespace ffscript {
 	}
 
 	void CreateThreadCommand::call(void* pReturnVal, void* param[]) {
+		// without a context, the thread runs without global variables
+		call(nullptr, pReturnVal, param);
+	}
+
+	void CreateThreadCommand::call(Context* context, void* pReturnVal, void* param[]) {
 		RuntimeFunctionInfo* runtimeInfo = (RuntimeFunctionInfo*)param[0];
 		void* functionParam = (void*)(&param[1]);
-		std::thread* pThread = new std::thread([this, runtimeInfo, functionParam]() {
+		// the thread runs with global variables of the program instance that creates it
+		void* globalData = context ? context->getGlobalData() : nullptr;
+		std::thread* pThread = new std::thread([this, runtimeInfo, functionParam, globalData]() {
 			Context context(1024*1024);
+			context.setGlobalData(globalData);
 
 			int paramSize = _paramSize;
 			int returnOffset = SCRIPT_FUNCTION_RETURN_STORAGE_OFFSET;
@@ -524,32 +534,17 @@ namespace ffscript {
 			}
 
 			if (runtimeInfo->info.type == RuntimeFunctionType::NativeFunction) {
-				CallNativeFuntion callNativeFunction;
-				//ref without delete the instance
-				DFunction2Ref refFunction((DFunction2*)runtimeInfo->address, [](DFunction2*) {});
-				callNativeFunction.setCommandData(returnOffset, paramOffset, refFunction);
-				callNativeFunction.execute();
+				FunctionForwarder::callFunctionObject(&context, runtimeInfo, returnOffset, paramOffset, paramSize);
 			}
 			else {
-				CommandPointer targetCommand = (CommandPointer)runtimeInfo->address;
+				CommandPointer targetCommand = ((const FunctionEntry*)runtimeInfo->address)->load(std::memory_order_acquire);
 				context.setCurrentCommand(targetCommand);
 				context.setEndCommand(nullptr);
 
 				int allocatedSize = _returnSize + paramSize;
 				context.scopeAllocate(allocatedSize, 0);
 
-				if (runtimeInfo->anoynymousInfo.data == nullptr || runtimeInfo->anoynymousInfo.dataSize == 0) {
-					CallScriptFuntion3 callScriptFunction;
-					callScriptFunction.setTargetCommand(targetCommand);
-					callScriptFunction.setCommandData(returnOffset, paramOffset, paramSize);
-					callScriptFunction.execute();
-				}
-				else {
-					CallLambdaFuntion callLambdaFunction(&runtimeInfo->anoynymousInfo);
-					callLambdaFunction.setTargetCommand(targetCommand);
-					callLambdaFunction.setCommandData(returnOffset, paramOffset, paramSize);
-					callLambdaFunction.execute();
-				}
+				FunctionForwarder::callFunctionObject(&context, runtimeInfo, returnOffset, paramOffset, paramSize);
 
 				context.scopeUnallocate(allocatedSize, 0);
 			}
@@ -562,6 +557,22 @@ namespace ffscript {
 		return new CreateThreadCommand(_returnSize, _paramSize);
 	}
 
+	/////////////////////////////////////////
+	CallCreateThread::CallCreateThread() {}
+	CallCreateThread::~CallCreateThread() {}
+
+	void CallCreateThread::buildCommandText(std::list<std::string>& strCommands) {
+		CallNativeFuntion::buildCommandText(strCommands);
+	}
+
+	void CallCreateThread::execute(Context* context) {
+		int currentOffset = context->getCurrentOffset();
+		void* returnVal = context->getAbsoluteAddress(getTargetOffset() + currentOffset);
+		void** params = (void**)context->getAbsoluteAddress(_beginParamOffset + currentOffset);
+
+		((CreateThreadCommand*)_targetFunction.get())->call(context, returnVal, params);
+	}
+
 	void joinThread(THREAD_HANDLE handle) {
 		std::thread* pThread = (std::thread*)handle;
 		if (pThread->joinable()) {
@@ -602,23 +613,25 @@ namespace ffscript {
 
 	}
 
-	void ElementAccessCommand3::execute() {
-		auto context = Context::getCurrent();
-		int currentOffset = context->getCurrentOffset();
-
+	void ElementAccessCommand3::execute(Context* context) {
 		if (_command1) {
-			_command1->execute();
+			_command1->execute(context);
 		}
-		_command2->execute();
+		_command2->execute(context);
+		accessElement(context);
+	}
+
+	void ElementAccessCommand3::accessElement(Context* context) {
+		int currentOffset = context->getCurrentOffset();
 		int indexOffset = currentOffset + _command2->getTargetOffset();
 		char* returnAdress;
 		int index;
-		context->read(indexOffset, &index, sizeof(index));
+		context->readFrame(indexOffset, &index, sizeof(index));
 
 		// check if array offset is contain a address
 		if (_isAddress) {
 			// read address of array
-			context->read(_arrayOffset + currentOffset, &returnAdress, sizeof(void*));
+			context->readFrame(_arrayOffset + currentOffset, &returnAdress, sizeof(void*));
 		}
 		else {
 			returnAdress = (char*)context->getAbsoluteAddress(_arrayOffset + currentOffset);
@@ -639,8 +652,9 @@ namespace ffscript {
 	///
 	///
 	///
-	ElementAccessForGlobalCommand::ElementAccessForGlobalCommand(void* arrayData, int returnOffset, int elmSize) :
-		_arrayData(arrayData),
+	ElementAccessForGlobalCommand::ElementAccessForGlobalCommand(int arrayOffset, int returnOffset, int elmSize, bool isAddress) :
+		_arrayOffset(arrayOffset),
+		_isAddress(isAddress),
 		_elmSize(elmSize),
 		TargetedCommand(returnOffset, sizeof(void*)) {
 
@@ -652,15 +666,17 @@ namespace ffscript {
 	}
 	void ElementAccessForGlobalCommand::buildCommandText(std::list<std::string>& strCommands) {}
 
-	void ElementAccessForGlobalCommand::execute() {
-		auto context = Context::getCurrent();
+	void ElementAccessForGlobalCommand::execute(Context* context) {
 		int currentOffset = context->getCurrentOffset();
 
-		_indexCommand->execute();
+		_indexCommand->execute(context);
 		int indexOffset = currentOffset + _indexCommand->getTargetOffset();
-		char* returnAdress = (char*)_arrayData;
+		char* returnAdress = (char*)context->getGlobalData() + _arrayOffset;
+		if (_isAddress) {
+			returnAdress = *(char**)returnAdress;
+		}
 		int index;
-		context->read(indexOffset, &index, sizeof(index));
+		context->readFrame(indexOffset, &index, sizeof(index));
 
 		// copy adress of element into return offset
 		context->lea(getTargetOffset() + currentOffset, (returnAdress + index*_elmSize));
@@ -11,12 +11,14 @@
 
 #pragma once
 #include "InstructionCommand.h"
+#include "CommandTree.h"
 #include "expressionunit.h"
 #include "BasicFunctionFactory.hpp"
 #include "function/CachedDelegate.h"
 
 namespace ffscript {
 	class DefaultAssigmentCommand : public TargetedCommand {
+		friend class ProgramCache;
 		//int _returnOffset;
 		int _blockSize;
 		//int _offset1;
@@ -27,11 +29,12 @@ namespace ffscript {
 		DefaultAssigmentCommand(int returnOffset, int blockSize/*, int offset1, int offset2*/);
 		virtual ~DefaultAssigmentCommand();
 		void buildCommandText(std::list<std::string>& strCommands);
-		virtual void execute();
+		virtual void execute(Context* context);
 		virtual int pushCommandParam(TargetedCommand* command);
 	};
 
 	class DefaultAssigmentCommandForSemiRef : public TargetedCommand {
+		friend class ProgramCache;
 		//int _returnOffset;
 		int _blockSize;
 		//int _offset1;
@@ -42,7 +45,7 @@ namespace ffscript {
 		DefaultAssigmentCommandForSemiRef(int returnOffset, int blockSize/*, int offset1, int offset2*/);
 		virtual ~DefaultAssigmentCommandForSemiRef();
 		void buildCommandText(std::list<std::string>& strCommands);
-		virtual void execute();
+		virtual void execute(Context* context);
 		virtual int pushCommandParam(TargetedCommand* command);
 	};
 
@@ -115,6 +118,7 @@ namespace ffscript {
 
 	//class for deref a pointer and return r-value
 	class DeRefCommand : public DFunction2 {
+		friend class ProgramCache;
 	private:
 		int _typeSize;
 	public:
@@ -125,6 +129,7 @@ namespace ffscript {
 
 	//class for deref a pointer and return r-value
 	class DeRefCommand2 : public DFunction2 {
+		friend class ProgramCache;
 	private:
 		int _typeSize;
 	public:
@@ -151,7 +156,7 @@ namespace ffscript {
 	// trigger functions for constructor and destructor
 	//
 	/////////////////////////////////////////////////////////////////////////
-	class BeforeConstructorCall : public CachedDelegate {
+	class BeforeConstructorCall : public CommandTrigger {
 		unsigned int _constructObjectOffsetRef;
 		InstructionCommand* _pushObjectToConstructorParamCommand;
 		std::list<InstructionCommand*> _constructorItems;
@@ -161,7 +166,7 @@ namespace ffscript {
 	public:
 		BeforeConstructorCall(InstructionCommand* pushObjectToConstructorParamCommand, unsigned int objectOffsetRef);
 		virtual ~BeforeConstructorCall();
-		void call();
+		unsigned char call(Context* context);
 
 		void buildOperator(ScriptCompiler* scriptCompiler, ScriptScope* currentScope, const std::list<OperatorBuidItemInfo> &operatorInfoList);
 
@@ -170,8 +175,25 @@ namespace ffscript {
 	//this function will do nothing, it just used for constructor/destructor that not registered
 	//but children elements inside have constructors/destructors
 	void dummyOperator(void*);
-	void afterCallConstructor(int contructorIndex);
-	unsigned char beforeCallDestructor(int contructorIndex);
+
+	// mark the constructor is executed in current scope of the context
+	class AfterConstructorCall : public CommandTrigger {
+		friend class ProgramCache;
+		int _contructorIndex;
+	public:
+		AfterConstructorCall(int contructorIndex);
+		unsigned char call(Context* context);
+	};
+
+	// check if the constructor was executed in current scope of the context
+	// so the destructor can be executed
+	class BeforeDestructorCall : public CommandTrigger {
+		friend class ProgramCache;
+		int _contructorIndex;
+	public:
+		BeforeDestructorCall(int contructorIndex);
+		unsigned char call(Context* context);
+	};
 
 
 	void defaultRuntimeFunctionInfoConstructor(RuntimeFunctionInfo* obj);
@@ -187,9 +209,16 @@ namespace ffscript {
 		CreateThreadCommand(int returnSize, int paramSize);
 		void setCommandData(int returnSize, int paramSize);
 		void call(void* pReturnVal, void* param[]);
+		// start a thread that runs with global variables of the given context
+		void call(Context* context, void* pReturnVal, void* param[]);
 		DFunction2* clone();
 	};
 
+	// call command of function createThread, the thread is created on the context
+	// that executes the command
+	BEGIN_INSTRUCTION_COMMAND_DECLARE(CallCreateThread, CallNativeFuntion);
+	END_INSTRUCTION_COMMAND_DECLARE(CallCreateThread);
+
 	void joinThread(THREAD_HANDLE);
 	void closeThread(THREAD_HANDLE);
 
@@ -197,6 +226,7 @@ namespace ffscript {
 	/// access to an element in static array
 	///
 	class ElementAccessCommand3 : public TargetedCommand {
+		friend class FlatCode;
 		int _elmSize;
 		int _arrayOffset;
 		bool _isAddress;
@@ -206,9 +236,11 @@ namespace ffscript {
 		ElementAccessCommand3(int arrayOffset, int returnOffset, int elmSize, bool isAddress);
 		virtual ~ElementAccessCommand3();
 		void buildCommandText(std::list<std::string>& strCommands);
-		virtual void execute();
+		virtual void execute(Context* context);
 		void setCommand1(TargetedCommand* command);
 		void setCommand2(TargetedCommand* command);
+		// compute address of the element after the array and index commands were run
+		void accessElement(Context* context);
 	};
 
 	///
@@ -216,13 +248,16 @@ namespace ffscript {
 	///
 	class ElementAccessForGlobalCommand : public TargetedCommand {
 		int _elmSize;
-		void* _arrayData;
+		// offset of the array in the global data, if the array is accessed by address
+		// the global variable at the offset stores address of the array
+		int _arrayOffset;
+		bool _isAddress;
 		TargetedCommand* _indexCommand;
 	public:
-		ElementAccessForGlobalCommand(void* arrayData, int returnOffset, int elmSize);
+		ElementAccessForGlobalCommand(int arrayOffset, int returnOffset, int elmSize, bool isAddress);
 		virtual ~ElementAccessForGlobalCommand();
 		void buildCommandText(std::list<std::string>& strCommands);
-		virtual void execute();
+		virtual void execute(Context* context);
 		void setIndexCommand(TargetedCommand* command);
 	};
 }
\ No newline at end of file
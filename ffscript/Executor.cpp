@@ -25,19 +25,48 @@
 
 namespace ffscript {
 
-	Executor::Executor(){}
+	Executor::Executor() : _frameSize(0), _globalData(nullptr) {
+		auto codeArena = CodeArena::getCurrent();
+		if (codeArena) {
+			_codeArena = codeArena->shared_from_this();
+		}
+	}
 	Executor::~Executor(){}	
 
 	void Executor::runCode() {
+		runCode(Context::getCurrent());
+	}
 
-		auto it = _commandList.begin();
+	void Executor::runCode(Context* context) {
+		// the commands access their frame without checking, so verify it once here
+		if (!context->prepareWrite(context->getCurrentOffset(), _frameSize)) {
+			return;
+		}
 		auto end = _commandList.end();
 
-		Context* currentContext = Context::getCurrent();
+		if (context->getGlobalData() || _globalData == nullptr) {
+			for (auto it = _commandList.begin(); it != end; ++it) {
+				(*it)->execute(context);
+			}
+			return;
+		}
 
-		for (auto it = _commandList.begin(); it != end; ++it) {
-			(*it)->execute();
+		// the context is not bound to any global data, run with the global data of the scope
+		context->setGlobalData(_globalData);
+		try {
+			for (auto it = _commandList.begin(); it != end; ++it) {
+				(*it)->execute(context);
+			}
+		}
+		catch (std::exception&) {
+			context->setGlobalData(nullptr);
+			throw;
 		}
+		context->setGlobalData(nullptr);
+	}
+
+	void* Executor::getGlobalData() const {
+		return _globalData;
 	}
 
 	CommandList* Executor::getCode() {
@@ -48,4 +77,23 @@ namespace ffscript {
 		_commandList.push_back(commandEntry);
 		_commandContainer.push_back(CommandRef(commandEntry));
 	}
+
+	void Executor::replaceCommand(InstructionCommand* oldCommand, InstructionCommand* newCommand) {
+		for (auto it = _commandList.begin(); it != _commandList.end(); ++it) {
+			if (*it == oldCommand) {
+				*it = newCommand;
+				_commandContainer.push_back(CommandRef(newCommand));
+				return;
+			}
+		}
+	}
+
+	MemoryBlock* Executor::findConstantBlock(const void* data) const {
+		for (auto& memoryBlock : _memoryBlocks) {
+			if (memoryBlock->getDataRef() == data) {
+				return memoryBlock.get();
+			}
+		}
+		return nullptr;
+	}
 }
\ No newline at end of file
@@ -17,23 +17,40 @@
 #include "function/DynamicFunction.h"
 #include "Context.h"
 #include "MemoryBlock.h"
+#include "CodeArena.h"
 
 namespace ffscript {
 	class Executor	{
 	
 	protected:
-	
+		// arena that keeps the commands, it must be released after the commands
+		CodeArenaRef _codeArena;
 		typedef shared_ptr<InstructionCommand> CommandRef;
 		std::list<CommandRef> _commandContainer;
 		std::list<MemoryBlockRef> _memoryBlocks;
 		CommandList _commandList;
+		// size of the data that the code accesses from current offset of the context
+		int _frameSize;
+		// base of global variables of the scope the code was extracted from, the code
+		// runs with it when the context does not have global data
+		void* _globalData;
 	public:
 		Executor();
 		virtual ~Executor();
 
 		virtual CommandList* getCode();
 		void addCommand(InstructionCommand*);
+		// replace a command in the code, the old command is still kept
+		// with the executor because the new command may use it
+		void replaceCommand(InstructionCommand* oldCommand, InstructionCommand* newCommand);
+		// find the constant block of the executor that stores the data, a buffer
+		// block stores plain data and an object block stores a string literal
+		MemoryBlock* findConstantBlock(const void* data) const;
 		void runCode();
+		// the code runs with global data of the context, or with global data of
+		// the scope it was extracted from if the context does not have any
+		void runCode(Context* context);
+		void* getGlobalData() const;
 	};
 
 	typedef std::shared_ptr<Executor> ExecutorRef;
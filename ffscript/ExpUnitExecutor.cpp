@@ -115,9 +115,8 @@ namespace ffscript {
 			MemberVariable* pMemberVariable = dynamic_cast<MemberVariable*>(pVariable);
 			if (pMemberVariable == nullptr) {
 				if (globalScope) {
-					void* paramData = globalScope->getGlobalAddress(pVariable->getOffset());
-					auto pushParamRefFunc = new PushParamRef();
-					pushParamRefFunc->setCommandData(paramData, returnOffset);
+					auto pushParamRefFunc = new PushGlobalParamRef();
+					pushParamRefFunc->setCommandData(pVariable->getOffset(), returnOffset);
 
 					assitFunction = pushParamRefFunc;
 				}
@@ -380,12 +379,16 @@ namespace ffscript {
 				scope->allocate(_localSize - memToRunCode);
 			}
 		}
+		_frameSize = getCurrentLocalOffset();
 		return (_returnOffset >= 0);
 	}
 #endif
 	void* ExpUnitExecutor::getReturnData() {
-		Context* currentContext = Context::getCurrent();
-		void* returnAdress = currentContext->getAbsoluteAddress(currentContext->getCurrentOffset() + _returnOffset);
+		return getReturnData(Context::getCurrent());
+	}
+
+	void* ExpUnitExecutor::getReturnData(Context* context) {
+		void* returnAdress = context->getAbsoluteAddress(context->getCurrentOffset() + _returnOffset);
 		return returnAdress;
 	}
 }
\ No newline at end of file
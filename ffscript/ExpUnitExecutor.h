@@ -32,6 +32,7 @@ namespace ffscript {
 	class ScriptFunction;
 	class TargetedCommand;
 	class OptimizedLogicCommand;
+	class NativeCommandFactory;
 
 	class ExpUnitExecutor :
 		public Executor
@@ -54,6 +55,8 @@ namespace ffscript {
 		bool extractCode(ScriptCompiler* compiler, const Expression* pExpression);
 		bool extractCode(ScriptCompiler* compiler, const ExecutableUnitRef& rootUnit);
 		void* getReturnData();
+		// get the result of the expression that was run on the given context
+		void* getReturnData(Context* context);
 		int getCurrentLocalOffset() const;
 		int getReturnOffset() const;
 		int getLocalSize() const;
@@ -67,6 +70,7 @@ namespace ffscript {
 		TargetedCommand* extractCodeForOperandRef(ScriptCompiler* scriptCompiler, const ExecutableUnitRef& node, int returnOffset);
 
 		void extractParamForNativeFunction(ScriptCompiler* scriptCompiler, FunctionCommand* commander, NativeFunction* expFunctionUnit, int beginParamOffset, int returnOffset);
+		TargetedCommand* extractParamForNativeOperator(ScriptCompiler* scriptCompiler, NativeCommandFactory* nativeCommandFactory, NativeFunction* expFunctionUnit, int beginParamOffset, int returnOffset);
 		void extractParamForDynamicFunction(ScriptCompiler* scriptCompiler, FunctionCommand* commander, NativeFunction* expFunctionUnit, int beginParamOffset, int returnOffset);
 		void extractParamScriptFunction(ScriptCompiler* scriptCompiler, FunctionCommand* commander, ScriptFunction* expFunctionUnit, int beginParamOffset, int returnOffset);
 		TargetedCommand* extractParamForForwardFunction(ScriptCompiler* scriptCompiler, Function* expFunctionUnit, int beginParamOffset, int returnOffset);
@@ -31,6 +31,7 @@
 #include "CommandTree.h"
 #include "MemberVariableAccessors.h"
 #include "LogicCommands.hpp"
+#include "NativeOperatorCommands.hpp"
 #include "DefaultCommands.h"
 #include "Supportfunctions.h"
 #include "CompositeConstrutorUnit.h"
@@ -55,8 +56,7 @@ namespace ffscript {
 
 		GlobalScope* globalScope = dynamic_cast<GlobalScope*>(ownerScope);
 		if (globalScope) {
-			void* address = globalScope->getGlobalAddress(pVariable->getOffset());
-			accessors->push_back(new MVGlobalAccessor(address));
+			accessors->push_back(new MVGlobalAccessor(pVariable->getOffset()));
 		}
 		else {
 			accessors->push_back(new MVContextAccessor());
@@ -91,9 +91,8 @@ namespace ffscript {
 			if (pMemberVariable == nullptr) {
 				GlobalScope* globalScope = dynamic_cast<GlobalScope*>(ownerScope);
 				if (globalScope) {
-					void* paramData = globalScope->getGlobalAddress(pVariable->getOffset());
-					auto pushParamRefFunc = new PushParam();
-					pushParamRefFunc->setCommandData(paramData, dataSize, returnOffset);
+					auto pushParamRefFunc = new PushGlobalParam();
+					pushParamRefFunc->setCommandData(pVariable->getOffset(), dataSize, returnOffset);
 
 					assitFunction = pushParamRefFunc;
 				}
@@ -176,9 +175,11 @@ namespace ffscript {
 
 			functionCommandTree->pushCommandParam(paramCommand);
 		}
+
 		const DFunction2Ref& nativeFunction = expFunctionUnit->getNative();
-		auto runNativeFuncFunc = new CallNativeFuntion();
+		CallNativeFuntion* runNativeFuncFunc;
 		if (expFunctionUnit->getType() == EXP_UNIT_ID_CREATE_THREAD) {
+			runNativeFuncFunc = new CallCreateThread();
 			auto newFunction = (CreateThreadCommand*)nativeFunction->clone();
 			ExecutableUnitRef& functionObjectUnit = expFunctionUnit->getChild(0);
 			auto functionType = functionObjectUnit->getReturnType().origin();
@@ -195,13 +196,103 @@ namespace ffscript {
 			runNativeFuncFunc->setCommandData(returnOffset, beginParamOffset, DFunction2Ref(newFunction));
 		}
 		else {
+			runNativeFuncFunc = new CallNativeFuntion();
 			runNativeFuncFunc->setCommandData(returnOffset, beginParamOffset, nativeFunction);
+			runNativeFuncFunc->setFunctionId(expFunctionUnit->getId());
 		}
 		runNativeFuncFunc->setFunctionName(expFunctionUnit->getName());
 		originCommand = runNativeFuncFunc;
 		functionCommandTree->setCommand(originCommand);		
 	}
 
+	// return the variable of an operand unit if its data is stored in current context
+	// at a fixed offset, so it can be accessed directly without copying to a param
+	static Variable* getLocalVariableOperand(const ExecutableUnitRef& unit) {
+		if (unit->getType() != EXP_UNIT_ID_XOPERAND) {
+			return nullptr;
+		}
+		Variable* pVariable = ((CXOperand*)unit.get())->getVariable();
+		if (dynamic_cast<MemberVariable*>(pVariable) || dynamic_cast<GlobalScope*>(pVariable->getScope()) || pVariable->getOffset() < 0) {
+			return nullptr;
+		}
+		return pVariable;
+	}
+
+	TargetedCommand* ExpUnitExecutor::extractParamForNativeOperator(ScriptCompiler* scriptCompiler, NativeCommandFactory* nativeCommandFactory, NativeFunction* expFunctionUnit, int beginParamOffset, int returnOffset) {
+		int n = expFunctionUnit->getChildCount();
+		int paramOffsets[NATIVE_OPERATOR_MAX_PARAM];
+		bool directRefs[NATIVE_OPERATOR_MAX_PARAM];
+		bool directParams[NATIVE_OPERATOR_MAX_PARAM];
+		int i;
+
+		// a param is read directly from its variable instead of copying to a param slot when
+		// the param is a reference of a local variable, the command always accesses it at run time,
+		// or the param is a local variable and no later param can change it before the operator run
+		bool laterParamsAreOperands = true;
+		for (i = n - 1; i >= 0; i--) {
+			ExecutableUnitRef& paramUnit = expFunctionUnit->getChild(i);
+			Variable* pVariable = nullptr;
+			directRefs[i] = false;
+
+			if (paramUnit->getType() == EXP_UNIT_ID_MAKE_REF) {
+				pVariable = getLocalVariableOperand(((RefFunction*)paramUnit.get())->getValueOfVariable());
+				directRefs[i] = pVariable != nullptr;
+			}
+			else if (laterParamsAreOperands) {
+				pVariable = getLocalVariableOperand(paramUnit);
+			}
+
+			directParams[i] = pVariable != nullptr;
+			if (pVariable) {
+				paramOffsets[i] = pVariable->getOffset();
+			}
+			if (ISFUNCTION(paramUnit) && !directParams[i]) {
+				laterParamsAreOperands = false;
+			}
+		}
+
+		// only params those are not read directly need slots in the local memory
+		int paramSize = 0;
+		int computedParamCount = 0;
+		for (i = 0; i < n; i++) {
+			if (directParams[i] == false) {
+				ExecutableUnitRef& paramUnit = expFunctionUnit->getChild(i);
+				paramOffsets[i] = beginParamOffset + paramSize;
+				paramSize += scriptCompiler->getTypeSizeInStack(paramUnit->getReturnType().iType());
+				computedParamCount++;
+			}
+		}
+		moveLocalOffset(paramSize);
+
+		FunctionCommand* functionCommandTree = nullptr;
+		if (computedParamCount == 1) {
+			functionCommandTree = new FunctionCommand1P();
+		}
+		else if (computedParamCount == 2) {
+			functionCommandTree = new FunctionCommand2P();
+		}
+
+		for (i = 0; i < n; i++) {
+			if (directParams[i] == false) {
+				ExecutableUnitRef& paramUnit = expFunctionUnit->getChild(i);
+				functionCommandTree->pushCommandParam(convert2Code2(scriptCompiler, paramUnit, paramOffsets[i]));
+			}
+		}
+
+		auto nativeCommand = nativeCommandFactory->createCommand(returnOffset, beginParamOffset);
+		for (i = 0; i < n; i++) {
+			nativeCommand->setParamOffset(i, paramOffsets[i], directRefs[i]);
+		}
+		nativeCommand->setFunctionName(expFunctionUnit->getName());
+		nativeCommand->setFunctionId(expFunctionUnit->getId());
+
+		if (functionCommandTree == nullptr) {
+			return nativeCommand;
+		}
+		functionCommandTree->setCommand(nativeCommand);
+		return functionCommandTree;
+	}
+
 	void ExpUnitExecutor::extractParamScriptFunction(ScriptCompiler* scriptCompiler, FunctionCommand* functionCommandTree, ScriptFunction* scriptFunction, int beginParamOffset, int returnOffset) {
 		int n = scriptFunction->getChildCount();
 		TargetedCommand* paramCommand;
@@ -231,29 +322,13 @@ namespace ffscript {
 		callScriptFunctionFunc->setFunctionName(scriptFunction->toString());
 
 		Program* program = scriptCompiler->getProgram();
-		bool found = false;
 		if (program) {
-			CodeSegmentEntry* pFunctionCode = program->getFunctionPlainCode(scriptFunction->getId());
-			if (pFunctionCode) {
-				callScriptFunctionFunc->setTargetCommand(pFunctionCode->first);
-				found = true;
-			}
+			// the entry is set when code of the function is laid out and again
+			// when the function is recompiled, so the call does not need to be updated
+			callScriptFunctionFunc->setFunctionEntry(program->getFunctionEntry(scriptFunction->getId()));
 		}
-
-		if (!found) {
-			auto updateLaterMan = CodeUpdater::getInstance(this->getScope());
-			if (updateLaterMan) {
-				////when this function is called, the command pointer of the script function is not determine yet
-				////so we need to add to update later list of program to complete the arguments.
-
-				auto updateScriptFunctionFunc = new FT::CachedFunctionDelegate<void, Program*, CallScriptFuntion2*, int>(CodeUpdater::updateScriptFunction);
-				updateScriptFunctionFunc->setArgs(program, callScriptFunctionFunc, scriptFunction->getId());
-
-				updateLaterMan->addUpdateLaterTask((DelegateRef)updateScriptFunctionFunc);
-			}
-			else {
-				callScriptFunctionFunc->setTargetCommand(nullptr);
-			}
+		else {
+			callScriptFunctionFunc->setTargetCommand(nullptr);
 		}
 
 		originCommand = callScriptFunctionFunc;
@@ -613,23 +688,21 @@ namespace ffscript {
 
 		TargetedCommand* copyCommand = nullptr;
 		TargetedCommand* mainCommand = nullptr;
-		void* paramData = nullptr;
 
 		if (globalScope) {
-			paramData = globalScope->getGlobalAddress(pVariable1->getOffset());
 			if (globalScope2) {
-				auto leaCommand = new LeaAddressToAddress();
-				leaCommand->setCommandData(globalScope2->getGlobalAddress(pVariable2->getOffset()), paramData);
+				auto leaCommand = new LeaGlobalToGlobal();
+				leaCommand->setCommandData(pVariable2->getOffset(), pVariable1->getOffset());
 
-				auto pushParam = new LeaAddressToOffset();
-				pushParam->setCommandData(globalScope2->getGlobalAddress(pVariable2->getOffset()), returnOffset);
+				auto pushParam = new LeaGlobalToOffset();
+				pushParam->setCommandData(pVariable2->getOffset(), returnOffset);
 
 				mainCommand = pushParam;
 				copyCommand = (TargetedCommand*)leaCommand;
 			}
 			else {
-				auto leaCommand = new LeaOffsetToAddress();
-				leaCommand->setCommandData(pVariable2->getOffset(), paramData);
+				auto leaCommand = new LeaOffsetToGlobal();
+				leaCommand->setCommandData(pVariable2->getOffset(), pVariable1->getOffset());
 
 				auto pushParam = new LeaOffsetToOffset();
 				pushParam->setCommandData(pVariable2->getOffset(), returnOffset);
@@ -640,12 +713,12 @@ namespace ffscript {
 		}
 		else {
 			if (globalScope2) {
-				auto pushParamRefFunc = new PushParamRef();
-				pushParamRefFunc->setCommandData(globalScope2->getGlobalAddress(pVariable2->getOffset()), pVariable1->getOffset());
+				auto pushParamRefFunc = new PushGlobalParamRef();
+				pushParamRefFunc->setCommandData(pVariable2->getOffset(), pVariable1->getOffset());
 				copyCommand = pushParamRefFunc;
 
-				auto pushParam = new LeaAddressToOffset();
-				pushParam->setCommandData(globalScope2->getGlobalAddress(pVariable2->getOffset()), returnOffset);
+				auto pushParam = new LeaGlobalToOffset();
+				pushParam->setCommandData(pVariable2->getOffset(), returnOffset);
 				mainCommand = pushParam;
 			}
 			else {
@@ -722,9 +795,9 @@ namespace ffscript {
 				param1Command = nullptr;
 			}
 			else {
-				auto copyGlobalStaticArrayCommand = dynamic_cast<PushParam*>(param1Command);
+				auto copyGlobalStaticArrayCommand = dynamic_cast<PushGlobalParam*>(param1Command);
 				if (copyGlobalStaticArrayCommand) {
-					auto acessCommand = new ElementAccessForGlobalCommand(copyGlobalStaticArrayCommand->getSourceData(), returnOffset, elemSize);
+					auto acessCommand = new ElementAccessForGlobalCommand(copyGlobalStaticArrayCommand->getSourceOffset(), returnOffset, elemSize, false);
 					delete param1Command;
 					param1Command = nullptr;
 					acessCommand->setIndexCommand(param2Command);
@@ -734,10 +807,10 @@ namespace ffscript {
 			}
 		}
 		else {
-			auto copyGlobalStaticArrayCommand = dynamic_cast<PushParam*>(param1Command);
+			auto copyGlobalStaticArrayCommand = dynamic_cast<PushGlobalParam*>(param1Command);
 			if (copyGlobalStaticArrayCommand) {
-				void** pArray = (void**)copyGlobalStaticArrayCommand->getSourceData();
-				auto acessCommand = new ElementAccessForGlobalCommand(*pArray, returnOffset, elemSize);
+				// the global variable stores address of the array
+				auto acessCommand = new ElementAccessForGlobalCommand(copyGlobalStaticArrayCommand->getSourceOffset(), returnOffset, elemSize, true);
 				delete param1Command;
 				param1Command = nullptr;
 				acessCommand->setIndexCommand(param2Command);
@@ -1046,6 +1119,17 @@ namespace ffscript {
 			NativeFunction* expFunctionUnit = dynamic_cast<NativeFunction*>(node.get());
 			int n = ((Function*)node.get())->getChildCount();
 
+			// built-in operators of primitive types are run by their specialized commands
+			// instead of calling through the native function object
+			NativeCommandFactory* nativeCommandFactory = nullptr;
+			if (expFunctionUnit && n <= NATIVE_OPERATOR_MAX_PARAM && !node->getUserData() &&
+				node->getType() != EXP_UNIT_ID_OPERATOR_LOGIC_AND && node->getType() != EXP_UNIT_ID_OPERATOR_LOGIC_OR) {
+				nativeCommandFactory = scriptCompiler->getNativeCommand(expFunctionUnit->getId());
+			}
+			if (nativeCommandFactory) {
+				return extractParamForNativeOperator(scriptCompiler, nativeCommandFactory, expFunctionUnit, beginParamOffset, returnOffset);
+			}
+
 			switch (n)
 			{
 			case 0:
@@ -1109,6 +1193,11 @@ namespace ffscript {
 				scope->allocate(_localSize - memToRunCode);
 			}
 		}
+		_frameSize = getCurrentLocalOffset();
+		auto globalScope = scope ? dynamic_cast<GlobalScope*>(scope->getRoot()) : nullptr;
+		if (globalScope) {
+			_globalData = globalScope->getGlobalAddress(0);
+		}
 		addCommand(assitFunction);
 		return (_returnOffset >= 0);
 	}
@@ -1136,9 +1225,7 @@ namespace ffscript {
 					auto userBlockRef = dynamic_pointer_cast<ObjectBlock<OperatorBuidInfo>>(node->getUserData());
 					OperatorBuidInfo* buildInfo = (OperatorBuidInfo*)userBlockRef->getDataRef();
 					if (buildInfo->operatorIndex >= 0) {
-						auto constructorTrigger = std::make_shared<FT::CachedFunctionDelegate<void, int>>(afterCallConstructor);
-						//push constructor index to function afterCallConstructor
-						constructorTrigger->setArgs(buildInfo->operatorIndex);
+						auto constructorTrigger = std::make_shared<AfterConstructorCall>(buildInfo->operatorIndex);
 						triggerCommand->setAfterTrigger(constructorTrigger, "setctor(" + std::to_string(buildInfo->operatorIndex) + ")");
 					}
 
@@ -1209,9 +1296,7 @@ namespace ffscript {
 					OperatorBuidInfo* buildInfo = (OperatorBuidInfo*)userBlockRef->getDataRef();
 					if (operatorType & UMASK_DESTRUCTOR) {
 						triggerCommand = new ConditionTriggerCommand();
-						auto destructorTrigger = std::make_shared<FT::CachedFunctionDelegate<unsigned char, int>>(beforeCallDestructor);
-						//push constructor index to function beforeCallDestructor
-						destructorTrigger->setArgs(buildInfo->operatorIndex);
+						auto destructorTrigger = std::make_shared<BeforeDestructorCall>(buildInfo->operatorIndex);
 						//set condition command
 						triggerCommand->setBeforeTrigger(destructorTrigger, "checkctor(" + std::to_string(buildInfo->operatorIndex) + ")");
 					}
@@ -820,14 +820,16 @@ namespace ffscript {
 						}
 					}
 					if (!foundRefType) {
-						if (scriptCompiler->findKeyword(stdtoken) != KEYWORD_UNKNOWN) {
+						// the token is looked up in several registries, it is interned once for all of them
+						int tokenSymbol = scriptCompiler->findSymbol(stdtoken);
+						if (scriptCompiler->findKeyword(tokenSymbol) != KEYWORD_UNKNOWN) {
 							eResult = EE_TOKEN_UNEXPECTED;
 							scriptCompiler->setErrorText("token '" + stdtoken + "' is not expected here");
 							break;
 						}
 
 						//try search constant name first
-						auto createConstantFunction = scriptCompiler->findConstantMap(stdtoken);
+						auto createConstantFunction = scriptCompiler->findConstantMap(tokenSymbol);
 						if (createConstantFunction) {
 							createConstantFunction->call();
 							pExpUnit = (ExecutableUnit*)createConstantFunction->getReturnValAsVoidPointer();
@@ -869,7 +871,7 @@ namespace ffscript {
 									pExpUnit = new CXOperand(currentScope, pVariable);
 								}
 								else {
-									auto operatorEntry = scriptCompiler->findPredefinedOperator(stdtoken);
+									auto operatorEntry = scriptCompiler->findPredefinedOperator(tokenSymbol);
 									if (operatorEntry
 										//bellow double check to make sure the declaration in pre-defined operator talbe have at least one instant of implementation in the library
 										/* && (scriptCompiler->findOverloadingFuncRoot(stdtoken) ||
@@ -0,0 +1,217 @@
+/******************************************************************
+* File:        ExpressionOptimizer.cpp
+* Description: implement ExpressionOptimizer class. A class that runs
+*              on a linked expression tree before its code is extracted.
+*              It folds built-in operators and castings of primitive
+*              types those have only constant operands into a single
+*              constant unit.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "ExpressionOptimizer.h"
+#include "ScriptCompiler.h"
+#include "BasicType.h"
+#include "expresion_defs.h"
+#include <string.h>
+
+namespace ffscript {
+
+	template <class TD>
+	static bool convertPrimitive(const BasicTypes& basicTypes, int sourceType, const void* source, TD& dest) {
+		if (sourceType == basicTypes.TYPE_INT) {
+			dest = (TD)*((const int*)source);
+		}
+		else if (sourceType == basicTypes.TYPE_LONG) {
+			dest = (TD)*((const long long*)source);
+		}
+		else if (sourceType == basicTypes.TYPE_FLOAT) {
+			dest = (TD)*((const float*)source);
+		}
+		else if (sourceType == basicTypes.TYPE_DOUBLE) {
+			dest = (TD)*((const double*)source);
+		}
+		else if (sourceType == basicTypes.TYPE_BOOL) {
+			// same as ConversionFactoryBoolTo
+			dest = (TD)(*((const bool*)source) ? 1 : 0);
+		}
+		else {
+			return false;
+		}
+		return true;
+	}
+
+	ExpressionOptimizer::ExpressionOptimizer(ScriptCompiler* scriptCompiler) : _scriptCompiler(scriptCompiler) {
+	}
+
+	ExpressionOptimizer::~ExpressionOptimizer() {
+	}
+
+	bool ExpressionOptimizer::isPrimitiveType(const ScriptType& type) const {
+		auto& basicTypes = _scriptCompiler->getTypeManager()->getBasicTypes();
+		int iType = type.iType();
+
+		return iType == basicTypes.TYPE_INT || iType == basicTypes.TYPE_LONG ||
+			iType == basicTypes.TYPE_FLOAT || iType == basicTypes.TYPE_DOUBLE ||
+			iType == basicTypes.TYPE_BOOL;
+	}
+
+	bool ExpressionOptimizer::isConstantOperand(const ExecutableUnitRef& unit) const {
+		return unit && unit->getType() == EXP_UNIT_ID_CONST && isPrimitiveType(unit->getReturnType());
+	}
+
+	ExecutableUnitRef ExpressionOptimizer::createConstant(const ScriptType& type, const void* value) const {
+		auto& basicTypes = _scriptCompiler->getTypeManager()->getBasicTypes();
+		int iType = type.iType();
+
+		// use same data types of constant units that created by the expression parser
+		if (iType == basicTypes.TYPE_INT) {
+			return std::make_shared<CConstOperand<int>>(*((const int*)value), type);
+		}
+		if (iType == basicTypes.TYPE_LONG) {
+			return std::make_shared<CConstOperand<__int64>>(*((const __int64*)value), type);
+		}
+		if (iType == basicTypes.TYPE_FLOAT) {
+			return std::make_shared<CConstOperand<float>>(*((const float*)value), type);
+		}
+		if (iType == basicTypes.TYPE_DOUBLE) {
+			return std::make_shared<CConstOperand<double>>(*((const double*)value), type);
+		}
+		if (iType == basicTypes.TYPE_BOOL) {
+			return std::make_shared<CConstOperand<bool>>(*((const bool*)value), type);
+		}
+		return nullptr;
+	}
+
+	ExecutableUnitRef ExpressionOptimizer::foldOperator(Function* function) const {
+		// only built-in operators of primitive types have native commands
+		// and they have no side effect when their params are passed by value
+		if (_scriptCompiler->getNativeCommand(function->getId()) == nullptr) {
+			return nullptr;
+		}
+		auto nativeFunction = dynamic_cast<NativeFunction*>(function);
+		if (nativeFunction == nullptr || !nativeFunction->getNative()) {
+			return nullptr;
+		}
+
+		auto& typeManager = _scriptCompiler->getTypeManager();
+		auto& basicTypes = typeManager->getBasicTypes();
+		auto& returnType = function->getReturnType();
+		int n = function->getChildCount();
+
+		// the buffer is enough for parameters of unary and binary operators
+		void* paramBuffer[4];
+		char* param = (char*)paramBuffer;
+		char* paramEnd = param + sizeof(paramBuffer);
+
+		for (int i = 0; i < n; i++) {
+			auto& child = function->getChild(i);
+			auto& childType = child->getReturnType();
+			int paramSize = typeManager->getTypeSizeInStack(childType.iType());
+			int dataSize = ((ConstOperandBase*)child.get())->getDataSize();
+			if (param + paramSize > paramEnd || dataSize > paramSize) {
+				return nullptr;
+			}
+			memcpy(param, child->Execute(), dataSize);
+			param += paramSize;
+		}
+
+		// don't fold integer divisions those may raise an exception at compile time
+		auto& name = function->getName();
+		if (n == 2 && (name == "/" || name == "%")) {
+			auto& divisor = function->getChild(1);
+			long long divisorValue;
+			int divisorType = divisor->getReturnType().iType();
+			if (divisorType == basicTypes.TYPE_INT || divisorType == basicTypes.TYPE_LONG) {
+				convertPrimitive(basicTypes, divisorType, divisor->Execute(), divisorValue);
+				if (divisorValue == 0 || divisorValue == -1) {
+					return nullptr;
+				}
+			}
+		}
+
+		double returnBuffer[2];
+		nativeFunction->getNative()->call(returnBuffer, paramBuffer);
+
+		return createConstant(returnType, returnBuffer);
+	}
+
+	ExecutableUnitRef ExpressionOptimizer::foldCasting(Function* function) const {
+		if (dynamic_cast<CastingFunction*>(function) == nullptr || function->getChildCount() != 1) {
+			return nullptr;
+		}
+		auto& basicTypes = _scriptCompiler->getTypeManager()->getBasicTypes();
+		auto& child = function->getChild(0);
+		int sourceType = child->getReturnType().iType();
+		const void* source = child->Execute();
+		auto& returnType = function->getReturnType();
+		int targetType = returnType.iType();
+
+		if (targetType == basicTypes.TYPE_INT) {
+			int value;
+			if (convertPrimitive(basicTypes, sourceType, source, value)) return createConstant(returnType, &value);
+		}
+		else if (targetType == basicTypes.TYPE_LONG) {
+			__int64 value;
+			if (convertPrimitive(basicTypes, sourceType, source, value)) return createConstant(returnType, &value);
+		}
+		else if (targetType == basicTypes.TYPE_FLOAT) {
+			float value;
+			if (convertPrimitive(basicTypes, sourceType, source, value)) return createConstant(returnType, &value);
+		}
+		else if (targetType == basicTypes.TYPE_DOUBLE) {
+			double value;
+			if (convertPrimitive(basicTypes, sourceType, source, value)) return createConstant(returnType, &value);
+		}
+		else if (targetType == basicTypes.TYPE_BOOL) {
+			// same as ConversionFactoryToBool
+			double value;
+			if (convertPrimitive(basicTypes, sourceType, source, value)) {
+				bool boolValue = value != 0;
+				return createConstant(returnType, &boolValue);
+			}
+		}
+		return nullptr;
+	}
+
+	int ExpressionOptimizer::foldConstants(ExecutableUnitRef& unit) const {
+		if (!unit || !ISFUNCTION(unit)) {
+			return 0;
+		}
+
+		auto function = (Function*)unit.get();
+		int foldedCount = 0;
+		int n = function->getChildCount();
+		bool allConstant = true;
+
+		// fold children first, so an operator can be folded
+		// when its operands are constant sub trees
+		for (int i = 0; i < n; i++) {
+			auto& child = function->getChild(i);
+			foldedCount += foldConstants(child);
+			allConstant = allConstant && isConstantOperand(child);
+		}
+
+		// units those have extra build info or results are not primitive are kept
+		if (n == 0 || !allConstant || function->getUserData() || !isPrimitiveType(function->getReturnType())) {
+			return foldedCount;
+		}
+
+		ExecutableUnitRef constantUnit = foldOperator(function);
+		if (!constantUnit) {
+			constantUnit = foldCasting(function);
+		}
+		if (constantUnit) {
+			// keep origin source char in new expression unit
+			constantUnit->setSourceCharIndex(unit->getSourceCharIndex());
+			unit = constantUnit;
+			foldedCount++;
+		}
+
+		return foldedCount;
+	}
+}
@@ -0,0 +1,40 @@
+/******************************************************************
+* File:        ExpressionOptimizer.h
+* Description: declare ExpressionOptimizer class. A class that runs
+*              on a linked expression tree before its code is extracted.
+*              It folds built-in operators and castings of primitive
+*              types those have only constant operands into a single
+*              constant unit.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "expressionunit.h"
+
+namespace ffscript {
+	class ScriptCompiler;
+
+	class ExpressionOptimizer
+	{
+		ScriptCompiler* _scriptCompiler;
+	private:
+		bool isConstantOperand(const ExecutableUnitRef& unit) const;
+		ExecutableUnitRef foldOperator(Function* function) const;
+		ExecutableUnitRef foldCasting(Function* function) const;
+	public:
+		ExpressionOptimizer(ScriptCompiler* scriptCompiler);
+		virtual ~ExpressionOptimizer();
+
+		bool isPrimitiveType(const ScriptType& type) const;
+		ExecutableUnitRef createConstant(const ScriptType& type, const void* value) const;
+
+		// replace constant sub trees of the unit by constant units
+		// return number of function units were folded
+		int foldConstants(ExecutableUnitRef& unit) const;
+	};
+}
@@ -56,6 +56,11 @@ namespace ffscript {
 			return (int)(_p - _data) + 1;
 		}
 
+		// drop elements on top of the stack to return to a smaller size
+		inline void shrink(int size) {
+			_p = _data + size - 1;
+		}
+
 		inline const T* begin() const {
 			return _data;
 		}
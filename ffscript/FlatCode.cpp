@@ -0,0 +1,492 @@
+/******************************************************************
+* File:        FlatCode.cpp
+* Description: implement FlatCode class. A class that serializes the
+*              command trees of a program into linear sequences of
+*              fixed-size records. Records of all trees are stored in
+*              one contiguous buffer and each sequence is run by a loop
+*              instead of recursive execute calls of the tree nodes.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "FlatCode.h"
+#include "CommandTree.h"
+#include "DefaultCommands.h"
+#include "Context.h"
+#include "NativeOperatorCommands.hpp"
+#include <typeinfo>
+#include <istream>
+#include <ostream>
+#include <string.h>
+#include <string>
+
+namespace ffscript {
+
+	static const char* s_pushNames[] = { "PushParam", "PushParamOffset", "PushParamRefOffset" };
+	static const char* s_commandKindNames[] = { "NativeOperator", "CallNative", "Other" };
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	bool FusionPattern::operator<(const FusionPattern& other) const {
+		if (pushOpCode != other.pushOpCode) {
+			return pushOpCode < other.pushOpCode;
+		}
+		return commandKind < other.commandKind;
+	}
+
+	const char* FusionPattern::getPushName() const {
+		return s_pushNames[(int)pushOpCode - (int)FlatOpCode::PushParam];
+	}
+
+	const char* FusionPattern::getCommandKindName() const {
+		return s_commandKindNames[(int)commandKind];
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	void FusionTable::addPattern(const FusionPattern& pattern) {
+		_patterns.insert(pattern);
+	}
+
+	bool FusionTable::contains(const FusionPattern& pattern) const {
+		return _patterns.find(pattern) != _patterns.end();
+	}
+
+	int FusionTable::getPatternCount() const {
+		return (int)_patterns.size();
+	}
+
+	static FusionTable createDefaultTable() {
+		FusionTable fusionTable;
+		// operands of built-in operators and native functions
+		// are pushed right before they are called
+		for (auto push : { FlatOpCode::PushParam, FlatOpCode::PushParamOffset, FlatOpCode::PushParamRefOffset }) {
+			fusionTable.addPattern({ push, FlatCommandKind::NativeOperator });
+			fusionTable.addPattern({ push, FlatCommandKind::CallNative });
+		}
+		return fusionTable;
+	}
+
+	const FusionTable& FusionTable::getDefault() {
+		// the table is filled by the initializer of the static,
+		// so threads those flatten code at same time see a complete table
+		static const FusionTable defaultTable = createDefaultTable();
+		return defaultTable;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	std::atomic<long long>* FlatProfile::getCounter(const FusionPattern& pattern) {
+		return &_counts[pattern];
+	}
+
+	long long FlatProfile::getCount(const FusionPattern& pattern) const {
+		auto it = _counts.find(pattern);
+		return it == _counts.end() ? 0 : it->second.load();
+	}
+
+	void FlatProfile::buildFusionTable(FusionTable& fusionTable, long long minCount) const {
+		for (auto& item : _counts) {
+			if (item.second >= minCount) {
+				fusionTable.addPattern(item.first);
+			}
+		}
+	}
+
+	void FlatProfile::save(std::ostream& stream) const {
+		for (auto& item : _counts) {
+			stream << item.first.getPushName() << " " << item.first.getCommandKindName() << " " << item.second.load() << std::endl;
+		}
+	}
+
+	bool FlatProfile::load(std::istream& stream) {
+		std::string pushName, commandKindName;
+		long long count;
+		while (stream >> pushName >> commandKindName >> count) {
+			int push = 0, commandKind = 0;
+			while (push < 3 && pushName != s_pushNames[push]) push++;
+			while (commandKind < (int)FlatCommandKind::KindCount && commandKindName != s_commandKindNames[commandKind]) commandKind++;
+			if (push == 3 || commandKind == (int)FlatCommandKind::KindCount) {
+				return false;
+			}
+			FusionPattern pattern = { (FlatOpCode)((int)FlatOpCode::PushParam + push), (FlatCommandKind)commandKind };
+			_counts[pattern] += count;
+		}
+		return stream.eof();
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	FlatCommand::FlatCommand(TargetedCommand* rootCommand, const FlatRecord* begin, const FlatRecord* end) :
+		TargetedCommand(rootCommand->getTargetOffset(), rootCommand->getTargetSize()),
+		_begin(begin), _end(end), _rootCommand(rootCommand) {}
+
+	FlatCommand::~FlatCommand() {}
+
+	void FlatCommand::buildCommandText(std::list<std::string>& strCommands) {
+		_rootCommand->buildCommandText(strCommands);
+	}
+
+	void FlatCommand::execute(Context* context) {
+		const FlatRecord* record = _begin;
+		int currentOffset;
+		bool* result;
+
+		// the statement called a script function in its middle and the function has returned
+		auto resumePoint = (const FlatRecord*)context->getResumePoint();
+		if (resumePoint) {
+			record = resumePoint;
+			context->setResumePoint(nullptr);
+		}
+
+		while (record < _end) {
+			switch (record->opCode)
+			{
+			case FlatOpCode::Execute:
+				record->command->execute(context);
+				record++;
+				break;
+			case FlatOpCode::ShortCut:
+				currentOffset = context->getCurrentOffset();
+				if (((OptimizedLogicCommand*)record->command)->testParam1(context->getAbsoluteAddress(currentOffset + record->sourceOffset)) == record->value) {
+					result = (bool*)context->getAbsoluteAddress(currentOffset + record->targetOffset);
+					*result = record->value;
+					record += record->skip;
+				}
+				else {
+					record++;
+				}
+				break;
+			case FlatOpCode::StoreParam2:
+				currentOffset = context->getCurrentOffset();
+				result = (bool*)context->getAbsoluteAddress(currentOffset + record->targetOffset);
+				*result = ((OptimizedLogicCommand*)record->command)->testParam2(context->getAbsoluteAddress(currentOffset + record->sourceOffset));
+				record++;
+				break;
+			case FlatOpCode::SkipIfFalse:
+				if (*(bool*)context->getAbsoluteAddress(context->getCurrentOffset() + record->sourceOffset)) {
+					record++;
+				}
+				else {
+					record += record->skip;
+				}
+				break;
+			case FlatOpCode::Skip:
+				record += record->skip;
+				break;
+			case FlatOpCode::ElementAccess:
+				((ElementAccessCommand3*)record->command)->accessElement(context);
+				record++;
+				break;
+			case FlatOpCode::EnterFunction:
+				if (record + 1 < _end) {
+					// the rest of the statement uses result of the function, so the function
+					// returns to the command before this statement and the loop runs this
+					// statement again from the next record
+					context->setResumePoint(record + 1);
+					context->setCurrentCommand(context->getCurrentCommand() - 1);
+				}
+				((CallScriptFuntion2*)record->command)->enterFunction(context);
+				// the loop moves to next command after this statement, so stop one command
+				// before the function to let the loop start the function at its first command
+				context->setCurrentCommand(context->getCurrentCommand() - 1);
+				return;
+			case FlatOpCode::PushParam:
+				context->writeFrame(context->getCurrentOffset() + record->targetOffset, record->pointer, record->size);
+				record++;
+				break;
+			case FlatOpCode::PushParamOffset:
+				currentOffset = context->getCurrentOffset();
+				context->writeFrame(currentOffset + record->targetOffset, context->getAbsoluteAddress(currentOffset + record->sourceOffset), record->size);
+				record++;
+				break;
+			case FlatOpCode::PushParamRefOffset:
+				currentOffset = context->getCurrentOffset();
+				context->lea(currentOffset + record->targetOffset, context->getAbsoluteAddress(currentOffset + record->sourceOffset));
+				record++;
+				break;
+			case FlatOpCode::PushParamExecute:
+				context->writeFrame(context->getCurrentOffset() + record->targetOffset, record->pointer, record->size);
+				(record + 1)->command->execute(context);
+				record += 2;
+				break;
+			case FlatOpCode::PushParamOffsetExecute:
+				currentOffset = context->getCurrentOffset();
+				context->writeFrame(currentOffset + record->targetOffset, context->getAbsoluteAddress(currentOffset + record->sourceOffset), record->size);
+				(record + 1)->command->execute(context);
+				record += 2;
+				break;
+			case FlatOpCode::PushParamRefOffsetExecute:
+				currentOffset = context->getCurrentOffset();
+				context->lea(currentOffset + record->targetOffset, context->getAbsoluteAddress(currentOffset + record->sourceOffset));
+				(record + 1)->command->execute(context);
+				record += 2;
+				break;
+			case FlatOpCode::CountPattern:
+				((std::atomic<long long>*)record->pointer)->fetch_add(1, std::memory_order_relaxed);
+				record->command->execute(context);
+				record++;
+				break;
+			case FlatOpCode::PushGlobalParam:
+				context->writeFrame(context->getCurrentOffset() + record->targetOffset, context->getGlobalData() + record->sourceOffset, record->size);
+				record++;
+				break;
+			case FlatOpCode::PushGlobalParamRef:
+				context->lea(context->getCurrentOffset() + record->targetOffset, context->getGlobalData() + record->sourceOffset);
+				record++;
+				break;
+			default:
+				record++;
+				break;
+			}
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	FlatCode::FlatCode(CommandPointer codeBegin, CommandPointer codeEnd, const std::list<CodeSegmentEntry>& functionCodes) : _fusedCount(0) {
+		struct FlatRoot {
+			CommandPointer commandPointer;
+			int begin;
+			int end;
+		};
+		std::vector<FlatRoot> flatRoots;
+
+		// commands of functions are run by loops those follow jumps, global commands are not
+		std::vector<bool> inFunction(codeEnd - codeBegin, false);
+		for (auto& functionCode : functionCodes) {
+			for (CommandPointer commandPointer = functionCode.first; commandPointer <= functionCode.second; ++commandPointer) {
+				if (commandPointer >= codeBegin && commandPointer < codeEnd) {
+					inFunction[commandPointer - codeBegin] = true;
+				}
+			}
+		}
+
+		for (CommandPointer commandPointer = codeBegin; commandPointer < codeEnd; ++commandPointer) {
+			if (*commandPointer == nullptr) continue;
+
+			int begin = (int)_records.size();
+			flattenCommand(*commandPointer);
+			int end = (int)_records.size();
+
+			// script functions called by statements of functions are entered and run by the loop
+			// of the context without nested loops, the statement continues when they return
+			bool enterFunction = false;
+			if (inFunction[commandPointer - codeBegin]) {
+				for (int i = begin; i < end; i++) {
+					if (canEnterFunction(_records[i])) {
+						_records[i].opCode = FlatOpCode::EnterFunction;
+						enterFunction = true;
+					}
+				}
+			}
+
+			// a single record is the root itself, there is nothing to flatten
+			if (end - begin > 1 || enterFunction) {
+				flatRoots.push_back({ commandPointer, begin, end });
+			}
+			else {
+				_records.resize(begin);
+			}
+		}
+
+		// all records are added, the buffer will not be moved anymore
+		_records.shrink_to_fit();
+		_flatCommands.reserve(flatRoots.size());
+		const FlatRecord* records = _records.data();
+
+		for (auto& flatRoot : flatRoots) {
+			auto flatCommand = new FlatCommand((TargetedCommand*)*flatRoot.commandPointer, records + flatRoot.begin, records + flatRoot.end);
+			_flatCommands.push_back(flatCommand);
+			*flatRoot.commandPointer = flatCommand;
+		}
+		fuseRecords(FusionTable::getDefault());
+	}
+
+	FlatCode::~FlatCode() {
+		for (auto flatCommand : _flatCommands) {
+			delete flatCommand;
+		}
+	}
+
+	bool FlatCode::lowerRecord(FlatRecord& record) {
+		// only lower the exact command types, derived commands
+		// may override execute method with other behaviors
+		const std::type_info& commandType = typeid(*record.command);
+
+		if (commandType == typeid(PushParam)) {
+			auto pushParam = (PushParam*)record.command;
+			record.opCode = FlatOpCode::PushParam;
+			record.pointer = pushParam->_param;
+			record.targetOffset = pushParam->getTargetOffset();
+			record.size = pushParam->getTargetSize();
+		}
+		else if (commandType == typeid(PushParamOffset)) {
+			auto pushParamOffset = (PushParamOffset*)record.command;
+			record.opCode = FlatOpCode::PushParamOffset;
+			record.sourceOffset = pushParamOffset->_sourceOffset;
+			record.targetOffset = pushParamOffset->getTargetOffset();
+			record.size = pushParamOffset->getTargetSize();
+		}
+		else if (commandType == typeid(PushParamRefOffset) || commandType == typeid(LeaOffsetToOffset)) {
+			// both commands store address of source offset to target offset
+			record.opCode = FlatOpCode::PushParamRefOffset;
+			record.sourceOffset = commandType == typeid(PushParamRefOffset) ?
+				((PushParamRefOffset*)record.command)->_sourceOffset : ((LeaOffsetToOffset*)record.command)->_sourceOffset;
+			record.targetOffset = ((TargetedCommand*)record.command)->getTargetOffset();
+		}
+		else if (commandType == typeid(PushGlobalParam)) {
+			auto pushParam = (PushGlobalParam*)record.command;
+			record.opCode = FlatOpCode::PushGlobalParam;
+			record.sourceOffset = pushParam->_sourceOffset;
+			record.targetOffset = pushParam->getTargetOffset();
+			record.size = pushParam->getTargetSize();
+		}
+		else if (commandType == typeid(PushGlobalParamRef) || commandType == typeid(LeaGlobalToOffset)) {
+			// both commands store address of a global variable to target offset
+			record.opCode = FlatOpCode::PushGlobalParamRef;
+			record.sourceOffset = commandType == typeid(PushGlobalParamRef) ?
+				((PushGlobalParamRef*)record.command)->_sourceOffset : ((LeaGlobalToOffset*)record.command)->_sourceOffset;
+			record.targetOffset = ((TargetedCommand*)record.command)->getTargetOffset();
+		}
+		else {
+			return false;
+		}
+		return true;
+	}
+
+	FlatCommandKind FlatCode::getCommandKind(InstructionCommand* command) {
+		if (dynamic_cast<NativeOperatorCommand*>(command)) {
+			return FlatCommandKind::NativeOperator;
+		}
+		if (typeid(*command) == typeid(CallNativeFuntion)) {
+			return FlatCommandKind::CallNative;
+		}
+		return FlatCommandKind::Other;
+	}
+
+	void FlatCode::fuseRecords(const FusionTable& fusionTable, FlatProfile* profile) {
+		// push commands never become control records, so records of them
+		// can be lowered again from their commands whatever they were fused or not
+		FlatRecord* end = _records.data() + _records.size();
+		for (FlatRecord* record = _records.data(); record < end; record++) {
+			lowerRecord(*record);
+		}
+
+		_fusedCount = 0;
+		for (auto flatCommand : _flatCommands) {
+			// records of a pattern must be in same statement
+			FlatRecord* begin = _records.data() + (flatCommand->getBegin() - _records.data());
+			FlatRecord* last = begin + flatCommand->getRecordCount() - 1;
+			for (FlatRecord* record = begin; record < last; record++) {
+				auto next = record + 1;
+				if (record->opCode < FlatOpCode::PushParam || record->opCode > FlatOpCode::PushParamRefOffset || next->opCode != FlatOpCode::Execute) {
+					continue;
+				}
+				FusionPattern pattern = { record->opCode, getCommandKind(next->command) };
+				if (profile) {
+					record->opCode = FlatOpCode::CountPattern;
+					record->pointer = profile->getCounter(pattern);
+				}
+				else if (fusionTable.contains(pattern)) {
+					record->opCode = (FlatOpCode)((int)record->opCode - (int)FlatOpCode::PushParam + (int)FlatOpCode::PushParamExecute);
+					_fusedCount++;
+				}
+			}
+		}
+	}
+
+	bool FlatCode::canEnterFunction(const FlatRecord& record) {
+		if (record.opCode != FlatOpCode::Execute) {
+			return false;
+		}
+		const std::type_info& commandType = typeid(*record.command);
+		return commandType == typeid(CallScriptFuntion3) || commandType == typeid(CallLambdaFuntion);
+	}
+
+	void FlatCode::addRecord(FlatOpCode opCode, InstructionCommand* command) {
+		FlatRecord record;
+		memset(&record, 0, sizeof(record));
+		record.opCode = opCode;
+		record.command = command;
+		_records.push_back(record);
+	}
+
+	void FlatCode::flattenCommand(InstructionCommand* command) {
+		if (command == nullptr) return;
+
+		// only flatten the exact tree types, derived commands
+		// may override execute method with other behaviors
+		const std::type_info& commandType = typeid(*command);
+
+		if (commandType == typeid(FunctionCommand0P)) {
+			flattenCommand(((FunctionCommand0P*)command)->_command);
+		}
+		else if (commandType == typeid(FunctionCommand1P)) {
+			auto functionCommand = (FunctionCommand1P*)command;
+			flattenCommand(functionCommand->_commandParam);
+			flattenCommand(functionCommand->_command);
+		}
+		else if (commandType == typeid(FunctionCommand2P)) {
+			auto functionCommand = (FunctionCommand2P*)command;
+			flattenCommand(functionCommand->_commandParam1);
+			flattenCommand(functionCommand->_commandParam2);
+			flattenCommand(functionCommand->_command);
+		}
+		else if (commandType == typeid(FunctionCommandNP)) {
+			auto functionCommand = (FunctionCommandNP*)command;
+			TargetedCommand** param = functionCommand->_commandParams;
+			TargetedCommand** end = param + functionCommand->_nParam;
+			while (param < end) {
+				flattenCommand(*param);
+				param++;
+			}
+			flattenCommand(functionCommand->_command);
+		}
+		else if (commandType == typeid(ConditionalCommand)) {
+			auto conditionalCommand = (ConditionalCommand*)command;
+			flattenCommand(conditionalCommand->_conditionUnit);
+
+			int skipIfIndex = (int)_records.size();
+			addRecord(FlatOpCode::SkipIfFalse, command);
+			_records[skipIfIndex].sourceOffset = conditionalCommand->_conditionUnit->getTargetOffset();
+			flattenCommand(conditionalCommand->_ifUnit);
+
+			int skipElseIndex = (int)_records.size();
+			addRecord(FlatOpCode::Skip, command);
+			_records[skipIfIndex].skip = (int)_records.size() - skipIfIndex;
+			flattenCommand(conditionalCommand->_elseUnit);
+			_records[skipElseIndex].skip = (int)_records.size() - skipElseIndex;
+		}
+		else if (commandType == typeid(ElementAccessCommand3)) {
+			auto elementAccess = (ElementAccessCommand3*)command;
+			if (elementAccess->_command1) {
+				flattenCommand(elementAccess->_command1);
+			}
+			flattenCommand(elementAccess->_command2);
+			addRecord(FlatOpCode::ElementAccess, command);
+		}
+		else if (auto logicCommand = dynamic_cast<OptimizedLogicCommand*>(command)) {
+			// logic commands describe how they test their params by virtual methods,
+			// so the templated commands of other param types can be flattened too
+			flattenCommand(logicCommand->_commandParam1);
+
+			int shortCutIndex = (int)_records.size();
+			addRecord(FlatOpCode::ShortCut, command);
+			auto& shortCut = _records[shortCutIndex];
+			shortCut.value = logicCommand->getShortCutValue();
+			shortCut.sourceOffset = logicCommand->_commandParam1->getTargetOffset();
+			shortCut.targetOffset = logicCommand->getTargetOffset();
+
+			flattenCommand(logicCommand->_commandParam2);
+			addRecord(FlatOpCode::StoreParam2, command);
+			auto& storeParam = _records.back();
+			storeParam.sourceOffset = logicCommand->_commandParam2->getTargetOffset();
+			storeParam.targetOffset = logicCommand->getTargetOffset();
+
+			_records[shortCutIndex].skip = (int)_records.size() - shortCutIndex;
+		}
+		else {
+			addRecord(FlatOpCode::Execute, command);
+		}
+	}
+}
@@ -0,0 +1,161 @@
+/******************************************************************
+* File:        FlatCode.h
+* Description: declare FlatCode class. A class that serializes the
+*              command trees of a program into linear sequences of
+*              fixed-size records. Records of all trees are stored in
+*              one contiguous buffer and each sequence is run by a loop
+*              instead of recursive execute calls of the tree nodes.
+*              Frequent record patterns are fused into superinstructions.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "InstructionCommand.h"
+#include <vector>
+#include <list>
+#include <set>
+#include <map>
+#include <iosfwd>
+#include <atomic>
+
+namespace ffscript {
+
+	enum class FlatOpCode : unsigned char {
+		// call virtual execute method of a leaf command
+		Execute = 0,
+		// first param of a logic command decides the result, skip second param
+		ShortCut,
+		// store second param of a logic command to the result
+		StoreParam2,
+		// skip records when the condition is false
+		SkipIfFalse,
+		Skip,
+		// compute element address after array and index commands were run
+		ElementAccess,
+		// enter a script function called by a statement, the function is run by the loop
+		// that runs the statement instead of a nested loop, the statement continues
+		// from the next record when the function returns
+		EnterFunction,
+		// push commands, their operands are stored in the record
+		PushParam,
+		PushParamOffset,
+		PushParamRefOffset,
+		// superinstructions, a push command and the command of next record
+		// are run by one record, the next record is kept for records those skip to it
+		PushParamExecute,
+		PushParamOffsetExecute,
+		PushParamRefOffsetExecute,
+		// counting mode, count the pattern of this record and next record then run the command
+		CountPattern,
+		// push commands of global variables, their sources are offsets from the global data
+		// of the context. They are not fused, so they are placed after the fusion range
+		PushGlobalParam,
+		PushGlobalParamRef,
+	};
+
+	// kind of the command follows a push command in a pattern
+	enum class FlatCommandKind : unsigned char {
+		NativeOperator = 0,
+		CallNative,
+		Other,
+		KindCount
+	};
+
+	struct FusionPattern {
+		FlatOpCode pushOpCode;
+		FlatCommandKind commandKind;
+
+		bool operator<(const FusionPattern& other) const;
+		const char* getPushName() const;
+		const char* getCommandKindName() const;
+	};
+
+	// patterns of command sequences those are fused into superinstructions
+	class FusionTable {
+		std::set<FusionPattern> _patterns;
+	public:
+		void addPattern(const FusionPattern& pattern);
+		bool contains(const FusionPattern& pattern) const;
+		int getPatternCount() const;
+		// built-in table for loops and conditions, such as 'i += 1' and 'i < n + 1'
+		static const FusionTable& getDefault();
+	};
+
+	// number of times each pattern was run, it is collected by running flat code in counting mode
+	class FlatProfile {
+		// counters are atomic, tasks those run same flat code count concurrently
+		std::map<FusionPattern, std::atomic<long long>> _counts;
+	public:
+		std::atomic<long long>* getCounter(const FusionPattern& pattern);
+		long long getCount(const FusionPattern& pattern) const;
+		// fill the table by patterns those were run at least minCount times
+		void buildFusionTable(FusionTable& fusionTable, long long minCount) const;
+		// text format, each line is a pattern and its count: <push> <command kind> <count>
+		void save(std::ostream& stream) const;
+		bool load(std::istream& stream);
+	};
+
+	struct FlatRecord {
+		FlatOpCode opCode;
+		// short cut value of logic commands
+		bool value;
+		// offset of the source data or condition, relative to current offset
+		int sourceOffset;
+		// offset of the target data, relative to current offset
+		int targetOffset;
+		// number of records will be skipped, counted from this record
+		int skip;
+		// size of the data will be pushed
+		int size;
+		// address of the pushed constant, or counter of the pattern in counting mode
+		void* pointer;
+		InstructionCommand* command;
+	};
+
+	class FlatCommand : public TargetedCommand {
+		const FlatRecord* _begin;
+		const FlatRecord* _end;
+		// origin root of the tree, it is used to build command text
+		TargetedCommand* _rootCommand;
+	public:
+		FlatCommand(TargetedCommand* rootCommand, const FlatRecord* begin, const FlatRecord* end);
+		virtual ~FlatCommand();
+		virtual void execute(Context* context);
+		virtual void buildCommandText(std::list<std::string>& strCommands);
+		inline TargetedCommand* getRootCommand() const { return _rootCommand; }
+		inline const FlatRecord* getBegin() const { return _begin; }
+		inline int getRecordCount() const { return (int)(_end - _begin); }
+	};
+
+	class FlatCode
+	{
+		std::vector<FlatRecord> _records;
+		std::vector<FlatCommand*> _flatCommands;
+		int _fusedCount;
+	private:
+		void flattenCommand(InstructionCommand* command);
+		void addRecord(FlatOpCode opCode, InstructionCommand* command);
+		static bool canEnterFunction(const FlatRecord& record);
+		static bool lowerRecord(FlatRecord& record);
+		static FlatCommandKind getCommandKind(InstructionCommand* command);
+	public:
+		// flatten command trees in the code segment and replace the roots in the code by
+		// flat commands, statements in the function codes enter the functions they call
+		FlatCode(CommandPointer codeBegin, CommandPointer codeEnd, const std::list<CodeSegmentEntry>& functionCodes);
+		virtual ~FlatCode();
+
+		inline int getRecordCount() const { return (int)_records.size(); }
+		// number of trees those were replaced by flat commands
+		inline int getFlatCommandCount() const { return (int)_flatCommands.size(); }
+		// lower push records and fuse the patterns in the table into superinstructions,
+		// if a profile is given, patterns are counted to the profile instead of being fused
+		void fuseRecords(const FusionTable& fusionTable, FlatProfile* profile = nullptr);
+		// number of superinstructions
+		inline int getFusedCount() const { return _fusedCount; }
+	};
+}
@@ -0,0 +1,132 @@
+/******************************************************************
+* File:        FlatHashMap.hpp
+* Description: define FlatHashMap class. A hash map of integer keys
+*              those items are stored in a flat array and collisions
+*              are resolved by linear probing.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+namespace ffscript {
+
+	template <class Key, class Value>
+	class FlatHashMap {
+		struct Slot {
+			Key key = Key();
+			Value value;
+			bool used = false;
+		};
+
+		std::vector<Slot> _slots;
+		size_t _count;
+		size_t _mask;
+
+		static size_t hashKey(Key key) {
+			// mix bits of the key, so keys those differ only in high bits
+			// are spread to different slots too
+			uint64_t h = (uint64_t)key * 0x9E3779B97F4A7C15ULL;
+			return (size_t)(h ^ (h >> 32));
+		}
+
+		size_t findSlot(Key key) const {
+			if (_count == 0) return _slots.size();
+			for (size_t i = hashKey(key) & _mask;; i = (i + 1) & _mask) {
+				auto& slot = _slots[i];
+				if (!slot.used) return _slots.size();
+				if (slot.key == key) return i;
+			}
+		}
+
+		void rehash(size_t capacity) {
+			std::vector<Slot> oldSlots(capacity);
+			oldSlots.swap(_slots);
+			_mask = capacity - 1;
+			for (auto& slot : oldSlots) {
+				if (slot.used) {
+					size_t i = hashKey(slot.key) & _mask;
+					while (_slots[i].used) {
+						i = (i + 1) & _mask;
+					}
+					_slots[i].key = slot.key;
+					_slots[i].value = std::move(slot.value);
+					_slots[i].used = true;
+				}
+			}
+		}
+	public:
+		FlatHashMap() : _count(0), _mask(0) {}
+
+		Value* find(Key key) {
+			size_t i = findSlot(key);
+			return i < _slots.size() ? &_slots[i].value : nullptr;
+		}
+
+		const Value* find(Key key) const {
+			size_t i = findSlot(key);
+			return i < _slots.size() ? &_slots[i].value : nullptr;
+		}
+
+		// insert the value if the key does not exist, the second item of the result
+		// is false if the key exists, the first item is the value of the key
+		std::pair<Value*, bool> insert(Key key, const Value& value) {
+			// keep the table at most half full, so probing sequences stay short
+			if ((_count + 1) * 2 > _slots.size()) {
+				rehash(_slots.size() ? _slots.size() * 2 : 16);
+			}
+			size_t i = hashKey(key) & _mask;
+			for (; _slots[i].used; i = (i + 1) & _mask) {
+				if (_slots[i].key == key) {
+					return std::make_pair(&_slots[i].value, false);
+				}
+			}
+			_slots[i].key = key;
+			_slots[i].value = value;
+			_slots[i].used = true;
+			_count++;
+			return std::make_pair(&_slots[i].value, true);
+		}
+
+		Value& operator[](Key key) {
+			return *insert(key, Value()).first;
+		}
+
+		bool erase(Key key) {
+			size_t i = findSlot(key);
+			if (i >= _slots.size()) return false;
+
+			// move back the items those were probed over the erased slot, so the
+			// table does not need tombstones
+			for (size_t j = (i + 1) & _mask; _slots[j].used; j = (j + 1) & _mask) {
+				size_t home = hashKey(_slots[j].key) & _mask;
+				bool stay = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+				if (stay) continue;
+				_slots[i].key = _slots[j].key;
+				_slots[i].value = std::move(_slots[j].value);
+				i = j;
+			}
+			_slots[i].used = false;
+			_slots[i].value = Value();
+			_count--;
+			return true;
+		}
+
+		size_t size() const {
+			return _count;
+		}
+
+		void clear() {
+			_slots.clear();
+			_count = 0;
+			_mask = 0;
+		}
+	};
+}
@@ -19,7 +19,7 @@ namespace ffscript {
 
 	extern bool parseArgumentTypes(ScriptCompiler* scriptCompiler, const std::string& sargs, vector<ScriptType>& args);
 	
-	FuncLibrary::FuncLibrary()
+	FuncLibrary::FuncLibrary(const SymbolTableRef& symbolTable) : _symbolTable(symbolTable)
 	{
 	}
 
@@ -76,20 +76,25 @@ namespace ffscript {
 			return fit->functionId;
 		}
 
-		auto dfit = _dynamicFunctionMap.find(name);
-		if (dfit != _dynamicFunctionMap.end()) {
-			return dfit->second;
-		}
-
-		return -1;
+		return findDynamicFunctionOnly(name);
 	}
 
 	bool FuncLibrary::mapFunction(const std::string& name, const std::vector<ScriptType>& paramTypes, int functionId) {
-		list<OverLoadingItem> overloadingTemp;
-		list<OverLoadingItem>* pOverloadingFuncs;
-		auto it = _functionsMap.insert(std::make_pair(name, overloadingTemp));
-
-		pOverloadingFuncs = &(it.first->second);
+		int symbol = _symbolTable->intern(name);
+		auto group = _functionsMap.find(symbol);
+		if (group == nullptr) {
+			int groupIndex;
+			if (_freeGroups.size()) {
+				groupIndex = _freeGroups.back();
+				_freeGroups.pop_back();
+			}
+			else {
+				groupIndex = (int)_overloadingGroups.size();
+				_overloadingGroups.emplace_back();
+			}
+			group = _functionsMap.insert(symbol, groupIndex).first;
+		}
+		list<OverLoadingItem>* pOverloadingFuncs = &_overloadingGroups[*group];
 
 		//check if the function with same argument is exist
 		auto iit = findOverloadingItem(*pOverloadingFuncs, paramTypes);
@@ -101,7 +106,7 @@ namespace ffscript {
 		pOverloadingFuncs->push_back(factoryItemTmp);
 		OverLoadingItem& factoryItem = pOverloadingFuncs->back();
 		factoryItem.functionId = functionId;
-		factoryItem.itemName = &(it.first->first);
+		factoryItem.itemName = &_symbolTable->getName(symbol);
 		factoryItem.mask = 0;
 		//copy argument types
 		auto& args = factoryItem.paramTypes;
@@ -116,15 +121,17 @@ namespace ffscript {
 	}
 
 	bool FuncLibrary::mapDynamicFunction(const std::string& name, int functionId) {
-		auto itres = _dynamicFunctionMap.insert(std::make_pair(name, functionId));
+		int symbol = _symbolTable->intern(name);
+		auto itres = _dynamicFunctionMap.insert(symbol, functionId);
 		if (!itres.second) {
 			//a function has same name is already exist
 			return false;
 		}
+		_dynamicFunctionSymbols.push_back(symbol);
 		OverLoadingItem factoryItem;
 		factoryItem.functionId = functionId;
 		//factoryItem.paramCount = -1; //-1 is the mark of dynamic functions
-		factoryItem.itemName = &(itres.first->first);
+		factoryItem.itemName = &_symbolTable->getName(symbol);
 		//factoryItem.paramTypes = nullptr;
 		factoryItem.mask = ITEM_MASK_DYNAMIC_FUNCTION;
 
@@ -134,33 +141,52 @@ namespace ffscript {
 	}
 
 	void FuncLibrary::unmapFunction(const std::string& name, int functionId) {
-		list<OverLoadingItem>* pOverloadingFuncs;
-		auto it = _functionsMap.find(name);
-		if (it == _functionsMap.end()) {
+		int symbol = _symbolTable->find(name);
+		auto group = _functionsMap.find(symbol);
+		if (group == nullptr) {
 			return;
 		}
+		int groupIndex = *group;
+		list<OverLoadingItem>* pOverloadingFuncs = &_overloadingGroups[groupIndex];
 
-		pOverloadingFuncs = &it->second;
 		int functionIdTemp = functionId;
 		void* allocatedMem = nullptr;
 		auto rmIt = std::remove_if(pOverloadingFuncs->begin(), pOverloadingFuncs->end(), [functionIdTemp, &allocatedMem](const OverLoadingItem& item) ->bool {
 			return item.functionId == functionIdTemp;
 		});
+		if (rmIt != pOverloadingFuncs->end()) {
+			_overloadingIdMap.erase(functionId);
+		}
 		pOverloadingFuncs->erase(rmIt, pOverloadingFuncs->end());
+
+		// functions of user libraries are unmapped each time a program is compiled,
+		// the empty group is reused instead of adding a new one for the next name
+		if (pOverloadingFuncs->empty()) {
+			_functionsMap.erase(symbol);
+			_freeGroups.push_back(groupIndex);
+		}
 	}
 
 	const list<OverLoadingItem>* FuncLibrary::findOverloadingFuncRoot(const std::string& name) const {
-		auto it = _functionsMap.find(name);
-		if (it == _functionsMap.end()) {
+		return findOverloadingFuncRoot(_symbolTable->find(name));
+	}
+
+	const list<OverLoadingItem>* FuncLibrary::findOverloadingFuncRoot(int symbol) const {
+		auto group = _functionsMap.find(symbol);
+		if (group == nullptr) {
 			return nullptr;
 		}
-		return &(it->second);
+		return &_overloadingGroups[*group];
 	}
 
 	int FuncLibrary::findDynamicFunctionOnly(const std::string& name) {
-		auto it = _dynamicFunctionMap.find(name);
-		if (it != _dynamicFunctionMap.end()) {
-			return it->second;
+		return findDynamicFunctionOnly(_symbolTable->find(name));
+	}
+
+	int FuncLibrary::findDynamicFunctionOnly(int symbol) {
+		auto functionId = _dynamicFunctionMap.find(symbol);
+		if (functionId != nullptr) {
+			return *functionId;
 		}
 
 		return -1;
@@ -168,14 +194,16 @@ namespace ffscript {
 
 	void FuncLibrary::beginUserLib() {
 		_systemLibMarkEnd = (LibraryMarkInfoRef)(new LibraryMarkInfo);
-		_systemLibMarkEnd->dynamicFuncIter = _dynamicFunctionMap.end();
-		_systemLibMarkEnd->funcFactoryIter = _functionsMap.end();
+		_systemLibMarkEnd->dynamicFuncCount = _dynamicFunctionSymbols.size();
 	}
 
 	void FuncLibrary::clearUserLib() {
 		if (_systemLibMarkEnd) {
-			_dynamicFunctionMap.erase(_systemLibMarkEnd->dynamicFuncIter, _dynamicFunctionMap.end());
-			_functionsMap.erase(_systemLibMarkEnd->funcFactoryIter, _functionsMap.end());
+			// overloading functions are removed by unmapFunction, their groups are kept
+			for (size_t i = _systemLibMarkEnd->dynamicFuncCount; i < _dynamicFunctionSymbols.size(); i++) {
+				_dynamicFunctionMap.erase(_dynamicFunctionSymbols[i]);
+			}
+			_dynamicFunctionSymbols.resize(_systemLibMarkEnd->dynamicFuncCount);
 			_systemLibMarkEnd.reset();
 		}
 	}
@@ -199,9 +227,9 @@ namespace ffscript {
 	//}
 
 	const OverLoadingItem* FuncLibrary::findFunctionInfo(int functionId) {
-		auto it = _overloadingIdMap.find(functionId);
-		if (it != _overloadingIdMap.end()) {
-			return it->second;
+		auto item = _overloadingIdMap.find(functionId);
+		if (item != nullptr) {
+			return *item;
 		}
 		return nullptr;
 	}
@@ -15,9 +15,11 @@
 #include "FactoryTree.h"
 #include "MemoryBlock.h"
 #include "ScriptType.h"
+#include "SymbolTable.h"
+#include "FlatHashMap.hpp"
 #include <vector>
 #include <list>
-#include <map>
+#include <deque>
 #include <string>
 
 namespace ffscript {
@@ -25,24 +27,33 @@ namespace ffscript {
 
 	class FuncLibrary
 	{
+		SymbolTableRef _symbolTable;
 		std::list<MemoryBlockRef> _memoryBlocks;
-		std::map<std::string, std::list<OverLoadingItem>> _functionsMap; /*map function name to list of overloading functions*/
-		std::map<std::string, int> _dynamicFunctionMap; /* map for dynamic funtions, are functions can accept what ever parameter count, map function name to function factory id*/
+		// overloading functions of a name are stored in a group, groups are not moved so
+		// pointers to them are valid while the library is alive. A group emptied by
+		// unmapFunction is reused for the next new name, so pointers to it must not be
+		// kept after its functions are unregistered
+		std::deque<std::list<OverLoadingItem>> _overloadingGroups;
+		std::vector<int> _freeGroups;
+		FlatHashMap<int, int> _functionsMap; /*map symbol of function name to its group of overloading functions*/
+		FlatHashMap<int, int> _dynamicFunctionMap; /* map for dynamic funtions, are functions can accept what ever parameter count, map symbol of function name to function factory id*/
+		std::vector<int> _dynamicFunctionSymbols; /* symbols of dynamic functions in order they are registered */
 		std::list<OverLoadingItem> _overLoadingContainer;
-		std::map<int, OverLoadingItem*> _overloadingIdMap;
+		FlatHashMap<int, OverLoadingItem*> _overloadingIdMap;
 		struct LibraryMarkInfo {
-			decltype(_dynamicFunctionMap.begin()) dynamicFuncIter;
-			decltype(_functionsMap.begin()) funcFactoryIter;
+			size_t dynamicFuncCount;
 		};
 		typedef std::shared_ptr<LibraryMarkInfo> LibraryMarkInfoRef;
 		LibraryMarkInfoRef _systemLibMarkEnd;
 
 	public:
-		FuncLibrary();
+		FuncLibrary(const SymbolTableRef& symbolTable);
 		~FuncLibrary();
 		const std::list<OverLoadingItem>* findOverloadingFuncRoot(const std::string& name) const;
+		const std::list<OverLoadingItem>* findOverloadingFuncRoot(int symbol) const;
 		int findFunction(ScriptCompiler* scriptCompiler, const std::string& name, const std::string& sargs);
 		int findDynamicFunctionOnly(const std::string& name);
+		int findDynamicFunctionOnly(int symbol);
 		int findFunction(ScriptCompiler* scriptCompiler, const std::string& name, const std::vector<ScriptType>& paramTypes);
 		bool mapFunction(const std::string& name, const std::vector<ScriptType>& paramTypes, int functionId);
 		bool mapDynamicFunction(const std::string& name, int functionId);
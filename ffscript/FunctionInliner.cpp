@@ -0,0 +1,218 @@
+/******************************************************************
+* File:        FunctionInliner.cpp
+* Description: implement FunctionInliner class. A function can be
+*              inlined when its body is only a return statement of an
+*              expression that has no side effect and has only
+*              primitive values, so copying the expression to callers
+*              does not need to care constructors and destructors.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "FunctionInliner.h"
+#include "FunctionScope.h"
+#include "ScriptFunction.h"
+#include "ScriptCompiler.h"
+#include "BasicType.h"
+#include "expresion_defs.h"
+#include <algorithm>
+
+namespace ffscript {
+
+	FunctionInliner::FunctionInliner(ScriptCompiler* scriptCompiler) :
+		_scriptCompiler(scriptCompiler),
+		_optimizer(scriptCompiler),
+		_inlinedCount(0) {
+	}
+
+	FunctionInliner::~FunctionInliner() {
+	}
+
+	bool FunctionInliner::isPrimitiveValue(const ScriptType& type) const {
+		return _optimizer.isPrimitiveType(type) && !type.isRefType() && !type.isSemiRefType();
+	}
+
+	bool FunctionInliner::isPureExpression(ExecutableUnit* unit, const std::vector<Variable*>* params, int& unitCount) const {
+		unitCount++;
+		if (!isPrimitiveValue(unit->getReturnType())) {
+			return false;
+		}
+
+		auto unitType = unit->getType();
+		if (unitType == EXP_UNIT_ID_CONST) {
+			return true;
+		}
+		if (unitType == EXP_UNIT_ID_XOPERAND) {
+			auto pVariable = ((CXOperand*)unit)->getVariable();
+			if (pVariable == nullptr || !isPrimitiveValue(pVariable->getDataType())) {
+				return false;
+			}
+			// expression of an inlined function can use only its parameters
+			return params == nullptr || std::find(params->begin(), params->end(), pVariable) != params->end();
+		}
+		if (!ISFUNCTION(unit)) {
+			return false;
+		}
+
+		// only built-in operators and castings of primitive types
+		// have no side effect when their params are passed by value
+		auto function = (Function*)unit;
+		if (function->getUserData()) {
+			return false;
+		}
+		if (_scriptCompiler->getNativeCommand(function->getId()) == nullptr && dynamic_cast<CastingFunction*>(function) == nullptr) {
+			return false;
+		}
+		int n = function->getChildCount();
+		for (int i = 0; i < n; i++) {
+			if (!isPureExpression(function->getChild(i).get(), params, unitCount)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void FunctionInliner::addFunction(FunctionScope* functionScope) {
+		InlineInfo& info = _functions[functionScope->getFunctionId()];
+		info.functionScope = functionScope;
+		info.state = InlineState::Unchecked;
+		info.expression = nullptr;
+	}
+
+	void FunctionInliner::checkFunctions() {
+		for (auto it = _functions.begin(); it != _functions.end(); it++) {
+			getInlineInfo(it->first);
+		}
+	}
+
+	const FunctionInliner::InlineInfo* FunctionInliner::getInlineInfo(int functionId) {
+		auto it = _functions.find(functionId);
+		if (it == _functions.end()) {
+			return nullptr;
+		}
+		InlineInfo& info = it->second;
+		if (info.state == InlineState::Inlinable) {
+			return &info;
+		}
+		if (info.state != InlineState::Unchecked) {
+			// a function being checked is calling itself, directly or indirectly
+			return nullptr;
+		}
+
+		info.state = InlineState::Checking;
+		auto functionScope = info.functionScope;
+		auto expression = functionScope->getSingleReturnExpression();
+		if (expression == nullptr) {
+			info.state = InlineState::NotInlinable;
+			return nullptr;
+		}
+		if (ISFUNCTION(expression)) {
+			inlineCalls((Function*)expression);
+		}
+
+		auto& returnType = functionScope->getReturnType();
+		bool inlinable = isPrimitiveValue(returnType) && expression->getReturnType().iType() == returnType.iType();
+
+		functionScope->getParamVariables(info.params);
+		for (auto pVariable : info.params) {
+			inlinable = inlinable && isPrimitiveValue(pVariable->getDataType());
+		}
+
+		int unitCount = 0;
+		inlinable = inlinable && isPureExpression(expression, &info.params, unitCount) && unitCount <= MAX_INLINE_UNITS;
+		if (!inlinable) {
+			info.state = InlineState::NotInlinable;
+			return nullptr;
+		}
+
+		info.expression = expression;
+		info.state = InlineState::Inlinable;
+		return &info;
+	}
+
+	ExecutableUnitRef FunctionInliner::cloneExpression(ExecutableUnit* unit, const InlineInfo* info, Function* call) const {
+		ExecutableUnitRef newUnit;
+		auto unitType = unit->getType();
+		if (unitType == EXP_UNIT_ID_CONST) {
+			newUnit = _optimizer.createConstant(unit->getReturnType(), unit->Execute());
+		}
+		else if (unitType == EXP_UNIT_ID_XOPERAND) {
+			auto xOperand = (CXOperand*)unit;
+			if (info) {
+				// parameter of the inlined function is replaced by the argument of the call,
+				// so it is computed in frame of the caller instead of frame of the function
+				auto paramIt = std::find(info->params.begin(), info->params.end(), xOperand->getVariable());
+				if (paramIt != info->params.end()) {
+					return cloneExpression(call->getChild((int)(paramIt - info->params.begin())).get(), nullptr, nullptr);
+				}
+			}
+			newUnit = std::make_shared<CXOperand>(xOperand->getScope(), xOperand->getVariable(), xOperand->getReturnType());
+		}
+		else {
+			auto function = (Function*)unit;
+			auto newFunction = _scriptCompiler->createFunctionFromId(function->getId());
+			newUnit = ExecutableUnitRef(newFunction);
+			newFunction->setReturnType(function->getReturnType());
+
+			int n = function->getChildCount();
+			for (int i = 0; i < n; i++) {
+				newFunction->pushParam(cloneExpression(function->getChild(i).get(), info, call));
+			}
+		}
+		newUnit->setMask(unit->getMask());
+		newUnit->setSourceCharIndex(unit->getSourceCharIndex());
+		return newUnit;
+	}
+
+	void FunctionInliner::inlineCalls(Function* function) {
+		int n = function->getChildCount();
+		for (int i = 0; i < n; i++) {
+			auto& child = function->getChild(i);
+			if (!ISFUNCTION(child)) {
+				continue;
+			}
+			// inline calls in arguments first
+			inlineCalls((Function*)child.get());
+
+			auto call = dynamic_cast<ScriptFunction*>(child.get());
+			if (call == nullptr) {
+				continue;
+			}
+			auto info = getInlineInfo(call->getId());
+			if (info == nullptr || call->getChildCount() != (int)info->params.size()) {
+				continue;
+			}
+
+			// arguments are copied to every place their parameters are used
+			// so they must have no side effect
+			bool inlinable = true;
+			int argCount = call->getChildCount();
+			for (int j = 0; j < argCount && inlinable; j++) {
+				auto& arg = call->getChild(j);
+				int unitCount = 0;
+				inlinable = arg->getReturnType().iType() == info->params[j]->getDataType().iType() &&
+					isPureExpression(arg.get(), nullptr, unitCount) && unitCount <= MAX_INLINE_UNITS;
+			}
+			if (!inlinable) {
+				continue;
+			}
+
+			auto inlinedUnit = cloneExpression(info->expression, info, call);
+			// the inlined expression takes place of the call in its parent
+			inlinedUnit->setMask(call->getMask());
+			inlinedUnit->setSourceCharIndex(call->getSourceCharIndex());
+			child = inlinedUnit;
+			// constant arguments may make the inlined expression constant
+			_optimizer.foldConstants(child);
+			_inlinedCount++;
+		}
+	}
+
+	int FunctionInliner::getInlinedCount() const {
+		return _inlinedCount;
+	}
+}
@@ -0,0 +1,68 @@
+/******************************************************************
+* File:        FunctionInliner.h
+* Description: declare FunctionInliner class. A class that replaces
+*              calls of small script functions by copies of their
+*              return expressions before code of the program is
+*              extracted.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "expressionunit.h"
+#include "ExpressionOptimizer.h"
+#include <map>
+#include <vector>
+
+namespace ffscript {
+	class ScriptCompiler;
+	class FunctionScope;
+	class Variable;
+
+	class FunctionInliner
+	{
+		enum class InlineState {
+			Unchecked,
+			Checking,
+			Inlinable,
+			NotInlinable,
+		};
+
+		struct InlineInfo {
+			FunctionScope* functionScope;
+			InlineState state;
+			ExecutableUnit* expression;
+			std::vector<Variable*> params;
+		};
+
+		ScriptCompiler* _scriptCompiler;
+		ExpressionOptimizer _optimizer;
+		std::map<int, InlineInfo> _functions;
+		int _inlinedCount;
+	private:
+		bool isPrimitiveValue(const ScriptType& type) const;
+		bool isPureExpression(ExecutableUnit* unit, const std::vector<Variable*>* params, int& unitCount) const;
+		const InlineInfo* getInlineInfo(int functionId);
+		ExecutableUnitRef cloneExpression(ExecutableUnit* unit, const InlineInfo* info, Function* call) const;
+	public:
+		// maximum number of units in an expression of an inlinable function
+		static const int MAX_INLINE_UNITS = 16;
+
+		FunctionInliner(ScriptCompiler* scriptCompiler);
+		virtual ~FunctionInliner();
+
+		void addFunction(FunctionScope* functionScope);
+		// check added functions can be inlined or not, calls in expressions
+		// of the functions are inlined first, so a function calls other
+		// small functions can be inlined too
+		void checkFunctions();
+		// replace calls to inlinable functions in children of the function unit
+		void inlineCalls(Function* function);
+		// number of calls were inlined, including calls in inlined functions
+		int getInlinedCount() const;
+	};
+}
@@ -141,6 +141,18 @@ namespace ffscript {
 		);
 	}
 
+	// register a native function that is a template argument, the function object calls
+	// it directly. Usage: registerFunction<decltype(&f), &f>(fb, "f", "int", "int,int")
+	template<class Fx, Fx fx>
+	int registerFunction(FunctionRegisterHelper& fb, const std::string& scriptFunction, const std::string& returnType, const std::string& paramTypes) {
+		typedef FT::StaticFunctionDelegate3<Fx, fx> NativeFunction;
+		return fb.registFunction(
+			scriptFunction,
+			paramTypes, // parameter type of the function
+			new DefaultUserFunctionFactory(std::make_shared<NativeFunction>(), fb.getSriptCompiler(), returnType, NativeFunction::paramCount)
+		);
+	}
+
 	template <class Class, class Rt, class... Types>
 	int registerFunction(FunctionRegisterHelper& fb, Class* obj,  Rt(Class::*nativeFunction)(Types...), const std::string& scriptFunction, const std::string& returnType, const std::string& paramTypes) {
 		return fb.registFunction(
@@ -22,7 +22,8 @@ namespace ffscript {
 	FunctionScope::FunctionScope(ScriptScope* parent, const std::string& name, const ScriptType& returnType) :
 		ContextScope(parent, this),
 		_name(name),
-		_returnType(returnType) {
+		_returnType(returnType),
+		_functionId(-1) {
 	}
 
 	FunctionScope::~FunctionScope() {
@@ -159,10 +160,12 @@ namespace ffscript {
 	}
 
 	const wchar_t* FunctionScope::parseBody(const wchar_t* text, const wchar_t* end, const ScriptType& returnType, const std::vector<ScriptType>& paramTypes) {
-		_functionId = ((GlobalScope*)getParent())->registScriptFunction(_name, returnType, paramTypes);
-
+		// a function compiled again keeps the id it was registered with
 		if (_functionId < 0) {
-			return nullptr;
+			_functionId = ((GlobalScope*)getParent())->registScriptFunction(_name, returnType, paramTypes);
+			if (_functionId < 0) {
+				return nullptr;
+			}
 		}
 
 		//EnterFunction* enterFunction = new EnterFunction(this);
@@ -194,6 +197,10 @@ namespace ffscript {
 		return _functionId;
 	}
 
+	void FunctionScope::setFunctionId(int functionId) {
+		_functionId = functionId;
+	}
+
 	const std::string& FunctionScope::getName() const {
 		return _name;
 	}
@@ -206,6 +213,39 @@ namespace ffscript {
 		return res;
 	}
 
+	ExecutableUnit* FunctionScope::getSingleReturnExpression() {
+		// body of the function must be:
+		// enter scope, return expression, return command, exit scope, exit function
+		if (getChildren().size() || _commandBuilder.size() != 5) {
+			return nullptr;
+		}
+		auto it = _commandBuilder.begin();
+		if (dynamic_cast<EnterScopeBuilder*>((it++)->get()) == nullptr) {
+			return nullptr;
+		}
+		auto returnExpression = dynamic_cast<ExecutableUnit*>((it++)->get());
+		if (returnExpression == nullptr) {
+			return nullptr;
+		}
+#if USE_DIRECT_COPY_FOR_RETURN
+		if (dynamic_cast<ReturnCommandBuilder2*>(it->get()) == nullptr) {
+#else
+		if (dynamic_cast<ReturnCommandBuilder*>(it->get()) == nullptr) {
+#endif
+			return nullptr;
+		}
+		return returnExpression;
+	}
+
+	void FunctionScope::getParamVariables(std::vector<Variable*>& params) {
+		auto& variables = getVariables();
+		for (auto it = variables.begin(); it != variables.end(); it++) {
+			if (it->getGroupType() == VariableGroupType::FuntionParameter) {
+				params.push_back(&*it);
+			}
+		}
+	}
+
 	///////////////////////////////////////////////////////////////////////
 	AnonymousFunctionScope::AnonymousFunctionScope(ScriptScope* parent, const std::list<ExecutableUnitRef>& captureList) :
 	FunctionScope(parent, "", ScriptType()),
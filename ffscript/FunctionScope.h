@@ -30,9 +30,15 @@ namespace ffscript {
 		FunctionScope(ScriptScope* parent, const std::string& name, const ScriptType& returnType);
 		virtual ~FunctionScope();
 		int getFunctionId() const;
+		// set id of a registered function before parsing the body, the body is
+		// compiled as a new version of the function
+		void setFunctionId(int functionId);
 		const std::string& getName() const;
 		virtual bool updateCodeForControllerCommands(Program* program);
 		const ScriptType& getReturnType() const;
+		// get the expression of a function that its body has only a return statement
+		ExecutableUnit* getSingleReturnExpression();
+		void getParamVariables(std::vector<Variable*>& params);
 	public:
 		const wchar_t* parseFunctionParameters(const wchar_t* text, const wchar_t* end, std::vector<ScriptType>& paramTypes);
 		virtual const wchar_t* parse(const wchar_t* text, const wchar_t* end);
@@ -18,17 +18,18 @@
 #include "CodeUpdater.h"
 #include "ScriptRunner.h"
 #include "CLamdaProg.h"
+#include <stdexcept>
 
 namespace ffscript {
 	GlobalScope::GlobalScope(StaticContext* staticContext, ScriptCompiler* scriptCompiler):
-		ScriptScope(scriptCompiler), _errorCompiledChar(nullptr), _beginCompileChar(nullptr)
+		ScriptScope(scriptCompiler), _errorCompiledChar(nullptr), _beginCompileChar(nullptr), _inlinedCallCount(0), _recompileChildCount(0)
 	{
 		_updateLaterMan = new CodeUpdater(this);
 		_refContext = false;
 		_staticContextRef.reset(staticContext);
 	}
 
-	GlobalScope::GlobalScope(int globalMemSize, ScriptCompiler* scriptCompiler) : ScriptScope(scriptCompiler), _errorCompiledChar(nullptr), _beginCompileChar(nullptr) {
+	GlobalScope::GlobalScope(int globalMemSize, ScriptCompiler* scriptCompiler) : ScriptScope(scriptCompiler), _errorCompiledChar(nullptr), _beginCompileChar(nullptr), _inlinedCallCount(0), _recompileChildCount(0) {
 		_staticContextRef.reset(new StaticContext(globalMemSize));
 		_refContext = true;
 		_updateLaterMan = new CodeUpdater(this);
@@ -49,6 +50,10 @@ namespace ffscript {
 		return _staticContextRef->getAbsoluteAddress(_staticContextRef->getCurrentOffset() + offset);
 	}
 
+	StaticContext* GlobalScope::getStaticContext() const {
+		return _staticContextRef.get();
+	}
+
 	void GlobalScope::runGlobalCode() {
 		int constructorCount = this->getConstructorCommandCount();
 		int dataSize = getDataSize();
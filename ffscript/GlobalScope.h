@@ -23,6 +23,7 @@ namespace ffscript {
 	class Executor;
 	class CodeUpdater;
 	class CLamdaProg;
+	class FunctionScope;
 
 	class GlobalScope : public ScriptScope
 	{
@@ -32,11 +33,34 @@ namespace ffscript {
 		bool _refContext;
 		const WCHAR* _errorCompiledChar;
 		const WCHAR* _beginCompileChar;
+		// number of calls were inlined in last compiled program
+		int _inlinedCallCount;
+		// scopes of the compiled program those were replaced by recompiled functions,
+		// their code is still used by running tasks. Each function is replaced once
+		ScopeRefList _replacedScopes;
+		// recompiled functions those are not committed yet, pairs of old and new scope
+		std::list<std::pair<FunctionScope*, FunctionScope*>> _recompiledScopes;
+		// number of children before the functions were recompiled
+		size_t _recompileChildCount;
+		// commands of the recompiled functions are allocated here
+		CodeArenaRef _recompileArena;
+		// committed code of recompiled functions and the scopes those own it
+		struct FunctionUpdate {
+			Program* program;
+			CodeSegmentEntry code;
+			ScopeRefList scopes;
+			// code is not used by the program anymore, it is released when the runs
+			// entered before the update that replaced it are left
+			bool replaced;
+			unsigned int replacedEpoch;
+		};
+		std::list<FunctionUpdate> _functionUpdates;
 	public:
 		GlobalScope(StaticContext* staticContext, ScriptCompiler* scriptCompiler);
 		GlobalScope(int globalMemSize, ScriptCompiler* scriptCompiler);
 		virtual ~GlobalScope();
 		void* getGlobalAddress(int offset);
+		StaticContext* getStaticContext() const;
 		void runGlobalCode();
 		void cleanupGlobalMemory();
 		virtual int correctAndOptimize(Program* program);
@@ -51,8 +75,22 @@ namespace ffscript {
 		const wchar_t* parse(const wchar_t* text, const wchar_t* end);
 		const wchar_t* parseAnonymous(const wchar_t* text, const wchar_t* end, const std::list<ExecutableUnitRef>& captureList, int& functionId);
 		virtual bool extractCode(Program* program);		
+		// compile a function of the program again. The text is a function definition with
+		// same signature as the compiled one. The new code is not used until the recompiled
+		// functions are committed. It returns false if the function cannot be recompiled
+		// alone, then the recompiled functions must be discarded
+		bool recompileFunction(Program* program, const wchar_t* text, const wchar_t* end);
+		// swap code of all recompiled functions in. Each function is switched by an atomic
+		// store to its entry, calls those start after it run the new code and calls those
+		// started before finish on the old code. The functions are switched one by one.
+		// Code replaced by an update is released at the next update, so tasks must not run
+		// the replaced code when the program is updated again
+		bool commitRecompiledFunctions(Program* program);
+		// drop the recompiled functions, the program keeps its code
+		void discardRecompiledFunctions(Program* program);
 		virtual int registScriptFunction(const std::string& name, const ScriptType& returnType, const std::vector<ScriptType>& paramTypes);
 		CodeUpdater* getCodeUpdater() const;
+		int getInlinedCallCount() const;
 	protected:
 		const wchar_t* detectKeyword(const wchar_t* text, const wchar_t* end);
 		const wchar_t* parseStruct(const wchar_t* text, const wchar_t* end);
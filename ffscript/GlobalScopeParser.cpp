@@ -25,6 +25,7 @@
 #include "ContextScope.h"
 #include "StructClass.h"
 #include "ScopedCompilingScope.h"
+#include "FunctionInliner.h"
 
 #include <string>
 
@@ -34,6 +35,10 @@ namespace ffscript {
 		return _updateLaterMan;
 	}
 
+	int GlobalScope::getInlinedCallCount() const {
+		return _inlinedCallCount;
+	}
+
 	const wchar_t* GlobalScope::parseStruct(const wchar_t* text, const wchar_t* end) {
 		const wchar_t* c;
 		const wchar_t* d;
@@ -394,6 +399,8 @@ namespace ffscript {
 	}
 
 	bool GlobalScope::extractCode(Program* program) {
+		// commands and constant blocks of the program are allocated in its code arena
+		CodeArenaScope arenaScope(program->getCodeArena());
 
 		updateVariableOffset();
 
@@ -446,6 +453,7 @@ namespace ffscript {
 
 				for (CommandPointer commandPointer = beginCommand; commandPointer <= endCommand; ++commandPointer) {
 					_staticContextRef->addCommand(commandPointer);
+					program->addGlobalCommand(commandPointer);
 				}
 			}
 		}
@@ -458,16 +466,40 @@ namespace ffscript {
 
 				for (CommandPointer commandPointer = beginCommand; commandPointer <= endCommand; ++commandPointer) {
 					_staticContextRef->addDestructorCommand(commandPointer);
+					program->addGlobalDestructorCommand(commandPointer);
 				}
 			}
 		}
 
+		// global variables are accessed by offsets, the program runs with global data
+		// of the static context until it is bound to an instance
+		program->setGlobalLayout(getDataSize(), getScopeSize(), getConstructorCommandCount());
+		program->setGlobalData(getGlobalAddress(0));
+		_staticContextRef->setGlobalData(getGlobalAddress(0));
+
+		program->flattenCode();
+		program->lowerCode();
+
 		return true;
 	}
 
 	int GlobalScope::correctAndOptimize(Program* program) {
 		const ScopeRefList& children = getChildren();
 		int iRes = 0;
+
+		// replace calls of small functions by their expressions before
+		// destructors are generated and code of the functions is extracted
+		FunctionInliner inliner(getCompiler());
+		for (auto it = children.begin(); it != children.end(); ++it) {
+			auto functionScope = dynamic_cast<FunctionScope*>(it->get());
+			if (functionScope && dynamic_cast<AnonymousFunctionScope*>(functionScope) == nullptr) {
+				inliner.addFunction(functionScope);
+			}
+		}
+		inliner.checkFunctions();
+		inlineFunctionCalls(&inliner);
+		_inlinedCallCount = inliner.getInlinedCount();
+
 		for (auto it = children.begin(); it != children.end() && iRes == 0; ++it) {			
 			iRes = (*it)->correctAndOptimize(program);
 		}
@@ -475,6 +507,234 @@ namespace ffscript {
 		return iRes;
 	}
 
+	static bool isSameType(const ScriptType& type1, const ScriptType& type2) {
+		return type1.iType() == type2.iType() && type1.sType() == type2.sType();
+	}
+
+	bool GlobalScope::recompileFunction(Program* program, const wchar_t* text, const wchar_t* end) {
+		ScriptCompiler* scriptCompiler = getCompiler();
+		if (scriptCompiler->getProgram() != program) {
+			scriptCompiler->setErrorText("the program is not the last program compiled by the scope");
+			return false;
+		}
+
+		const ScopeRefList& children = getChildren();
+		if (!_recompileArena) {
+			// tasks of the program were run when it was compiled, only tasks
+			// of the recompiled functions are run when they are committed
+			getCodeUpdater()->clear();
+			program->beginFunctionUpdate();
+			_recompileChildCount = children.size();
+			_recompileArena = std::make_shared<CodeArena>();
+		}
+
+		_beginCompileChar = text;
+
+		ScriptType type;
+		const wchar_t* c = this->parseType(text, end, type);
+		if (c == nullptr || type.isUnkownType()) {
+			scriptCompiler->setErrorText("expected return type of a function");
+			setErrorCompilerChar(text);
+			return false;
+		}
+		const wchar_t* d = trimLeft(c, end);
+		c = lastCharInToken(d, end);
+		std::string name = convertToAscii(d, c - d);
+		c = trimLeft(c, end);
+		if (c >= end || *c != '(') {
+			scriptCompiler->setErrorText("expected a function definition");
+			setErrorCompilerChar(c);
+			return false;
+		}
+
+		// scopes created while compiling the function are added after the current children
+		size_t childCount = children.size();
+		auto newChildrenBegin = [&children, childCount]() {
+			auto it = children.begin();
+			std::advance(it, childCount);
+			return it;
+		};
+		// functions of the program are placed before the recompiled functions
+		auto programChildrenEnd = children.begin();
+		std::advance(programChildrenEnd, _recompileChildCount);
+
+		FunctionScope* newScope = new FunctionScope(this, name, type);
+		std::vector<ScriptType> paramTypes;
+		c = newScope->parseHeader(c, end, paramTypes);
+		if (c == nullptr) {
+			return false;
+		}
+
+		int functionId = scriptCompiler->findFunction(name, paramTypes);
+		FunctionScope* oldScope = nullptr;
+		for (auto it = children.begin(); it != programChildrenEnd; ++it) {
+			auto functionScope = dynamic_cast<FunctionScope*>(it->get());
+			if (functionScope && dynamic_cast<AnonymousFunctionScope*>(functionScope) == nullptr &&
+				functionScope->getFunctionId() == functionId) {
+				oldScope = functionScope;
+				break;
+			}
+		}
+		if (oldScope == nullptr) {
+			scriptCompiler->setErrorText("function '" + name + "' is not found in the program");
+			return false;
+		}
+
+		std::vector<Variable*> oldParams;
+		oldScope->getParamVariables(oldParams);
+		bool sameSignature = isSameType(oldScope->getReturnType(), type) && oldParams.size() == paramTypes.size();
+		for (size_t i = 0; sameSignature && i < paramTypes.size(); i++) {
+			sameSignature = isSameType(oldParams[i]->getDataType(), paramTypes[i]);
+		}
+		if (!sameSignature) {
+			scriptCompiler->setErrorText("signature of function '" + name + "' is changed");
+			return false;
+		}
+		// calls to a small function may be replaced by its expression, they cannot be redirected
+		if (oldScope->getSingleReturnExpression() != nullptr) {
+			scriptCompiler->setErrorText("function '" + name + "' may be inlined in its callers, the program must be compiled again");
+			return false;
+		}
+
+		newScope->setFunctionId(functionId);
+		c = newScope->parseBody(c, end, type, paramTypes);
+		if (c == nullptr) {
+			return false;
+		}
+		c = trimLeft(c, end);
+		if (c < end) {
+			scriptCompiler->setErrorText("unexpected text after body of function '" + name + "'");
+			setErrorCompilerChar(c);
+			return false;
+		}
+
+		// calls to the other small functions are inlined as the function was compiled with the program
+		FunctionInliner inliner(scriptCompiler);
+		for (auto it = children.begin(); it != programChildrenEnd; ++it) {
+			auto functionScope = dynamic_cast<FunctionScope*>(it->get());
+			if (functionScope && functionScope != oldScope && dynamic_cast<AnonymousFunctionScope*>(functionScope) == nullptr) {
+				inliner.addFunction(functionScope);
+			}
+		}
+		newScope->inlineFunctionCalls(&inliner);
+
+		for (auto it = newChildrenBegin(); it != children.end(); ++it) {
+			if ((*it)->correctAndOptimize(program) != 0) {
+				return false;
+			}
+		}
+
+		CodeArenaScope arenaScope(_recompileArena.get());
+		for (auto it = newChildrenBegin(); it != children.end(); ++it) {
+			if ((*it)->extractCode(program) == false) {
+				return false;
+			}
+		}
+
+		_recompiledScopes.push_back(std::make_pair(oldScope, newScope));
+		return true;
+	}
+
+	bool GlobalScope::commitRecompiledFunctions(Program* program) {
+		if (!_recompileArena) {
+			return true;
+		}
+
+		const ScopeRefList& children = getChildren();
+		auto newChildrenBegin = children.begin();
+		std::advance(newChildrenBegin, _recompileChildCount);
+
+		FunctionUpdate functionUpdate;
+		functionUpdate.program = program;
+		functionUpdate.replaced = false;
+		functionUpdate.replacedEpoch = 0;
+		{
+			CodeArenaScope arenaScope(_recompileArena.get());
+			// code of the new executors is placed after the code of the program
+			functionUpdate.code = program->appendPlainCode();
+
+			// the new code is staged as plain code of the functions, tasks of
+			// the new scopes complete their commands with it
+			ContextScope* contextScope;
+			for (auto it = newChildrenBegin; it != children.end(); ++it) {
+				contextScope = dynamic_cast<ContextScope*>((*it).get());
+				if (contextScope && contextScope->updateCodeForControllerCommands(program) == false) {
+					program->releaseAppendedCode(functionUpdate.code);
+					discardRecompiledFunctions(program);
+					return false;
+				}
+			}
+			getCodeUpdater()->runUpdate();
+			program->flattenAppendedCode(functionUpdate.code);
+		}
+
+		// the new code is completed, now the functions are switched
+		for (auto& recompiledScope : _recompiledScopes) {
+			auto oldScopeRef = replaceChild(recompiledScope.first, recompiledScope.second);
+			auto oldCode = recompiledScope.first->getCode();
+
+			// keep the old scope as long as its code
+			auto update = _functionUpdates.begin();
+			for (; update != _functionUpdates.end(); ++update) {
+				if (update->program == program && oldCode->first >= update->code.first && oldCode->first <= update->code.second) {
+					break;
+				}
+			}
+			if (update != _functionUpdates.end()) {
+				update->scopes.push_back(oldScopeRef);
+			}
+			else {
+				_replacedScopes.push_back(oldScopeRef);
+			}
+		}
+		program->commitFunctionUpdate();
+		getCodeUpdater()->clear();
+		_recompiledScopes.clear();
+		_recompileArena.reset();
+
+		// runs entered before this update may still be on the replaced code, it is
+		// released by a later update after they are left. Code of lambdas stays used
+		// because closures created by the old code keep calling it
+		for (auto it = _functionUpdates.begin(); it != _functionUpdates.end();) {
+			if (it->program != program) {
+				++it;
+				continue;
+			}
+			if (!it->replaced && !program->isAppendedCodeUsed(it->code)) {
+				it->replaced = true;
+				it->replacedEpoch = program->getUpdateEpoch();
+			}
+			if (it->replaced && !program->hasRunBefore(it->replacedEpoch)) {
+				program->releaseAppendedCode(it->code);
+				it = _functionUpdates.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+		if (functionUpdate.code.first) {
+			_functionUpdates.push_back(functionUpdate);
+		}
+		return true;
+	}
+
+	void GlobalScope::discardRecompiledFunctions(Program* program) {
+		if (!_recompileArena) {
+			return;
+		}
+
+		// executors of the new scopes are dropped before the scopes
+		program->cancelFunctionUpdate();
+
+		const ScopeRefList& children = getChildren();
+		while (children.size() > _recompileChildCount) {
+			detachChild(children.back().get());
+		}
+		getCodeUpdater()->clear();
+		_recompiledScopes.clear();
+		_recompileArena.reset();
+	}
+
 	const WCHAR* GlobalScope::getErrorCompiledChar() const {
 		return _errorCompiledChar;
 	}
@@ -16,6 +16,8 @@
 #include "function/DynamicFunction2.h"
 #include "MemberVariableAccessors.h"
 #include "ScopeRuntimeData.h"
+#include "ClosureAllocator.h"
+#include "CodeArena.h"
 
 #include <iomanip>
 #include <sstream>
@@ -31,6 +33,14 @@ namespace ffscript {
 
 	InstructionCommand::~InstructionCommand(){
 	}
+
+	void* InstructionCommand::operator new(size_t size) {
+		return CodeArena::allocateObject(size);
+	}
+
+	void InstructionCommand::operator delete(void* data) {
+		CodeArena::deallocateObject(data);
+	}
 	
 	///
 	///
@@ -73,8 +83,7 @@ namespace ffscript {
 		strCommands.emplace_back("allocate(" + std::to_string(_scopeDataSize + _scopeCodeSize) + ") - enter scope");
 	}
 
-	void EnterContextScope::execute() {
-		Context* context = Context::getCurrent();
+	void EnterContextScope::execute(Context* context) {
 		context->pushContext(_constructorCommandCount);
 		context->scopeAllocate(_scopeDataSize, _scopeCodeSize);
 #ifndef THROW_EXCEPTION_ON_ERROR
@@ -85,7 +94,7 @@ namespace ffscript {
 
 		if (_scopeAutoRunList) {
 			for (auto it = _scopeAutoRunList->begin(); it != _scopeAutoRunList->end(); it++) {
-				(*it)->execute();
+				(*it)->execute(context);
 			}
 		}
 	}
@@ -118,12 +127,15 @@ namespace ffscript {
 		}
 	}
 
+	bool ExitContextScope::hasAutoRunCommands() const {
+		return _scopeAutoRunList != nullptr;
+	}
+
 	void ExitContextScope::buildCommandText(std::list<std::string>& strCommands) {		
 		strCommands.emplace_back("unallocate(" + std::to_string(_scopeDataSize + _scopeCodeSize) + ") - exit scope");
 	}
 
-	void ExitContextScope::execute() {
-		Context* context = Context::getCurrent();
+	void ExitContextScope::execute(Context* context) {
 #ifndef THROW_EXCEPTION_ON_ERROR
 		if (context->isError()) {
 			context->scopeUnallocate(_scopeSize);
@@ -133,7 +145,7 @@ namespace ffscript {
 #endif
 		if (_scopeAutoRunList) {
 			for (auto it = _scopeAutoRunList->begin(); it != _scopeAutoRunList->end(); it++) {
-				(*it)->execute();
+				(*it)->execute(context);
 			}
 		}
 		
@@ -159,8 +171,7 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void PushParamRef::execute() {
-		Context* context = Context::getCurrent();
+	void PushParamRef::execute(Context* context) {
 		int offset = getTargetOffset() + context->getCurrentOffset();
 		context->lea(offset, _param);
 	}
@@ -181,8 +192,7 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void PushParamRefOffset::execute() {
-		Context* context = Context::getCurrent();
+	void PushParamRefOffset::execute(Context* context) {
 		int sourceOffset = _sourceOffset + context->getCurrentOffset();
 		int targetOffset = getTargetOffset() + context->getCurrentOffset();
 		context->lea(targetOffset, context->getAbsoluteAddress(sourceOffset));
@@ -207,10 +217,9 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void PushParam::execute() {
-		Context* context = Context::getCurrent();
+	void PushParam::execute(Context* context) {
 		int offset = getTargetOffset() + context->getCurrentOffset();
-		context->write(offset, _param, getTargetSize());
+		context->writeFrame(offset, _param, getTargetSize());
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
@@ -227,8 +236,7 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void LeaOffsetToAddress::execute() {
-		Context* context = Context::getCurrent();
+	void LeaOffsetToAddress::execute(Context* context) {
 		int sourceOffset = _sourceOffset + context->getCurrentOffset();
 		*(size_t*)_target = (size_t)context->getAbsoluteAddress(sourceOffset);
 	}
@@ -247,7 +255,7 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void LeaAddressToAddress::execute() {
+	void LeaAddressToAddress::execute(Context* context) {
 		*(size_t*)_target = (size_t)_source;
 	}
 
@@ -266,8 +274,7 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void LeaOffsetToOffset::execute() {
-		Context* context = Context::getCurrent();
+	void LeaOffsetToOffset::execute(Context* context) {
 		int sourceOffset = _sourceOffset + context->getCurrentOffset();
 		int targetOffset = getTargetOffset() + context->getCurrentOffset();
 
@@ -289,8 +296,7 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void LeaAddressToOffset::execute() {
-		Context* context = Context::getCurrent();
+	void LeaAddressToOffset::execute(Context* context) {
 		int targetOffset = getTargetOffset() + context->getCurrentOffset();
 
 		context->lea(targetOffset, _source);
@@ -316,11 +322,116 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void PushParamOffset::execute() {
-		Context* context = Context::getCurrent();
+	void PushParamOffset::execute(Context* context) {
 		int sourceOffset = _sourceOffset + context->getCurrentOffset();
 		int targetOffset = getTargetOffset() + context->getCurrentOffset();
-		context->write(targetOffset, context->getAbsoluteAddress(sourceOffset), getTargetSize());
+		context->writeFrame(targetOffset, context->getAbsoluteAddress(sourceOffset), getTargetSize());
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	PushGlobalParam::PushGlobalParam() : _sourceOffset(0) {}
+	PushGlobalParam::~PushGlobalParam() {}
+
+	void PushGlobalParam::setCommandData(int sourceOffset, int paramSize, int targetOffset) {
+		_sourceOffset = sourceOffset;
+		setTargetSize(paramSize);
+		setTargetOffset(targetOffset);
+	}
+
+	int PushGlobalParam::getSourceOffset() const {
+		return _sourceOffset;
+	}
+
+	void PushGlobalParam::buildCommandText(std::list<std::string>& strCommands) {
+		std::stringstream ss;
+		ss << "write (global[" << _sourceOffset << "], " << getTargetSize() << ", [" << getTargetOffset() << "])";
+		strCommands.emplace_back(ss.str());
+	}
+
+	void PushGlobalParam::execute(Context* context) {
+		int targetOffset = getTargetOffset() + context->getCurrentOffset();
+		context->writeFrame(targetOffset, context->getGlobalData() + _sourceOffset, getTargetSize());
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	PushGlobalParamRef::PushGlobalParamRef() : _sourceOffset(0), TargetedCommand(0, sizeof(void*)) {}
+	PushGlobalParamRef::~PushGlobalParamRef() {}
+
+	void PushGlobalParamRef::setCommandData(int sourceOffset, int targetOffset) {
+		_sourceOffset = sourceOffset;
+		setTargetOffset(targetOffset);
+	}
+
+	void PushGlobalParamRef::buildCommandText(std::list<std::string>& strCommands) {
+		std::stringstream ss;
+		ss << "lea (global[" << _sourceOffset << "], [" << getTargetOffset() << "])";
+		strCommands.emplace_back(ss.str());
+	}
+
+	void PushGlobalParamRef::execute(Context* context) {
+		int targetOffset = getTargetOffset() + context->getCurrentOffset();
+		context->lea(targetOffset, context->getGlobalData() + _sourceOffset);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	LeaGlobalToOffset::LeaGlobalToOffset() : _sourceOffset(0) {}
+	LeaGlobalToOffset::~LeaGlobalToOffset() {}
+
+	void LeaGlobalToOffset::setCommandData(int sourceOffset, int targetOffset) {
+		_sourceOffset = sourceOffset;
+		setTargetOffset(targetOffset);
+		setTargetSize(sizeof(void*));
+	}
+
+	void LeaGlobalToOffset::buildCommandText(std::list<std::string>& strCommands) {
+		std::stringstream ss;
+		ss << "lea (global[" << _sourceOffset << "], [" << getTargetOffset() << "])";
+		strCommands.emplace_back(ss.str());
+	}
+
+	void LeaGlobalToOffset::execute(Context* context) {
+		int targetOffset = getTargetOffset() + context->getCurrentOffset();
+		context->lea(targetOffset, context->getGlobalData() + _sourceOffset);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	LeaOffsetToGlobal::LeaOffsetToGlobal() : _sourceOffset(0), _targetOffset(0) {}
+	LeaOffsetToGlobal::~LeaOffsetToGlobal() {}
+
+	void LeaOffsetToGlobal::setCommandData(int sourceOffset, int targetOffset) {
+		_sourceOffset = sourceOffset;
+		_targetOffset = targetOffset;
+	}
+
+	void LeaOffsetToGlobal::buildCommandText(std::list<std::string>& strCommands) {
+		std::stringstream ss;
+		ss << "lea ([" << _sourceOffset << "], global[" << _targetOffset << "])";
+		strCommands.emplace_back(ss.str());
+	}
+
+	void LeaOffsetToGlobal::execute(Context* context) {
+		int sourceOffset = _sourceOffset + context->getCurrentOffset();
+		*(size_t*)(context->getGlobalData() + _targetOffset) = (size_t)context->getAbsoluteAddress(sourceOffset);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	LeaGlobalToGlobal::LeaGlobalToGlobal() : _sourceOffset(0), _targetOffset(0) {}
+	LeaGlobalToGlobal::~LeaGlobalToGlobal() {}
+
+	void LeaGlobalToGlobal::setCommandData(int sourceOffset, int targetOffset) {
+		_sourceOffset = sourceOffset;
+		_targetOffset = targetOffset;
+	}
+
+	void LeaGlobalToGlobal::buildCommandText(std::list<std::string>& strCommands) {
+		std::stringstream ss;
+		ss << "lea (global[" << _sourceOffset << "], global[" << _targetOffset << "])";
+		strCommands.emplace_back(ss.str());
+	}
+
+	void LeaGlobalToGlobal::execute(Context* context) {
+		unsigned char* globalData = context->getGlobalData();
+		*(size_t*)(globalData + _targetOffset) = (size_t)(globalData + _sourceOffset);
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
@@ -338,8 +449,7 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void CopyDataToRef::execute() {
-		Context* context = Context::getCurrent();
+	void CopyDataToRef::execute(Context* context) {
 		int targetOffsetRef = getTargetOffset() + context->getCurrentOffset();
 		int sourceOffset = _sourceOffset + context->getCurrentOffset();
 
@@ -365,18 +475,17 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void RetreiveScriptFunctionResult::execute() {
-		Context* context = Context::getCurrent();
+	void RetreiveScriptFunctionResult::execute(Context* context) {
 		int functionResultOffset = context->getCurrentOffset() + context->getCurrentScopeSize();
 		int targetOffset = context->getCurrentOffset() + getTargetOffset();
 
 		void* sourceAddress = context->getAbsoluteAddress(functionResultOffset);
 
-		context->write(targetOffset, sourceAddress, getTargetSize());
+		context->writeFrame(targetOffset, sourceAddress, getTargetSize());
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
-	CallFuntion::CallFuntion() : _beginParamOffset(0){}
+	CallFuntion::CallFuntion() : _beginParamOffset(0), _functionId(-1) {}
 	CallFuntion::~CallFuntion() {}	
 	void CallFuntion::setFunctionName(const std::string& functionName) {
 		_functionName = functionName;
@@ -386,6 +495,14 @@ namespace ffscript {
 		return _beginParamOffset;
 	}
 
+	int CallFuntion::getFunctionId() const {
+		return _functionId;
+	}
+
+	void CallFuntion::setFunctionId(int functionId) {
+		_functionId = functionId;
+	}
+
 	/////////////////////////////////////////////////////////////////////////////////////
 	CallNativeFuntion::CallNativeFuntion() : _targetFunction(nullptr) {}
 	CallNativeFuntion::~CallNativeFuntion() {}
@@ -401,8 +518,7 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}	
 
-	void CallNativeFuntion::execute() {
-		Context* context = Context::getCurrent();
+	void CallNativeFuntion::execute(Context* context) {
 		int currentOffset = context->getCurrentOffset();
 
 		//return offset is at begining of function data offset
@@ -438,34 +554,32 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void FunctionForwarder::execute() {
-		Context* context = Context::getCurrent();
-		int currentOffset = context->getCurrentOffset();
+	void FunctionForwarder::execute(Context* context) {
+		RuntimeFunctionInfo* runtimeInfo = (RuntimeFunctionInfo*)context->getAbsoluteAddress(_funtionInfoOffset + context->getCurrentOffset());
+		callFunctionObject(context, runtimeInfo, getTargetOffset(), _beginParamOffset, _paramSize);
+	}
 
-		//params if any follow by returnOffset
-		int functionInfoOffset = _funtionInfoOffset + currentOffset;
+	void FunctionForwarder::callFunctionObject(Context* context, const RuntimeFunctionInfo* runtimeInfo, int returnOffset, int beginParamOffset, int paramSize) {
+		int currentOffset = context->getCurrentOffset();
 
-		RuntimeFunctionInfo* runtimeInfo = (RuntimeFunctionInfo*)context->getAbsoluteAddress(functionInfoOffset);
-		
 		if (runtimeInfo->info.type == RuntimeFunctionType::NativeFunction) {
-			CallNativeFuntion callNativeFunction;
-			//ref without delete the instance
-			DFunction2Ref refFunction( (DFunction2*) runtimeInfo->address, [](DFunction2*) {});
-			callNativeFunction.setCommandData(getTargetOffset(), _beginParamOffset, refFunction);
-			callNativeFunction.execute();
+			//call the native function like CallNativeFuntion does but without wrapping it by a reference
+			void* returnVal = context->getAbsoluteAddress(returnOffset + currentOffset);
+			void** params = (void**)context->getAbsoluteAddress(beginParamOffset + currentOffset);
+			((DFunction2*)runtimeInfo->address)->call(returnVal, params);
+			return;
 		}
-		else if(runtimeInfo->anoynymousInfo.data == nullptr || runtimeInfo->anoynymousInfo.dataSize == 0) {
-			CallScriptFuntion3 callScriptFunction;
-			callScriptFunction.setTargetCommand((CommandPointer)runtimeInfo->address);
-			callScriptFunction.setCommandData(getTargetOffset(), _beginParamOffset, _paramSize);
-			callScriptFunction.execute();
+
+		bool isLambda = runtimeInfo->anoynymousInfo.data != nullptr && runtimeInfo->anoynymousInfo.dataSize != 0;
+		int capturedDataSize = isLambda ? runtimeInfo->anoynymousInfo.dataSize : 0;
+		CommandPointer targetFunction = ((const FunctionEntry*)runtimeInfo->address)->load(std::memory_order_acquire);
+		if (!CallScriptFuntion2::pushFunctionFrame(context, targetFunction, returnOffset, beginParamOffset, paramSize, capturedDataSize)) {
+			return;
 		}
-		else {
-			CallLambdaFuntion callLambdaFunction(&runtimeInfo->anoynymousInfo);
-			callLambdaFunction.setTargetCommand((CommandPointer)runtimeInfo->address);
-			callLambdaFunction.setCommandData(getTargetOffset(), _beginParamOffset, _paramSize);
-			callLambdaFunction.execute();
+		if (isLambda) {
+			CallLambdaFuntion::writeCapturedData(context, &runtimeInfo->anoynymousInfo, paramSize);
 		}
+		context->runFunctionScript();
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
@@ -481,8 +595,7 @@ namespace ffscript {
 		CallNativeFuntion::buildCommandText(strCommands);
 	}
 
-	void CallNativeFuntionWithAssitInfo::execute() {
-		Context* context = Context::getCurrent();
+	void CallNativeFuntionWithAssitInfo::execute(Context* context) {
 		int currentOffset = context->getCurrentOffset();
 
 		int nParam = _pairCount;
@@ -502,7 +615,7 @@ namespace ffscript {
 			pInfo++;
 		}
 
-		CallNativeFuntion::execute();
+		CallNativeFuntion::execute(context);
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
@@ -535,8 +648,7 @@ namespace ffscript {
 		_sizes = sizes;
 	}
 
-	void CallDynamicFuntion::execute() {
-		Context* context = Context::getCurrent();
+	void CallDynamicFuntion::execute(Context* context) {
 		int currentOffset = context->getCurrentOffset();
 		int nParam = _pairCount;
 
@@ -580,7 +692,7 @@ namespace ffscript {
 			elem++;
 		}
 
-		CallNativeFuntion::execute();
+		CallNativeFuntion::execute(context);
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
@@ -602,8 +714,7 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void CallScriptFuntion::execute() {
-		Context* context = Context::getCurrent();
+	void CallScriptFuntion::execute(Context* context) {
 		int currentOffset = context->getCurrentOffset();
 
 		//int returnOffset = _returnOffset + currentOffset;
@@ -636,7 +747,7 @@ namespace ffscript {
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
-	CallScriptFuntion2::CallScriptFuntion2() : _targetFunction(nullptr), _paramSize(0) {}
+	CallScriptFuntion2::CallScriptFuntion2() : _targetFunction(nullptr), _functionEntry(nullptr), _callerReturn(nullptr), _paramSize(0) {}
 	CallScriptFuntion2::~CallScriptFuntion2() {}
 	void CallScriptFuntion2::setCommandData(int returnOffset, int beginParamOffset, int paramSize) {
 		setTargetOffset(returnOffset);
@@ -646,11 +757,29 @@ namespace ffscript {
 
 	void CallScriptFuntion2::setTargetCommand(CommandPointer targetFunction) {
 		_targetFunction = targetFunction;
+		_functionEntry = nullptr;
+	}
+
+	void CallScriptFuntion2::setFunctionEntry(const FunctionEntry* functionEntry) {
+		_targetFunction = nullptr;
+		_functionEntry = functionEntry;
+	}
+
+	CommandPointer CallScriptFuntion2::getTargetCommand() const {
+		return _functionEntry ? _functionEntry->load(std::memory_order_acquire) : _targetFunction;
+	}
+
+	void CallScriptFuntion2::setCallerReturn(CommandPointer callerReturn) {
+		_callerReturn = callerReturn;
+	}
+
+	CommandPointer CallScriptFuntion2::getCallerReturn() const {
+		return _callerReturn;
 	}
 
 	void CallScriptFuntion2::buildCommandText(std::list<std::string>& strCommands) {
 		std::stringstream ss;
-		ss << "invoke (" << _functionName << ", [" << _beginParamOffset << "], " << _paramSize << ", [" << getTargetOffset() << "])";
+		ss << (_callerReturn ? "tailinvoke (" : "invoke (") << _functionName << ", [" << _beginParamOffset << "], " << _paramSize << ", [" << getTargetOffset() << "])";
 		strCommands.emplace_back(ss.str());
 	}
 
@@ -665,12 +794,49 @@ namespace ffscript {
 		return getReturnOffset(context) + sizeof(void*);
 	}
 
-	void CallScriptFuntion2::execute() {
-		Context* context = Context::getCurrent();
+	void CallScriptFuntion2::execute(Context* context) {
+		enterFunction(context);
+	}
+
+	void CallScriptFuntion2::enterFunction(Context* context) {
+		if (_callerReturn) {
+			enterTailFunction(context);
+			return;
+		}
+		pushFunctionFrame(context, getTargetCommand(), getTargetOffset(), _beginParamOffset, _paramSize, 0);
+	}
+
+	void CallScriptFuntion2::enterTailFunction(Context* context) {
+		// the function writes its result where the caller was asked to write its own
+		void* returnAddress = *(void**)context->getAbsoluteAddress(ffscript::getReturnOffset(context));
+		void* beginParamAddress = context->getAbsoluteAddress(context->getCurrentOffset() + _beginParamOffset);
+
+		// leave scopes of the caller, its frame is popped and the context comes back
+		// to the command that called the caller. The params are not touched by it
+		(*_callerReturn)->execute(context);
+#ifndef THROW_EXCEPTION_ON_ERROR
+		if (context->isError()) {
+			return;
+		}
+#endif
+		// the frame of the function is pushed at the place of the caller's frame
+		context->pushScope();
+		int currentOffset = ffscript::getReturnOffset(context);
+		if (!context->prepareWrite(currentOffset, sizeof(void*) + _paramSize)) {
+			return;
+		}
+		context->lea(currentOffset, returnAddress);
+		// the params are still in the old frame, they may overlap their new place
+		memmove(context->getAbsoluteAddress(ffscript::getBeginParamOffset(context)), beginParamAddress, _paramSize);
+
+		context->jump(getTargetCommand());
+	}
+
+	bool CallScriptFuntion2::pushFunctionFrame(Context* context, CommandPointer targetFunction, int returnOffset, int beginParamOffset, int paramSize, int capturedDataSize) {
 		int currentOffset = context->getCurrentOffset();
 
-		int returnOffset = getTargetOffset() + currentOffset;
-		int beginParamOffset = _beginParamOffset + currentOffset;
+		returnOffset += currentOffset;
+		beginParamOffset += currentOffset;
 
 		void* returnAddress = context->getAbsoluteAddress(returnOffset);
 		void* beginParamAddress = context->getAbsoluteAddress(beginParamOffset);
@@ -683,41 +849,49 @@ namespace ffscript {
 		//after move offset the current offset will change to begin of function memory space
 		currentOffset = ffscript::getReturnOffset(context);
 
+		//the only check of the data passed to the function, the rest of its frame
+		//is verified when the function scope is allocated
+		if (!context->prepareWrite(currentOffset, sizeof(void*) + paramSize + capturedDataSize)) {
+			return false;
+		}
+
 		//store return address at first block of function
 		context->lea(currentOffset, returnAddress);
 		
 		currentOffset = ffscript::getBeginParamOffset(context);
-		context->write(currentOffset, beginParamAddress, _paramSize);
-#ifndef THROW_EXCEPTION_ON_ERROR
-		if (context->isError()) {
-			return;
-		}
-#endif
+		context->writeFrame(currentOffset, beginParamAddress, paramSize);
+
 		//set command cursor is the previous command of the function
 		//to allow the thread context will execute the first command in the next loop
-		context->jump(_targetFunction);
+		context->jump(targetFunction);
+		return true;
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
 	CallScriptFuntion3::CallScriptFuntion3(){}	
 	
-	void CallScriptFuntion3::execute() {
-		CallScriptFuntion2::execute();
-		Context* context = Context::getCurrent();
+	void CallScriptFuntion3::execute(Context* context) {
+		enterFunction(context);
 		context->runFunctionScript();
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
 	CallLambdaFuntion::CallLambdaFuntion(AnoynymousDataInfo* data) : _anoynymousInfo(data) {}
 
-	void CallLambdaFuntion::execute() {
-		CallScriptFuntion2::execute();
+	void CallLambdaFuntion::enterFunction(Context* context) {
+		if (pushFunctionFrame(context, getTargetCommand(), getTargetOffset(), _beginParamOffset, _paramSize, _anoynymousInfo->dataSize)) {
+			writeCapturedData(context, _anoynymousInfo, _paramSize);
+		}
+	}
 
-		Context* context = Context::getCurrent();
+	void CallLambdaFuntion::writeCapturedData(Context* context, const AnoynymousDataInfo* anoynymousInfo, int paramSize) {
 		auto beginParamOffset = ffscript::getBeginParamOffset(context);
-		auto anoynymousDataOffset = beginParamOffset + _paramSize;
-		context->write(anoynymousDataOffset, _anoynymousInfo->data, _anoynymousInfo->dataSize);
+		auto anoynymousDataOffset = beginParamOffset + paramSize;
+		context->writeFrame(anoynymousDataOffset, anoynymousInfo->data, anoynymousInfo->dataSize);
+	}
 
+	void CallLambdaFuntion::execute(Context* context) {
+		enterFunction(context);
 		context->runFunctionScript();
 	}
 
@@ -734,8 +908,7 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void Jump::execute() {
-		Context* context = Context::getCurrent();
+	void Jump::execute(Context* context) {
 		context->jump(_targetCommand);
 	}
 
@@ -753,8 +926,7 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void JumpIf::execute() {
-		Context* context = Context::getCurrent();
+	void JumpIf::execute(Context* context) {
  		int conditionOffset = _conditionOffset + context->getCurrentOffset();
 
 		bool* conditionValue = (bool*)context->getAbsoluteAddress(conditionOffset);
@@ -777,8 +949,7 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void JumpIfElse::execute() {
-		Context* context = Context::getCurrent();
+	void JumpIfElse::execute(Context* context) {
 		int conditionOffset = _conditionOffset + context->getCurrentOffset();
 		bool* conditionValue = (bool*)context->getAbsoluteAddress(conditionOffset);
 
@@ -808,13 +979,12 @@ namespace ffscript {
 		_indexPreventDestructorRun = indexPreventDestructorRun;
 	}
 
-	void ExitScriptFuntionAtReturn::execute() {
+	void ExitScriptFuntionAtReturn::execute(Context* context) {
 		if (_indexPreventDestructorRun >= 0) {
-			Context* context = Context::getCurrent();
 			auto scopeRuntimeData = context->getScopeRuntimeData();
 			scopeRuntimeData->markContructorNotExecuted(_indexPreventDestructorRun);
 		}
-		MultipleCommand::execute();
+		MultipleCommand::execute(context);
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
@@ -825,8 +995,7 @@ namespace ffscript {
 		strCommands.emplace_back("return()");
 	}
 
-	void ExitFunctionAtTheEnd::execute() {
-		Context* context = Context::getCurrent();		
+	void ExitFunctionAtTheEnd::execute(Context* context) {
 		context->popContext();
 		context->popScope();
 	}
@@ -845,9 +1014,9 @@ namespace ffscript {
 		}
 	}
 
-	void MultipleCommand::execute() {
+	void MultipleCommand::execute(Context* context) {
 		for (auto it = _commands.begin(); it != _commands.end(); it++) {
-			(*it)->execute();
+			(*it)->execute(context);
 		}
 	}
 
@@ -855,7 +1024,7 @@ namespace ffscript {
 	BreakCommand::BreakCommand() {}
 	BreakCommand::~BreakCommand() {}
 	void BreakCommand::buildCommandText(std::list<std::string>& strCommands) {
-		MultipleCommand::execute();
+		MultipleCommand::buildCommandText(strCommands);
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
@@ -873,9 +1042,8 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void ContinueCommand::execute() {
-		MultipleCommand::execute();
-		Context* context = Context::getCurrent();
+	void ContinueCommand::execute(Context* context) {
+		MultipleCommand::execute(context);
 
 		context->jump(_loopCommand);
 	}
@@ -906,9 +1074,7 @@ namespace ffscript {
 				strCommands.emplace_back("lea ([current_offset()], REGISTER)");
 			}
 			else if(accessorTmp = dynamic_cast<MVGlobalAccessor*>(accessor)) {
-				std::stringstream ss;
-				ss << "lea(" << int_to_hex(((MVGlobalAccessor*)accessor)->access(nullptr)) << ", REGISTER)";
-				strCommands.emplace_back("lea ([current_offset()], REGISTER)");
+				strCommands.emplace_back("lea (global[" + std::to_string(((MVGlobalAccessor*)accessor)->_offset) + "], REGISTER)");
 			}
 			else if (accessorTmp = dynamic_cast<MVOffsetAccessor*>(accessor)) {
 				strCommands.emplace_back("add(REGISTER, " + std::to_string(((MVOffsetAccessor*)accessor)->_offset) + ")");
@@ -922,20 +1088,19 @@ namespace ffscript {
 		ss << "write(REGISTER, [" << getTargetOffset() << "])";
 	}
 
-	void PushMemberVariableParam::execute() {
-		Context* context = Context::getCurrent();
+	void PushMemberVariableParam::execute(Context* context) {
 		MemberVariableAccessor** accessors = _accessors->data();
 		size_t count = _accessors->size();
 		MemberVariableAccessor** end = accessors + count;
 
-		void* address = (*accessors)->access(nullptr);
+		void* address = (*accessors)->accessRoot(context);
 
 		for (accessors++; accessors < end; accessors++) {
 			address = (*accessors)->access(address);
 		}
 
 		int targetOffset = getTargetOffset() + context->getCurrentOffset();
-		context->write(targetOffset, address, getTargetSize());
+		context->writeFrame(targetOffset, address, getTargetSize());
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
@@ -956,7 +1121,6 @@ namespace ffscript {
 	}
 
 	void PushMemberVariableParamRef::buildCommandText(std::list<std::string>& strCommands) {
-		Context* context = Context::getCurrent();
 		MemberVariableAccessor* accessor, *accessorTmp;
 		for (auto it = _accessors->begin(); it != _accessors->end(); it++) {
 			accessor = *it;
@@ -964,9 +1128,7 @@ namespace ffscript {
 				strCommands.emplace_back("lea ([current_offset()], REGISTER)");
 			}
 			else if (accessorTmp = dynamic_cast<MVGlobalAccessor*>(accessor)) {
-				std::stringstream ss;
-				ss << "lea (" << int_to_hex(((MVGlobalAccessor*)accessor)->access(nullptr)) << ", REGISTER)";
-				strCommands.emplace_back("lea ([current_offset()], REGISTER)");
+				strCommands.emplace_back("lea (global[" + std::to_string(((MVGlobalAccessor*)accessor)->_offset) + "], REGISTER)");
 			}
 			else if (accessorTmp = dynamic_cast<MVOffsetAccessor*>(accessor)) {
 				strCommands.emplace_back("add(REGISTER, " + std::to_string(((MVOffsetAccessor*)accessor)->_offset) + ")");
@@ -982,13 +1144,12 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void PushMemberVariableParamRef::execute() {
-		Context* context = Context::getCurrent();
+	void PushMemberVariableParamRef::execute(Context* context) {
 		MemberVariableAccessor** accessors = _accessors->data();
 		size_t count = _accessors->size();
 		MemberVariableAccessor** end = accessors + count;
 
-		void* address = (*accessors)->access(nullptr);
+		void* address = (*accessors)->accessRoot(context);
 
 		for (accessors++; accessors < end; accessors++) {
 			address = (*accessors)->access(address);
@@ -1008,7 +1169,7 @@ namespace ffscript {
 		_dataSize = dataSize;
 	}
 
-	void CallCreateLambda::setLambdaAddress(CommandPointer anoynymousTargetFunction, int destDataOffset) {
+	void CallCreateLambda::setLambdaAddress(const FunctionEntry* anoynymousTargetFunction, int destDataOffset) {
 		_anoynymousTargetFunction = anoynymousTargetFunction;
 		_destDataOffset = destDataOffset;
 	}
@@ -1019,8 +1180,7 @@ namespace ffscript {
 		strCommands.emplace_back(ss.str());
 	}
 
-	void CallCreateLambda::execute() {		
-		Context* context = Context::getCurrent();
+	void CallCreateLambda::execute(Context* context) {
 		int currentOffset = context->getCurrentOffset();
 
 		//return offset is at begining of function data offset
@@ -1033,8 +1193,8 @@ namespace ffscript {
 		void* dataAddress = context->getAbsoluteAddress(beginDataOffset);
 
 		RuntimeFunctionInfo* runtimeData = (RuntimeFunctionInfo*)returnVal;
-		runtimeData->address = _anoynymousTargetFunction;
-		runtimeData->anoynymousInfo.data = malloc(_dataSize);
+		runtimeData->address = (void*)_anoynymousTargetFunction;
+		runtimeData->anoynymousInfo.data = ClosureAllocator::allocate(_dataSize);
 		runtimeData->anoynymousInfo.targetOffset = _destDataOffset;
 		runtimeData->anoynymousInfo.dataSize = _dataSize;
 		memcpy_s(runtimeData->anoynymousInfo.data, _dataSize, dataAddress, _dataSize);
@@ -23,10 +23,14 @@ class DFunction2;
 
 #define BEGIN_INSTRUCTION_COMMAND_DECLARE(className, baseClass) \
  	class className : public baseClass { \
+		friend class ThreadedCode; \
+		friend class FlatCode; \
+		friend class CompareAndJump; \
+		friend class ProgramCache; \
 	public: \
 		className(); \
 		virtual ~className(); \
-		virtual void execute(); \
+		virtual void execute(Context* context); \
 		virtual void buildCommandText(std::list<std::string>& strCommands)
 
 #define END_INSTRUCTION_COMMAND_DECLARE(className) }
@@ -41,7 +45,10 @@ namespace ffscript {
 	public:
 		InstructionCommand();
 		virtual ~InstructionCommand();
-		virtual void execute() = 0;
+		// commands created while compiling a program are kept in the program's code arena
+		static void* operator new(size_t size);
+		static void operator delete(void* data);
+		virtual void execute(Context* context) = 0;
 		virtual void buildCommandText(std::list<std::string>& strCommands) = 0;
 	};
 
@@ -92,6 +99,7 @@ public:
 	void setScopeInfo(int dataSize, int codeSize);
 	void setRestoreCallFlag(bool blRestoreCall);
 	void storeAutoRunCommand(ScopeAutoRunList& autoRunCommandList);
+	bool hasAutoRunCommands() const;
 	END_INSTRUCTION_COMMAND_DECLARE(ExitContextScope);
 
 	////////////////////////////////////////////////////
@@ -162,6 +170,51 @@ public:
 	int getSourceOffset() const;
 	END_INSTRUCTION_COMMAND_DECLARE(PushParamOffset);
 
+	////////////////////////////////////////////////////
+	// commands those access global variables, sources and targets of them are
+	// offsets from the global data of the running context
+	BEGIN_INSTRUCTION_COMMAND_DECLARE(PushGlobalParam, TargetedCommand);
+private:
+	int _sourceOffset;
+public:
+	void setCommandData(int sourceOffset, int paramSize, int targetOffset);
+	int getSourceOffset() const;
+	END_INSTRUCTION_COMMAND_DECLARE(PushGlobalParam);
+
+	////////////////////////////////////////////////////
+	BEGIN_INSTRUCTION_COMMAND_DECLARE(PushGlobalParamRef, TargetedCommand);
+private:
+	int _sourceOffset;
+public:
+	void setCommandData(int sourceOffset, int targetOffset);
+	END_INSTRUCTION_COMMAND_DECLARE(PushGlobalParamRef);
+
+	////////////////////////////////////////////////////
+	BEGIN_INSTRUCTION_COMMAND_DECLARE(LeaGlobalToOffset, TargetedCommand);
+private:
+	int _sourceOffset;
+public:
+	void setCommandData(int sourceOffset, int targetOffset);
+	END_INSTRUCTION_COMMAND_DECLARE(LeaGlobalToOffset);
+
+	////////////////////////////////////////////////////
+	BEGIN_INSTRUCTION_COMMAND_DECLARE(LeaOffsetToGlobal, InstructionCommand);
+private:
+	int _sourceOffset;
+	int _targetOffset;
+public:
+	void setCommandData(int sourceOffset, int targetOffset);
+	END_INSTRUCTION_COMMAND_DECLARE(LeaOffsetToGlobal);
+
+	////////////////////////////////////////////////////
+	BEGIN_INSTRUCTION_COMMAND_DECLARE(LeaGlobalToGlobal, InstructionCommand);
+private:
+	int _sourceOffset;
+	int _targetOffset;
+public:
+	void setCommandData(int sourceOffset, int targetOffset);
+	END_INSTRUCTION_COMMAND_DECLARE(LeaGlobalToGlobal);
+
 	////////////////////////////////////////////////////
 	BEGIN_INSTRUCTION_COMMAND_DECLARE(CopyDataToRef, TargetedCommand);
 private:	
@@ -179,19 +232,25 @@ public:
 	///////////////////////////////////////////////////
 	class CallFuntion : public TargetedCommand
 	{
+		friend class ProgramCache;
 	protected:
 		int _beginParamOffset;		
 		std::string _functionName;
+		// id of the registered function that the command calls, it is -1 if the command
+		// does not call a registered function directly
+		int _functionId;
 	public:
 		CallFuntion();
 		int getBeginParamOffset() const;
 		void setFunctionName(const std::string& functionName);
+		int getFunctionId() const;
+		void setFunctionId(int functionId);
 		virtual ~CallFuntion();		
 	};
 
 	////////////////////////////////////////////////////
 	BEGIN_INSTRUCTION_COMMAND_DECLARE(CallNativeFuntion, CallFuntion);
-private:
+protected:
 	DFunction2Ref _targetFunction;
 public:
 	void setCommandData(int returnOffset, int beginParamOffset, const DFunction2Ref& targetFunction);
@@ -204,6 +263,9 @@ private:
 	int _paramSize;
 public:
 	void setCommandData(int funtionInfoOffset, int returnOffset, int beginParamOffset, int paramSize);
+	// call the function that a function object refers to, offsets are relative to current offset
+	// of the context. The call is dispatched directly without creating temporary call commands
+	static void callFunctionObject(Context* context, const RuntimeFunctionInfo* runtimeInfo, int returnOffset, int beginParamOffset, int paramSize);
 	END_INSTRUCTION_COMMAND_DECLARE(FunctionForwarder);
 
 	////////////////////////////////////////////////////
@@ -240,16 +302,36 @@ public:
 protected:
 	int _paramSize;
 	CommandPointer _targetFunction;
+	// entry of the target function, the command is loaded from it when the
+	// function is entered. It is null if the target command is fixed
+	const FunctionEntry* _functionEntry;
+	// return command of the caller when the call is a tail call, it is run before
+	// the function is entered, so the function takes the frame of the caller and
+	// returns its result to the caller of the caller. It is null for other calls
+	CommandPointer _callerReturn;
 public:
 	void setCommandData(int returnOffset, int beginParamOffset, int paramSize);
 	void setTargetCommand(CommandPointer targetFunction);
+	void setFunctionEntry(const FunctionEntry* functionEntry);
+	CommandPointer getTargetCommand() const;
+	void setCallerReturn(CommandPointer callerReturn);
+	CommandPointer getCallerReturn() const;
+	// push frame of the function and jump to its first command, the running
+	// loop of the context will run the function and come back after it returns
+	virtual void enterFunction(Context* context);
+	// push frame of a function and jump to its first command, return false if it failed.
+	// The data passed to the function is verified here, so it is written without checks
+	static bool pushFunctionFrame(Context* context, CommandPointer targetFunction, int returnOffset, int beginParamOffset, int paramSize, int capturedDataSize);
+protected:
+	// leave the caller, then move params over its frame and jump to the function
+	void enterTailFunction(Context* context);
 	END_INSTRUCTION_COMMAND_DECLARE(CallScriptFuntion2);
 
 	////////////////////////////////////////////////////
 	class CallScriptFuntion3 : public CallScriptFuntion2 {
 	public:
 		CallScriptFuntion3();
-		void execute();
+		void execute(Context* context);
 	};
 
 	////////////////////////////////////////////////////
@@ -257,7 +339,11 @@ public:
 		AnoynymousDataInfo* _anoynymousInfo;
 	public:
 		CallLambdaFuntion(AnoynymousDataInfo* data);
-		void execute();
+		void execute(Context* context);
+		void enterFunction(Context* context);
+		// write captured data of a lambda after params of the function frame was pushed,
+		// the frame must be pushed with size of captured data
+		static void writeCapturedData(Context* context, const AnoynymousDataInfo* anoynymousInfo, int paramSize);
 	};
 
 	////////////////////////////////////////////////////
@@ -303,12 +389,13 @@ public:
 
 	///////////////////////////////////////////////////
 	class ExitScriptFuntionAtReturn : public MultipleCommand {
+		friend class ProgramCache;
 		int _indexPreventDestructorRun;
 	public:
 		ExitScriptFuntionAtReturn();
 		virtual ~ExitScriptFuntionAtReturn();
 		virtual void buildCommandText(std::list<std::string>& strCommands);
-		virtual void execute();
+		virtual void execute(Context* context);
 		void setCommandData(int indexPreventDestructorRun);
 	};
 
@@ -344,9 +431,9 @@ private:
 	int _srcDataOffset;
 	int _destDataOffset;
 	int _dataSize;
-	CommandPointer _anoynymousTargetFunction;
+	const FunctionEntry* _anoynymousTargetFunction;
 public:
 	void setCommandData(int returnOffset, int dataOffset, int dataSize);
-	void setLambdaAddress(CommandPointer anoynymousTargetFunction, int destDataOffset);
+	void setLambdaAddress(const FunctionEntry* anoynymousTargetFunction, int destDataOffset);
 	END_INSTRUCTION_COMMAND_DECLARE(CallCreateLambda);
 }
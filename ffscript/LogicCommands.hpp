@@ -35,16 +35,24 @@ namespace ffscript {
 		}
 
 		virtual ~OptimizedLogicCommandT() {}
+
+		virtual bool testParam1(void* paramData) const {
+			return this->fVal1(paramData) != 0;
+		}
+
+		virtual bool testParam2(void* paramData) const {
+			return this->fVal2(paramData) != 0;
+		}
 	};
 	////////////////////////////////////////////////////
 	template <class T1, class T2>
 	class LogicAndCommandT : public OptimizedLogicCommandT<T1, T2> {
 	public:
 		LogicAndCommandT(bool param1IsRef, bool param2IsRef) : OptimizedLogicCommandT<T1, T2>(param1IsRef, param2IsRef) {}
-		virtual void execute() {
-			this->_commandParam1->execute();
+		virtual bool getShortCutValue() const { return false; }
+		virtual void execute(Context* context) {
+			this->_commandParam1->execute(context);
 
-			Context* context = Context::getCurrent();
 			int paramOffset = this->_commandParam1->getTargetOffset() + context->getCurrentOffset();
 			int returnOffset = this->getTargetOffset() + context->getCurrentOffset();
 			void* paramValueRef1 = context->getAbsoluteAddress(paramOffset);
@@ -54,7 +62,7 @@ namespace ffscript {
 				*resultValueRef = false;
 			}
 			else {
-				this->_commandParam2->execute();
+				this->_commandParam2->execute(context);
 				paramOffset = this->_commandParam2->getTargetOffset() + context->getCurrentOffset();
 				void* paramValueRef2 = context->getAbsoluteAddress(paramOffset);
 				*resultValueRef = (this->fVal2(paramValueRef2) != 0);
@@ -75,10 +83,10 @@ namespace ffscript {
 	class LogicOrCommandT : public OptimizedLogicCommandT<T1, T2> {
 	public:
 		LogicOrCommandT(bool param1IsRef, bool param2IsRef) : OptimizedLogicCommandT<T1, T2>(param1IsRef, param2IsRef) {}
-		virtual void execute() {
-			this->_commandParam1->execute();
+		virtual bool getShortCutValue() const { return true; }
+		virtual void execute(Context* context) {
+			this->_commandParam1->execute(context);
 
-			Context* context = Context::getCurrent();
 			int paramOffset = this->_commandParam1->getTargetOffset() + context->getCurrentOffset();
 			int returnOffset = this->getTargetOffset() + context->getCurrentOffset();
 			void* paramValueRef1 = (T1*)context->getAbsoluteAddress(paramOffset);
@@ -88,10 +96,10 @@ namespace ffscript {
 				*resultValueRef = true;
 			}
 			else {
-				this->_commandParam2->execute();
+				this->_commandParam2->execute(context);
 				paramOffset = this->_commandParam2->getTargetOffset() + context->getCurrentOffset();
 				void* paramValueRef2 = context->getAbsoluteAddress(paramOffset);
-				*resultValueRef = (this->fVal1(paramValueRef2) != 0);
+				*resultValueRef = (this->fVal2(paramValueRef2) != 0);
 			}
 		}
 
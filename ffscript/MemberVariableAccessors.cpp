@@ -18,6 +18,10 @@ namespace ffscript {
 	MemberVariableAccessor::MemberVariableAccessor() {}
 	MemberVariableAccessor::~MemberVariableAccessor() {}
 
+	void* MemberVariableAccessor::accessRoot(Context* context) {
+		return access(context->getAbsoluteAddress(context->getCurrentOffset()));
+	}
+
 	/////////////////////////////////////////////////////////////////////////////////////////
 	MVOffsetAccessor::MVOffsetAccessor(int offset) : _offset(offset) {}
 
@@ -31,14 +35,18 @@ namespace ffscript {
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////////
-	void* MVContextAccessor::access(void*) {
-		Context* context = Context::getCurrent();
-		return context->getAbsoluteAddress(context->getCurrentOffset());
+	// the address given to the first accessor is the address of current frame
+	void* MVContextAccessor::access(void* frameAddress) {
+		return frameAddress;
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////////
-	MVGlobalAccessor::MVGlobalAccessor(void* address) : _address(address) {}
-	void* MVGlobalAccessor::access(void*) {
-		return _address;
+	MVGlobalAccessor::MVGlobalAccessor(int offset) : _offset(offset) {}
+	void* MVGlobalAccessor::access(void* globalData) {
+		return ((char*)globalData) + _offset;
+	}
+
+	void* MVGlobalAccessor::accessRoot(Context* context) {
+		return access(context->getGlobalData());
 	}
 }
\ No newline at end of file
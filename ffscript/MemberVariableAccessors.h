@@ -13,12 +13,17 @@
 
 #pragma once
 namespace ffscript {
+	class Context;
+
 	class MemberVariableAccessor
 	{
 	public:
 		MemberVariableAccessor();
 		virtual ~MemberVariableAccessor();
 		virtual void* access(void* address) = 0;
+		// access the address for the first accessor of the chain, by default
+		// the address is accessed from the current frame of the context
+		virtual void* accessRoot(Context* context);
 	};
 
 	class MVContextAccessor : public MemberVariableAccessor {
@@ -28,10 +33,12 @@ namespace ffscript {
 
 	class MVGlobalAccessor : public MemberVariableAccessor {
 	public:
-		void* _address;
+		// offset of the variable from the global data
+		int _offset;
 	public:
-		MVGlobalAccessor(void* address);
-		void* access(void* address);
+		MVGlobalAccessor(int offset);
+		void* access(void* globalData);
+		void* accessRoot(Context* context);
 	};
 
 	class MVOffsetAccessor : public MemberVariableAccessor {
@@ -12,6 +12,7 @@
 **********************************************************************/
 
 #include "MemoryBlock.h"
+#include "CodeArena.h"
 
 #include <stdlib.h>
 
@@ -20,17 +21,27 @@ namespace ffscript {
 	MemoryBlock::MemoryBlock() {}
 	MemoryBlock::~MemoryBlock() {}
 
-	BufferBlock::BufferBlock(int size){
-		_buffer = (unsigned char*) malloc(size);
+	void* MemoryBlock::operator new(size_t size) {
+		return CodeArena::allocateObject(size);
+	}
+
+	void MemoryBlock::operator delete(void* data) {
+		CodeArena::deallocateObject(data);
+	}
+
+	BufferBlock::BufferBlock(int size) : _size(size) {
+		_buffer = (unsigned char*)CodeArena::allocateObject(size);
 	}
 
 	BufferBlock::~BufferBlock(){
-		if (_buffer) {
-			free(_buffer);
-		}
+		CodeArena::deallocateObject(_buffer);
 	}
 
 	void* BufferBlock::getDataRef() {
 		return _buffer;
 	}
+
+	int BufferBlock::getSize() const {
+		return _size;
+	}
 }
\ No newline at end of file
@@ -20,7 +20,10 @@ namespace ffscript {
 	{
 	public:
 		MemoryBlock();
-		virtual ~MemoryBlock();		
+		virtual ~MemoryBlock();
+		// constant blocks created while compiling a program are kept in the program's code arena
+		static void* operator new(size_t size);
+		static void operator delete(void* data);
 		virtual void* getDataRef() = 0;
 	};
 
@@ -32,6 +35,7 @@ namespace ffscript {
 		BufferBlock(int size);
 		virtual ~BufferBlock();
 		void* getDataRef();
+		int getSize() const;
 	};
 
 	template <class T>
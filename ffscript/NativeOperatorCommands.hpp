@@ -0,0 +1,174 @@
+/******************************************************************
+* File:        NativeOperatorCommands.hpp
+* Description: define command template classes for built-in operators
+*              of primitive types. Instances of these classes run the
+*              operator directly on the context memory instead of
+*              calling the native function object of the operator.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "InstructionCommand.h"
+#include "Context.h"
+#include "function/MemberTypeInfo.hpp"
+#include <sstream>
+#include <memory>
+#include <utility>
+#include <type_traits>
+
+namespace ffscript {
+	// maximum number of params of a built-in operator
+	#define NATIVE_OPERATOR_MAX_PARAM 2
+
+	// test a comparison of two params, each param is at the given address and it
+	// is accessed in the same way the operator command accesses its param
+	typedef bool(*ConditionFx)(char* param1, bool directRef1, char* param2, bool directRef2);
+
+	class NativeOperatorCommand : public CallFuntion {
+	protected:
+		int _paramCount;
+		// offset of each param, relative to current offset
+		int _paramOffsets[NATIVE_OPERATOR_MAX_PARAM];
+		// a reference param is accessed directly at its offset
+		// instead of through the address stored at its offset
+		bool _directRefs[NATIVE_OPERATOR_MAX_PARAM];
+	public:
+		NativeOperatorCommand(int paramCount, int returnOffset, int beginParamOffset) : _paramCount(paramCount) {
+			setTargetOffset(returnOffset);
+			_beginParamOffset = beginParamOffset;
+			for (int i = 0; i < NATIVE_OPERATOR_MAX_PARAM; i++) {
+				_paramOffsets[i] = beginParamOffset;
+				_directRefs[i] = false;
+			}
+		}
+
+		virtual ~NativeOperatorCommand() {}
+
+		inline int getParamCount() const { return _paramCount; }
+		inline int getParamOffset(int paramIndex) const { return _paramOffsets[paramIndex]; }
+		inline bool isDirectRef(int paramIndex) const { return _directRefs[paramIndex]; }
+
+		// comparisons of primitive values can be tested without the command,
+		// so a branch command can test its condition directly
+		virtual ConditionFx getConditionFx() const { return nullptr; }
+
+		void setParamOffset(int paramIndex, int offset, bool directRef) {
+			_paramOffsets[paramIndex] = offset;
+			_directRefs[paramIndex] = directRef;
+		}
+
+		virtual void buildCommandText(std::list<std::string>& strCommands) {
+			std::stringstream ss;
+			ss << "op (" << _functionName;
+			for (int i = 0; i < _paramCount; i++) {
+				ss << ", " << (_directRefs[i] ? "[&" : "[") << _paramOffsets[i] << "]";
+			}
+			ss << ", [" << getTargetOffset() << "])";
+			strCommands.emplace_back(ss.str());
+		}
+	};
+
+	// factory class that create a command for a registered native function
+	class NativeCommandFactory {
+	public:
+		virtual ~NativeCommandFactory() {}
+		virtual NativeOperatorCommand* createCommand(int returnOffset, int beginParamOffset) = 0;
+	};
+
+	typedef std::shared_ptr<NativeCommandFactory> NativeCommandFactoryRef;
+
+	template <class CommandT>
+	class DefaultNativeCommandFactory : public NativeCommandFactory {
+	public:
+		NativeOperatorCommand* createCommand(int returnOffset, int beginParamOffset) {
+			return new CommandT(returnOffset, beginParamOffset);
+		}
+	};
+
+	// param layout in the context is same as layout used by FunctionDelegate3,
+	// a reference param stores address of its value
+	template <class T>
+	struct OperatorParam {
+		static inline T& get(char* p, bool) { return *((T*)p); }
+	};
+
+	template <class T>
+	struct OperatorParam<T&> {
+		static inline T& get(char* p, bool directRef) { return directRef ? *((T*)p) : **((T**)p); }
+	};
+
+	template <class RT>
+	struct OperatorResult {
+		template <class Fx, class...Args>
+		static inline void invoke(void* pRet, Fx fx, Args&&...args) {
+			*((RT*)pRet) = fx(std::forward<Args>(args)...);
+		}
+	};
+
+	template <>
+	struct OperatorResult<void> {
+		template <class Fx, class...Args>
+		static inline void invoke(void* pRet, Fx fx, Args&&...args) {
+			fx(std::forward<Args>(args)...);
+		}
+	};
+
+	////////////////////////////////////////////////////
+	template <class RT, class T, RT(*fx)(T)>
+	class UnaryOperatorCommand : public NativeOperatorCommand {
+	public:
+		UnaryOperatorCommand(int returnOffset, int beginParamOffset) : NativeOperatorCommand(1, returnOffset, beginParamOffset) {}
+
+		virtual void execute(Context* context) {
+			char* frame = (char*)context->getAbsoluteAddress(context->getCurrentOffset());
+
+			OperatorResult<RT>::invoke(frame + getTargetOffset(), fx, OperatorParam<T>::get(frame + _paramOffsets[0], _directRefs[0]));
+		}
+	};
+
+	template <class RT, class T1, class T2, RT(*fx)(T1, T2)>
+	struct BinaryCondition {
+		static ConditionFx get() { return nullptr; }
+	};
+
+	template <class T1, class T2, bool(*fx)(T1, T2)>
+	struct BinaryCondition<bool, T1, T2, fx> {
+		static bool test(char* param1, bool directRef1, char* param2, bool directRef2) {
+			return fx(OperatorParam<T1>::get(param1, directRef1), OperatorParam<T2>::get(param2, directRef2));
+		}
+
+		static ConditionFx get() {
+			typedef typename std::remove_reference<T1>::type Type1;
+			typedef typename std::remove_reference<T2>::type Type2;
+			return std::is_arithmetic<Type1>::value && std::is_arithmetic<Type2>::value ? &test : nullptr;
+		}
+	};
+
+	////////////////////////////////////////////////////
+	template <class RT, class T1, class T2, RT(*fx)(T1, T2)>
+	class BinaryOperatorCommand : public NativeOperatorCommand {
+		typedef FT::MemberTypeInfo<0, ARG_ALIGMENT_SIZE, T1, T2> ParamInfo;
+	public:
+		BinaryOperatorCommand(int returnOffset, int beginParamOffset) : NativeOperatorCommand(2, returnOffset, beginParamOffset) {
+			_paramOffsets[0] = beginParamOffset + (int)ParamInfo::template offset<0>();
+			_paramOffsets[1] = beginParamOffset + (int)ParamInfo::template offset<1>();
+		}
+
+		virtual void execute(Context* context) {
+			char* frame = (char*)context->getAbsoluteAddress(context->getCurrentOffset());
+
+			OperatorResult<RT>::invoke(frame + getTargetOffset(), fx,
+				OperatorParam<T1>::get(frame + _paramOffsets[0], _directRefs[0]),
+				OperatorParam<T2>::get(frame + _paramOffsets[1], _directRefs[1]));
+		}
+
+		virtual ConditionFx getConditionFx() const {
+			return BinaryCondition<RT, T1, T2, fx>::get();
+		}
+	};
+}
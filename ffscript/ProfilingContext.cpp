@@ -0,0 +1,262 @@
+/******************************************************************
+* File:        ProfilingContext.cpp
+* Description: implement ProfilingContext class. A context that runs
+*              the code of a program command by command and records
+*              call counts and running time of script functions and
+*              hit counts of commands.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "ProfilingContext.h"
+#include "Program.h"
+#include "FuncLibrary.h"
+#include "ExpresionParser.h"
+#include "InstructionCommand.h"
+#include <chrono>
+#include <algorithm>
+
+namespace ffscript {
+
+	ProfilingContext::ProfilingContext(Program* program, unsigned int stackSize) :
+		Context(stackSize),
+		_codeBegin(program->getFirstCommand())
+	{
+		size_t commandCount = (size_t)(program->getEndCommand() - _codeBegin);
+		_commandHits.resize(commandCount, 0);
+		_functionEntries.resize(commandCount, -1);
+
+		// a script function is entered when its first command is run
+		for (auto& functionCode : program->getFunctionPlainCodes()) {
+			size_t index = (size_t)(functionCode.second.first - _codeBegin);
+			if (index < commandCount) {
+				_functionEntries[index] = functionCode.first;
+			}
+		}
+		reset();
+	}
+
+	ProfilingContext::~ProfilingContext() {
+	}
+
+	long long ProfilingContext::getTime() {
+		return (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void ProfilingContext::reset() {
+		_functionProfiles.clear();
+		_frames.clear();
+		_foreignCommandHits.clear();
+		std::fill(_commandHits.begin(), _commandHits.end(), 0);
+
+		// root of the call tree, it is not a function
+		_callNodes.clear();
+		_callNodes.push_back({ -1, -1, 0, 0 });
+	}
+
+	void ProfilingContext::countCommand(CommandPointer command) {
+		size_t index = (size_t)(command - _codeBegin);
+		if (index < _commandHits.size()) {
+			if (_functionEntries[index] >= 0) {
+				_commandHits[index]++;
+				enterFunction(_functionEntries[index]);
+			}
+			// a statement that continues after a function it called returns is not counted again
+			else if (getResumePoint() == nullptr) {
+				_commandHits[index]++;
+			}
+		}
+		else {
+			_foreignCommandHits[command]++;
+		}
+	}
+
+	void ProfilingContext::enterFunction(int functionId) {
+		int parent = _frames.size() ? _frames.back().node : 0;
+		int node;
+		auto it = _callNodes[parent].children.find(functionId);
+		if (it == _callNodes[parent].children.end()) {
+			node = (int)_callNodes.size();
+			_callNodes[parent].children.insert(std::make_pair(functionId, node));
+			_callNodes.push_back({ functionId, parent, 0, 0 });
+		}
+		else {
+			node = it->second;
+		}
+		_callNodes[node].callCount++;
+
+		auto functionProfile = &_functionProfiles.insert(std::make_pair(functionId, FunctionProfile{ 0, 0, 0, 0 })).first->second;
+		functionProfile->callCount++;
+		functionProfile->activeCount++;
+
+		// the function is running while the allocated stack is not shrunk below this level
+		_frames.push_back({ getScopeLevel(), node, functionProfile, getTime(), 0 });
+	}
+
+	void ProfilingContext::leaveFunction(long long now) {
+		auto& frame = _frames.back();
+		long long elapsedTime = now - frame.beginTime;
+		long long exclusiveTime = elapsedTime - frame.childTime;
+
+		auto functionProfile = frame.functionProfile;
+		functionProfile->exclusiveTime += exclusiveTime;
+		if (--functionProfile->activeCount == 0) {
+			functionProfile->inclusiveTime += elapsedTime;
+		}
+		_callNodes[frame.node].exclusiveTime += exclusiveTime;
+
+		_frames.pop_back();
+		if (_frames.size()) {
+			_frames.back().childTime += elapsedTime;
+		}
+	}
+
+	void ProfilingContext::runCommands(bool exitWhenFunctionReturns) {
+		const int stackLevel = getScopeLevel();
+		const size_t frameCount = _frames.size();
+		try {
+			while (getCurrentCommand() != getEndCommand()) {
+				CommandPointer command = getCurrentCommand();
+				countCommand(command);
+				(*command)->execute(this);
+
+				int scopeLevel = getScopeLevel();
+				if (_frames.size() && scopeLevel < _frames.back().scopeLevel) {
+					long long now = getTime();
+					do {
+						leaveFunction(now);
+					} while (_frames.size() && scopeLevel < _frames.back().scopeLevel);
+				}
+				if ((exitWhenFunctionReturns && scopeLevel < stackLevel)
+#ifndef THROW_EXCEPTION_ON_ERROR
+					|| isError()
+#endif
+					) {
+					break;
+				}
+				moveToNextCommand();
+			}
+		}
+		catch (...) {
+			// functions entered in this loop are stopped by the exception
+			long long now = getTime();
+			while (_frames.size() > frameCount) {
+				leaveFunction(now);
+			}
+			throw;
+		}
+	}
+
+	void ProfilingContext::runFunctionScript() {
+#ifndef THROW_EXCEPTION_ON_ERROR
+		if (isError()) return;
+#endif
+		runCommands(true);
+	}
+
+	void ProfilingContext::run() {
+		if (getCurrentCommand()
+#ifndef THROW_EXCEPTION_ON_ERROR
+			&& !isError()
+#endif
+			) {
+			runCommands(false);
+		}
+	}
+
+	const FunctionProfile* ProfilingContext::getFunctionProfile(int functionId) const {
+		auto it = _functionProfiles.find(functionId);
+		if (it == _functionProfiles.end()) {
+			return nullptr;
+		}
+		return &it->second;
+	}
+
+	const std::map<int, FunctionProfile>& ProfilingContext::getFunctionProfiles() const {
+		return _functionProfiles;
+	}
+
+	long long ProfilingContext::getCommandHits(CommandPointer command) const {
+		size_t index = (size_t)(command - _codeBegin);
+		if (index < _commandHits.size()) {
+			return _commandHits[index];
+		}
+		auto it = _foreignCommandHits.find(command);
+		if (it == _foreignCommandHits.end()) {
+			return 0;
+		}
+		return it->second;
+	}
+
+	void ProfilingContext::getFunctionNames(FuncLibrary* funcLib, std::map<int, std::string>& names) const {
+		std::map<std::string, int> nameCounts;
+		for (auto& it : _functionProfiles) {
+			auto functionInfo = funcLib ? funcLib->findFunctionInfo(it.first) : nullptr;
+			std::string name;
+			if (functionInfo && functionInfo->itemName) {
+				name = *functionInfo->itemName;
+			}
+			else {
+				name = "function";
+			}
+			names[it.first] = name;
+			nameCounts[name]++;
+		}
+		// overloading functions have same name, so their ids are added to their names
+		for (auto& it : names) {
+			if (nameCounts[it.second] > 1) {
+				it.second += "#" + std::to_string(it.first);
+			}
+		}
+	}
+
+	void ProfilingContext::writeCollapsedStacks(std::ostream& os, FuncLibrary* funcLib) const {
+		std::map<int, std::string> names;
+		getFunctionNames(funcLib, names);
+
+		for (size_t i = 1; i < _callNodes.size(); i++) {
+			auto& callNode = _callNodes[i];
+			std::string stack = names[callNode.functionId];
+			for (int parent = callNode.parent; parent > 0; parent = _callNodes[parent].parent) {
+				stack = names[_callNodes[parent].functionId] + ";" + stack;
+			}
+			os << stack << " " << callNode.exclusiveTime << std::endl;
+		}
+	}
+
+	void ProfilingContext::writeJsonSummary(std::ostream& os, FuncLibrary* funcLib) const {
+		std::map<int, std::string> names;
+		getFunctionNames(funcLib, names);
+
+		os << "{" << std::endl;
+		os << "\t\"functions\": {";
+		const char* separator = "";
+		for (auto& it : _functionProfiles) {
+			auto& functionProfile = it.second;
+			os << separator << std::endl;
+			os << "\t\t\"" << names[it.first] << "\": {"
+				<< "\"id\": " << it.first
+				<< ", \"calls\": " << functionProfile.callCount
+				<< ", \"inclusive\": " << functionProfile.inclusiveTime
+				<< ", \"exclusive\": " << functionProfile.exclusiveTime << "}";
+			separator = ",";
+		}
+		os << std::endl << "\t}," << std::endl;
+
+		// commands are identified by their indices in the program
+		os << "\t\"commands\": [";
+		separator = "";
+		for (size_t i = 0; i < _commandHits.size(); i++) {
+			if (_commandHits[i] == 0) continue;
+			os << separator << std::endl;
+			os << "\t\t{\"index\": " << i << ", \"hits\": " << _commandHits[i] << "}";
+			separator = ",";
+		}
+		os << std::endl << "\t]" << std::endl;
+		os << "}" << std::endl;
+	}
+}
@@ -0,0 +1,97 @@
+/******************************************************************
+* File:        ProfilingContext.h
+* Description: declare ProfilingContext class. A context that runs
+*              the code of a program command by command and records
+*              call counts and running time of script functions and
+*              hit counts of commands. The normal context is not
+*              changed, so the code runs as fast as before when the
+*              profiling context is not used.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "Context.h"
+#include <vector>
+#include <map>
+#include <string>
+#include <iostream>
+
+namespace ffscript {
+	class Program;
+	class FuncLibrary;
+
+	// running time is measured in nanoseconds
+	struct FunctionProfile {
+		long long callCount;
+		// time from entering to leaving the function, calls of the function
+		// inside itself are not counted twice
+		long long inclusiveTime;
+		// inclusive time without time of the functions it calls
+		long long exclusiveTime;
+		// number of running calls of the function, used for recursive calls
+		int activeCount;
+	};
+
+	class ProfilingContext : public Context
+	{
+		// a node in call tree, each path from the root is a distinct call stack
+		struct CallNode {
+			int functionId;
+			int parent;
+			long long callCount;
+			long long exclusiveTime;
+			std::map<int, int> children;
+		};
+
+		struct ProfilingFrame {
+			int scopeLevel;
+			int node;
+			FunctionProfile* functionProfile;
+			long long beginTime;
+			long long childTime;
+		};
+
+		CommandPointer _codeBegin;
+		// id of the function begins at each command of the program or -1
+		std::vector<int> _functionEntries;
+		std::map<int, FunctionProfile> _functionProfiles;
+		std::vector<CallNode> _callNodes;
+		std::vector<ProfilingFrame> _frames;
+		std::vector<long long> _commandHits;
+		// commands are not belong to the program, such as commands of a lambda program
+		std::map<CommandPointer, long long> _foreignCommandHits;
+	private:
+		void runCommands(bool exitWhenFunctionReturns);
+		void countCommand(CommandPointer command);
+		void enterFunction(int functionId);
+		void leaveFunction(long long now);
+		static long long getTime();
+		void getFunctionNames(FuncLibrary* funcLib, std::map<int, std::string>& names) const;
+	public:
+		ProfilingContext(Program* program, unsigned int stackSize);
+		virtual ~ProfilingContext();
+
+		// the threaded code of the program is not used, commands are run through
+		// their execute method, so each of them can be counted
+		void run() override;
+		void runFunctionScript() override;
+
+		// clear the recorded data, must not be called while the code is running
+		void reset();
+		const FunctionProfile* getFunctionProfile(int functionId) const;
+		const std::map<int, FunctionProfile>& getFunctionProfiles() const;
+		long long getCommandHits(CommandPointer command) const;
+
+		// write a line for each call stack in format 'f1;f2;f3 time', it is
+		// the input of flame graph tools. Names of the functions are taken
+		// from the library, overloading functions are distinguished by their ids
+		void writeCollapsedStacks(std::ostream& os, FuncLibrary* funcLib) const;
+		// write profiles of the functions as a json object keyed by function name
+		void writeJsonSummary(std::ostream& os, FuncLibrary* funcLib) const;
+	};
+}
@@ -15,9 +15,18 @@
 #include <Context.h>
 #include "Expression.h"
 #include "InstructionCommand.h"
+#include "ThreadedCode.h"
+#include "FlatCode.h"
+#include <mutex>
 
 namespace ffscript {
-	Program::Program() : _commandCounter(0), _programCode(nullptr)
+	// plain code of live programs, mapped by their first command
+	static std::map<CommandPointer, Program*> s_programCodes;
+	static std::mutex s_programCodesMutex;
+
+	Program::Program() : _codeArena(std::make_shared<CodeArena>()), _updatingFunctions(false), _updateEpoch(0), _programCode(nullptr), _programCodeCapacity(0), _commandCounter(0), _plainExecutorCount(0),
+		_executionMode(ExecutionMode::Interpreter), _threadedCode(nullptr), _flatCode(nullptr),
+		_globalDataSize(0), _globalScopeSize(0), _globalConstructorCount(0), _globalData(nullptr)
 		//_moveOffset()
 	{
 		//_assitantFuncLib = (FuncLibraryRef)( new FuncLibrary() );
@@ -26,25 +35,58 @@ namespace ffscript {
 	Program::~Program()
 	{
 		if (_programCode) {
-			free(_programCode);
+			std::lock_guard<std::mutex> lock(s_programCodesMutex);
+			s_programCodes.erase(_programCode);
+		}
+		if (_threadedCode) {
+			delete _threadedCode;
+		}
+		if (_flatCode) {
+			delete _flatCode;
+		}
+		for (auto& appendedCode : _appendedCodes) {
+			if (appendedCode.flatCode) {
+				delete appendedCode.flatCode;
+			}
 		}
 	}
 
 	void Program::addExecutor(const ExecutorRef& executor) {
 		if (executor->getCode() != nullptr) {
 			_commandContainer.push_back(executor);
-			_commandCounter += (int)executor->getCode()->size();
+		}
+		// the global scope sets global data when it extracts the program, a program
+		// built from executors uses global data of the scope they were extracted from
+		if (_globalData == nullptr) {
+			_globalData = executor->getGlobalData();
 		}
 	}
 
 	void Program::convertToPlainCode() {
-		if (_commandCounter == 0) return;
+		int commandCounter = 0;
+		for (auto& executor : _commandContainer) {
+			commandCounter += (int)executor->getCode()->size();
+		}
+		if (commandCounter == 0) return;
+
+		_commandCounter = commandCounter;
+		_plainExecutorCount = (int)_commandContainer.size();
 
 		_expCmdMap.clear();
-		if (_programCode) {
-			free(_programCode);
+		if (_flatCode) {
+			delete _flatCode;
+			_flatCode = nullptr;
+		}
+		// arena blocks cannot be released, so the old code array is reused if it is big enough
+		if (_commandCounter > _programCodeCapacity) {
+			std::lock_guard<std::mutex> lock(s_programCodesMutex);
+			if (_programCode) {
+				s_programCodes.erase(_programCode);
+			}
+			_programCode = (CommandPointer)_codeArena->allocate(sizeof(InstructionCommand*)* _commandCounter);
+			_programCodeCapacity = _commandCounter;
+			s_programCodes[_programCode] = this;
 		}
-		_programCode = (CommandPointer)malloc(sizeof(InstructionCommand*)* _commandCounter);
 		CommandPointer pCommand = _programCode;
 		auto end1 = _commandContainer.end();
 		for (auto it1 = _commandContainer.begin(); it1 != end1; ++it1) {
@@ -61,6 +103,87 @@ namespace ffscript {
 		}
 	}
 
+	CodeSegmentEntry Program::appendPlainCode() {
+		auto begin = _commandContainer.begin();
+		std::advance(begin, _plainExecutorCount);
+
+		int commandCount = 0;
+		for (auto it = begin; it != _commandContainer.end(); ++it) {
+			commandCount += (int)(*it)->getCode()->size();
+		}
+		if (commandCount == 0) {
+			_commandContainer.erase(begin, _commandContainer.end());
+			return CodeSegmentEntry(nullptr, nullptr);
+		}
+
+		// the segment is released with the arena of its commands
+		auto codeArena = CodeArena::getCurrent() ? CodeArena::getCurrent() : _codeArena.get();
+		CommandPointer code = (CommandPointer)codeArena->allocate(sizeof(InstructionCommand*) * commandCount);
+		CommandPointer pCommand = code;
+		for (auto it = begin; it != _commandContainer.end(); ++it) {
+			auto commands = (*it)->getCode();
+			for (auto command : *commands) {
+				*pCommand = command;
+				pCommand++;
+			}
+			if (commands->size()) {
+				_expCmdMap[it->get()] = CodeSegmentEntry(pCommand - commands->size(), pCommand - 1);
+			}
+		}
+
+		AppendedCode appendedCode;
+		appendedCode.code = CodeSegmentEntry(code, pCommand - 1);
+		appendedCode.executors.splice(appendedCode.executors.end(), _commandContainer, begin, _commandContainer.end());
+		appendedCode.flatCode = nullptr;
+		_appendedCodes.push_back(appendedCode);
+		return appendedCode.code;
+	}
+
+	void Program::flattenAppendedCode(const CodeSegmentEntry& code) {
+		for (auto& appendedCode : _appendedCodes) {
+			if (appendedCode.code.first != code.first || appendedCode.flatCode) continue;
+
+			std::list<CodeSegmentEntry> functionCodes;
+			for (auto& functionCode : _functionMap) {
+				functionCodes.push_back(functionCode.second);
+			}
+			for (auto& functionCode : _pendingFunctionMap) {
+				functionCodes.push_back(functionCode.second);
+			}
+			appendedCode.flatCode = new FlatCode(code.first, code.second + 1, functionCodes);
+		}
+	}
+
+	bool Program::isAppendedCodeUsed(const CodeSegmentEntry& code) const {
+		for (auto functionMap : { &_functionMap, &_pendingFunctionMap }) {
+			for (auto& functionCode : *functionMap) {
+				if (functionCode.second.first >= code.first && functionCode.second.first <= code.second) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	void Program::releaseAppendedCode(const CodeSegmentEntry& code) {
+		for (auto it = _appendedCodes.begin(); it != _appendedCodes.end(); ++it) {
+			if (it->code.first != code.first) continue;
+
+			if (it->flatCode) {
+				delete it->flatCode;
+			}
+			for (auto& executor : it->executors) {
+				_expCmdMap.erase(executor.get());
+			}
+			_appendedCodes.erase(it);
+			return;
+		}
+	}
+
+	int Program::getAppendedCodeCount() const {
+		return (int)_appendedCodes.size();
+	}
+
 	CommandPointer Program::getFirstCommand() const {
 		return _programCode;
 	}
@@ -78,6 +201,12 @@ namespace ffscript {
 	}
 
 	CodeSegmentEntry* Program::getFunctionPlainCode(int functionId) {
+		if (_updatingFunctions) {
+			auto pendingIt = _pendingFunctionMap.find(functionId);
+			if (pendingIt != _pendingFunctionMap.end()) {
+				return &pendingIt->second;
+			}
+		}
 		auto it = _functionMap.find(functionId);
 		if (it == _functionMap.end()) {
 			return nullptr;
@@ -86,7 +215,94 @@ namespace ffscript {
 	}
 
 	void Program::setFunctionPlainCode(int functionId, const CodeSegmentEntry& functionCode) {
-		_functionMap.insert( std::make_pair(functionId, functionCode));
+		if (_updatingFunctions) {
+			_pendingFunctionMap[functionId] = functionCode;
+			return;
+		}
+		std::lock_guard<std::mutex> lock(_functionEntriesMutex);
+		_functionMap[functionId] = functionCode;
+		auto it = _functionEntries.find(functionId);
+		if (it != _functionEntries.end()) {
+			it->second.store(functionCode.first, std::memory_order_release);
+		}
+	}
+
+	const FunctionEntry* Program::getFunctionEntry(int functionId) {
+		std::lock_guard<std::mutex> lock(_functionEntriesMutex);
+		auto it = _functionEntries.find(functionId);
+		if (it != _functionEntries.end()) {
+			return &it->second;
+		}
+		auto& functionEntry = _functionEntries[functionId];
+		auto functionCode = _functionMap.find(functionId);
+		functionEntry.store(functionCode != _functionMap.end() ? functionCode->second.first : nullptr, std::memory_order_release);
+		return &functionEntry;
+	}
+
+	void Program::beginFunctionUpdate() {
+		_pendingFunctionMap.clear();
+		_updatingFunctions = true;
+	}
+
+	void Program::commitFunctionUpdate() {
+		_updatingFunctions = false;
+		// the code is completed before it is stored, a call that loads the entry
+		// with acquire order sees all commands of the new code
+		for (auto& functionCode : _pendingFunctionMap) {
+			setFunctionPlainCode(functionCode.first, functionCode.second);
+		}
+		_pendingFunctionMap.clear();
+
+		// runs entered after this point load the new code
+		std::lock_guard<std::mutex> lock(_activeRunsMutex);
+		_updateEpoch++;
+	}
+
+	unsigned int Program::enterRun() {
+		std::lock_guard<std::mutex> lock(_activeRunsMutex);
+		_activeRuns[_updateEpoch]++;
+		return _updateEpoch;
+	}
+
+	void Program::leaveRun(unsigned int epoch) {
+		std::lock_guard<std::mutex> lock(_activeRunsMutex);
+		auto it = _activeRuns.find(epoch);
+		if (it != _activeRuns.end() && --it->second == 0) {
+			_activeRuns.erase(it);
+		}
+	}
+
+	unsigned int Program::getUpdateEpoch() {
+		std::lock_guard<std::mutex> lock(_activeRunsMutex);
+		return _updateEpoch;
+	}
+
+	bool Program::hasRunBefore(unsigned int epoch) {
+		std::lock_guard<std::mutex> lock(_activeRunsMutex);
+		return _activeRuns.size() && _activeRuns.begin()->first < epoch;
+	}
+
+	void Program::cancelFunctionUpdate() {
+		_updatingFunctions = false;
+		_pendingFunctionMap.clear();
+		// executors those were not laid out yet
+		auto begin = _commandContainer.begin();
+		std::advance(begin, _plainExecutorCount);
+		_commandContainer.erase(begin, _commandContainer.end());
+	}
+
+	const std::map<int, CodeSegmentEntry>& Program::getFunctionPlainCodes() const {
+		return _functionMap;
+	}
+
+	MemoryBlock* Program::findConstantBlock(const void* data) const {
+		for (auto& executor : _commandContainer) {
+			auto memoryBlock = executor->findConstantBlock(data);
+			if (memoryBlock) {
+				return memoryBlock;
+			}
+		}
+		return nullptr;
 	}
 
 	FunctionInfo* Program::getFunctionInfo(int functionId) {
@@ -105,6 +321,108 @@ namespace ffscript {
 		_functionInfoMap.insert(std::make_pair(functionId, functionInfo));
 	}
 
+	void Program::flattenCode() {
+		// command trees in the code were flattened already
+		if (_flatCode || _programCode == nullptr) return;
+		std::list<CodeSegmentEntry> functionCodes;
+		for (auto& functionCode : _functionMap) {
+			functionCodes.push_back(functionCode.second);
+		}
+		_flatCode = new FlatCode(_programCode, _programCode + _commandCounter, functionCodes);
+	}
+
+	const FlatCode* Program::getFlatCode() const {
+		return _flatCode;
+	}
+
+	void Program::fuseFlatCode(const FusionTable& fusionTable, FlatProfile* profile) {
+		if (_flatCode) {
+			_flatCode->fuseRecords(fusionTable, profile);
+		}
+	}
+
+	void Program::setExecutionMode(ExecutionMode executionMode) {
+		_executionMode = executionMode;
+		if (_programCode) {
+			lowerCode();
+		}
+	}
+
+	ExecutionMode Program::getExecutionMode() const {
+		return _executionMode;
+	}
+
+	void Program::lowerCode() {
+		if (_threadedCode) {
+			delete _threadedCode;
+			_threadedCode = nullptr;
+		}
+		if (_executionMode == ExecutionMode::ThreadedCode && _programCode) {
+			_threadedCode = new ThreadedCode(_programCode, _programCode + _commandCounter);
+		}
+	}
+
+	const ThreadedCode* Program::getThreadedCode() const {
+		return _threadedCode;
+	}
+
+	CodeArena* Program::getCodeArena() const {
+		return _codeArena.get();
+	}
+
+	void Program::addGlobalCommand(CommandPointer command) {
+		_globalCommands.push_back(command);
+	}
+
+	void Program::addGlobalDestructorCommand(CommandPointer command) {
+		_globalDestructorCommands.push_back(command);
+	}
+
+	const std::list<CommandPointer>& Program::getGlobalCommands() const {
+		return _globalCommands;
+	}
+
+	const std::list<CommandPointer>& Program::getGlobalDestructorCommands() const {
+		return _globalDestructorCommands;
+	}
+
+	void Program::setGlobalLayout(int dataSize, int scopeSize, int constructorCount) {
+		_globalDataSize = dataSize;
+		_globalScopeSize = scopeSize;
+		_globalConstructorCount = constructorCount;
+	}
+
+	int Program::getGlobalDataSize() const {
+		return _globalDataSize;
+	}
+
+	int Program::getGlobalScopeSize() const {
+		return _globalScopeSize;
+	}
+
+	int Program::getGlobalConstructorCount() const {
+		return _globalConstructorCount;
+	}
+
+	void Program::setGlobalData(void* globalData) {
+		_globalData = globalData;
+	}
+
+	Program* Program::findProgram(CommandPointer command) {
+		std::lock_guard<std::mutex> lock(s_programCodesMutex);
+		auto it = s_programCodes.upper_bound(command);
+		if (it == s_programCodes.begin()) {
+			return nullptr;
+		}
+		--it;
+		auto program = it->second;
+		return command < program->getEndCommand() ? program : nullptr;
+	}
+
+	void* Program::getGlobalData() const {
+		return _globalData;
+	}
+
 	//int Program::findFunction(const std::string& name, const std::vector<int>& paramTypes) {
 	//	return _assitantFuncLib->findFunction(name, paramTypes);
 	//}
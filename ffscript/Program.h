@@ -16,13 +16,26 @@
 #include <memory>
 #include "FunctionRegisterHelper.h"
 #include <map>
+#include <mutex>
 #include <string.h>
 #include "Executor.h"
 #include "FuncLibrary.h"
+#include "CodeArena.h"
 
 namespace ffscript {
 
 	class Executor;
+	class ThreadedCode;
+	class FlatCode;
+	class FusionTable;
+	class FlatProfile;
+
+	enum class ExecutionMode : unsigned char {
+		// each command is run by calling its virtual execute method
+		Interpreter = 0,
+		// the plain code is lowered to a threaded code and dispatched by op codes
+		ThreadedCode,
+	};
 
 	struct FunctionInfo {
 		unsigned short returnStorageSize;
@@ -31,14 +44,57 @@ namespace ffscript {
 
 	class Program
 	{
+		// code objects of the program are allocated in this arena,
+		// it must be released after the other members
+		CodeArenaRef _codeArena;
 		std::list<std::shared_ptr<Executor>> _commandContainer;
 		std::map<Executor*, CodeSegmentEntry> _expCmdMap;
 		std::map<int, CodeSegmentEntry> _functionMap;
+		// entries of script functions, calls to a function load its code from the entry,
+		// so all calls are redirected by one atomic store when the function is updated
+		std::map<int, FunctionEntry> _functionEntries;
+		// entries are requested by runners those may be created in any thread
+		std::mutex _functionEntriesMutex;
+		// code of functions those are being updated, it is published when the update is committed
+		std::map<int, CodeSegmentEntry> _pendingFunctionMap;
+		bool _updatingFunctions;
+		// number of committed function updates and the active runs by the update count
+		// when they entered. Code replaced by an update is used only by runs entered before it
+		unsigned int _updateEpoch;
+		std::map<unsigned int, int> _activeRuns;
+		std::mutex _activeRunsMutex;
 		std::map<int, FunctionInfo> _functionInfoMap;
 		//FuncLibraryRef _assitantFuncLib;
 
 		CommandPointer _programCode;
+		// number of commands the program code array can keep, the array is
+		// reused when the code is laid out again
+		int _programCodeCapacity;
 		int _commandCounter;
+		// number of executors those code is laid out
+		int _plainExecutorCount;
+		// segment laid out after the program code, it keeps the executors of its code, so
+		// the segment and the arena of its commands are released together
+		struct AppendedCode {
+			CodeSegmentEntry code;
+			std::list<ExecutorRef> executors;
+			FlatCode* flatCode;
+		};
+		std::list<AppendedCode> _appendedCodes;
+		ExecutionMode _executionMode;
+		ThreadedCode* _threadedCode;
+		FlatCode* _flatCode;
+
+		// global code and layout of the global data, they are used to create
+		// instances of the program those have their own global data
+		std::list<CommandPointer> _globalCommands;
+		std::list<CommandPointer> _globalDestructorCommands;
+		int _globalDataSize;
+		int _globalScopeSize;
+		int _globalConstructorCount;
+		// global data of the compiler's static context, it is used when the program
+		// runs without an instance
+		void* _globalData;
 		//static Program* g_instance;
 	public:
 		Program();
@@ -52,6 +108,18 @@ namespace ffscript {
 
 		//this method must be called after all executors is and before the other methods
 		void convertToPlainCode();
+		// lay out code of the executors added after the plain code was made. The code is
+		// placed in a new segment allocated in the current arena of the thread, so commands
+		// of the plain code are not moved and the functions running on them are not affected.
+		// It returns first and last command of the segment, they are null if there is no new code
+		CodeSegmentEntry appendPlainCode();
+		// replace the command trees in an appended segment by flat commands
+		void flattenAppendedCode(const CodeSegmentEntry& code);
+		// check if code of a function is in the appended segment
+		bool isAppendedCodeUsed(const CodeSegmentEntry& code) const;
+		// release an appended segment and its executors, no task may run its code
+		void releaseAppendedCode(const CodeSegmentEntry& code);
+		int getAppendedCodeCount() const;
 		CommandPointer getFirstCommand() const;
 		CommandPointer getEndCommand() const;
 
@@ -59,8 +127,60 @@ namespace ffscript {
 
 		CodeSegmentEntry* getFunctionPlainCode(int functionId);
 		void setFunctionPlainCode(int functionId, const CodeSegmentEntry& functionCode);
+		const std::map<int, CodeSegmentEntry>& getFunctionPlainCodes() const;
+		// get entry of a function, it is created if the function does not have code yet
+		// and it is filled when code of the function is set
+		const FunctionEntry* getFunctionEntry(int functionId);
+
+		// code of functions set after beginFunctionUpdate is kept as pending code. It is
+		// not used by calls until commitFunctionUpdate stores it to entries of the functions,
+		// cancelFunctionUpdate drops it and the executors added for it
+		void beginFunctionUpdate();
+		void commitFunctionUpdate();
+		void cancelFunctionUpdate();
+		// a run of the program's code from outside calls enterRun before it loads entries of
+		// functions and leaveRun with the returned epoch when it is completed
+		unsigned int enterRun();
+		void leaveRun(unsigned int epoch);
+		unsigned int getUpdateEpoch();
+		// check if a run entered before the given epoch is still active
+		bool hasRunBefore(unsigned int epoch);
+		// find the constant block that stores the data, it is null if the data is not
+		// stored in a constant block of the code
+		MemoryBlock* findConstantBlock(const void* data) const;
 
 		FunctionInfo* getFunctionInfo(int functionId);
 		void setFunctionInfo(int functionId, const FunctionInfo& functionInfo);
+
+		// this method must be called after the plain code is completed and before lowerCode
+		// it replaces the command trees in the plain code by flat commands
+		void flattenCode();
+		const FlatCode* getFlatCode() const;
+		// fuse command sequences of the flat code by patterns in the table, the code is
+		// fused by the default table when it is flattened. If a profile is given, the code
+		// runs in counting mode and counts the patterns to the profile instead
+		void fuseFlatCode(const FusionTable& fusionTable, FlatProfile* profile = nullptr);
+
+		void setExecutionMode(ExecutionMode executionMode);
+		ExecutionMode getExecutionMode() const;
+		// this method must be called after the plain code is completed
+		// it prepares the code for the selected execution mode
+		void lowerCode();
+		const ThreadedCode* getThreadedCode() const;
+		CodeArena* getCodeArena() const;
+
+		void addGlobalCommand(CommandPointer command);
+		void addGlobalDestructorCommand(CommandPointer command);
+		const std::list<CommandPointer>& getGlobalCommands() const;
+		const std::list<CommandPointer>& getGlobalDestructorCommands() const;
+		void setGlobalLayout(int dataSize, int scopeSize, int constructorCount);
+		int getGlobalDataSize() const;
+		int getGlobalScopeSize() const;
+		int getGlobalConstructorCount() const;
+		void setGlobalData(void* globalData);
+		void* getGlobalData() const;
+		// find the program whose plain code contains the command, a context that
+		// does not have global data runs the code with global data of the program
+		static Program* findProgram(CommandPointer command);
 	};
 }
@@ -0,0 +1,1359 @@
+/******************************************************************
+* File:        ProgramCache.cpp
+* Description: implement ProgramCache class. A class that saves the
+*              compiled code of a program to a binary stream and
+*              loads it back without parsing the source again.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "ProgramCache.h"
+#include "CompilerSuite.h"
+#include "CommandTree.h"
+#include "CompareAndJump.h"
+#include "DefaultCommands.h"
+#include "FlatCode.h"
+#include "NativeOperatorCommands.hpp"
+#include "ScriptType.h"
+#include "ObjectBlock.hpp"
+#include "StructClass.h"
+#include <typeinfo>
+#include <sstream>
+#include <limits>
+#include <string.h>
+
+namespace ffscript {
+
+	const unsigned int ProgramCache::FORMAT_VERSION = 4;
+
+	static const char CACHE_MAGIC[4] = { 'F', 'F', 'P', 'C' };
+	static const int NULL_COMMAND_INDEX = std::numeric_limits<int>::min();
+
+	// kinds of commands in the stream
+	enum CachedCommandType : unsigned char {
+		CACHED_NULL = 0,
+		CACHED_ENTER_SCOPE,
+		CACHED_EXIT_SCOPE,
+		CACHED_PUSH_PARAM,
+		CACHED_PUSH_PARAM_REF,
+		CACHED_PUSH_PARAM_OFFSET,
+		CACHED_PUSH_PARAM_REF_OFFSET,
+		CACHED_LEA_OFFSET_TO_OFFSET,
+		CACHED_LEA_ADDRESS_TO_OFFSET,
+		CACHED_COPY_DATA_TO_REF,
+		CACHED_RETREIVE_RESULT,
+		CACHED_CALL_NATIVE,
+		CACHED_NATIVE_OPERATOR,
+		CACHED_CALL_SCRIPT2,
+		CACHED_CALL_SCRIPT3,
+		CACHED_JUMP,
+		CACHED_JUMP_IF,
+		CACHED_JUMP_IF_ELSE,
+		CACHED_BREAK,
+		CACHED_EXIT_AT_RETURN,
+		CACHED_CONTINUE,
+		CACHED_EXIT_AT_THE_END,
+		CACHED_FUNCTION_0P,
+		CACHED_FUNCTION_1P,
+		CACHED_FUNCTION_2P,
+		CACHED_FUNCTION_NP,
+		CACHED_COMPARE_AND_JUMP,
+		CACHED_DEFAULT_ASSIGNMENT,
+		CACHED_DEFAULT_ASSIGNMENT_SEMI_REF,
+		CACHED_CALL_DEREF,
+		CACHED_CALL_DEREF2,
+		CACHED_PUSH_GLOBAL_PARAM,
+		CACHED_PUSH_GLOBAL_PARAM_REF,
+		CACHED_LEA_GLOBAL_TO_OFFSET,
+		CACHED_LEA_OFFSET_TO_GLOBAL,
+		CACHED_LEA_GLOBAL_TO_GLOBAL,
+		CACHED_TRIGGER,
+		CACHED_CONDITION_TRIGGER,
+		CACHED_CALL_MEMBER_ACCESS,
+		CACHED_CALL_ARRAY_TO_STRUCT,
+	};
+
+	// kinds of constants in the constant table
+	enum CachedConstantType : unsigned char {
+		// plain data of a built-in type
+		CACHED_CONSTANT_BUFFER = 0,
+		CACHED_CONSTANT_STRING,
+		CACHED_CONSTANT_WSTRING,
+	};
+
+	// kinds of triggers of constructors and destructors
+	enum CachedTriggerType : unsigned char {
+		CACHED_TRIGGER_NONE = 0,
+		// mark the constructor is executed
+		CACHED_TRIGGER_SET_CONSTRUCTOR,
+		// check if the constructor was executed before the destructor is
+		CACHED_TRIGGER_CHECK_CONSTRUCTOR,
+	};
+
+	// kinds of addresses in the stream
+	enum CachedAddressType : unsigned char {
+		CACHED_ADDRESS_NULL = 0,
+		// index in the constant table
+		CACHED_ADDRESS_CONSTANT,
+	};
+
+	// executor that keeps the loaded commands, sub commands those are not owned
+	// by their parent commands are kept with the executor too
+	class LoadedCodeExecutor : public Executor {
+	public:
+		void keepCommand(InstructionCommand* command) {
+			_commandContainer.push_back(CommandRef(command));
+		}
+
+		void* addConstant(unsigned char constantType, const std::string& data) {
+			MemoryBlock* memoryBlock;
+			if (constantType == CACHED_CONSTANT_STRING) {
+				memoryBlock = new ObjectBlock<std::string>(data);
+			}
+			else if (constantType == CACHED_CONSTANT_WSTRING) {
+				std::wstring value(data.size() / sizeof(wchar_t), 0);
+				memcpy(&value[0], data.c_str(), value.size() * sizeof(wchar_t));
+				memoryBlock = new ObjectBlock<std::wstring>(value);
+			}
+			else if (constantType == CACHED_CONSTANT_BUFFER) {
+				memoryBlock = new BufferBlock((int)data.size());
+				memcpy(memoryBlock->getDataRef(), data.c_str(), data.size());
+			}
+			else {
+				return nullptr;
+			}
+			_memoryBlocks.push_back(MemoryBlockRef(memoryBlock));
+			return memoryBlock->getDataRef();
+		}
+	};
+
+	template <class T>
+	static inline void writeValue(std::ostream& stream, const T& value) {
+		stream.write((const char*)&value, sizeof(T));
+	}
+
+	static void writeString(std::ostream& stream, const std::string& value) {
+		writeValue(stream, (int)value.size());
+		stream.write(value.c_str(), value.size());
+	}
+
+	template <class T>
+	static inline T readValue(std::istream& stream) {
+		T value = T();
+		stream.read((char*)&value, sizeof(T));
+		return value;
+	}
+
+	// number of bytes those are not read yet, it is unknown if the stream is not seekable
+	static long long getRemainingSize(std::istream& stream) {
+		auto position = stream.tellg();
+		if (position < 0) {
+			return std::numeric_limits<long long>::max();
+		}
+		stream.seekg(0, std::ios::end);
+		auto end = stream.tellg();
+		stream.seekg(position);
+		return (long long)(end - position);
+	}
+
+	// read number of items those each takes at least itemSize bytes in the stream, a count
+	// that does not fit in the rest of the stream fails the stream instead of being allocated
+	static int readCount(std::istream& stream, int itemSize) {
+		int count = readValue<int>(stream);
+		if (!stream.good()) {
+			return 0;
+		}
+		if (count < 0 || (long long)count * itemSize > getRemainingSize(stream)) {
+			stream.setstate(std::ios::failbit);
+			return 0;
+		}
+		return count;
+	}
+
+	static std::string readString(std::istream& stream) {
+		int size = readCount(stream, 1);
+		if (size == 0 || !stream.good()) {
+			return "";
+		}
+		std::string value(size, 0);
+		stream.read(&value[0], size);
+		return value;
+	}
+
+	ProgramCache::ProgramCache(CompilerSuite* compilerSuite) : _compilerSuite(compilerSuite), _program(nullptr), _loadFailed(false) {}
+
+	ProgramCache::~ProgramCache() {}
+
+	ScriptCompiler* ProgramCache::getCompiler() const {
+		return _compilerSuite->getCompiler().get();
+	}
+
+	GlobalScope* ProgramCache::getGlobalScope() const {
+		return _compilerSuite->getGlobalScope().get();
+	}
+
+	void ProgramCache::writeCommandPointer(std::ostream& stream, CommandPointer commandPointer) {
+		writeValue(stream, commandPointer ? (int)(commandPointer - _program->getFirstCommand()) : NULL_COMMAND_INDEX);
+	}
+
+	bool ProgramCache::writeAddress(std::ostream& stream, const void* address) {
+		if (address == nullptr) {
+			writeValue(stream, (unsigned char)CACHED_ADDRESS_NULL);
+			return true;
+		}
+
+		// constant values and string literals are stored in the constant table, other objects cannot be stored
+		auto memoryBlock = _program->findConstantBlock(address);
+		std::pair<unsigned char, std::string> constant;
+		if (auto bufferBlock = dynamic_cast<BufferBlock*>(memoryBlock)) {
+			constant.first = CACHED_CONSTANT_BUFFER;
+			constant.second.assign((const char*)address, bufferBlock->getSize());
+		}
+		else if (dynamic_cast<ObjectBlock<std::string>*>(memoryBlock)) {
+			constant.first = CACHED_CONSTANT_STRING;
+			constant.second = *(const std::string*)address;
+		}
+		else if (dynamic_cast<ObjectBlock<std::wstring>*>(memoryBlock)) {
+			auto& value = *(const std::wstring*)address;
+			constant.first = CACHED_CONSTANT_WSTRING;
+			constant.second.assign((const char*)value.c_str(), value.size() * sizeof(wchar_t));
+		}
+		else {
+			return false;
+		}
+		auto it = _constantIndexMap.insert(std::make_pair(address, (int)_constants.size()));
+		if (it.second) {
+			_constants.push_back(std::move(constant));
+		}
+		writeValue(stream, (unsigned char)CACHED_ADDRESS_CONSTANT);
+		writeValue(stream, it.first->second);
+		return true;
+	}
+
+	bool ProgramCache::writeNativeFunction(std::ostream& stream, int functionId) {
+		if (functionId < 0) {
+			return false;
+		}
+		auto it = _nativeIndexMap.insert(std::make_pair(functionId, (int)_nativeFunctions.size()));
+		if (it.second) {
+			_nativeFunctions.push_back(functionId);
+		}
+		writeValue(stream, it.first->second);
+		return true;
+	}
+
+	bool ProgramCache::writeFunctionTypes(std::ostream& stream, int functionId) {
+		auto scriptCompiler = getCompiler();
+		auto functionInfo = scriptCompiler->getFunctionLib()->findFunctionInfo(functionId);
+		auto functionFactory = scriptCompiler->getFunctionFactory(functionId);
+		if (functionInfo == nullptr || functionInfo->itemName == nullptr || functionFactory == nullptr) {
+			return false;
+		}
+
+		writeString(stream, *functionInfo->itemName);
+		writeString(stream, functionFactory->getReturnType().sType());
+		writeValue(stream, (int)functionInfo->paramTypes.size());
+		for (auto& paramType : functionInfo->paramTypes) {
+			writeString(stream, paramType->sType());
+		}
+		return true;
+	}
+
+	bool ProgramCache::writeTrigger(std::ostream& stream, const CommandTriggerRef& trigger) {
+		if (trigger == nullptr) {
+			writeValue(stream, (unsigned char)CACHED_TRIGGER_NONE);
+		}
+		else if (auto afterConstructor = dynamic_cast<AfterConstructorCall*>(trigger.get())) {
+			writeValue(stream, (unsigned char)CACHED_TRIGGER_SET_CONSTRUCTOR);
+			writeValue(stream, afterConstructor->_contructorIndex);
+		}
+		else if (auto beforeDestructor = dynamic_cast<BeforeDestructorCall*>(trigger.get())) {
+			writeValue(stream, (unsigned char)CACHED_TRIGGER_CHECK_CONSTRUCTOR);
+			writeValue(stream, beforeDestructor->_contructorIndex);
+		}
+		else {
+			// constructors and destructors of struct members are built when the code is updated
+			return setSaveError("constructors of struct members");
+		}
+		return true;
+	}
+
+	void ProgramCache::writeStructs(std::ostream& stream) {
+		auto userStructs = getCompiler()->getTypeManager()->getUserStructs();
+		writeValue(stream, (int)userStructs.size());
+		std::string memberName;
+		MemberInfo memberInfo;
+		for (auto userStruct : userStructs) {
+			writeString(stream, userStruct->getName());
+			// the size is checked when the struct is declared again
+			writeValue(stream, userStruct->getSize());
+			writeValue(stream, userStruct->getMemberCount());
+			for (bool hasMember = userStruct->getMemberFirst(&memberName, &memberInfo); hasMember;
+				hasMember = userStruct->getMemberNext(&memberName, &memberInfo)) {
+				writeString(stream, memberInfo.type.sType());
+				writeString(stream, memberName);
+			}
+		}
+	}
+
+	bool ProgramCache::writeCommand(std::ostream& stream, InstructionCommand* command) {
+		if (command == nullptr) {
+			writeValue(stream, (unsigned char)CACHED_NULL);
+			return true;
+		}
+
+		const std::type_info& commandType = typeid(*command);
+		// flat code is built again when the program is loaded
+		if (commandType == typeid(FlatCommand)) {
+			return writeCommand(stream, ((FlatCommand*)command)->getRootCommand());
+		}
+
+		CachedCommandType cachedType;
+		if (commandType == typeid(EnterContextScope)) cachedType = CACHED_ENTER_SCOPE;
+		else if (commandType == typeid(ExitContextScope)) cachedType = CACHED_EXIT_SCOPE;
+		else if (commandType == typeid(PushParam)) cachedType = CACHED_PUSH_PARAM;
+		else if (commandType == typeid(PushParamRef)) cachedType = CACHED_PUSH_PARAM_REF;
+		else if (commandType == typeid(PushParamOffset)) cachedType = CACHED_PUSH_PARAM_OFFSET;
+		else if (commandType == typeid(PushParamRefOffset)) cachedType = CACHED_PUSH_PARAM_REF_OFFSET;
+		else if (commandType == typeid(LeaOffsetToOffset)) cachedType = CACHED_LEA_OFFSET_TO_OFFSET;
+		else if (commandType == typeid(LeaAddressToOffset)) cachedType = CACHED_LEA_ADDRESS_TO_OFFSET;
+		else if (commandType == typeid(PushGlobalParam)) cachedType = CACHED_PUSH_GLOBAL_PARAM;
+		else if (commandType == typeid(PushGlobalParamRef)) cachedType = CACHED_PUSH_GLOBAL_PARAM_REF;
+		else if (commandType == typeid(LeaGlobalToOffset)) cachedType = CACHED_LEA_GLOBAL_TO_OFFSET;
+		else if (commandType == typeid(LeaOffsetToGlobal)) cachedType = CACHED_LEA_OFFSET_TO_GLOBAL;
+		else if (commandType == typeid(LeaGlobalToGlobal)) cachedType = CACHED_LEA_GLOBAL_TO_GLOBAL;
+		else if (commandType == typeid(CopyDataToRef)) cachedType = CACHED_COPY_DATA_TO_REF;
+		else if (commandType == typeid(RetreiveScriptFunctionResult)) cachedType = CACHED_RETREIVE_RESULT;
+		else if (commandType == typeid(CallNativeFuntion)) {
+			// dereference and struct functions are created by the compiler, they are not registered
+			auto& targetFunction = ((CallNativeFuntion*)command)->_targetFunction;
+			if (dynamic_cast<DeRefCommand*>(targetFunction.get())) cachedType = CACHED_CALL_DEREF;
+			else if (dynamic_cast<DeRefCommand2*>(targetFunction.get())) cachedType = CACHED_CALL_DEREF2;
+			else if (dynamic_cast<MemberAccessCommand2*>(targetFunction.get())) cachedType = CACHED_CALL_MEMBER_ACCESS;
+			else if (dynamic_cast<ArrayToStructCommand*>(targetFunction.get())) cachedType = CACHED_CALL_ARRAY_TO_STRUCT;
+			else cachedType = CACHED_CALL_NATIVE;
+		}
+		else if (dynamic_cast<NativeOperatorCommand*>(command)) cachedType = CACHED_NATIVE_OPERATOR;
+		else if (commandType == typeid(CallScriptFuntion2)) cachedType = CACHED_CALL_SCRIPT2;
+		else if (commandType == typeid(CallScriptFuntion3)) cachedType = CACHED_CALL_SCRIPT3;
+		else if (commandType == typeid(Jump)) cachedType = CACHED_JUMP;
+		else if (commandType == typeid(JumpIf)) cachedType = CACHED_JUMP_IF;
+		else if (commandType == typeid(JumpIfElse)) cachedType = CACHED_JUMP_IF_ELSE;
+		else if (commandType == typeid(BreakCommand)) cachedType = CACHED_BREAK;
+		else if (commandType == typeid(ExitScriptFuntionAtReturn)) cachedType = CACHED_EXIT_AT_RETURN;
+		else if (commandType == typeid(ContinueCommand)) cachedType = CACHED_CONTINUE;
+		else if (commandType == typeid(ExitFunctionAtTheEnd)) cachedType = CACHED_EXIT_AT_THE_END;
+		else if (commandType == typeid(FunctionCommand0P)) cachedType = CACHED_FUNCTION_0P;
+		else if (commandType == typeid(FunctionCommand1P)) cachedType = CACHED_FUNCTION_1P;
+		else if (commandType == typeid(FunctionCommand2P)) cachedType = CACHED_FUNCTION_2P;
+		else if (commandType == typeid(FunctionCommandNP)) cachedType = CACHED_FUNCTION_NP;
+		else if (commandType == typeid(CompareAndJump)) cachedType = CACHED_COMPARE_AND_JUMP;
+		else if (commandType == typeid(DefaultAssigmentCommand)) cachedType = CACHED_DEFAULT_ASSIGNMENT;
+		else if (commandType == typeid(DefaultAssigmentCommandForSemiRef)) cachedType = CACHED_DEFAULT_ASSIGNMENT_SEMI_REF;
+		else if (commandType == typeid(TriggerCommand)) cachedType = CACHED_TRIGGER;
+		else if (commandType == typeid(ConditionTriggerCommand)) cachedType = CACHED_CONDITION_TRIGGER;
+		else {
+			return setSaveError(std::string("command '") + commandType.name() + "'");
+		}
+
+		writeValue(stream, (unsigned char)cachedType);
+		auto targetedCommand = dynamic_cast<TargetedCommand*>(command);
+		if (targetedCommand) {
+			writeValue(stream, targetedCommand->getTargetOffset());
+			writeValue(stream, targetedCommand->getTargetSize());
+		}
+
+		switch (cachedType)
+		{
+		case CACHED_ENTER_SCOPE: {
+			auto enterScope = (EnterContextScope*)command;
+			if (enterScope->_scopeAutoRunList) {
+				return setSaveError("constructors in a scope");
+			}
+			writeValue(stream, enterScope->_scopeDataSize);
+			writeValue(stream, enterScope->_scopeCodeSize);
+			writeValue(stream, enterScope->_constructorCommandCount);
+			break;
+		}
+		case CACHED_EXIT_SCOPE: {
+			auto exitScope = (ExitContextScope*)command;
+			if (exitScope->_scopeAutoRunList) {
+				return setSaveError("destructors in a scope");
+			}
+			writeValue(stream, exitScope->_scopeDataSize);
+			writeValue(stream, exitScope->_scopeCodeSize);
+			writeValue(stream, exitScope->_restoreCall);
+			break;
+		}
+		case CACHED_PUSH_PARAM:
+			if (!writeAddress(stream, ((PushParam*)command)->_param)) {
+				return setSaveError("param of a push command");
+			}
+			break;
+		case CACHED_PUSH_PARAM_REF:
+			if (!writeAddress(stream, ((PushParamRef*)command)->_param)) {
+				return setSaveError("param of a push command");
+			}
+			break;
+		case CACHED_PUSH_PARAM_OFFSET:
+			writeValue(stream, ((PushParamOffset*)command)->_sourceOffset);
+			break;
+		case CACHED_PUSH_PARAM_REF_OFFSET:
+			writeValue(stream, ((PushParamRefOffset*)command)->_sourceOffset);
+			break;
+		case CACHED_LEA_OFFSET_TO_OFFSET:
+			writeValue(stream, ((LeaOffsetToOffset*)command)->_sourceOffset);
+			break;
+		case CACHED_LEA_ADDRESS_TO_OFFSET:
+			if (!writeAddress(stream, ((LeaAddressToOffset*)command)->_source)) {
+				return setSaveError("source of a lea command");
+			}
+			break;
+		case CACHED_PUSH_GLOBAL_PARAM:
+			writeValue(stream, ((PushGlobalParam*)command)->_sourceOffset);
+			break;
+		case CACHED_PUSH_GLOBAL_PARAM_REF:
+			writeValue(stream, ((PushGlobalParamRef*)command)->_sourceOffset);
+			break;
+		case CACHED_LEA_GLOBAL_TO_OFFSET:
+			writeValue(stream, ((LeaGlobalToOffset*)command)->_sourceOffset);
+			break;
+		case CACHED_LEA_OFFSET_TO_GLOBAL:
+			writeValue(stream, ((LeaOffsetToGlobal*)command)->_sourceOffset);
+			writeValue(stream, ((LeaOffsetToGlobal*)command)->_targetOffset);
+			break;
+		case CACHED_LEA_GLOBAL_TO_GLOBAL:
+			writeValue(stream, ((LeaGlobalToGlobal*)command)->_sourceOffset);
+			writeValue(stream, ((LeaGlobalToGlobal*)command)->_targetOffset);
+			break;
+		case CACHED_COPY_DATA_TO_REF:
+			writeValue(stream, ((CopyDataToRef*)command)->_sourceOffset);
+			break;
+		case CACHED_RETREIVE_RESULT:
+			break;
+		case CACHED_CALL_NATIVE:
+		case CACHED_NATIVE_OPERATOR: {
+			// native functions are bound again by their names and signatures
+			auto callFunction = (CallFuntion*)command;
+			if (!writeNativeFunction(stream, callFunction->getFunctionId())) {
+				return setSaveError("native function '" + callFunction->_functionName + "'");
+			}
+			writeValue(stream, callFunction->getBeginParamOffset());
+			if (cachedType == CACHED_NATIVE_OPERATOR) {
+				auto nativeOperator = (NativeOperatorCommand*)command;
+				writeValue(stream, nativeOperator->getParamCount());
+				for (int i = 0; i < nativeOperator->getParamCount(); i++) {
+					writeValue(stream, nativeOperator->getParamOffset(i));
+					writeValue(stream, nativeOperator->isDirectRef(i));
+				}
+			}
+			break;
+		}
+		case CACHED_CALL_DEREF:
+		case CACHED_CALL_DEREF2: {
+			auto callFunction = (CallNativeFuntion*)command;
+			auto targetFunction = callFunction->_targetFunction.get();
+			writeValue(stream, callFunction->getBeginParamOffset());
+			writeValue(stream, cachedType == CACHED_CALL_DEREF ? ((DeRefCommand*)targetFunction)->_typeSize : ((DeRefCommand2*)targetFunction)->_typeSize);
+			break;
+		}
+		case CACHED_CALL_MEMBER_ACCESS:
+		case CACHED_CALL_ARRAY_TO_STRUCT: {
+			auto callFunction = (CallNativeFuntion*)command;
+			writeValue(stream, callFunction->getBeginParamOffset());
+			writeString(stream, callFunction->_functionName);
+			break;
+		}
+		case CACHED_CALL_SCRIPT2:
+		case CACHED_CALL_SCRIPT3: {
+			auto callScriptFunction = (CallScriptFuntion2*)command;
+			writeString(stream, callScriptFunction->_functionName);
+			writeValue(stream, callScriptFunction->getBeginParamOffset());
+			writeValue(stream, callScriptFunction->_paramSize);
+			writeCommandPointer(stream, callScriptFunction->getTargetCommand());
+			writeCommandPointer(stream, callScriptFunction->_callerReturn);
+			break;
+		}
+		case CACHED_JUMP:
+			writeCommandPointer(stream, ((Jump*)command)->_targetCommand);
+			break;
+		case CACHED_JUMP_IF:
+		case CACHED_JUMP_IF_ELSE:
+			writeValue(stream, ((JumpIf*)command)->_conditionOffset);
+			writeCommandPointer(stream, ((JumpIf*)command)->_targetCommandTrue);
+			if (cachedType == CACHED_JUMP_IF_ELSE) {
+				writeCommandPointer(stream, ((JumpIfElse*)command)->_targetCommandFalse);
+			}
+			break;
+		case CACHED_BREAK:
+		case CACHED_EXIT_AT_RETURN:
+		case CACHED_CONTINUE: {
+			if (cachedType == CACHED_EXIT_AT_RETURN) {
+				writeValue(stream, ((ExitScriptFuntionAtReturn*)command)->_indexPreventDestructorRun);
+			}
+			else if (cachedType == CACHED_CONTINUE) {
+				writeCommandPointer(stream, ((ContinueCommand*)command)->_loopCommand);
+			}
+			auto& commands = ((MultipleCommand*)command)->getCommands();
+			writeValue(stream, (int)commands.size());
+			for (auto subCommand : commands) {
+				if (!writeCommand(stream, subCommand)) return false;
+			}
+			break;
+		}
+		case CACHED_EXIT_AT_THE_END:
+			break;
+		case CACHED_FUNCTION_0P:
+			if (!writeCommand(stream, ((FunctionCommand0P*)command)->_command)) return false;
+			break;
+		case CACHED_FUNCTION_1P:
+			if (!writeCommand(stream, ((FunctionCommand1P*)command)->_commandParam)) return false;
+			if (!writeCommand(stream, ((FunctionCommand1P*)command)->_command)) return false;
+			break;
+		case CACHED_FUNCTION_2P:
+			if (!writeCommand(stream, ((FunctionCommand2P*)command)->_commandParam1)) return false;
+			if (!writeCommand(stream, ((FunctionCommand2P*)command)->_commandParam2)) return false;
+			if (!writeCommand(stream, ((FunctionCommand2P*)command)->_command)) return false;
+			break;
+		case CACHED_FUNCTION_NP: {
+			auto functionCommand = (FunctionCommandNP*)command;
+			writeValue(stream, functionCommand->_nMaxParam);
+			writeValue(stream, functionCommand->_nParam);
+			for (int i = 0; i < functionCommand->_nParam; i++) {
+				if (!writeCommand(stream, functionCommand->_commandParams[i])) return false;
+			}
+			if (!writeCommand(stream, functionCommand->_command)) return false;
+			break;
+		}
+		case CACHED_COMPARE_AND_JUMP: {
+			auto compareAndJump = (CompareAndJump*)command;
+			if (!writeCommand(stream, compareAndJump->_comparison)) return false;
+			for (int i = 0; i < 2; i++) {
+				auto& operand = compareAndJump->_operands[i];
+				if (!writeAddress(stream, operand.address)) {
+					return setSaveError("operand of a condition");
+				}
+				writeValue(stream, operand.offset);
+				writeValue(stream, operand.directRef);
+				writeValue(stream, operand.global);
+			}
+			writeCommandPointer(stream, compareAndJump->_targetTrue);
+			writeCommandPointer(stream, compareAndJump->_targetFalse);
+			break;
+		}
+		case CACHED_DEFAULT_ASSIGNMENT: {
+			auto assigmentCommand = (DefaultAssigmentCommand*)command;
+			writeValue(stream, assigmentCommand->_blockSize);
+			if (!writeCommand(stream, assigmentCommand->_command1)) return false;
+			if (!writeCommand(stream, assigmentCommand->_command2)) return false;
+			break;
+		}
+		case CACHED_DEFAULT_ASSIGNMENT_SEMI_REF: {
+			auto assigmentCommand = (DefaultAssigmentCommandForSemiRef*)command;
+			writeValue(stream, assigmentCommand->_blockSize);
+			if (!writeCommand(stream, assigmentCommand->_command1)) return false;
+			if (!writeCommand(stream, assigmentCommand->_command2)) return false;
+			break;
+		}
+		case CACHED_TRIGGER:
+		case CACHED_CONDITION_TRIGGER: {
+			auto triggerCommand = (TriggerCommand*)command;
+			if (!writeTrigger(stream, triggerCommand->_beforeExecuteFunc)) return false;
+			if (!writeTrigger(stream, triggerCommand->_afterExecuteFunc)) return false;
+			if (!writeCommand(stream, triggerCommand->_mainCommand)) return false;
+			break;
+		}
+		default:
+			return false;
+		}
+		return true;
+	}
+
+	// all items those cannot be saved are rejected through this function, they are listed in
+	// the comment of ProgramCache::save
+	bool ProgramCache::setSaveError(const std::string& unsavedItem) {
+		getCompiler()->setErrorText(unsavedItem + " cannot be saved");
+		return false;
+	}
+
+	bool ProgramCache::save(Program* program, std::ostream& stream) {
+		auto scriptCompiler = getCompiler();
+		if (program == nullptr || program->getFirstCommand() == nullptr) {
+			scriptCompiler->setErrorText("program does not have code to save");
+			return false;
+		}
+		// code of recompiled functions is placed out of the program code
+		for (auto& functionCode : program->getFunctionPlainCodes()) {
+			if (functionCode.second.first < program->getFirstCommand() || functionCode.second.second >= program->getEndCommand()) {
+				return setSaveError("program with recompiled functions");
+			}
+		}
+
+		_program = program;
+		_constantIndexMap.clear();
+		_constants.clear();
+		_nativeIndexMap.clear();
+		_nativeFunctions.clear();
+
+		// the code is written first to collect constants and native functions it uses
+		std::stringstream codeStream;
+		int commandCount = (int)(program->getEndCommand() - program->getFirstCommand());
+		writeValue(codeStream, commandCount);
+		for (auto command = program->getFirstCommand(); command != program->getEndCommand(); command++) {
+			if (!writeCommand(codeStream, *command)) {
+				return false;
+			}
+		}
+
+		stream.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+		writeValue(stream, FORMAT_VERSION);
+		writeValue(stream, (int)sizeof(void*));
+		writeValue(stream, (int)sizeof(wchar_t));
+
+		// layout of global data and commands of the global scope
+		writeValue(stream, program->getGlobalDataSize());
+		writeValue(stream, program->getGlobalScopeSize());
+		writeValue(stream, program->getGlobalConstructorCount());
+		auto& globalCommands = program->getGlobalCommands();
+		writeValue(stream, (int)globalCommands.size());
+		for (auto command : globalCommands) {
+			writeCommandPointer(stream, command);
+		}
+		auto& destructorCommands = program->getGlobalDestructorCommands();
+		writeValue(stream, (int)destructorCommands.size());
+		for (auto command : destructorCommands) {
+			writeCommandPointer(stream, command);
+		}
+
+		// structs are declared before functions those use them
+		writeStructs(stream);
+
+		// script functions and their code
+		auto& functionCodes = program->getFunctionPlainCodes();
+		writeValue(stream, (int)functionCodes.size());
+		for (auto& functionCode : functionCodes) {
+			if (!writeFunctionTypes(stream, functionCode.first)) {
+				scriptCompiler->setErrorText("information of function " + std::to_string(functionCode.first) + " is missing");
+				return false;
+			}
+			writeCommandPointer(stream, functionCode.second.first);
+			writeCommandPointer(stream, functionCode.second.second);
+		}
+
+		writeValue(stream, (int)_constants.size());
+		for (auto& constant : _constants) {
+			writeValue(stream, constant.first);
+			writeString(stream, constant.second);
+		}
+
+		writeValue(stream, (int)_nativeFunctions.size());
+		for (auto functionId : _nativeFunctions) {
+			if (!writeFunctionTypes(stream, functionId)) {
+				scriptCompiler->setErrorText("information of function " + std::to_string(functionId) + " is missing");
+				return false;
+			}
+		}
+
+		stream << codeStream.rdbuf();
+		return stream.good();
+	}
+
+	bool ProgramCache::setLoadError(const std::string& errorText) {
+		if (!_loadFailed) {
+			getCompiler()->setErrorText(errorText);
+			_loadFailed = true;
+		}
+		return false;
+	}
+
+	void ProgramCache::keepCommand(InstructionCommand* command) {
+		((LoadedCodeExecutor*)_loadedCode.get())->keepCommand(command);
+	}
+
+	void ProgramCache::readCommandPointer(std::istream& stream, CommandPointer* commandPointer) {
+		int commandIndex = readValue<int>(stream);
+		*commandPointer = nullptr;
+		if (commandIndex != NULL_COMMAND_INDEX) {
+			_commandLinks.push_back(std::make_pair(commandPointer, commandIndex));
+		}
+	}
+
+	void* ProgramCache::readAddress(std::istream& stream) {
+		auto addressType = readValue<unsigned char>(stream);
+		if (addressType == CACHED_ADDRESS_NULL) {
+			return nullptr;
+		}
+		int value = readValue<int>(stream);
+		if (addressType == CACHED_ADDRESS_CONSTANT && value >= 0 && value < (int)_loadedConstants.size()) {
+			return _loadedConstants[value];
+		}
+		setLoadError("invalid address in the program cache");
+		return nullptr;
+	}
+
+	int ProgramCache::readNativeFunction(std::istream& stream) {
+		int nativeIndex = readValue<int>(stream);
+		if (nativeIndex < 0 || nativeIndex >= (int)_loadedNativeFunctions.size()) {
+			setLoadError("invalid native function in the program cache");
+			return -1;
+		}
+		return _loadedNativeFunctions[nativeIndex];
+	}
+
+	bool ProgramCache::readFunctionTypes(std::istream& stream, std::string& name, std::vector<ScriptType>& paramTypes, ScriptType& returnType) {
+		auto scriptCompiler = getCompiler();
+		name = readString(stream);
+		returnType = ScriptType::parseType(scriptCompiler, readString(stream));
+		int paramCount = readCount(stream, sizeof(int));
+		if (!stream.good() || returnType.isUnkownType()) {
+			return false;
+		}
+		paramTypes.resize(paramCount);
+		for (int i = 0; i < paramCount; i++) {
+			paramTypes[i] = ScriptType::parseType(scriptCompiler, readString(stream));
+			if (paramTypes[i].isUnkownType()) {
+				return false;
+			}
+		}
+		return stream.good();
+	}
+
+	CommandTriggerRef ProgramCache::readTrigger(std::istream& stream, std::string& commandName) {
+		auto triggerType = readValue<unsigned char>(stream);
+		if (triggerType == CACHED_TRIGGER_NONE) {
+			return nullptr;
+		}
+		int constructorIndex = readValue<int>(stream);
+		if (constructorIndex < 0) {
+			setLoadError("invalid trigger in the program cache");
+			return nullptr;
+		}
+		if (triggerType == CACHED_TRIGGER_SET_CONSTRUCTOR) {
+			commandName = "setctor(" + std::to_string(constructorIndex) + ")";
+			return std::make_shared<AfterConstructorCall>(constructorIndex);
+		}
+		if (triggerType == CACHED_TRIGGER_CHECK_CONSTRUCTOR) {
+			commandName = "checkctor(" + std::to_string(constructorIndex) + ")";
+			return std::make_shared<BeforeDestructorCall>(constructorIndex);
+		}
+		setLoadError("invalid trigger in the program cache");
+		return nullptr;
+	}
+
+	bool ProgramCache::readStructs(std::istream& stream) {
+		auto scriptCompiler = getCompiler();
+		// a struct takes at least sizes of its name, its size and its member count
+		int structCount = readCount(stream, 3 * sizeof(int));
+		for (int i = 0; i < structCount && stream.good(); i++) {
+			std::unique_ptr<StructClass> userStruct(new StructClass(scriptCompiler, readString(stream)));
+			int structSize = readValue<int>(stream);
+			int memberCount = readCount(stream, 2 * sizeof(int));
+			for (int j = 0; j < memberCount && stream.good(); j++) {
+				auto memberType = ScriptType::parseType(scriptCompiler, readString(stream));
+				auto memberName = readString(stream);
+				if (memberType.isUnkownType()) {
+					return setLoadError("invalid member of struct '" + userStruct->getName() + "' in the program cache");
+				}
+				userStruct->addMember(memberType, memberName);
+			}
+			if (!stream.good()) {
+				break;
+			}
+			// the layout depends on sizes of member types those are registered by the compiler
+			if (userStruct->getSize() != structSize) {
+				return setLoadError("layout of struct '" + userStruct->getName() + "' does not match the program cache");
+			}
+			auto structName = userStruct->getName();
+			if (IS_UNKNOWN_TYPE(scriptCompiler->registStruct(userStruct.get()))) {
+				return setLoadError("cannot declare struct '" + structName + "'");
+			}
+			// the struct is owned by the compiler now
+			userStruct.release();
+		}
+		if (!stream.good()) {
+			return setLoadError("program cache is truncated");
+		}
+		return true;
+	}
+
+	InstructionCommand* ProgramCache::readCommand(std::istream& stream) {
+		auto cachedType = readValue<unsigned char>(stream);
+		if (!stream.good() || cachedType == CACHED_NULL) {
+			return nullptr;
+		}
+
+		auto scriptCompiler = getCompiler();
+		bool targeted = cachedType != CACHED_ENTER_SCOPE && cachedType != CACHED_EXIT_SCOPE && cachedType != CACHED_JUMP &&
+			cachedType != CACHED_JUMP_IF && cachedType != CACHED_JUMP_IF_ELSE && cachedType != CACHED_BREAK &&
+			cachedType != CACHED_EXIT_AT_RETURN && cachedType != CACHED_CONTINUE && cachedType != CACHED_EXIT_AT_THE_END &&
+			cachedType != CACHED_COMPARE_AND_JUMP;
+		int targetOffset = 0;
+		int targetSize = 0;
+		if (targeted) {
+			targetOffset = readValue<int>(stream);
+			targetSize = readValue<int>(stream);
+		}
+
+		InstructionCommand* command = nullptr;
+		switch (cachedType)
+		{
+		case CACHED_ENTER_SCOPE: {
+			auto enterScope = new EnterContextScope();
+			int dataSize = readValue<int>(stream);
+			int codeSize = readValue<int>(stream);
+			int constructorCommandCount = readValue<int>(stream);
+			enterScope->setScopeInfo(dataSize, codeSize, constructorCommandCount);
+			command = enterScope;
+			break;
+		}
+		case CACHED_EXIT_SCOPE: {
+			auto exitScope = new ExitContextScope();
+			int dataSize = readValue<int>(stream);
+			int codeSize = readValue<int>(stream);
+			exitScope->setScopeInfo(dataSize, codeSize);
+			exitScope->setRestoreCallFlag(readValue<bool>(stream));
+			command = exitScope;
+			break;
+		}
+		case CACHED_PUSH_PARAM: {
+			auto pushParam = new PushParam();
+			pushParam->setCommandData(readAddress(stream), targetSize, targetOffset);
+			command = pushParam;
+			break;
+		}
+		case CACHED_PUSH_PARAM_REF: {
+			auto pushParamRef = new PushParamRef();
+			pushParamRef->setCommandData(readAddress(stream), targetOffset);
+			command = pushParamRef;
+			break;
+		}
+		case CACHED_PUSH_PARAM_OFFSET: {
+			auto pushParamOffset = new PushParamOffset();
+			pushParamOffset->setCommandData(readValue<int>(stream), targetSize, targetOffset);
+			command = pushParamOffset;
+			break;
+		}
+		case CACHED_PUSH_PARAM_REF_OFFSET: {
+			auto pushParamRefOffset = new PushParamRefOffset();
+			pushParamRefOffset->setCommandData(readValue<int>(stream), targetOffset);
+			command = pushParamRefOffset;
+			break;
+		}
+		case CACHED_LEA_OFFSET_TO_OFFSET: {
+			auto leaCommand = new LeaOffsetToOffset();
+			leaCommand->setCommandData(readValue<int>(stream), targetOffset);
+			command = leaCommand;
+			break;
+		}
+		case CACHED_LEA_ADDRESS_TO_OFFSET: {
+			auto leaCommand = new LeaAddressToOffset();
+			leaCommand->setCommandData(readAddress(stream), targetOffset);
+			command = leaCommand;
+			break;
+		}
+		case CACHED_PUSH_GLOBAL_PARAM: {
+			auto pushParam = new PushGlobalParam();
+			pushParam->setCommandData(readValue<int>(stream), targetSize, targetOffset);
+			command = pushParam;
+			break;
+		}
+		case CACHED_PUSH_GLOBAL_PARAM_REF: {
+			auto pushParamRef = new PushGlobalParamRef();
+			pushParamRef->setCommandData(readValue<int>(stream), targetOffset);
+			command = pushParamRef;
+			break;
+		}
+		case CACHED_LEA_GLOBAL_TO_OFFSET: {
+			auto leaCommand = new LeaGlobalToOffset();
+			leaCommand->setCommandData(readValue<int>(stream), targetOffset);
+			command = leaCommand;
+			break;
+		}
+		case CACHED_LEA_OFFSET_TO_GLOBAL: {
+			auto leaCommand = new LeaOffsetToGlobal();
+			int sourceOffset = readValue<int>(stream);
+			leaCommand->setCommandData(sourceOffset, readValue<int>(stream));
+			command = leaCommand;
+			break;
+		}
+		case CACHED_LEA_GLOBAL_TO_GLOBAL: {
+			auto leaCommand = new LeaGlobalToGlobal();
+			int sourceOffset = readValue<int>(stream);
+			leaCommand->setCommandData(sourceOffset, readValue<int>(stream));
+			command = leaCommand;
+			break;
+		}
+		case CACHED_COPY_DATA_TO_REF: {
+			auto copyCommand = new CopyDataToRef();
+			copyCommand->setCommandData(readValue<int>(stream), targetSize, targetOffset);
+			command = copyCommand;
+			break;
+		}
+		case CACHED_RETREIVE_RESULT: {
+			auto retreiveCommand = new RetreiveScriptFunctionResult();
+			retreiveCommand->setCommandData(targetOffset, targetSize);
+			command = retreiveCommand;
+			break;
+		}
+		case CACHED_CALL_NATIVE: {
+			int functionId = readNativeFunction(stream);
+			int beginParamOffset = readValue<int>(stream);
+			auto nativeFunction = dynamic_cast<NativeFunction*>(functionId >= 0 ? scriptCompiler->createFunctionFromId(functionId) : nullptr);
+			if (nativeFunction == nullptr) {
+				setLoadError("cannot bind native function " + std::to_string(functionId));
+				return nullptr;
+			}
+			auto callNativeFunction = new CallNativeFuntion();
+			callNativeFunction->setCommandData(targetOffset, beginParamOffset, nativeFunction->getNative());
+			callNativeFunction->setFunctionName(nativeFunction->getName());
+			callNativeFunction->setFunctionId(functionId);
+			delete nativeFunction;
+			command = callNativeFunction;
+			break;
+		}
+		case CACHED_CALL_DEREF:
+		case CACHED_CALL_DEREF2: {
+			int beginParamOffset = readValue<int>(stream);
+			int typeSize = readValue<int>(stream);
+			DFunction2* derefCommand;
+			if (cachedType == CACHED_CALL_DEREF) {
+				derefCommand = new DeRefCommand(typeSize);
+			}
+			else {
+				derefCommand = new DeRefCommand2(typeSize);
+			}
+			auto callNativeFunction = new CallNativeFuntion();
+			callNativeFunction->setCommandData(targetOffset, beginParamOffset, DFunction2Ref(derefCommand));
+			callNativeFunction->setFunctionName(DEREF_OPERATOR);
+			command = callNativeFunction;
+			break;
+		}
+		case CACHED_CALL_MEMBER_ACCESS:
+		case CACHED_CALL_ARRAY_TO_STRUCT: {
+			int beginParamOffset = readValue<int>(stream);
+			DFunction2* structCommand;
+			if (cachedType == CACHED_CALL_MEMBER_ACCESS) {
+				structCommand = new MemberAccessCommand2();
+			}
+			else {
+				structCommand = new ArrayToStructCommand();
+			}
+			auto callNativeFunction = new CallNativeFuntion();
+			callNativeFunction->setCommandData(targetOffset, beginParamOffset, DFunction2Ref(structCommand));
+			callNativeFunction->setFunctionName(readString(stream));
+			command = callNativeFunction;
+			break;
+		}
+		case CACHED_NATIVE_OPERATOR: {
+			int functionId = readNativeFunction(stream);
+			int beginParamOffset = readValue<int>(stream);
+			int paramCount = readValue<int>(stream);
+			auto nativeCommandFactory = functionId >= 0 ? scriptCompiler->getNativeCommand(functionId) : nullptr;
+			if (nativeCommandFactory == nullptr) {
+				setLoadError("cannot bind native operator " + std::to_string(functionId));
+				return nullptr;
+			}
+			auto nativeOperator = nativeCommandFactory->createCommand(targetOffset, beginParamOffset);
+			if (nativeOperator->getParamCount() != paramCount) {
+				delete nativeOperator;
+				setLoadError("native operator " + std::to_string(functionId) + " does not match the program cache");
+				return nullptr;
+			}
+			for (int i = 0; i < paramCount; i++) {
+				int paramOffset = readValue<int>(stream);
+				nativeOperator->setParamOffset(i, paramOffset, readValue<bool>(stream));
+			}
+			auto functionInfo = scriptCompiler->getFunctionLib()->findFunctionInfo(functionId);
+			if (functionInfo == nullptr || functionInfo->itemName == nullptr) {
+				delete nativeOperator;
+				setLoadError("native operator " + std::to_string(functionId) + " does not have a name");
+				return nullptr;
+			}
+			nativeOperator->setFunctionName(*functionInfo->itemName);
+			nativeOperator->setFunctionId(functionId);
+			command = nativeOperator;
+			break;
+		}
+		case CACHED_CALL_SCRIPT2:
+		case CACHED_CALL_SCRIPT3: {
+			auto callScriptFunction = cachedType == CACHED_CALL_SCRIPT2 ? new CallScriptFuntion2() : new CallScriptFuntion3();
+			callScriptFunction->setFunctionName(readString(stream));
+			int beginParamOffset = readValue<int>(stream);
+			int paramSize = readValue<int>(stream);
+			callScriptFunction->setCommandData(targetOffset, beginParamOffset, paramSize);
+			readCommandPointer(stream, &callScriptFunction->_targetFunction);
+			readCommandPointer(stream, &callScriptFunction->_callerReturn);
+			command = callScriptFunction;
+			break;
+		}
+		case CACHED_JUMP: {
+			auto jump = new Jump();
+			readCommandPointer(stream, &jump->_targetCommand);
+			command = jump;
+			break;
+		}
+		case CACHED_JUMP_IF:
+		case CACHED_JUMP_IF_ELSE: {
+			auto jumpIf = cachedType == CACHED_JUMP_IF ? new JumpIf() : new JumpIfElse();
+			jumpIf->_conditionOffset = readValue<int>(stream);
+			readCommandPointer(stream, &jumpIf->_targetCommandTrue);
+			if (cachedType == CACHED_JUMP_IF_ELSE) {
+				readCommandPointer(stream, &((JumpIfElse*)jumpIf)->_targetCommandFalse);
+			}
+			command = jumpIf;
+			break;
+		}
+		case CACHED_BREAK:
+		case CACHED_EXIT_AT_RETURN:
+		case CACHED_CONTINUE: {
+			MultipleCommand* multipleCommand;
+			if (cachedType == CACHED_EXIT_AT_RETURN) {
+				auto exitCommand = new ExitScriptFuntionAtReturn();
+				exitCommand->setCommandData(readValue<int>(stream));
+				multipleCommand = exitCommand;
+			}
+			else if (cachedType == CACHED_CONTINUE) {
+				auto continueCommand = new ContinueCommand();
+				readCommandPointer(stream, &continueCommand->_loopCommand);
+				multipleCommand = continueCommand;
+			}
+			else {
+				multipleCommand = new BreakCommand();
+			}
+			int subCommandCount = readCount(stream, 1);
+			for (int i = 0; i < subCommandCount && stream.good(); i++) {
+				auto subCommand = readCommand(stream);
+				if (subCommand == nullptr) break;
+				// sub commands are not owned by the command
+				keepCommand(subCommand);
+				multipleCommand->getCommands().push_back(subCommand);
+			}
+			if ((int)multipleCommand->getCommands().size() != subCommandCount) {
+				delete multipleCommand;
+				setLoadError("invalid command in the program cache");
+				return nullptr;
+			}
+			command = multipleCommand;
+			break;
+		}
+		case CACHED_EXIT_AT_THE_END:
+			command = new ExitFunctionAtTheEnd();
+			break;
+		case CACHED_FUNCTION_0P:
+		case CACHED_FUNCTION_1P:
+		case CACHED_FUNCTION_2P:
+		case CACHED_FUNCTION_NP: {
+			FunctionCommand* functionCommand;
+			int paramCount;
+			if (cachedType == CACHED_FUNCTION_NP) {
+				// the maximum count is bounded by the stream size too, so a broken count is not allocated
+				int maxParamCount = readCount(stream, 1);
+				paramCount = readCount(stream, 1);
+				if (!stream.good() || maxParamCount < paramCount) {
+					setLoadError("invalid command in the program cache");
+					return nullptr;
+				}
+				functionCommand = new FunctionCommandNP(maxParamCount);
+			}
+			else if (cachedType == CACHED_FUNCTION_2P) {
+				functionCommand = new FunctionCommand2P();
+				paramCount = 2;
+			}
+			else if (cachedType == CACHED_FUNCTION_1P) {
+				functionCommand = new FunctionCommand1P();
+				paramCount = 1;
+			}
+			else {
+				functionCommand = new FunctionCommand0P();
+				paramCount = 0;
+			}
+			// params are owned by the command tree
+			for (int i = 0; i < paramCount && !_loadFailed; i++) {
+				auto paramCommand = (TargetedCommand*)readCommand(stream);
+				if (paramCommand) {
+					functionCommand->pushCommandParam(paramCommand);
+				}
+			}
+			auto mainCommand = (TargetedCommand*)readCommand(stream);
+			if (mainCommand == nullptr) {
+				delete functionCommand;
+				setLoadError("invalid command in the program cache");
+				return nullptr;
+			}
+			functionCommand->setCommand(mainCommand);
+			command = functionCommand;
+			break;
+		}
+		case CACHED_COMPARE_AND_JUMP: {
+			auto comparison = dynamic_cast<NativeOperatorCommand*>(readCommand(stream));
+			ConditionFx condition = comparison ? comparison->getConditionFx() : nullptr;
+			if (condition == nullptr) {
+				if (comparison) delete comparison;
+				setLoadError("invalid condition in the program cache");
+				return nullptr;
+			}
+			// the comparison is not owned by the command
+			keepCommand(comparison);
+			auto compareAndJump = new CompareAndJump(comparison, condition);
+			for (int i = 0; i < 2; i++) {
+				auto& operand = compareAndJump->_operands[i];
+				operand.address = (char*)readAddress(stream);
+				operand.offset = readValue<int>(stream);
+				operand.directRef = readValue<bool>(stream);
+				operand.global = readValue<bool>(stream);
+			}
+			readCommandPointer(stream, &compareAndJump->_targetTrue);
+			readCommandPointer(stream, &compareAndJump->_targetFalse);
+			command = compareAndJump;
+			break;
+		}
+		case CACHED_DEFAULT_ASSIGNMENT:
+		case CACHED_DEFAULT_ASSIGNMENT_SEMI_REF: {
+			int blockSize = readValue<int>(stream);
+			TargetedCommand* assigmentCommand;
+			if (cachedType == CACHED_DEFAULT_ASSIGNMENT) {
+				assigmentCommand = new DefaultAssigmentCommand(targetOffset, blockSize);
+			}
+			else {
+				assigmentCommand = new DefaultAssigmentCommandForSemiRef(targetOffset, blockSize);
+			}
+			// params are not owned by the command
+			for (int i = 0; i < 2; i++) {
+				auto paramCommand = (TargetedCommand*)readCommand(stream);
+				if (paramCommand == nullptr) {
+					delete assigmentCommand;
+					setLoadError("invalid command in the program cache");
+					return nullptr;
+				}
+				keepCommand(paramCommand);
+				if (cachedType == CACHED_DEFAULT_ASSIGNMENT) {
+					((DefaultAssigmentCommand*)assigmentCommand)->pushCommandParam(paramCommand);
+				}
+				else {
+					((DefaultAssigmentCommandForSemiRef*)assigmentCommand)->pushCommandParam(paramCommand);
+				}
+			}
+			command = assigmentCommand;
+			break;
+		}
+		case CACHED_TRIGGER:
+		case CACHED_CONDITION_TRIGGER: {
+			auto triggerCommand = cachedType == CACHED_TRIGGER ? new TriggerCommand() : new ConditionTriggerCommand();
+			std::string commandName;
+			auto beforeTrigger = readTrigger(stream, commandName);
+			if (beforeTrigger) {
+				triggerCommand->setBeforeTrigger(beforeTrigger, commandName);
+			}
+			auto afterTrigger = readTrigger(stream, commandName);
+			if (afterTrigger) {
+				triggerCommand->setAfterTrigger(afterTrigger, commandName);
+			}
+			// the main command is owned by the trigger command
+			auto mainCommand = _loadFailed ? nullptr : (TargetedCommand*)readCommand(stream);
+			if (mainCommand == nullptr) {
+				delete triggerCommand;
+				setLoadError("invalid command in the program cache");
+				return nullptr;
+			}
+			triggerCommand->setCommand(mainCommand);
+			command = triggerCommand;
+			break;
+		}
+		default:
+			setLoadError("unknown command in the program cache");
+			return nullptr;
+		}
+
+		if (targeted) {
+			auto targetedCommand = (TargetedCommand*)command;
+			targetedCommand->setTargetOffset(targetOffset);
+			targetedCommand->setTargetSize(targetSize);
+		}
+		return command;
+	}
+
+	Program* ProgramCache::load(std::istream& stream) {
+		auto scriptCompiler = getCompiler();
+		auto globalScope = getGlobalScope();
+		_loadFailed = false;
+		_commandLinks.clear();
+		_loadedConstants.clear();
+		_loadedNativeFunctions.clear();
+
+		char magic[sizeof(CACHE_MAGIC)];
+		stream.read(magic, sizeof(magic));
+		unsigned int formatVersion = readValue<unsigned int>(stream);
+		int pointerSize = readValue<int>(stream);
+		int wideCharSize = readValue<int>(stream);
+		if (!stream.good() || memcmp(magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) || formatVersion != FORMAT_VERSION ||
+			pointerSize != (int)sizeof(void*) || wideCharSize != (int)sizeof(wchar_t)) {
+			setLoadError("stream is not a program cache of current version");
+			return nullptr;
+		}
+
+		int dataSize = readValue<int>(stream);
+		int scopeSize = readValue<int>(stream);
+		// each constructor is run by a command, so the count is bounded by the stream size
+		int constructorCount = readCount(stream, 1);
+		std::vector<int> globalCommands(readCount(stream, sizeof(int)));
+		for (auto& commandIndex : globalCommands) {
+			commandIndex = readValue<int>(stream);
+		}
+		std::vector<int> destructorCommands(readCount(stream, sizeof(int)));
+		for (auto& commandIndex : destructorCommands) {
+			commandIndex = readValue<int>(stream);
+		}
+		if (!stream.good()) {
+			setLoadError("program cache is truncated");
+			return nullptr;
+		}
+
+		// structs and script functions are registered as the source was parsed
+		scriptCompiler->clearUserLib();
+		scriptCompiler->beginUserLib();
+		Program* program = new Program();
+		_program = program;
+		scriptCompiler->bindProgram(program);
+		globalScope->setScopeSize(dataSize, scopeSize);
+		// constructors of global variables are marked in the global scope when they run
+		while (globalScope->getConstructorCommandCount() < constructorCount) {
+			globalScope->generateNextConstructId();
+		}
+		if (!readStructs(stream)) {
+			delete program;
+			return nullptr;
+		}
+
+		std::string name;
+		std::vector<ScriptType> paramTypes;
+		ScriptType returnType;
+		// a function takes at least sizes of its name, return type and param count and its code range
+		std::vector<std::pair<int, std::pair<int, int>>> functionCodes(readCount(stream, 5 * sizeof(int)));
+		if (!stream.good()) {
+			setLoadError("program cache is truncated");
+		}
+		for (int i = 0; i < (int)functionCodes.size() && !_loadFailed; i++) {
+			auto& functionCode = functionCodes[i];
+			if (!readFunctionTypes(stream, name, paramTypes, returnType)) {
+				setLoadError("invalid function in the program cache");
+				break;
+			}
+			functionCode.first = globalScope->registScriptFunction(name, returnType, paramTypes);
+			functionCode.second.first = readValue<int>(stream);
+			functionCode.second.second = readValue<int>(stream);
+			if (functionCode.first < 0) {
+				setLoadError("cannot register function '" + name + "'");
+				break;
+			}
+		}
+
+		// constants and native functions used by the code
+		CodeArenaScope arenaScope(program->getCodeArena());
+		auto loadedCode = std::make_shared<LoadedCodeExecutor>();
+		_loadedCode = loadedCode;
+		int constantCount = _loadFailed ? 0 : readCount(stream, sizeof(int));
+		for (int i = 0; i < constantCount && stream.good(); i++) {
+			auto constantType = readValue<unsigned char>(stream);
+			auto constant = loadedCode->addConstant(constantType, readString(stream));
+			if (constant == nullptr) {
+				setLoadError("invalid constant in the program cache");
+				break;
+			}
+			_loadedConstants.push_back(constant);
+		}
+		int nativeCount = _loadFailed ? 0 : readCount(stream, 3 * sizeof(int));
+		for (int i = 0; i < nativeCount && !_loadFailed; i++) {
+			if (!readFunctionTypes(stream, name, paramTypes, returnType)) {
+				setLoadError("invalid native function in the program cache");
+				break;
+			}
+			int functionId = scriptCompiler->findFunction(name, paramTypes);
+			auto functionFactory = functionId >= 0 ? scriptCompiler->getFunctionFactory(functionId) : nullptr;
+			if (functionFactory == nullptr || functionFactory->getReturnType() != returnType) {
+				setLoadError("native function '" + name + "' is not registered");
+				break;
+			}
+			_loadedNativeFunctions.push_back(functionId);
+		}
+
+		int commandCount = _loadFailed ? 0 : readCount(stream, 1);
+		for (int i = 0; i < commandCount && !_loadFailed; i++) {
+			auto command = readCommand(stream);
+			if (command == nullptr) {
+				setLoadError("invalid command in the program cache");
+				break;
+			}
+			loadedCode->addCommand(command);
+		}
+		if (!_loadFailed && !stream.good()) {
+			setLoadError("program cache is truncated");
+		}
+		if (_loadFailed) {
+			_loadedCode.reset();
+			delete program;
+			return nullptr;
+		}
+
+		program->addExecutor(_loadedCode);
+		_loadedCode.reset();
+		program->convertToPlainCode();
+
+		// command pointers are placed in the code now
+		CommandPointer firstCommand = program->getFirstCommand();
+		auto isValidIndex = [commandCount](int commandIndex) {
+			// a jump command points to the command before its target
+			return commandIndex >= -1 && commandIndex < commandCount;
+		};
+		for (auto& commandLink : _commandLinks) {
+			if (!isValidIndex(commandLink.second)) {
+				setLoadError("invalid jump in the program cache");
+				delete program;
+				return nullptr;
+			}
+			*commandLink.first = firstCommand + commandLink.second;
+		}
+		_commandLinks.clear();
+
+		for (auto& functionCode : functionCodes) {
+			auto& codeRange = functionCode.second;
+			if (!isValidIndex(codeRange.first) || !isValidIndex(codeRange.second)) {
+				setLoadError("invalid function code in the program cache");
+				delete program;
+				return nullptr;
+			}
+			program->setFunctionPlainCode(functionCode.first, CodeSegmentEntry(firstCommand + codeRange.first, firstCommand + codeRange.second));
+		}
+
+		// global commands are run directly, so they must point to commands of the code
+		for (auto commandIndexes : { &globalCommands, &destructorCommands }) {
+			for (int commandIndex : *commandIndexes) {
+				if (commandIndex < 0 || commandIndex >= commandCount) {
+					setLoadError("invalid global command in the program cache");
+					delete program;
+					return nullptr;
+				}
+			}
+		}
+
+		auto staticContext = globalScope->getStaticContext();
+		for (int commandIndex : globalCommands) {
+			staticContext->addCommand(firstCommand + commandIndex);
+			program->addGlobalCommand(firstCommand + commandIndex);
+		}
+		for (int commandIndex : destructorCommands) {
+			staticContext->addDestructorCommand(firstCommand + commandIndex);
+			program->addGlobalDestructorCommand(firstCommand + commandIndex);
+		}
+		program->setGlobalLayout(dataSize, scopeSize, constructorCount);
+		program->setGlobalData(globalScope->getGlobalAddress(0));
+		staticContext->setGlobalData(globalScope->getGlobalAddress(0));
+
+		program->flattenCode();
+		program->lowerCode();
+		return program;
+	}
+}
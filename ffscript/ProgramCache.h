@@ -0,0 +1,102 @@
+/******************************************************************
+* File:        ProgramCache.h
+* Description: declare ProgramCache class. A class that saves the
+*              compiled code of a program to a binary stream and
+*              loads it back without parsing the source again.
+*              Global data and constants are saved as offsets and
+*              values, native functions are saved by their names and
+*              signatures and they are bound again when the program
+*              is loaded. Structs declared by the program are saved
+*              by their members and declared again when it is loaded.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "InstructionCommand.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <memory>
+
+namespace ffscript {
+
+	class CompilerSuite;
+	class ScriptCompiler;
+	class GlobalScope;
+	class Program;
+	class Executor;
+	class ScriptType;
+	class CommandTrigger;
+
+	class ProgramCache
+	{
+		CompilerSuite* _compilerSuite;
+		Program* _program;
+
+		// state of saving, constants and native functions are indexed in order they are found
+		std::map<const void*, int> _constantIndexMap;
+		// kind and bytes of each constant
+		std::vector<std::pair<unsigned char, std::string>> _constants;
+		std::map<int, int> _nativeIndexMap;
+		std::vector<int> _nativeFunctions;
+
+		// state of loading
+		std::vector<void*> _loadedConstants;
+		std::vector<int> _loadedNativeFunctions;
+		// command pointers those are set when the code is placed in the program, a pointer
+		// is stored as index of the command it points to
+		std::list<std::pair<CommandPointer*, int>> _commandLinks;
+		std::shared_ptr<Executor> _loadedCode;
+		bool _loadFailed;
+	private:
+		ScriptCompiler* getCompiler() const;
+		GlobalScope* getGlobalScope() const;
+
+		bool writeCommand(std::ostream& stream, InstructionCommand* command);
+		bool writeAddress(std::ostream& stream, const void* address);
+		bool writeNativeFunction(std::ostream& stream, int functionId);
+		void writeCommandPointer(std::ostream& stream, CommandPointer commandPointer);
+		bool writeFunctionTypes(std::ostream& stream, int functionId);
+		bool writeTrigger(std::ostream& stream, const std::shared_ptr<CommandTrigger>& trigger);
+		void writeStructs(std::ostream& stream);
+
+		InstructionCommand* readCommand(std::istream& stream);
+		void* readAddress(std::istream& stream);
+		int readNativeFunction(std::istream& stream);
+		void readCommandPointer(std::istream& stream, CommandPointer* commandPointer);
+		bool readFunctionTypes(std::istream& stream, std::string& name, std::vector<ScriptType>& paramTypes, ScriptType& returnType);
+		std::shared_ptr<CommandTrigger> readTrigger(std::istream& stream, std::string& commandName);
+		bool readStructs(std::istream& stream);
+		void keepCommand(InstructionCommand* command);
+		bool setSaveError(const std::string& unsavedItem);
+		bool setLoadError(const std::string& errorText);
+	public:
+		// version of the binary format, a stream of other version is not loaded
+		static const unsigned int FORMAT_VERSION;
+
+		ProgramCache(CompilerSuite* compilerSuite);
+		virtual ~ProgramCache();
+
+		// save the program those was compiled by the compiler suite. Code, global data, structs
+		// declared by the script, string literals and constructors or destructors of variables are
+		// saved, it returns false and sets the error text of the compiler through setSaveError if
+		// the program contains one of the following items:
+		//  - constructors or destructors of struct members, their commands are built at runtime
+		//  - lambdas, member access and dynamic functions, their commands are created at runtime
+		//  - functions those were recompiled by CompilerSuite::updateProgram
+		bool save(Program* program, std::ostream& stream);
+
+		// load a program saved by the save method. Structs and script functions of the program are
+		// registered to the compiler of the suite and the global data is placed in its global scope
+		// as if the program was compiled by the suite. It returns null if the stream is not valid or a native
+		// function used by the program is not registered in the compiler
+		Program* load(std::istream& stream);
+	};
+}
@@ -0,0 +1,83 @@
+/******************************************************************
+* File:        ProgramInstance.cpp
+* Description: implement ProgramInstance class. A class that holds
+*              global data of a compiled program. Many instances
+*              can be created from one program, each of them runs
+*              the global code and the functions of the program on
+*              its own global variables.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "ProgramInstance.h"
+#include "StaticContext.h"
+#include "Program.h"
+#include <stdexcept>
+
+namespace ffscript {
+	ProgramInstance::ProgramInstance(Program* program, int globalMemSize) : _program(program)
+	{
+		if (program == nullptr) {
+			throw std::runtime_error("Cannot create program instance from a null program");
+		}
+		if (globalMemSize < program->getGlobalScopeSize()) {
+			throw std::runtime_error("Global memory is not enough for the program instance");
+		}
+
+		_context = std::make_shared<StaticContext>(globalMemSize);
+
+		// the commands are shared with the program, only the global data is owned by the instance
+		auto& globalCommands = program->getGlobalCommands();
+		for (auto it = globalCommands.begin(); it != globalCommands.end(); ++it) {
+			_context->addCommand(*it);
+		}
+		auto& destructorCommands = program->getGlobalDestructorCommands();
+		for (auto it = destructorCommands.begin(); it != destructorCommands.end(); ++it) {
+			_context->addDestructorCommand(*it);
+		}
+	}
+
+	ProgramInstance::~ProgramInstance()
+	{
+	}
+
+	Program* ProgramInstance::getProgram() const {
+		return _program;
+	}
+
+	const std::shared_ptr<StaticContext>& ProgramInstance::getGlobalContext() const {
+		return _context;
+	}
+
+	void* ProgramInstance::getGlobalAddress(int offset) const {
+		return _context->getGlobalData() + offset;
+	}
+
+	void* ProgramInstance::getGlobalData() const {
+		return _context->getGlobalData();
+	}
+
+	void ProgramInstance::runGlobalCode() {
+		int dataSize = _program->getGlobalDataSize();
+		int codeSize = _program->getGlobalScopeSize() - dataSize;
+
+		_context->pushContext(_program->getGlobalConstructorCount());
+		_context->scopeAllocate(dataSize, codeSize);
+
+		_context->run();
+	}
+
+	void ProgramInstance::cleanupGlobalMemory() {
+		int dataSize = _program->getGlobalDataSize();
+		int codeSize = _program->getGlobalScopeSize() - dataSize;
+
+		_context->runDestructorCommands();
+
+		_context->scopeUnallocate(dataSize, codeSize);
+		_context->popContext();
+	}
+}
@@ -0,0 +1,44 @@
+/******************************************************************
+* File:        ProgramInstance.h
+* Description: declare ProgramInstance class. A class that holds
+*              global data of a compiled program. Many instances
+*              can be created from one program, each of them runs
+*              the global code and the functions of the program on
+*              its own global variables.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include <memory>
+
+namespace ffscript {
+
+	class Program;
+	class StaticContext;
+
+	class ProgramInstance
+	{
+		Program* _program;
+		std::shared_ptr<StaticContext> _context;
+	public:
+		// the global memory size must be large enough for the global scope of the
+		// program and the stack used by its global code
+		ProgramInstance(Program* program, int globalMemSize);
+		virtual ~ProgramInstance();
+
+		Program* getProgram() const;
+		const std::shared_ptr<StaticContext>& getGlobalContext() const;
+		// address of global variables of the instance, the offset is offset of
+		// the global variable in the global scope of the program
+		void* getGlobalAddress(int offset) const;
+		void* getGlobalData() const;
+
+		void runGlobalCode();
+		void cleanupGlobalMemory();
+	};
+}
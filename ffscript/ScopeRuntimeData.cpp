@@ -1,10 +1,10 @@
 /******************************************************************
 * File:        ScopeRuntimeData.cpp
-* Description: implement ScopeRuntimeData and its derived classes.
+* Description: implement ScopeRuntimeData class.
 *              A scope runtime data object contains information
-*              of current scope in a context. It created at run time
-*              when the command pointer enter an scope and destroyed
-*              when the command pointer leave current scope.
+*              of current scope in a context. It is stored in the
+*              context stack when the command pointer enter an scope
+*              and removed when the command pointer leave current scope.
 * Author:      Vincent Pham
 *
 * Copyright (c) 2018 VincentPT.
@@ -14,29 +14,18 @@
 **********************************************************************/
 
 #include "ScopeRuntimeData.h"
-#include <stdlib.h>
 
 namespace ffscript {
 
-	static const unsigned char mask_base = 0xF0;
+	// each constructor uses one bit, the first constructor uses the highest bit
+	static const unsigned char mask_base = 0x80;
 
-	ScopeRuntimeData::ScopeRuntimeData() : _executedConstructor (nullptr)
+	ScopeRuntimeData::ScopeRuntimeData(unsigned char* executedConstructor, unsigned int bitmapSize) :
+		_executedConstructor(executedConstructor),
+		_bitmapSize(bitmapSize)
 	{
 	}
 
-	ScopeRuntimeData::~ScopeRuntimeData() {}
-
-	ScopeRuntimeData* ScopeRuntimeData::createRuntimeData(int scopeContructorCount) {
-		if (scopeContructorCount == 0) {
-			return nullptr;
-		}
-		if (scopeContructorCount <= 8) {
-			return new ScopeRuntimeDataFixSize();
-		}
-
-		return new ScopeRuntimeDataDynamicSize( (scopeContructorCount >> 3) + (scopeContructorCount & 0x07) != 0 ); // scopeContructorCount /8 + scopeContructorCount % 8
-	}
-
 	unsigned char ScopeRuntimeData::isContructorExecuted(int index) {
 		int byteIndex = index >> 3; // index / 8
 		index &= 0x07;   // index % 8
@@ -66,20 +55,4 @@ namespace ffscript {
 
 		val &= (~mask);
 	}
-
-	/////////////////////////////////////////////////////////////////////
-	ScopeRuntimeDataFixSize::ScopeRuntimeDataFixSize() :_data(0) {
-		_executedConstructor = &_data;
-	}
-	ScopeRuntimeDataFixSize::~ScopeRuntimeDataFixSize() {}
-	
-	/////////////////////////////////////////////////////////////////////
-	ScopeRuntimeDataDynamicSize::ScopeRuntimeDataDynamicSize(int size) {
-		_data = (unsigned char*) malloc(size);
-		_executedConstructor = _data;
-	}
-
-	ScopeRuntimeDataDynamicSize::~ScopeRuntimeDataDynamicSize() {
-		free(_data);
-	}
 }
\ No newline at end of file
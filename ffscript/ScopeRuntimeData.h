@@ -1,10 +1,10 @@
 /******************************************************************
 * File:        ScopeRuntimeData.h
-* Description: declare ScopeRuntimeData and its derived classes.
+* Description: declare ScopeRuntimeData class.
 *              A scope runtime data object contains information
-*              of current scope in a context. It created at run time
-*              when the command pointer enter an scope and destroyed
-*              when the command pointer leave current scope.
+*              of current scope in a context. It is stored in the
+*              context stack when the command pointer enter an scope
+*              and removed when the command pointer leave current scope.
 * Author:      Vincent Pham
 *
 * Copyright (c) 2018 VincentPT.
@@ -14,34 +14,25 @@
 **********************************************************************/
 
 #pragma once
-#include <vector>
+
 namespace ffscript {
 	class ScopeRuntimeData
-	{		
-	protected:
+	{
+		// bitmap of executed constructors, it is owned by the context
 		unsigned char* _executedConstructor;
-		ScopeRuntimeData();
+		unsigned int _bitmapSize;
 	public:
-		static ScopeRuntimeData* createRuntimeData(int scopeContructorCount);
-		virtual ~ScopeRuntimeData();
+		ScopeRuntimeData() = default;
+		ScopeRuntimeData(unsigned char* executedConstructor, unsigned int bitmapSize);
+
+		// number of bytes used to store executed state of constructors in a scope
+		static inline unsigned int getBitmapSize(unsigned int scopeContructorCount) {
+			return (scopeContructorCount + 7) >> 3;
+		}
+		inline unsigned int getBitmapSize() const { return _bitmapSize; }
+
 		unsigned char isContructorExecuted(int index);
 		void markContructorExecuted(int index);
 		void markContructorNotExecuted(int index);
 	};
-
-	class ScopeRuntimeDataFixSize : public ScopeRuntimeData
-	{
-		unsigned char _data;
-	public:
-		ScopeRuntimeDataFixSize();
-		virtual ~ScopeRuntimeDataFixSize();
-	};
-
-	class ScopeRuntimeDataDynamicSize : public ScopeRuntimeData
-	{
-		unsigned char *_data;
-	public:
-		ScopeRuntimeDataDynamicSize(int size);
-		virtual ~ScopeRuntimeDataDynamicSize();
-	};
 }
@@ -0,0 +1,152 @@
+/******************************************************************
+* File:        ScriptBatchRunner.cpp
+* Description: implement ScriptBatchRunner class. A class that runs
+*              a script function over many inputs by using a group
+*              of worker threads. Each worker owns a context that is
+*              reused for all batches, the inputs are split to chunks
+*              and workers take chunks until the batch is done.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "ScriptBatchRunner.h"
+#include "Context.h"
+#include "Program.h"
+
+namespace ffscript {
+	ScriptBatchRunner::ScriptBatchRunner(Program* program, int functionId, int workerCount, unsigned int stackSize, int chunkSize) :
+		_scriptRunner(program, functionId),
+		_chunkSize(chunkSize > 0 ? chunkSize : 1),
+		_batchId(0),
+		_runningWorkers(0),
+		_stop(false),
+		_rangeFunction(nullptr),
+		_count(0),
+		_nextIndex(0)
+	{
+		if (workerCount < 0) {
+			// the thread that runs batches also processes inputs
+			workerCount = (int)std::thread::hardware_concurrency() - 1;
+			if (workerCount < 0) workerCount = 0;
+		}
+
+		// context's constructor makes itself current context of the thread,
+		// contexts of the workers are only used through the runner
+		auto backupCurrentContext = Context::getCurrent();
+		for (int i = 0; i <= workerCount; i++) {
+			_contexts.push_back(new Context(stackSize));
+		}
+		Context::makeCurrent(backupCurrentContext);
+
+		for (int i = 0; i < workerCount; i++) {
+			_workers.emplace_back(&ScriptBatchRunner::workerLoop, this, i);
+		}
+	}
+
+	ScriptBatchRunner::~ScriptBatchRunner() {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stop = true;
+		}
+		_startCondition.notify_all();
+		for (auto& worker : _workers) {
+			worker.join();
+		}
+
+		// context's destructor resets current context of the thread
+		auto backupCurrentContext = Context::getCurrent();
+		for (auto context : _contexts) {
+			delete context;
+		}
+		Context::makeCurrent(backupCurrentContext);
+	}
+
+	void ScriptBatchRunner::processChunks(Context* context) {
+		while (true) {
+			int begin = _nextIndex.fetch_add(_chunkSize);
+			if (begin >= _count) {
+				break;
+			}
+			int end = begin + _chunkSize;
+			if (end > _count) {
+				end = _count;
+			}
+
+			try {
+				(*_rangeFunction)(&_scriptRunner, context, begin, end);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(_mutex);
+				if (!_error) {
+					_error = std::current_exception();
+				}
+				// skip remain chunks
+				_nextIndex = _count;
+				break;
+			}
+		}
+	}
+
+	void ScriptBatchRunner::workerLoop(int workerIndex) {
+		Context* context = _contexts[workerIndex];
+		unsigned int processedBatch = 0;
+
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_startCondition.wait(lock, [this, processedBatch]() { return _stop || _batchId != processedBatch; });
+				if (_stop) {
+					break;
+				}
+				processedBatch = _batchId;
+			}
+
+			processChunks(context);
+
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_runningWorkers--;
+			}
+			_doneCondition.notify_one();
+		}
+	}
+
+	void ScriptBatchRunner::run(int count, const RangeFunction& rangeFunction) {
+		if (count <= 0) {
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_rangeFunction = &rangeFunction;
+			_count = count;
+			_nextIndex = 0;
+			_error = nullptr;
+			_runningWorkers = (int)_workers.size();
+			_batchId++;
+		}
+		_startCondition.notify_all();
+
+		processChunks(_contexts.back());
+
+		std::exception_ptr error;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_doneCondition.wait(lock, [this]() { return _runningWorkers == 0; });
+			_rangeFunction = nullptr;
+			error = _error;
+			_error = nullptr;
+		}
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	int ScriptBatchRunner::getWorkerCount() const {
+		return (int)_workers.size();
+	}
+}
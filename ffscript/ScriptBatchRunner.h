@@ -0,0 +1,88 @@
+/******************************************************************
+* File:        ScriptBatchRunner.h
+* Description: declare ScriptBatchRunner class. A class that runs
+*              a script function over many inputs by using a group
+*              of worker threads. Each worker owns a context that is
+*              reused for all batches, the inputs are split to chunks
+*              and workers take chunks until the batch is done.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "ffscript.h"
+#include "ScriptRunner.h"
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+namespace ffscript {
+	class Context;
+	class Program;
+
+	class ScriptBatchRunner
+	{
+	public:
+		// process inputs from index begin to index end - 1 on the given context
+		typedef std::function<void(ScriptRunner* runner, Context* context, int begin, int end)> RangeFunction;
+	private:
+		ScriptRunner _scriptRunner;
+		std::vector<std::thread> _workers;
+		// contexts of the workers, the last one is used by the thread that runs the batch
+		std::vector<Context*> _contexts;
+		int _chunkSize;
+
+		std::mutex _mutex;
+		std::condition_variable _startCondition;
+		std::condition_variable _doneCondition;
+		unsigned int _batchId;
+		int _runningWorkers;
+		bool _stop;
+
+		const RangeFunction* _rangeFunction;
+		int _count;
+		std::atomic<int> _nextIndex;
+		std::exception_ptr _error;
+	protected:
+		void workerLoop(int workerIndex);
+		void processChunks(Context* context);
+
+		template <typename Ret, typename Tuple, size_t... I>
+		static Ret invokeWithTuple(ScriptRunner* runner, Context* context, const Tuple& params, std::index_sequence<I...>) {
+			return runner->invoke<Ret>(context, std::get<I>(params)...);
+		}
+	public:
+		// workerCount is number of threads created to help the thread that runs batches,
+		// a negative value means using all hardware threads
+		ScriptBatchRunner(Program* program, int functionId, int workerCount = -1, unsigned int stackSize = 64 * 1024, int chunkSize = 256);
+		virtual ~ScriptBatchRunner();
+
+		// run the range function over count inputs, the function returns when all inputs are processed.
+		// only one batch can run at a time.
+		// if an input raises an exception, remain inputs are skipped and the exception is thrown here
+		void run(int count, const RangeFunction& rangeFunction);
+
+		// run the function for each tuple of arguments and store its results to outputs
+		template <typename Ret, typename... Args>
+		void run(const std::tuple<Args...>* inputs, Ret* outputs, int count) {
+			RangeFunction rangeFunction = [inputs, outputs](ScriptRunner* runner, Context* context, int begin, int end) {
+				for (int i = begin; i < end; i++) {
+					outputs[i] = invokeWithTuple<Ret>(runner, context, inputs[i], std::index_sequence_for<Args...>());
+				}
+			};
+			run(count, rangeFunction);
+		}
+
+		int getWorkerCount() const;
+	};
+}
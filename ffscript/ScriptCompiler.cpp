@@ -23,9 +23,12 @@
 #include "FwdCompositeConstrutorUnit.h"
 #include "CompositeConstrutorUnit.h"
 #include "FunctionRegisterHelper.h"
+#include "CodeArena.h"
 #include <stdarg.h>
+#include <limits>
 
 #define TYPE_CONVERSION_MAKE_KEY(source, target)  (((uint64_t)(source) << 32) | target)
+#define TEMPLATE_MAKE_KEY(symbol, argCount)  (((uint64_t)(symbol) << 32) | (uint32_t)(argCount))
 
 namespace ffscript {
 	std::string key_while("while");
@@ -41,16 +44,17 @@ namespace ffscript {
 
 	ScriptCompiler::ScriptCompiler() : _program(nullptr), _logger(nullptr)
 	{
-		_functionLibRef = (FuncLibraryRef)(new FuncLibrary());
-		_typeManagerRef = (TypeManagerRef)(new TypeManager());
-
-		_keywordMap.insert(std::make_pair(key_if, KEYWORD_IF));
-		_keywordMap.insert(std::make_pair(key_else, KEYWORD_ELSE));
-		_keywordMap.insert(std::make_pair(key_while, KEYWORD_WHILE));
-		_keywordMap.insert(std::make_pair(key_for, KEYWORD_FOR));
-		_keywordMap.insert(std::make_pair(key_return, KEYWORD_RETURN));
-		_keywordMap.insert(std::make_pair(key_break, KEYWORD_BREAK));
-		_keywordMap.insert(std::make_pair(key_continue, KEYWORD_CONTINUE));
+		_symbolTable = std::make_shared<SymbolTable>();
+		_functionLibRef = (FuncLibraryRef)(new FuncLibrary(_symbolTable));
+		_typeManagerRef = (TypeManagerRef)(new TypeManager(_symbolTable));
+
+		_keywordMap.insert(_symbolTable->intern(key_if), KEYWORD_IF);
+		_keywordMap.insert(_symbolTable->intern(key_else), KEYWORD_ELSE);
+		_keywordMap.insert(_symbolTable->intern(key_while), KEYWORD_WHILE);
+		_keywordMap.insert(_symbolTable->intern(key_for), KEYWORD_FOR);
+		_keywordMap.insert(_symbolTable->intern(key_return), KEYWORD_RETURN);
+		_keywordMap.insert(_symbolTable->intern(key_break), KEYWORD_BREAK);
+		_keywordMap.insert(_symbolTable->intern(key_continue), KEYWORD_CONTINUE);
 
 		//pre-defined operators for compile only
 		static OperatorEntry preCompileOperators[] = {
@@ -104,7 +108,7 @@ namespace ffscript {
 		OperatorEntry* end = preCompileOperators + n;
 		while (first < end)
 		{
-			_preCompileOperators.insert(std::make_pair(first->name, first));
+			_preCompileOperators.insert(_symbolTable->intern(first->name), first);
 			first++;
 		}
 
@@ -360,6 +364,8 @@ namespace ffscript {
 			it++;
 		}
 
+		_nativeCommandMap.erase(functionId);
+
 		for (auto it = _destructorMap.begin(); it != _destructorMap.end();) {
 			if (it->second == functionId) {
 				auto tit = it;
@@ -387,15 +393,15 @@ namespace ffscript {
 
 	bool ScriptCompiler::registerTypeConversionAccurative(int sourceType, int targetType, int accurative){
 		auto key = TYPE_CONVERSION_MAKE_KEY(sourceType, targetType);
-		auto it = _typeConversionMap.insert(std::make_pair(key, accurative));
+		auto it = _typeConversionMap.insert(key, accurative);
 		return it.second;
 	}
 
 	int ScriptCompiler::findConversionAccurative(int sourceType, int targetType) {
 		auto key = TYPE_CONVERSION_MAKE_KEY(sourceType, targetType);
-		auto it = _typeConversionMap.find(key);
-		if (it != _typeConversionMap.end()) {
-			return it->second;
+		auto accurative = _typeConversionMap.find(key);
+		if (accurative != nullptr) {
+			return *accurative;
 		}
 		LOG_COMPILE_MESSAGE(_logger, MESSAGE_WARNING, formatMessage("cannot find accuration of conversion: %s -> %s", getType(sourceType).c_str(), getType(targetType).c_str()));
 		return -1;
@@ -424,18 +430,34 @@ namespace ffscript {
 		return _logger;
 	}
 
+	int ScriptCompiler::findSymbol(const std::string& name) const {
+		return _symbolTable->find(name);
+	}
+
+	const SymbolTableRef& ScriptCompiler::getSymbolTable() const {
+		return _symbolTable;
+	}
+
 	EKeyword ScriptCompiler::findKeyword(const std::string& keyword) const {
-		auto it = _keywordMap.find(keyword);
-		if (it != _keywordMap.end()) {
-			return it->second;
+		return findKeyword(_symbolTable->find(keyword));
+	}
+
+	EKeyword ScriptCompiler::findKeyword(int symbol) const {
+		auto keyword = _keywordMap.find(symbol);
+		if (keyword != nullptr) {
+			return *keyword;
 		}
 		return KEYWORD_UNKNOWN;
 	}
 
 	const OperatorEntry* ScriptCompiler::findPredefinedOperator(const std::string& keyword) const {
-		auto it = _preCompileOperators.find(keyword);
-		if (it != _preCompileOperators.end()) {
-			return it->second;
+		return findPredefinedOperator(_symbolTable->find(keyword));
+	}
+
+	const OperatorEntry* ScriptCompiler::findPredefinedOperator(int symbol) const {
+		auto operatorEntry = _preCompileOperators.find(symbol);
+		if (operatorEntry != nullptr) {
+			return *operatorEntry;
 		}
 		return nullptr;
 	}
@@ -2021,109 +2043,224 @@ namespace ffscript {
 		}
 	}
 
-	CandidateCollectionRef ScriptCompiler::filterCandidate(
-		const string& functionName, int functionType,
-		const list<OverLoadingItem>* overloadingFuncs,
-		const std::vector<CandidateCollectionRef>& candidatesForParams, EExpressionResult& eResult) {
+	///
+	/// OverloadingResolver chooses the best combination of parameter candidates for each
+	/// overloading function without listing all combinations of the candidates.
+	/// Matching of a parameter candidate to an argument is computed once, then the best
+	/// path of each function is searched in order of the paths, a branch is cut when its
+	/// accurative cannot be less than accurative of the best path found.
+	///
+	class OverloadingResolver {
+		enum MatchLevel {
+			MATCH_NONE = 0,
+			// matched without searching matching level 2 for all functions
+			MATCH_NORMAL,
+			// matched only if matching level 2 is searched
+			MATCH_LEVEL2,
+		};
 
-		int n = (int)candidatesForParams.size();
-		ParamCastingInfo paramInfoTemp;
-		paramInfoTemp.accurative = 0;
-		paramInfoTemp.castingFunction = nullptr;
+		struct ParamMatch {
+			MatchLevel level;
+			ParamCastingInfo casting;
+		};
 
-		list<CandidateInfo> overloadingCandidatesOrigin;
+		struct FunctionMatch {
+			const OverLoadingItem* item;
+			// matching of candidates to arguments, index by [param][candidate]
+			std::vector<std::vector<ParamMatch>> params;
+			// minimum accurative of params from an index to the last param
+			std::vector<int> minRemain;
+		};
 
-		//filter overloading functions by number of parameter
-		for (auto it = overloadingFuncs->begin(); it != overloadingFuncs->end(); ++it) {
-			if ((*it).paramTypes.size() == (size_t)n) {
-				const OverLoadingItem& item = *it;
+		ScriptCompiler* _scriptCompiler;
+		int _functionType;
+		std::vector<std::vector<ExecutableUnitRef>> _paramCandidates;
+		std::list<FunctionMatch> _functions;
+		std::vector<int> _path;
+		std::vector<int> _bestPath;
+		int _bestAccurative;
+	public:
+		OverloadingResolver(ScriptCompiler* scriptCompiler, int functionType, const std::vector<CandidateCollectionRef>& candidatesForParams) :
+			_scriptCompiler(scriptCompiler),
+			_functionType(functionType),
+			_paramCandidates(candidatesForParams.size()),
+			_path(candidatesForParams.size()) {
+			for (size_t i = 0; i < candidatesForParams.size(); i++) {
+				auto& candidates = *candidatesForParams[i];
+				_paramCandidates[i].assign(candidates.begin(), candidates.end());
+			}
+		}
+
+		void addCandidate(const OverLoadingItem* item) {
+			_functions.emplace_back();
+			auto& function = _functions.back();
+			function.item = item;
+			function.params.resize(_paramCandidates.size());
+		}
+
+		void resolve(std::map<int, CandidatePathInfo>& candidateMap, std::list<std::vector<ExecutableUnitRef>>& paramPaths) {
+			ScriptType refVoidType(_scriptCompiler->getTypeManager()->getBasicTypes().TYPE_VOID | DATA_TYPE_POINTER_MASK, "ref void");
+			bool singleFunction = _functions.size() == 1;
+			int n = (int)_paramCandidates.size();
+
+			// compute matching of each candidate to each argument of the functions
+			for (auto fit = _functions.begin(); fit != _functions.end();) {
+				auto& function = *fit;
+				function.minRemain.resize(n + 1, 0);
+				bool matched = true;
+				for (int i = 0; i < n && matched; i++) {
+					auto& argumentType = *(function.item->paramTypes[i]);
+					auto& candidates = _paramCandidates[i];
+					auto& matches = function.params[i];
+					matches.resize(candidates.size());
+					int minAccurative = -1;
+					for (size_t c = 0; c < candidates.size(); c++) {
+						auto& param = candidates[c];
+						auto& match = matches[c];
+						match.casting.accurative = 0;
+						match.level = MATCH_NONE;
+
+						int level = 0;
+						if (_scriptCompiler->findMatchingComposite(argumentType, param, match.casting)) {
+							level = 1;
+						}
+						else {
+							level = _scriptCompiler->findMatching(refVoidType, argumentType, param->getReturnType(), match.casting, true);
+							// keep origin source char in new expression unit
+							if (level && match.casting.castingFunction) {
+								match.casting.castingFunction->setSourceCharIndex(param->getSourceCharIndex());
+							}
+						}
+						if (level == 0) continue;
 
-				CandidateInfo candidateInfo;
-				overloadingCandidatesOrigin.push_back(candidateInfo);
-				CandidateInfo& candidateInfoRef = overloadingCandidatesOrigin.back();
-				candidateInfoRef.item = &item;
-				candidateInfoRef.paramCasting.resize(n, paramInfoTemp);
+						// matching level 2 is always searched if there is only one function
+						match.level = level == 1 || singleFunction ? MATCH_NORMAL : MATCH_LEVEL2;
+						if (minAccurative < 0 || minAccurative > match.casting.accurative) {
+							minAccurative = match.casting.accurative;
+						}
+					}
+					matched = minAccurative >= 0;
+					function.minRemain[i] = minAccurative;
+				}
+				if (!matched) {
+					fit = _functions.erase(fit);
+					continue;
+				}
+				for (int i = n - 1; i >= 0; i--) {
+					function.minRemain[i] += function.minRemain[i + 1];
+				}
+				++fit;
 			}
-		}
 
-		std::list<std::vector<ExecutableUnitRef>> paramPaths;
-		listPaths<ExecutableUnitRef, CandidateCollection, ExecutableUnitRef>(candidatesForParams, paramPaths);
+			for (auto& function : _functions) {
+				_bestAccurative = std::numeric_limits<int>::max();
+				searchPath(function, 0, 0, true);
+				if (_bestAccurative == std::numeric_limits<int>::max()) continue;
 
-		std::map<int, CandidatePathInfo> candidateMap;
-		for (auto pit = paramPaths.begin(); pit != paramPaths.end(); pit++) {
-			auto& path = *pit;
+				paramPaths.emplace_back(n);
+				auto& path = paramPaths.back();
+
+				CandidatePathInfo candidate;
+				candidate.candidate.item = function.item;
+				candidate.candidate.totalAccurative = _bestAccurative;
+				candidate.candidate.paramCasting.resize(n);
+				candidate.paramPath = &path;
+				for (int i = 0; i < n; i++) {
+					path[i] = _paramCandidates[i][_bestPath[i]];
+					candidate.candidate.paramCasting[i] = function.params[i][_bestPath[i]].casting;
+				}
+
+				//if the canidate id is exits, keep the better one
+				auto it = candidateMap.insert(std::make_pair(function.item->functionId, candidate));
+				if (it.second == false && it.first->second.candidate.totalAccurative > _bestAccurative) {
+					it.first->second = candidate;
+				}
+			}
+		}
+	private:
+		bool isSkippedPath(bool normalMatching) const {
+			if (_functionType != EXP_UNIT_ID_OPERATOR_ASSIGNMENT) {
+				return false;
+			}
+			auto& param1 = _paramCandidates[0][_path[0]];
+			auto& param2 = _paramCandidates[1][_path[1]];
+			auto& param1Type = param1->getReturnType();
+			auto& param2Type = param2->getReturnType();
 			//prevent following expression to be executed by a native assigment function
 			// int b = 1;
 			// ref int a = b;
 			// int& a = b;
 			//but it will be processed by default assignment operator
-			if (functionType == EXP_UNIT_ID_OPERATOR_ASSIGNMENT) {
-				auto& param1 = path[0];
-				auto& param2 = path[1];
-				auto& param1Type = param1->getReturnType();
-				auto& param2Type = param2->getReturnType();
-				if ((param1->getType() == EXP_UNIT_ID_XOPERAND && param2Type.origin() == param1Type.origin() && param1Type.refLevel() - param2Type.refLevel() == 1) ||
-					((param1->getMask() & UMASK_DECLAREINEXPRESSION) && param1Type.isSemiRefType() && param1->getType() == EXP_UNIT_ID_XOPERAND && param2->getType() == EXP_UNIT_ID_XOPERAND)
-					) {
-					//continue
-					//following assigment is not allow
-					//ref int b;
-					//int a;
-					//b = a;
-					continue;
-				}
+			if ((param1->getType() == EXP_UNIT_ID_XOPERAND && param2Type.origin() == param1Type.origin() && param1Type.refLevel() - param2Type.refLevel() == 1) ||
+				((param1->getMask() & UMASK_DECLAREINEXPRESSION) && param1Type.isSemiRefType() && param1->getType() == EXP_UNIT_ID_XOPERAND && param2->getType() == EXP_UNIT_ID_XOPERAND)
+				) {
+				return true;
 			}
+			// no assiment operator defined for the given type, default assigment operator
+			// is used instead of searching the candicate with matching level 2
+			return !normalMatching && param1Type.iType() == param2Type.iType();
+		}
 
-			list<CandidateInfo> overloadingCandidates = overloadingCandidatesOrigin;
-			simpleFilter(this, path, overloadingCandidates, false);
-			if (overloadingCandidates.size() == 0) {
-				// when the code reach here, it means no operator found if we don't try to search matching level 2
-				if (functionType == EXP_UNIT_ID_OPERATOR_ASSIGNMENT) {
-					auto& param1 = path[0];
-					auto& param2 = path[1];
-					auto& param1Type = param1->getReturnType();
-					auto& param2Type = param2->getReturnType();
-					if (param1Type.iType() == param2Type.iType()) {
-						// now, it means no assiment operator defined for the given type
-						// for this case we don't try to search the candicate with matching level 2
-						// because we use default assigment operator
-						continue;
-					}
+		// check if any function matches the current path without searching matching level 2
+		bool hasNormalMatching() const {
+			int n = (int)_path.size();
+			for (auto& function : _functions) {
+				int i = 0;
+				while (i < n && function.params[i][_path[i]].level == MATCH_NORMAL) {
+					i++;
+				}
+				if (i == n) {
+					return true;
 				}
-				overloadingCandidates = overloadingCandidatesOrigin;
-				simpleFilter(this, path, overloadingCandidates, true);
 			}
+			return false;
+		}
 
-			//copy candidate to map but no duplicate candidate(function) id
-			for (auto cit = overloadingCandidates.begin(); cit != overloadingCandidates.end(); cit++) {
-				CandidatePathInfo candidate;
-				candidate.candidate = *cit;
-				candidate.paramPath = &path;
-				auto it = candidateMap.insert(std::make_pair(candidate.candidate.item->functionId, candidate));
-				CandidatePathInfo& insertedCandidate = it.first->second;
-				//if the canidate id is exits, compare accurative to choose the best one
-				if (it.second == false) {
-					//calcuate total accurative for each
-					int acc1 = insertedCandidate.candidate.totalAccurative;
-					int acc2 = 0;
-					for (int j = 0; j < n; j++) {
-						acc2 += candidate.candidate.paramCasting.at(j).accurative;
-					}
-					//the better found, so we repelace it
-					if (acc1 > acc2) {
-						candidate.candidate.totalAccurative = acc2;
-						it.first->second = candidate;
-					}
-				}
-				else {
-					int acc1 = 0;
-					for (int j = 0; j < n; j++) {
-						acc1 += insertedCandidate.candidate.paramCasting.at(j).accurative;
-					}
-					insertedCandidate.candidate.totalAccurative = acc1;
+		void searchPath(const FunctionMatch& function, int i, int accurative, bool normalMatching) {
+			// the first path is kept if there are paths have same accurative
+			if (accurative + function.minRemain[i] >= _bestAccurative) {
+				return;
+			}
+			int n = (int)_path.size();
+			if (i == n) {
+				// a path is checked with matching level 2 only if no function matches it normally
+				if (isSkippedPath(normalMatching) || (!normalMatching && hasNormalMatching())) {
+					return;
 				}
+				_bestAccurative = accurative;
+				_bestPath = _path;
+				return;
+			}
+
+			auto& matches = function.params[i];
+			for (size_t c = 0; c < matches.size(); c++) {
+				auto& match = matches[c];
+				if (match.level == MATCH_NONE) continue;
+
+				_path[i] = (int)c;
+				searchPath(function, i + 1, accurative + match.casting.accurative, normalMatching && match.level == MATCH_NORMAL);
 			}
 		}
+	};
+
+	CandidateCollectionRef ScriptCompiler::filterCandidate(
+		const string& functionName, int functionType,
+		const list<OverLoadingItem>* overloadingFuncs,
+		const std::vector<CandidateCollectionRef>& candidatesForParams, EExpressionResult& eResult) {
+
+		int n = (int)candidatesForParams.size();
+		OverloadingResolver resolver(this, functionType, candidatesForParams);
+
+		//filter overloading functions by number of parameter
+		for (auto it = overloadingFuncs->begin(); it != overloadingFuncs->end(); ++it) {
+			if ((*it).paramTypes.size() == (size_t)n) {
+				resolver.addCandidate(&(*it));
+			}
+		}
+
+		std::list<std::vector<ExecutableUnitRef>> paramPaths;
+		std::map<int, CandidatePathInfo> candidateMap;
+		resolver.resolve(candidateMap, paramPaths);
 
 		//now we have all candidate, we remove duplicate by function id
 		//but if two function return the same type, it is an ambious call.
@@ -2222,6 +2359,19 @@ namespace ffscript {
 		return it->second;
 	}
 
+	void ScriptCompiler::registNativeCommand(int functionId, const shared_ptr<NativeCommandFactory>& commandFactory) {
+		_nativeCommandMap[functionId] = commandFactory;
+	}
+
+	NativeCommandFactory* ScriptCompiler::getNativeCommand(int functionId) const {
+		auto it = _nativeCommandMap.find(functionId);
+		if (it == _nativeCommandMap.end()) {
+			return nullptr;
+		}
+
+		return it->second.get();
+	}
+
 	bool ScriptCompiler::registTypeInfo(int type, MemoryBlockRef typeInfoRef) {
 		return _typeManagerRef->registTypeInfo(type, typeInfoRef);
 	}
@@ -2276,11 +2426,11 @@ namespace ffscript {
 	}
 
 	TemplateRef ScriptCompiler::registTemplate(const std::string& name, const vector<std::string>& args) {
-		string keyStr = name + "_" + std::to_string( (int) args.size() );
+		auto key = TEMPLATE_MAKE_KEY(_symbolTable->intern(name), args.size());
 		TemplateRef dummy;
-		auto it = _templates.insert(std::make_pair( keyStr, dummy) );
+		auto it = _templates.insert(key, dummy);
 		if (it.second) {
-			auto& templateRef = it.first->second;
+			auto& templateRef = *it.first;
 			templateRef.reset( new Template(name) );
 
 			for (auto it = args.begin(); it != args.end(); it++) {
@@ -2294,28 +2444,34 @@ namespace ffscript {
 	}
 
 	TemplateRef ScriptCompiler::findTemplate(const std::string& name, int argCount) {
-		string keyStr = name + "_" + std::to_string(argCount);
-		TemplateRef dummy;
-		auto it = _templates.find(keyStr);
-		if (it == _templates.end()) {
+		int symbol = _symbolTable->find(name);
+		if (symbol == SymbolTable::INVALID_SYMBOL) {
+			return nullptr;
+		}
+		auto templateRef = _templates.find(TEMPLATE_MAKE_KEY(symbol, argCount));
+		if (templateRef == nullptr) {
 			return nullptr;
 		}
 
-		return it->second;
+		return *templateRef;
 	}
 
 	void ScriptCompiler::setConstantMap(const string& constantName, const DelegateRef& createConstantObjFunc) {		
-		auto it = _constantMap.insert( std::make_pair(constantName, createConstantObjFunc) );
+		auto it = _constantMap.insert(_symbolTable->intern(constantName), createConstantObjFunc);
 		//overwrite if constant name is existed
 		if (it.second == false) {
-			it.first->second = createConstantObjFunc;
+			*it.first = createConstantObjFunc;
 		}
 	}
 
 	DelegateRef ScriptCompiler::findConstantMap(const string& constantName) const {
-		auto it = _constantMap.find(constantName);
-		if (it != _constantMap.end()) {
-			return it->second;
+		return findConstantMap(_symbolTable->find(constantName));
+	}
+
+	DelegateRef ScriptCompiler::findConstantMap(int symbol) const {
+		auto createConstantObjFunc = _constantMap.find(symbol);
+		if (createConstantObjFunc != nullptr) {
+			return *createConstantObjFunc;
 		}
 
 		return nullptr;
@@ -2518,7 +2674,10 @@ namespace ffscript {
 				}
 				dim = (int)(dimensions.size() - i);
 				int arrayInfoSize = sizeof(StaticArrayInfo);
-				auto arrayTypeInfoBlock = std::make_shared<BufferBlock>(arrayInfoSize);
+				// type info is owned by the compiler, it must not be kept in code arena of the program
+				CodeArenaScope compilerScope(nullptr);
+				// create the block by its operator new, so it is released by the matched operator delete
+				MemoryBlockRef arrayTypeInfoBlock(new BufferBlock(arrayInfoSize));
 
 				auto pArrayInfo = (StaticArrayInfo*)arrayTypeInfoBlock->getDataRef();
 				pArrayInfo->dim = (unsigned char)dim;
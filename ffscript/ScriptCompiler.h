@@ -21,6 +21,8 @@
 #include "BasicFunctionFactory.hpp"
 #include "Template.h"
 #include "function/CachedDelegate.h"
+#include "SymbolTable.h"
+#include "FlatHashMap.hpp"
 
 #include <stack>
 #include <map>
@@ -38,6 +40,7 @@ namespace ffscript {
 	class FunctionFactory;
 	class Program;
 	class ScriptType;
+	class NativeCommandFactory;
 
 	using namespace std;
 
@@ -79,7 +82,7 @@ namespace ffscript {
 	
 	class ScriptCompiler
 	{
-		typedef map<uint64_t, int> TypeCompatibilityMap;
+		typedef FlatHashMap<uint64_t, int> TypeCompatibilityMap;
 		typedef shared_ptr<FunctionFactory> FunctionFactoryRef;
 
 		typedef std::map<std::string, int> BinaryFunctionParamMap;
@@ -87,23 +90,27 @@ namespace ffscript {
 		typedef vector<int> ConstructorIDList;
 		typedef std::shared_ptr<ConstructorIDList> ConstructorIDListRef;
 
+		// names of functions, types, keywords, operators and constants are interned in this
+		// table, the registries below are keyed by their symbols
+		SymbolTableRef _symbolTable;
 		FuncLibraryRef _functionLibRef;
 		TypeManagerRef _typeManagerRef;
 
 		stack<ScriptScope*> _scopeStack;
 		vector<FunctionFactory*> _functionFactories;
-		map<string, EKeyword > _keywordMap;
+		FlatHashMap<int, EKeyword> _keywordMap;
 		list<FunctionFactoryRef> _factoriesStorage;
 		TypeCompatibilityMap _typeConversionMap;
-		typedef std::map<string, OperatorEntry*>  OperatorMap;
+		typedef FlatHashMap<int, OperatorEntry*>  OperatorMap;
 		OperatorMap _preCompileOperators; /*map operator name to operator information, pre-defined operator is only allow type overloading, not param count overloading*/
 		map<int, int> _constructorMap;
 		map<int, int> _destructorMap;
 		map<int, BinaryFunctionParamMapRef> _copyConstructorMap;
 		map<int, ConstructorIDListRef> _constructorsMap; // map a data type to its constructor list
-		map<string, TemplateRef> _templates;
-		map<string, DelegateRef> _constantMap;
+		FlatHashMap<uint64_t, TemplateRef> _templates; // map symbol of template name and argument count to the template
+		FlatHashMap<int, DelegateRef> _constantMap;
 		map<int, int> _functionCallMap;
+		map<int, shared_ptr<NativeCommandFactory>> _nativeCommandMap; // map a native function to its specialized command factory
 
 		Program* _program;
 		CompilationLogger* _logger;
@@ -175,8 +182,15 @@ namespace ffscript {
 		bool registerTypeConversionAccurative(int sourceType, int targetType, int accurative);
 		int findConversionAccurative(int sourceType, int targetType);
 
+		// get symbol of a name, a name that is not registered in any registry of the
+		// compiler does not have a symbol and lookups by it fail immediately
+		int findSymbol(const std::string& name) const;
+		const SymbolTableRef& getSymbolTable() const;
+
 		EKeyword findKeyword(const std::string& keyword) const;
+		EKeyword findKeyword(int symbol) const;
 		const OperatorEntry* findPredefinedOperator(const std::string& keyword) const;
+		const OperatorEntry* findPredefinedOperator(int symbol) const;
 
 		TemplateRef registTemplate(const std::string& name, const vector<std::string>& args);
 		TemplateRef findTemplate(const std::string& name, int argCount);
@@ -229,6 +243,8 @@ namespace ffscript {
 
 		bool registFunctionOperator(int type, int functionId);
 		int getFunctionOperator(int type);
+		void registNativeCommand(int functionId, const shared_ptr<NativeCommandFactory>& commandFactory);
+		NativeCommandFactory* getNativeCommand(int functionId) const;
 
 		Program* bindProgram(Program* program);
 		Program* getProgram() const;
@@ -238,6 +254,7 @@ namespace ffscript {
 
 		void setConstantMap(const string& constantName, const DelegateRef& createConstantObjFunc);
 		DelegateRef findConstantMap(const string& constantName) const;
+		DelegateRef findConstantMap(int symbol) const;
 
 		const FuncLibraryRef& getFunctionLib() const;
 		const TypeManagerRef& getTypeManager() const;
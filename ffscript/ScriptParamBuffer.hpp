@@ -3,7 +3,8 @@
 * Description: define ScriptParamBuffer template class. This class
 *              is designed to serialize script function's arguments
 *              then pass it to the script function before execute
-*              the function.
+*              the function. This file also defines helpers to
+*              pack arguments directly to a buffer in same layout.
 * Author:      Vincent Pham
 *
 * Copyright (c) 2018 VincentPT.
@@ -14,6 +15,8 @@
 
 #pragma once
 #include <vector>
+#include <string.h>
+#include "function/MemberTypeInfo.hpp"
 
 namespace ffscript {
 	class ScriptParamBuffer {
@@ -41,4 +44,14 @@ namespace ffscript {
 			}
 		}
 	};
-}
\ No newline at end of file
+
+	inline void packScriptParams(char*) {}
+
+	// write arguments to the buffer in same layout of ScriptParamBuffer,
+	// an argument uses whole words
+	template <typename T, typename... Args>
+	inline void packScriptParams(char* buffer, const T& param, const Args&... params) {
+		memcpy(buffer, &param, sizeof(T));
+		packScriptParams(buffer + FT::getAlignSize<T, ARG_ALIGMENT_SIZE>(), params...);
+	}
+}
@@ -17,13 +17,15 @@
 #include "Program.h"
 #include "InstructionCommand.h"
 
+#include <stdexcept>
+
 namespace ffscript {
 	static const int s_returnOffset = SCRIPT_FUNCTION_RETURN_STORAGE_OFFSET;
 
-	ScriptRunner::ScriptRunner(Program* program, int functionId) : _program(program), _functionInfo(nullptr)
+	ScriptRunner::ScriptRunner(Program* program, int functionId) : _program(program), _functionInfo(nullptr),
+		_globalData(program->getGlobalData())
 	{
 		_functionInfo = program->getFunctionInfo(functionId);
-		auto functionCode = program->getFunctionPlainCode(functionId);
 
 		int paramOffset = s_returnOffset + _functionInfo->returnStorageSize;
 
@@ -35,58 +37,102 @@ namespace ffscript {
 #endif
 
 		callScriptCommand->setCommandData(s_returnOffset, paramOffset, _functionInfo->paramDataSize);
+		// the function is called through its entry, so the runner runs the last
+		// committed code of the function when the program is updated
+		callScriptCommand->setFunctionEntry(program->getFunctionEntry(functionId));
 #else
 		CallScriptFuntion* callScriptCommand = new CallScriptFuntion();
 		callScriptCommand.setCommandData(_resultSize, paramOffset, functionInfo->paramDataSize);
+		callScriptCommand->setTargetCommand(program->getFunctionPlainCode(functionId)->first);
 #endif
-		callScriptCommand->setTargetCommand(functionCode->first);
 		_scriptInvoker = callScriptCommand;
 	}
 
 	ScriptRunner::~ScriptRunner(){
+		delete _scriptInvoker;
 	}
 
 	void ScriptRunner::runFunction(const ScriptParamBuffer* paramBuffer) {
-		auto context = Context::getCurrent();
-
-		Program* program = _program;
+		runFunction(Context::getCurrent(), paramBuffer);
+	}
 
+	void ScriptRunner::runFunction(Context* context, const ScriptParamBuffer* paramBuffer) {
 		int paramOffset = s_returnOffset + _functionInfo->returnStorageSize;
 		if (paramBuffer != nullptr && _functionInfo->paramDataSize > 0) {
 			context->write(paramOffset, paramBuffer->getBuffer(), _functionInfo->paramDataSize);
 		}
 
+		execute(context);
+	}
+
+	char* ScriptRunner::prepareParams(Context* context, int paramSize, int returnSize) {
+		if (paramSize != _functionInfo->paramDataSize) {
+			throw std::runtime_error("size of arguments does not match the function");
+		}
+		if (returnSize > _functionInfo->returnStorageSize) {
+			throw std::runtime_error("return type does not match the function");
+		}
+
+		int paramOffset = s_returnOffset + _functionInfo->returnStorageSize;
+		if (!context->prepareWrite(paramOffset, paramSize)) {
+			return nullptr;
+		}
+		return (char*)context->getAbsoluteAddress(paramOffset);
+	}
+
+	void ScriptRunner::execute(Context* context) {
+		Program* program = _program;
+
+		// the context may be shared with another program, so restore its threaded code after running
+		auto backupThreadedCode = context->getThreadedCode();
+		context->setThreadedCode(program->getThreadedCode());
+		auto backupGlobalData = context->getGlobalData();
+		context->setGlobalData(_globalData);
+
 		context->setCurrentCommand(program->getEndCommand() - 1);
 		context->setEndCommand(program->getEndCommand());
+		// keep state of the context to restore it when the function is stopped by an exception
+		ContextState backupState;
+		context->saveState(backupState);
+
 		auto allocatedSize = _functionInfo->returnStorageSize + _functionInfo->paramDataSize;
 		context->scopeAllocate(allocatedSize, 0);
 
-		int backupOffset = context->getCurrentOffset();
-		auto backupScopeRuntimeData = context->getScopeRuntimeData();
-
+		// code replaced by an update while the function runs is kept until the run is left
+		auto epoch = program->enterRun();
 		try {
-			_scriptInvoker->execute();
+			_scriptInvoker->execute(context);
 		}
 		catch (std::exception& e) {
-			if (backupScopeRuntimeData) {
-				while (context->getScopeRuntimeData() != backupScopeRuntimeData) {
-					context->popContext();
-				}
-			}
-			int currentOffset = context->getCurrentOffset();
-			context->moveOffset(backupOffset - currentOffset);
-			
+			program->leaveRun(epoch);
+			context->restoreState(backupState);
+			context->setThreadedCode(backupThreadedCode);
+			context->setGlobalData(backupGlobalData);
 			throw;
 		}
 
 #if !USE_FUNCTION_TREE
 		_scriptContext->run();
 #endif
+		program->leaveRun(epoch);
 		context->scopeUnallocate(allocatedSize, 0);
+		context->setThreadedCode(backupThreadedCode);
+		context->setGlobalData(backupGlobalData);
+	}
+
+	void ScriptRunner::setGlobalData(void* globalData) {
+		_globalData = globalData;
+	}
+
+	void* ScriptRunner::getGlobalData() const {
+		return _globalData;
 	}
 
 	void* ScriptRunner::getTaskResult() {
-		auto context = Context::getCurrent();
+		return getTaskResult(Context::getCurrent());
+	}
+
+	void* ScriptRunner::getTaskResult(Context* context) {
 		if (_functionInfo->returnStorageSize > 0 && context) {
 #if USE_DIRECT_COPY_FOR_RETURN
 			return context->getAbsoluteAddress(s_returnOffset);
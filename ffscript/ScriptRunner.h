@@ -18,20 +18,86 @@
 
 namespace ffscript {
 	class Program;
+	class Context;
 	struct FunctionInfo;
 	class CallFuntion;
 
+	template <typename Ret>
+	struct ScriptReturnSize {
+		static const int value = sizeof(Ret);
+	};
+
+	template <>
+	struct ScriptReturnSize<void> {
+		static const int value = 0;
+	};
+
+	// a reference is returned by the script as an address
+	template <typename Ret>
+	struct ScriptReturnSize<Ret&> {
+		static const int value = sizeof(void*);
+	};
+
 	class ScriptRunner
 	{
 	protected:
 		Program* _program;
 		FunctionInfo* _functionInfo;
 		CallFuntion* _scriptInvoker;
+		// global data that the function runs with
+		void* _globalData;
+	protected:
+		// check the arguments and the result match the function
+		// then return address of the function's arguments in the context
+		char* prepareParams(Context* context, int paramSize, int returnSize);
+		// execute the function when its arguments are already in the context
+		void execute(Context* context);
+
+		template <typename Ret>
+		struct ResultReader {
+			static Ret read(ScriptRunner* runner, Context* context) {
+				return *(Ret*)runner->getTaskResult(context);
+			}
+		};
+
+		template <typename Ret>
+		struct ResultReader<Ret&> {
+			static Ret& read(ScriptRunner* runner, Context* context) {
+				return **(Ret**)runner->getTaskResult(context);
+			}
+		};
 	public:
 		ScriptRunner(Program* program, int functionId);
 		virtual ~ScriptRunner();
 
 		virtual void runFunction(const ScriptParamBuffer* paramBuffer);
 		virtual void* getTaskResult();
+		// run the function on the given context instead of the current context of the thread
+		virtual void runFunction(Context* context, const ScriptParamBuffer* paramBuffer);
+		virtual void* getTaskResult(Context* context);
+
+		// run the function with global data of an instance of the program,
+		// by default the function runs with global data of the program
+		void setGlobalData(void* globalData);
+		void* getGlobalData() const;
+
+		// run the function with typed arguments, the arguments are written directly
+		// to the context without an intermediate buffer and the result is returned
+		// as its type. Types of the arguments and the result must be same as types
+		// of the function's parameters and return type in the script, but only sizes
+		// of them are checked, so an argument of other type in same size is not detected
+		template <typename Ret, typename... Args>
+		Ret invoke(Context* context, const Args&... params) {
+			typedef FT::MemberTypeInfo<0, ARG_ALIGMENT_SIZE, Args...> ParamInfo;
+			char* paramAddress = prepareParams(context, ParamInfo::totalSize(), ScriptReturnSize<Ret>::value);
+			packScriptParams(paramAddress, params...);
+			execute(context);
+			return ResultReader<Ret>::read(this, context);
+		}
+	};
+
+	template <>
+	struct ScriptRunner::ResultReader<void> {
+		static void read(ScriptRunner*, Context*) {}
 	};
 }
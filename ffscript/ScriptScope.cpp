@@ -13,6 +13,8 @@
 #include "ObjectBlock.hpp"
 #include "ExpUnitExecutor.h"
 #include "Program.h"
+#include "FunctionInliner.h"
+#include <stdexcept>
 
 namespace ffscript {
 	ScriptScope::ScriptScope(ScriptCompiler* scriptCompiler) :
@@ -396,6 +398,11 @@ namespace ffscript {
 		return _dataSize;
 	}
 
+	void ScriptScope::setScopeSize(int dataSize, int scopeSize) {
+		_dataSize = dataSize;
+		_scopeSize = scopeSize;
+	}
+
 	int ScriptScope::getBaseOffset() const {
 		return _scopeBaseOffset;
 	}
@@ -445,6 +452,45 @@ namespace ffscript {
 	const ScopeRefList& ScriptScope::getChildren() const {
 		return _children;
 	}
+
+	ScriptScopeRef ScriptScope::detachChild(ScriptScope* child) {
+		ScriptScopeRef childRef;
+		for (auto it = _children.begin(); it != _children.end(); it++) {
+			if (it->get() == child) {
+				childRef = *it;
+				_children.erase(it);
+				break;
+			}
+		}
+		return childRef;
+	}
+
+	ScriptScopeRef ScriptScope::replaceChild(ScriptScope* oldChild, ScriptScope* newChild) {
+		ScriptScopeRef newChildRef = detachChild(newChild);
+		ScriptScopeRef oldChildRef;
+		for (auto it = _children.begin(); it != _children.end(); it++) {
+			if (it->get() == oldChild) {
+				oldChildRef = *it;
+				*it = newChildRef;
+				break;
+			}
+		}
+		return oldChildRef;
+	}
+	void ScriptScope::inlineFunctionCalls(FunctionInliner* inliner) {
+		for (auto it = _commandBuilder.begin(); it != _commandBuilder.end(); it++) {
+			// root units are referred by other command builders, so only their
+			// children can be replaced
+			auto exeUnit = dynamic_cast<ExecutableUnit*>(it->get());
+			if (exeUnit && ISFUNCTION(exeUnit)) {
+				inliner->inlineCalls((Function*)exeUnit);
+			}
+		}
+		for (auto it = _children.begin(); it != _children.end(); it++) {
+			(*it)->inlineFunctionCalls(inliner);
+		}
+	}
+
 	/*int ScriptScope::allocateMem(int size) {
 		if (_currentOffset + size > _maxSize) {
 			return -1;
@@ -34,6 +34,7 @@ namespace ffscript {
 	struct OperatorItem;
 	typedef std::shared_ptr<ScriptScope> ScriptScopeRef;
 	class CXOperand;
+	class FunctionInliner;
 
 	typedef std::list<CommandUnitRef > ComandRefList;
 	typedef ComandRefList::const_iterator CommandConstRefIter;
@@ -95,6 +96,8 @@ namespace ffscript {
 
 		int getScopeSize() const;
 		int getDataSize() const;
+		// set sizes of the scope directly, it is used when code of the scope is loaded without parsing
+		void setScopeSize(int dataSize, int scopeSize);
 		int getBaseOffset() const;
 		void setBaseOffset(int offset);
 		void allocate(int size);
@@ -107,6 +110,10 @@ namespace ffscript {
 		ScriptScope* getParent() const;
 		ScriptScope* getRoot() const;
 		const ScopeRefList& getChildren() const;
+		// detach a child scope, the returned reference keeps the child alive
+		ScriptScopeRef detachChild(ScriptScope* child);
+		// put a child scope at place of another child, the old child is detached
+		ScriptScopeRef replaceChild(ScriptScope* oldChild, ScriptScope* newChild);
 		void setParent(ScriptScope* parent);
 		void clear();
 
@@ -121,6 +128,8 @@ namespace ffscript {
 		virtual const wchar_t* parse(const wchar_t* text, const wchar_t* end) = 0;
 		virtual int correctAndOptimize(Program* program) = 0;
 		virtual bool extractCode(Program* program) = 0;
+		// inline calls in expressions of the scope and its children
+		void inlineFunctionCalls(FunctionInliner* inliner);
 
 		//void setBeginExpression(CommandConstRefIter expressionIter);
 		//CommandConstRefIter getBeginExpression() const;
@@ -17,6 +17,7 @@
 #include "ScopedCompilingScope.h"
 #include "Program.h"
 #include "FwdCompositeConstrutorUnit.h"
+#include "ExpressionOptimizer.h"
 
 namespace ffscript {
 	const wchar_t* ScriptScope::parseType(const wchar_t* text, const wchar_t* end, ScriptType& type) {
@@ -141,11 +142,14 @@ namespace ffscript {
 		ExpressionParser& parser = *pParser;
 		ScriptCompiler* scriptCompiler = parser.getCompiler();
 		EExpressionResult eResult = EE_INCOMPLETED_EXPRESSION;
+		// fold constant sub trees of linked expressions before they are put to the scope
+		ExpressionOptimizer optimizer(scriptCompiler);
 		if (expList.size() == 1) {
 			CandidateCollectionRef candidates = std::make_shared<CandidateCollection>();
 			eResult = parser.link(expList.front().get(), candidates);
 			if (eResult == EE_SUCCESS) {
 				if (expectedReturnType == nullptr) {
+					optimizer.foldConstants(candidates->front());
 					putCommandUnit(candidates->front());
 				}
 				else {
@@ -154,6 +158,7 @@ namespace ffscript {
 						scriptCompiler->setErrorText("Cannot cast the return type to '" + expectedReturnType->sType() + "'");
 						return EE_TYPE_CONVERSION_ERROR;
 					}
+					optimizer.foldConstants(candidate);
 					putCommandUnit(candidate);
 				}
 			}
@@ -173,6 +178,7 @@ namespace ffscript {
 				eResult = parser.link(it->get(), candidates);
 				if (eResult == EE_SUCCESS) {
 					if (expectedReturnType == nullptr || it != lastUnitIter) {
+						optimizer.foldConstants(candidates->front());
 						putCommandUnit(candidates->front());
 					}
 					else {
@@ -182,6 +188,7 @@ namespace ffscript {
 							((GlobalScope*)getRoot())->setErrorCompilerCharIndex(candidates->front()->getSourceCharIndex());
 							return eResult;
 						}
+						optimizer.foldConstants(candidate);
 						putCommandUnit(candidate);
 					}
 					candidates->clear();
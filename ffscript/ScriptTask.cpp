@@ -18,11 +18,17 @@
 #include "ScriptTask.h"
 #include "Context.h"
 #include "Program.h"
+#include "ProgramInstance.h"
 #include "InstructionCommand.h"
 
 namespace ffscript {
-	ScriptTask::ScriptTask(Program* program) : _program(program), _scriptContext(nullptr), _allocatedSize(0),
-		_scriptRunner(nullptr), _lastCallFunctionId(-1)
+	ScriptTask::ScriptTask(Program* program) : _program(program), _scriptContext(nullptr),
+		_scriptRunner(nullptr), _globalData(program->getGlobalData())
+	{
+	}
+
+	ScriptTask::ScriptTask(ProgramInstance* programInstance) : _program(programInstance->getProgram()), _scriptContext(nullptr),
+		_scriptRunner(nullptr), _globalData(programInstance->getGlobalData())
 	{
 	}
 
@@ -30,8 +36,8 @@ namespace ffscript {
 		if (_scriptContext) {
 			delete _scriptContext;
 		}
-		if (_scriptRunner) {
-			delete _scriptRunner;
+		for (auto& it : _scriptRunners) {
+			delete it.second;
 		}
 	}
 
@@ -40,10 +46,14 @@ namespace ffscript {
 	}
 
 	void ScriptTask::runFunction(int stackSize, int functionId, const ScriptParamBuffer* paramBuffer) {
-		if (_scriptRunner == nullptr || _lastCallFunctionId != functionId) {
-			if (_scriptRunner) delete _scriptRunner;
+		auto it = _scriptRunners.find(functionId);
+		if (it != _scriptRunners.end()) {
+			_scriptRunner = it->second;
+		}
+		else {
 			_scriptRunner = new ScriptRunner(_program, functionId);
-			_lastCallFunctionId = functionId;
+			_scriptRunner->setGlobalData(_globalData);
+			_scriptRunners.insert(std::make_pair(functionId, _scriptRunner));
 		}
 
 		if (_scriptContext == nullptr) {
@@ -52,15 +62,13 @@ namespace ffscript {
 		else if (_scriptContext->getMemCapacity() < stackSize) {
 			delete _scriptContext;
 			_scriptContext = new Context(stackSize);
-			_allocatedSize = 0;
-		}
-		else
-		{
-			_scriptContext->scopeUnallocate(_allocatedSize, 0);
 		}
+		// the script runner releases what it allocated in the context after running,
+		// so the context can be reused as it is
 
+		_scriptRunner->runFunction(_scriptContext, paramBuffer);
+		// keep the task context as current context of the thread like it used to be
 		Context::makeCurrent(_scriptContext);
-		_scriptRunner->runFunction(paramBuffer);
 	}
 
 	void ScriptTask::runFunction(int functionId, const ScriptParamBuffer& paramBuffer) {
@@ -72,7 +80,6 @@ namespace ffscript {
 	}
 
 	void* ScriptTask::getTaskResult() {
-		Context::makeCurrent(_scriptContext);
-		return _scriptRunner->getTaskResult();
+		return _scriptRunner->getTaskResult(_scriptContext);
 	}
 }
\ No newline at end of file
@@ -19,23 +19,28 @@
 #include "ffscript.h"
 #include "ScriptParamBuffer.hpp"
 #include "ScriptRunner.h"
+#include <map>
 
 namespace ffscript {
 
 	class Context;
 	class Program;
+	class ProgramInstance;
 	struct FunctionInfo;
 
 	class ScriptTask
 	{
 		Context* _scriptContext;
-		int _allocatedSize;
 		ScriptRunner* _scriptRunner;
 		Program* _program;
-
-		int _lastCallFunctionId;
+		// global data that the functions run with
+		void* _globalData;
+		// runners of called functions are kept to switch between functions without allocating
+		std::map<int, ScriptRunner*> _scriptRunners;
 	public:
 		ScriptTask(Program* program);
+		// run functions of the program with global variables of the instance
+		ScriptTask(ProgramInstance* programInstance);
 		virtual ~ScriptTask();
 
 		void runFunction(int functionId, const ScriptParamBuffer* paramBuffer);
@@ -16,9 +16,14 @@
 #include "InstructionCommand.h"
 
 namespace ffscript {
-	StaticContext::StaticContext(unsigned char* threadData, int bufferSize) : Context(threadData, bufferSize) {}
+	StaticContext::StaticContext(unsigned char* threadData, int bufferSize) : Context(threadData, bufferSize) {
+		// global variables are placed at beginning of the context
+		setGlobalData(getAbsoluteAddress(getCurrentOffset()));
+	}
 
-	StaticContext::StaticContext(int bufferSize) : Context(bufferSize) {}
+	StaticContext::StaticContext(int bufferSize) : Context(bufferSize) {
+		setGlobalData(getAbsoluteAddress(getCurrentOffset()));
+	}
 
 	StaticContext::~StaticContext()
 	{
@@ -33,12 +38,17 @@ namespace ffscript {
 		_destructorCommands.push_back(command);
 	}
 
-	void StaticContext::runCommands(const std::list<CommandPointer>& commands) {
-		auto currentContext = Context::getCurrent();
-		Context::makeCurrent(this);
+	const std::list<CommandPointer>& StaticContext::getCommands() const {
+		return _globalCommands;
+	}
 
+	const std::list<CommandPointer>& StaticContext::getDestructorCommands() const {
+		return _destructorCommands;
+	}
+
+	void StaticContext::runCommands(const std::list<CommandPointer>& commands) {
 		for (auto it = commands.begin(); it != commands.end(); ++it) {
-			(*(*it))->execute();
+			(*(*it))->execute(this);
 #ifndef THROW_EXCEPTION_ON_ERROR
 			if (isError()) {
 				//Logger::WriteMessage(__FUNCTION__);
@@ -46,8 +56,6 @@ namespace ffscript {
 			}
 #endif
 		}
-
-		Context::makeCurrent(currentContext);
 	}
 
 	void StaticContext::run() {
@@ -32,6 +32,8 @@ namespace ffscript {
 		virtual ~StaticContext();
 		void addCommand(CommandPointer command);
 		void addDestructorCommand(CommandPointer command);
+		const std::list<CommandPointer>& getCommands() const;
+		const std::list<CommandPointer>& getDestructorCommands() const;
 		virtual void run();
 		virtual void runDestructorCommands();
 	};
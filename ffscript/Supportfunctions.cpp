@@ -23,6 +23,11 @@
 #include "InstructionCommand.h"
 #include "DefaultCommands.h"
 #include "CommandTree.h"
+#include "CompareAndJump.h"
+#include "ScriptFunction.h"
+#include "StructClass.h"
+#include "Program.h"
+#include <typeinfo>
 
 namespace ffscript {
 	CommandBuilder::CommandBuilder() : CommandBuilder(0, ""){
@@ -248,9 +253,94 @@ namespace ffscript {
 		updateReturnCommand2->setArgs(_ownerScope, _functionScope, exitAtReturn);
 		updateLaterMan->addUpdateLaterTask(updateReturnCommand2);
 
+		if (_returnDataUnit) {
+			auto updateTailCall = std::make_shared<FT::CachedMethodDelegate<ReturnCommandBuilder2, void, Executor*, ExitScriptFuntionAtReturn*>>(this, &ReturnCommandBuilder2::addTailCallTask);
+			updateTailCall->setArgs(pExcutor, exitAtReturn);
+			updateLaterMan->addUpdateLaterTask(updateTailCall);
+		}
+
 		return pExcutor;
 	}
 
+	void ReturnCommandBuilder2::addTailCallTask(Executor* returnExecutor, ExitScriptFuntionAtReturn* exitCommand) {
+		// exit commands of the scopes are filled by tasks those were added after this one,
+		// so the tail call is applied by a task that runs after them
+		auto updateTailCall = std::make_shared<FT::CachedMethodDelegate<ReturnCommandBuilder2, void, Executor*, ExitScriptFuntionAtReturn*>>(this, &ReturnCommandBuilder2::applyTailCall);
+		updateTailCall->setArgs(returnExecutor, exitCommand);
+		CodeUpdater::getInstance(_functionScope)->addUpdateLaterTask(updateTailCall);
+	}
+
+	static bool hasRefMember(ScriptCompiler* scriptCompiler, const ScriptType& type) {
+		if (type.isRefType() || type.isSemiRefType()) {
+			return true;
+		}
+		auto structClass = scriptCompiler->getStruct(type.iType());
+		if (structClass == nullptr) {
+			return false;
+		}
+		std::string memberName;
+		MemberInfo memberInfo;
+		std::list<ScriptType> memberTypes;
+		for (bool hasMember = structClass->getMemberFirst(&memberName, &memberInfo); hasMember;
+			hasMember = structClass->getMemberNext(&memberName, &memberInfo)) {
+			memberTypes.push_back(memberInfo.type);
+		}
+		for (auto& memberType : memberTypes) {
+			if (hasRefMember(scriptCompiler, memberType)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void ReturnCommandBuilder2::applyTailCall(Executor* returnExecutor, ExitScriptFuntionAtReturn* exitCommand) {
+		// the caller frame is reused by the called function, so nothing of the caller
+		// may run after the call and the call must not refer to data in the frame
+		if (_indexPreventDestructorRun >= 0) return;
+
+		auto& exitCommands = exitCommand->getCommands();
+		for (auto command : exitCommands) {
+			if (typeid(*command) == typeid(ExitContextScope)) {
+				if (((ExitContextScope*)command)->hasAutoRunCommands()) return;
+			}
+			else if (typeid(*command) != typeid(ExitFunctionAtTheEnd)) {
+				return;
+			}
+		}
+
+		ScriptFunction* scriptFunction = dynamic_cast<ScriptFunction*>(_returnDataUnit);
+		if (scriptFunction == nullptr) return;
+
+		ScriptCompiler* scriptCompiler = _functionScope->getCompiler();
+		FunctionFactory* functionFactory = scriptCompiler->getFunctionFactory(_functionScope->getFunctionId());
+		if (scriptFunction->getReturnType().iType() != functionFactory->getReturnType().iType()) return;
+
+		int n = scriptFunction->getChildCount();
+		for (int i = 0; i < n; i++) {
+			if (hasRefMember(scriptCompiler, scriptFunction->getChild(i)->getReturnType())) return;
+		}
+
+		Program* program = scriptCompiler->getProgram();
+		CodeUpdater* updateLaterMan = CodeUpdater::getInstance(_functionScope);
+		ExpUnitExecutor* unitExecutor = (ExpUnitExecutor*)updateLaterMan->findUpdateInfo(_returnDataUnit);
+		auto unitCode = program->getCode(unitExecutor);
+		auto returnCode = program->getCode(returnExecutor);
+		// temporary objects of the expression are destroyed by commands placed between
+		// the expression and the return command, so the call must be followed by it
+		if (unitCode == nullptr || returnCode == nullptr || unitCode->first != unitCode->second ||
+			unitCode->second + 1 != returnCode->first || *returnCode->second != exitCommand) return;
+
+		FunctionCommand* functionCommand = dynamic_cast<FunctionCommand*>(*unitCode->first);
+		if (functionCommand == nullptr) return;
+		auto callCommand = functionCommand->getCommand();
+		if (callCommand == nullptr || typeid(*callCommand) != typeid(CallScriptFuntion3) ||
+			callCommand->getTargetOffset() != unitExecutor->getReturnOffset()) return;
+
+		// the result of the function is written to the return address of the caller,
+		// so the copy of the return command is not run
+		((CallScriptFuntion3*)callCommand)->setCallerReturn(returnCode->second);
+	}
+
 	void ReturnCommandBuilder2::fillParams(CopyDataToRef* command) const {
 		if (_returnDataUnit == nullptr) return;
 
@@ -384,7 +474,27 @@ namespace ffscript {
 	}
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	IfCommandBuilder::IfCommandBuilder(ContextScope* ifScope) : _ifScope(ifScope), _elseScope(nullptr), _conditionUnit(nullptr){
+	// replace code of a condition by a command that tests the condition and jumps by itself when the condition is
+	// a single built-in comparison, the jump command placed after the condition is still built but it is not run
+	static CompareAndJump* fuseCondition(ScriptScope* scope, CommandUnitBuilder* conditionUnit) {
+		CodeUpdater* updateLaterMan = CodeUpdater::getInstance(scope);
+		Executor* conditionExecutor = updateLaterMan->findUpdateInfo(conditionUnit);
+		if (conditionExecutor == nullptr) {
+			return nullptr;
+		}
+		auto conditionCode = conditionExecutor->getCode();
+		if (conditionCode->size() != 1) {
+			return nullptr;
+		}
+		auto compareAndJump = CompareAndJump::createFromCondition(conditionCode->front());
+		if (compareAndJump) {
+			conditionExecutor->replaceCommand(conditionCode->front(), compareAndJump);
+		}
+		return compareAndJump;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	IfCommandBuilder::IfCommandBuilder(ContextScope* ifScope) : _ifScope(ifScope), _elseScope(nullptr), _conditionUnit(nullptr), _compareAndJump(nullptr) {
 	}
 
 	IfCommandBuilder::~IfCommandBuilder() {}
@@ -409,18 +519,38 @@ namespace ffscript {
 		_conditionUnit = conditionUnit;
 	}
 	
+	int IfCommandBuilder::getConstantCondition() const {
+		// condition expression was folded to a constant at compile time
+		auto constantCondition = dynamic_cast<CConstOperand<bool>*>(_conditionUnit);
+		if (constantCondition == nullptr) {
+			return -1;
+		}
+		return constantCondition->_value ? 1 : 0;
+	}
+
 	Executor* IfCommandBuilder::buildNativeCommand() {
 		ControllerExecutor* pExcutor = new ControllerExecutor();
 
 		InstructionCommand* command;
 
-		if (_elseScope) {
+		int constantCondition = getConstantCondition();
+		if (constantCondition == 0 && _elseScope == nullptr) {
+			// the if scope is never run, so no command is needed
+			_compareAndJump = nullptr;
+			return pExcutor;
+		}
+		if (constantCondition >= 0) {
+			// the branch is known at compile time, jump directly to the scope will be run
+			command = new Jump();
+		}
+		else if (_elseScope) {
 			command = new JumpIfElse();
 		}
 		else {
 			command = new JumpIf();
 		}
 		pExcutor->addCommand(command);
+		_compareAndJump = constantCondition < 0 ? fuseCondition(_ifScope, _conditionUnit) : nullptr;
 
 		CodeUpdater* updateLaterMan = CodeUpdater::getInstance(_ifScope);
 		auto updateIfCommand = std::make_shared<FT::CachedMethodDelegate<IfCommandBuilder, void, InstructionCommand*>>(this, &IfCommandBuilder::fillParams);
@@ -431,6 +561,13 @@ namespace ffscript {
 	}
 
 	void IfCommandBuilder::fillParams(InstructionCommand* command) const {
+		int constantCondition = getConstantCondition();
+		if (constantCondition >= 0) {
+			auto targetScope = constantCondition ? _ifScope : _elseScope;
+			((Jump*)command)->setCommandData(targetScope->getCode()->first - 1);
+			return;
+		}
+
 		CodeUpdater* updateLaterMan = CodeUpdater::getInstance(_ifScope);
 		ExpUnitExecutor* unitExecutor = (ExpUnitExecutor*)updateLaterMan->findUpdateInfo(_conditionUnit);
 
@@ -440,11 +577,14 @@ namespace ffscript {
 		if (_elseScope) {
 			((JumpIfElse*)command)->setCommandElse(_elseScope->getCode()->first - 1);
 		}
-		
+
+		if (_compareAndJump) {
+			_compareAndJump->setTargets(_ifScope->getCode()->first - 1, _elseScope ? _elseScope->getCode()->first - 1 : nullptr);
+		}
 	}
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	LoopCommandBuilder::LoopCommandBuilder(LoopScope* loopScope) : _loopScope(loopScope) {
+	LoopCommandBuilder::LoopCommandBuilder(LoopScope* loopScope) : _loopScope(loopScope), _compareAndJump(nullptr) {
 	}
 
 	LoopCommandBuilder::~LoopCommandBuilder() {}
@@ -462,6 +602,7 @@ namespace ffscript {
 
 		auto jumpIf = new JumpIf();
 		pExcutor->addCommand(jumpIf);
+		_compareAndJump = fuseCondition(_loopScope, _loopScope->getConditionExpression());
 
 		CodeUpdater* updateLaterMan = CodeUpdater::getInstance(_loopScope);
 		auto updateLoopCommand = std::make_shared<FT::CachedMethodDelegate<LoopCommandBuilder, void, JumpIf*>>(this, &LoopCommandBuilder::fillParams);
@@ -486,6 +627,10 @@ namespace ffscript {
 		auto firstLoopCommand = _loopScope->getCode()->first;
 	
 		command->setCommandData(conditionOffset, firstLoopCommand);
+
+		if (_compareAndJump) {
+			_compareAndJump->setTargets(firstLoopCommand, nullptr);
+		}
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -37,6 +37,7 @@ namespace ffscript {
 	class TriggerCommand;
 	class BeforeConstructorCall;
 	class Jump;
+	class CompareAndJump;
 
 	class CommandBuilder :
 		public CommandUnitBuilder
@@ -121,6 +122,8 @@ namespace ffscript {
 
 		Executor* buildNativeCommand();
 		void fillParams(CopyDataToRef* command) const;
+		void addTailCallTask(Executor* returnExecutor, ExitScriptFuntionAtReturn* exitCommand);
+		void applyTailCall(Executor* returnExecutor, ExitScriptFuntionAtReturn* exitCommand);
 	};
 
 	class BreakCommandBuilder : public CommandBuilder {
@@ -161,6 +164,11 @@ namespace ffscript {
 		ContextScope* _ifScope;
 		ContextScope* _elseScope;
 		CommandUnitBuilder* _conditionUnit;
+		// command replaces code of the condition, it is null if the condition cannot be fused
+		CompareAndJump* _compareAndJump;
+	private:
+		// return 1 or 0 if the condition is a constant true or false, otherwise return -1
+		int getConstantCondition() const;
 	public:
 		IfCommandBuilder(ContextScope* ifScope);
 		~IfCommandBuilder();
@@ -179,6 +187,7 @@ namespace ffscript {
 
 	class LoopCommandBuilder : public CommandBuilder {
 		LoopScope* _loopScope;
+		CompareAndJump* _compareAndJump;
 	public:
 		LoopCommandBuilder(LoopScope* loopScope);
 		~LoopCommandBuilder();
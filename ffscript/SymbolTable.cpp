@@ -0,0 +1,97 @@
+/******************************************************************
+* File:        SymbolTable.cpp
+* Description: implement SymbolTable class. A class that interns names
+*              of functions, types, keywords and constants to integer
+*              symbols, so the registries of the compiler look up
+*              names by the symbols instead of comparing strings.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "SymbolTable.h"
+#include <string.h>
+#include <stdint.h>
+
+namespace ffscript {
+
+	const int SymbolTable::INVALID_SYMBOL;
+
+	SymbolTable::SymbolTable() : _mask(0) {
+	}
+
+	SymbolTable::~SymbolTable() {
+	}
+
+	size_t SymbolTable::hashName(const char* name, size_t length) {
+		// FNV-1a
+		uint32_t h = 2166136261u;
+		for (const char* c = name; c < name + length; c++) {
+			h ^= (unsigned char)*c;
+			h *= 16777619u;
+		}
+		return (size_t)h;
+	}
+
+	void SymbolTable::rehash(size_t capacity) {
+		_slots.assign(capacity, INVALID_SYMBOL);
+		_mask = capacity - 1;
+		for (int symbol = 0; symbol < (int)_names.size(); symbol++) {
+			auto& name = _names[symbol];
+			size_t i = hashName(name.c_str(), name.size()) & _mask;
+			while (_slots[i] != INVALID_SYMBOL) {
+				i = (i + 1) & _mask;
+			}
+			_slots[i] = symbol;
+		}
+	}
+
+	int SymbolTable::intern(const std::string& name) {
+		int symbol = find(name);
+		if (symbol != INVALID_SYMBOL) {
+			return symbol;
+		}
+
+		symbol = (int)_names.size();
+		_names.push_back(name);
+		if (_names.size() * 2 > _slots.size()) {
+			rehash(_slots.size() ? _slots.size() * 2 : 256);
+		}
+		else {
+			size_t i = hashName(name.c_str(), name.size()) & _mask;
+			while (_slots[i] != INVALID_SYMBOL) {
+				i = (i + 1) & _mask;
+			}
+			_slots[i] = symbol;
+		}
+		return symbol;
+	}
+
+	int SymbolTable::find(const char* name, size_t length) const {
+		if (_slots.size() == 0) {
+			return INVALID_SYMBOL;
+		}
+		for (size_t i = hashName(name, length) & _mask; _slots[i] != INVALID_SYMBOL; i = (i + 1) & _mask) {
+			auto& symbolName = _names[_slots[i]];
+			if (symbolName.size() == length && memcmp(symbolName.c_str(), name, length) == 0) {
+				return _slots[i];
+			}
+		}
+		return INVALID_SYMBOL;
+	}
+
+	int SymbolTable::find(const std::string& name) const {
+		return find(name.c_str(), name.size());
+	}
+
+	const std::string& SymbolTable::getName(int symbol) const {
+		return _names.at(symbol);
+	}
+
+	size_t SymbolTable::size() const {
+		return _names.size();
+	}
+}
@@ -0,0 +1,51 @@
+/******************************************************************
+* File:        SymbolTable.h
+* Description: declare SymbolTable class. A class that interns names
+*              of functions, types, keywords and constants to integer
+*              symbols, so the registries of the compiler look up
+*              names by the symbols instead of comparing strings.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+
+namespace ffscript {
+
+	class SymbolTable
+	{
+		// names are never removed, so references to them are kept valid. The table grows
+		// with the number of distinct names registered to the compiler, a name registered
+		// again by the next compiled program uses the symbol it was interned with
+		std::deque<std::string> _names;
+		// open addressing index of the names, an empty slot is -1
+		std::vector<int> _slots;
+		size_t _mask;
+	private:
+		static size_t hashName(const char* name, size_t length);
+		void rehash(size_t capacity);
+	public:
+		static const int INVALID_SYMBOL = -1;
+
+		SymbolTable();
+		virtual ~SymbolTable();
+
+		// get symbol of the name, the name is added if it is not in the table
+		int intern(const std::string& name);
+		// get symbol of the name, it is INVALID_SYMBOL if the name is not in the table
+		int find(const char* name, size_t length) const;
+		int find(const std::string& name) const;
+		const std::string& getName(int symbol) const;
+		size_t size() const;
+	};
+
+	typedef std::shared_ptr<SymbolTable> SymbolTableRef;
+}
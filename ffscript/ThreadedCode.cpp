@@ -0,0 +1,131 @@
+/******************************************************************
+* File:        ThreadedCode.cpp
+* Description: implement ThreadedCode class. A class that lowers the
+*              plain code of a program into a compact instruction
+*              stream. Each instruction carries an op code and its
+*              operands inline so the context can dispatch it without
+*              calling the virtual execute method of the command.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#include "ThreadedCode.h"
+#include "InstructionCommand.h"
+#include <typeinfo>
+#include <stdlib.h>
+
+namespace ffscript {
+
+	void ThreadedCode::lowerCommand(InstructionCommand* command, ThreadedInstruction& instruction) {
+		memset(&instruction, 0, sizeof(instruction));
+		instruction.opCode = ThreadedOpCode::Execute;
+		instruction.command = command;
+
+		// only lower the exact command types, derived commands
+		// may override execute method with other behaviors
+		const std::type_info& commandType = typeid(*command);
+
+		if (commandType == typeid(Jump)) {
+			auto jumpCommand = (Jump*)command;
+			instruction.opCode = ThreadedOpCode::Jump;
+			instruction.targetTrue = jumpCommand->_targetCommand;
+		}
+		else if (commandType == typeid(JumpIf)) {
+			auto jumpIf = (JumpIf*)command;
+			instruction.opCode = ThreadedOpCode::JumpIf;
+			instruction.sourceOffset = jumpIf->_conditionOffset;
+			instruction.targetTrue = jumpIf->_targetCommandTrue;
+		}
+		else if (commandType == typeid(JumpIfElse)) {
+			auto jumpIfElse = (JumpIfElse*)command;
+			instruction.opCode = ThreadedOpCode::JumpIfElse;
+			instruction.sourceOffset = jumpIfElse->_conditionOffset;
+			instruction.targetTrue = jumpIfElse->_targetCommandTrue;
+			instruction.targetFalse = jumpIfElse->_targetCommandFalse;
+		}
+		else if (commandType == typeid(PushParam)) {
+			auto pushParam = (PushParam*)command;
+			instruction.opCode = ThreadedOpCode::PushParam;
+			instruction.pointer = pushParam->_param;
+			instruction.targetOffset = pushParam->getTargetOffset();
+			instruction.size = pushParam->getTargetSize();
+		}
+		else if (commandType == typeid(PushParamRef)) {
+			auto pushParamRef = (PushParamRef*)command;
+			instruction.opCode = ThreadedOpCode::PushParamRef;
+			instruction.pointer = pushParamRef->_param;
+			instruction.targetOffset = pushParamRef->getTargetOffset();
+		}
+		else if (commandType == typeid(PushParamOffset)) {
+			auto pushParamOffset = (PushParamOffset*)command;
+			instruction.opCode = ThreadedOpCode::PushParamOffset;
+			instruction.sourceOffset = pushParamOffset->_sourceOffset;
+			instruction.targetOffset = pushParamOffset->getTargetOffset();
+			instruction.size = pushParamOffset->getTargetSize();
+		}
+		else if (commandType == typeid(PushParamRefOffset) || commandType == typeid(LeaOffsetToOffset)) {
+			// both commands store address of source offset to target offset
+			auto targetedCommand = (TargetedCommand*)command;
+			instruction.opCode = ThreadedOpCode::PushParamRefOffset;
+			instruction.sourceOffset = commandType == typeid(PushParamRefOffset) ?
+				((PushParamRefOffset*)command)->_sourceOffset : ((LeaOffsetToOffset*)command)->_sourceOffset;
+			instruction.targetOffset = targetedCommand->getTargetOffset();
+		}
+		else if (commandType == typeid(PushGlobalParam)) {
+			auto pushParam = (PushGlobalParam*)command;
+			instruction.opCode = ThreadedOpCode::PushGlobalParam;
+			instruction.sourceOffset = pushParam->_sourceOffset;
+			instruction.targetOffset = pushParam->getTargetOffset();
+			instruction.size = pushParam->getTargetSize();
+		}
+		else if (commandType == typeid(PushGlobalParamRef) || commandType == typeid(LeaGlobalToOffset)) {
+			// both commands store address of a global variable to target offset
+			instruction.opCode = ThreadedOpCode::PushGlobalParamRef;
+			instruction.sourceOffset = commandType == typeid(PushGlobalParamRef) ?
+				((PushGlobalParamRef*)command)->_sourceOffset : ((LeaGlobalToOffset*)command)->_sourceOffset;
+			instruction.targetOffset = ((TargetedCommand*)command)->getTargetOffset();
+		}
+		else if (commandType == typeid(CallNativeFuntion)) {
+			auto callNative = (CallNativeFuntion*)command;
+			instruction.opCode = ThreadedOpCode::CallNative;
+			instruction.targetOffset = callNative->getTargetOffset();
+			instruction.sourceOffset = callNative->getBeginParamOffset();
+			// the command still keeps the function object alive
+			instruction.pointer = callNative->_targetFunction.get();
+		}
+	}
+
+	ThreadedCode::ThreadedCode(CommandPointer codeBegin, CommandPointer codeEnd) :
+		_instructions(nullptr), _codeBegin(codeBegin), _lowerCount(0)
+	{
+		_instructionCount = (int)(codeEnd - codeBegin);
+		if (_instructionCount <= 0) {
+			_instructionCount = 0;
+			return;
+		}
+
+		_instructions = (ThreadedInstruction*)malloc(sizeof(ThreadedInstruction) * _instructionCount);
+
+		ThreadedInstruction* instruction = _instructions;
+		for (CommandPointer command = codeBegin; command != codeEnd; command++, instruction++) {
+			lowerCommand(*command, *instruction);
+			if (instruction->opCode != ThreadedOpCode::Execute) {
+				_lowerCount++;
+			}
+		}
+	}
+
+	ThreadedCode::~ThreadedCode() {
+		if (_instructions) {
+			free(_instructions);
+		}
+	}
+
+	int ThreadedCode::getLoweredCount() const {
+		return _lowerCount;
+	}
+}
@@ -0,0 +1,72 @@
+/******************************************************************
+* File:        ThreadedCode.h
+* Description: declare ThreadedCode class. A class that lowers the
+*              plain code of a program into a compact instruction
+*              stream. Each instruction carries an op code and its
+*              operands inline so the context can dispatch it without
+*              calling the virtual execute method of the command.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+
+#pragma once
+#include "ffscript.h"
+
+namespace ffscript {
+
+	enum class ThreadedOpCode : unsigned char {
+		// call virtual execute method of the origin command
+		Execute = 0,
+		Jump,
+		JumpIf,
+		JumpIfElse,
+		PushParam,
+		PushParamRef,
+		PushParamOffset,
+		PushParamRefOffset,
+		// push a global variable or its address, source offset is relative to the global data
+		PushGlobalParam,
+		PushGlobalParamRef,
+		CallNative,
+		OpCodeCount
+	};
+
+	struct ThreadedInstruction {
+		ThreadedOpCode opCode;
+		// offset of the source data or condition, relative to current offset
+		int sourceOffset;
+		// offset of the target data, relative to current offset
+		int targetOffset;
+		// size of the data will be copied
+		int size;
+		// address of the source data or the native function object
+		void* pointer;
+		CommandPointer targetTrue;
+		CommandPointer targetFalse;
+		// origin command, it is used for Execute op code
+		InstructionCommand* command;
+	};
+
+	class ThreadedCode
+	{
+		ThreadedInstruction* _instructions;
+		CommandPointer _codeBegin;
+		int _instructionCount;
+		int _lowerCount;
+	private:
+		static void lowerCommand(InstructionCommand* command, ThreadedInstruction& instruction);
+	public:
+		ThreadedCode(CommandPointer codeBegin, CommandPointer codeEnd);
+		virtual ~ThreadedCode();
+
+		inline CommandPointer getCodeBegin() const { return _codeBegin; }
+		inline int getInstructionCount() const { return _instructionCount; }
+		inline const ThreadedInstruction* getInstructions() const { return _instructions; }
+		// number of instructions that do not use Execute op code
+		int getLoweredCount() const;
+	};
+}
@@ -16,7 +16,7 @@
 #include "ScriptCompiler.h"
 
 namespace ffscript {
-	TypeManager::TypeManager() {}
+	TypeManager::TypeManager(const SymbolTableRef& symbolTable) : _symbolTable(symbolTable) {}
 
 	TypeManager::~TypeManager()
 	{
@@ -31,7 +31,8 @@ namespace ffscript {
 		int typeInInt = (int)_typesInString.size();
 		typeInInt |= mask;
 
-		auto it = _typeStringIntMap.insert(std::pair<const std::string&, int>(type, typeInInt));
+		int symbol = _symbolTable->intern(type);
+		auto it = _typeSymbolMap.insert(symbol, typeInInt);
 
 		/* type is already exist */
 		if (it.second == false) {
@@ -40,7 +41,8 @@ namespace ffscript {
 
 		//add registered type
 		TypeInfo typeInfo;
-		typeInfo.name = &(it.first->first);
+		typeInfo.name = &_symbolTable->getName(symbol);
+		typeInfo.symbol = symbol;
 		typeInfo.size = 0;
 		_typesInString.push_back(typeInfo);
 
@@ -96,12 +98,12 @@ namespace ffscript {
 	}
 
 	int TypeManager::getType(const std::string& type) const {
-		auto it = _typeStringIntMap.find(type);
-		if (it == _typeStringIntMap.end()) {
+		auto typeId = _typeSymbolMap.find(_symbolTable->find(type));
+		if (typeId == nullptr) {
 			return DATA_TYPE_UNKNOWN;
 		}
 
-		return it->second;
+		return *typeId;
 	}
 
 	int TypeManager::registStruct(StructClass* pStruct) {
@@ -154,17 +156,25 @@ namespace ffscript {
 			for (int i = _systemTypeMarkEnd->typeIdx; i < (int)_typesInString.size(); i++) {
 				_structMap.erase(i);
 				_typeInfoMap.erase(i);
-				
-				for (auto it = _typeStringIntMap.begin(); it != _typeStringIntMap.end(); it++) {
-					if (it->second == i) {
-						_typeStringIntMap.erase(it);
-						break;
-					}
-				}
+				_typeSymbolMap.erase(_typesInString[i].symbol);
 			}
 
 			_typesInString.resize(_systemTypeMarkEnd->typeIdx);
 			_systemTypeMarkEnd.reset();
 		}
 	}
+
+	bool TypeManager::hasUserStructs() const {
+		return _systemTypeMarkEnd && _structMap.lower_bound(_systemTypeMarkEnd->typeIdx) != _structMap.end();
+	}
+
+	std::list<const StructClass*> TypeManager::getUserStructs() const {
+		std::list<const StructClass*> userStructs;
+		if (_systemTypeMarkEnd) {
+			for (auto it = _structMap.lower_bound(_systemTypeMarkEnd->typeIdx); it != _structMap.end(); it++) {
+				userStructs.push_back(it->second.get());
+			}
+		}
+		return userStructs;
+	}
 }
\ No newline at end of file
@@ -14,8 +14,11 @@
 #include "StructClass.h"
 #include "MemoryBlock.h"
 #include "BasicType.h"
+#include "SymbolTable.h"
+#include "FlatHashMap.hpp"
 
 #include <map>
+#include <list>
 #include <string>
 #include <memory>
 #include <vector>
@@ -26,13 +29,16 @@ namespace ffscript {
 	{
 		struct TypeInfo {
 			const std::string* name;
+			int symbol;
 			int size;
 		};
 
 		ffscript::BasicTypes _basicTypes;
 
+		SymbolTableRef _symbolTable;
 		std::vector<TypeInfo> _typesInString;
-		std::map<const std::string, int> _typeStringIntMap;
+		// map symbol of type name to type id
+		FlatHashMap<int, int> _typeSymbolMap;
 		std::map<int, StructClassRef> _structMap;
 		std::map<int, MemoryBlockRef> _typeInfoMap;
 
@@ -43,7 +49,7 @@ namespace ffscript {
 		LibraryMarkInfoRef _systemTypeMarkEnd;
 
 	public:
-		TypeManager();
+		TypeManager(const SymbolTableRef& symbolTable);
 		~TypeManager();
 		bool registTypeInfo(int type, MemoryBlockRef typeInfo);
 		void* getTypeInfo(int type);
@@ -65,6 +71,10 @@ namespace ffscript {
 
 		void beginUserTypes();
 		void clearUserTypes();
+		// check if structs were registered after beginUserTypes, such as structs declared by a script
+		bool hasUserStructs() const;
+		// structs registered after beginUserTypes in order of registration
+		std::list<const StructClass*> getUserStructs() const;
 	};
 
 	typedef std::shared_ptr<TypeManager> TypeManagerRef;
@@ -250,6 +250,7 @@ namespace ffscript {
 		_functionType(functionType),
 		_priority(iPriority),
 		ExecutableUnit(returnType),
+		_functionId(-1),
 		_paramSize(0)
 	{}
 
@@ -258,6 +259,7 @@ namespace ffscript {
 		_functionType(functionType),
 		_priority(iPriority),
 		ExecutableUnit(returnType),
+		_functionId(-1),
 		_paramSize(0)
 	{}
 	Function::~Function() {
@@ -13,6 +13,7 @@
 #pragma once
 #include <list>
 #include <memory>
+#include <atomic>
 
 #ifdef FFSCRIPT_DYNAMIC
 #ifdef FFSCIPT_EXPORTS
@@ -125,6 +126,8 @@ namespace ffscript {
 	typedef std::list<InstructionCommand*> CommandList;
 	typedef std::list<std::shared_ptr<InstructionCommand>> ScopeAutoRunList;
 	typedef std::pair< CommandPointer, CommandPointer > CodeSegmentEntry;
+	// first command of a script function, calls load it when they enter the function
+	typedef std::atomic<CommandPointer> FunctionEntry;
 
 	template <class Ret, class... Types>
 	using FunctionT = typename FT::FunctionDelegate3<Ret, Types...>;
@@ -217,6 +220,8 @@ namespace ffscript {
 
 	struct RuntimeFunctionInfo
 	{
+		// native function object or entry of a script function, calls through
+		// a script function object follow updates of the function
 		void* address;
 		AnoynymousDataInfo anoynymousInfo;
 		union
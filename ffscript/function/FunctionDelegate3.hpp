@@ -19,6 +19,7 @@
 #include "DynamicFunction2.h"
 #include "MemberTypeInfo.hpp"
 #include <tuple>
+#include <utility>
 
 namespace FunctionInvoker3 {
 	using namespace FT;
@@ -271,4 +272,35 @@ namespace FT {
 			return funcObj;
 		}
 	};
+
+	// function object of a target known at compile time, it reads the arguments
+	// at their offsets and calls the target directly instead of through a pointer
+	template <class Fx, Fx fx>
+	class StaticFunctionDelegate3;
+
+	template <class Ret, class...Types, Ret(*fx)(Types...)>
+	class StaticFunctionDelegate3<Ret(*)(Types...), fx> : public DFunction2 {
+		typedef MemberTypeInfo<0, ARG_ALIGMENT_SIZE, Types...> Helper;
+		typedef typename real_type<Ret>::_T RRT;
+		typedef RRT(*Fp)(typename real_type<Types>::_T...);
+
+		template <std::size_t... I>
+		static void invoke(void* pRet, char* args, std::index_sequence<I...>, std::false_type) {
+			*((RRT*)pRet) = ((Fp)fx)(*((typename real_type<Types>::_T*)&args[ARG_OFFSET(I)])...);
+		}
+
+		template <std::size_t... I>
+		static void invoke(void* pRet, char* args, std::index_sequence<I...>, std::true_type) {
+			((Fp)fx)(*((typename real_type<Types>::_T*)&args[ARG_OFFSET(I)])...);
+		}
+	public:
+		static constexpr int paramCount = sizeof...(Types);
+
+		void call(void* pReturnVal, void* params[]) {
+			invoke(pReturnVal, (char*)params, std::index_sequence_for<Types...>(), std::is_void<Ret>());
+		}
+		DFunction2* clone() {
+			return new StaticFunctionDelegate3<Ret(*)(Types...), fx>();
+		}
+	};
 }
\ No newline at end of file
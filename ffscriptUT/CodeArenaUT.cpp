@@ -0,0 +1,102 @@
+/******************************************************************
+* File:        CodeArenaUT.cpp
+* Description: Test cases for keeping code objects of programs in
+*              their code arenas.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include "fftest.hpp"
+
+#include <CompilerSuite.h>
+#include <ScriptTask.h>
+#include <Program.h>
+#include <CodeArena.h>
+#include <MemoryBlock.h>
+
+using namespace std;
+using namespace ffscript;
+
+namespace ffscriptUT
+{
+	namespace CodeArenaUT
+	{
+		FF_TEST_FUNCTION(CodeArena, AllocateInChunks)
+		{
+			CodeArena arena(1024);
+			char* block1 = (char*)arena.allocate(10);
+			char* block2 = (char*)arena.allocate(20);
+			FF_EXPECT_TRUE(block2 > block1 && block2 - block1 < 64, L"small blocks must be allocated next to each other");
+			FF_EXPECT_EQ(1, arena.getChunkCount(), L"small blocks must be allocated in same chunk");
+
+			// a big block has its own chunk, the current chunk is still used
+			arena.allocate(4096);
+			char* block3 = (char*)arena.allocate(8);
+			FF_EXPECT_EQ(2, arena.getChunkCount(), L"big block must be allocated in its own chunk");
+			FF_EXPECT_TRUE(block3 > block2 && block3 - block2 < 64, L"current chunk must be used after a big block");
+
+			// objects created out of an arena are in the heap
+			size_t allocatedSize = arena.getAllocatedSize();
+			{
+				unique_ptr<MemoryBlock> heapBlock(new BufferBlock(16));
+				FF_EXPECT_TRUE(arena.getAllocatedSize() == allocatedSize, L"block must not be allocated in an arena that is not current");
+			}
+			{
+				CodeArenaScope arenaScope(&arena);
+				FF_EXPECT_TRUE(CodeArena::getCurrent() == &arena, L"arena scope must make the arena current");
+				unique_ptr<MemoryBlock> arenaBlock(new BufferBlock(16));
+				FF_EXPECT_TRUE(arena.getAllocatedSize() > allocatedSize, L"block must be allocated in current arena");
+			}
+			FF_EXPECT_TRUE(CodeArena::getCurrent() == nullptr, L"arena scope must restore previous arena");
+		}
+
+		FF_TEST_FUNCTION(CodeArena, KeepCodeOfProgram)
+		{
+			const wchar_t* scriptCode =
+				L"int test(int a) {"
+				L"	int b = a * 2 + 1;"
+				L"	if(b > 10) {"
+				L"		b = b - 10;"
+				L"	}"
+				L"	return b;"
+				L"}"
+				;
+
+			// compile and discard programs many times
+			for (int i = 0; i < 50; i++) {
+				CompilerSuite compiler;
+				compiler.initialize(8);
+				auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+				// scopes of the compiler still keep executors of the program after
+				// the program is destroyed, so the arena must live until they are released
+				unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+				FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+				FF_EXPECT_TRUE(program->getCodeArena()->getAllocatedSize() > 0, L"code of program must be allocated in its arena");
+				FF_EXPECT_TRUE(CodeArena::getCurrent() == nullptr, L"arena of program must not be current after compiling");
+
+				int functionId = scriptCompiler->findFunction("test", "int");
+				FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'test'");
+
+				ScriptParamBuffer paramBuffer(i);
+				ScriptTask scriptTask(program.get());
+				scriptTask.runFunction(functionId, &paramBuffer);
+				int expected = i * 2 + 1;
+				if (expected > 10) {
+					expected -= 10;
+				}
+				FF_EXPECT_EQ(expected, *(int*)scriptTask.getTaskResult(), L"function in arena returns wrong value");
+
+				// laying out the code again reuses the code array of the program
+				size_t allocatedSize = program->getCodeArena()->getAllocatedSize();
+				auto firstCommand = program->getFirstCommand();
+				program->convertToPlainCode();
+				FF_EXPECT_TRUE(firstCommand == program->getFirstCommand(), L"code array must be reused");
+				FF_EXPECT_TRUE(allocatedSize == program->getCodeArena()->getAllocatedSize(), L"code array must not be allocated again");
+			}
+		}
+	}
+}
@@ -0,0 +1,147 @@
+/******************************************************************
+* File:        CompareAndJumpUT.cpp
+* Description: Test cases for conditions of if and while statements
+*              those are tested and jumped by a single command.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include "fftest.hpp"
+
+#include <CompilerSuite.h>
+#include <ScriptTask.h>
+#include <Program.h>
+#include <GlobalScope.h>
+#include <CompareAndJump.h>
+#include <typeinfo>
+
+using namespace std;
+using namespace ffscript;
+
+namespace ffscriptUT
+{
+	namespace CompareAndJumpUT
+	{
+		static int countCompareAndJump(Program* program) {
+			int count = 0;
+			for (auto command = program->getFirstCommand(); command != program->getEndCommand(); command++) {
+				if (typeid(**command) == typeid(CompareAndJump)) {
+					count++;
+				}
+			}
+			return count;
+		}
+
+		FF_TEST_FUNCTION(CompareAndJump, FuseComparisonConditions)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			const wchar_t* scriptCode =
+				L"void addTo(int& s, int n) {"
+				L"	int i = 0;"
+				L"	while(i < n) {"
+				L"		s = s + i;"
+				L"		i += 1;"
+				L"	}"
+				L"	if(s != 0) {"
+				L"		s = s + 1000;"
+				L"	}"
+				L"}"
+				L"int test(int n) {"
+				L"	int s = 0;"
+				L"	int k = 0;"
+				L"	double d = 0.5;"
+				L"	while(10 > k) {"
+				L"		k += 1;"
+				L"		if(d < 2.0) {"
+				L"			d += 0.5;"
+				L"		}"
+				L"		else {"
+				L"			s += 100;"
+				L"		}"
+				L"		if(k == 5) {"
+				L"			continue;"
+				L"		}"
+				L"		s += k;"
+				L"	}"
+				L"	addTo(s, n);"
+				L"	return s;"
+				L"}"
+				;
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+			// two commands for each while statement and one command for each if statement,
+			// except the condition of 's' in 'addTo', it is read through a reference
+			FF_EXPECT_EQ(6, countCompareAndJump(program.get()), L"comparison conditions must be fused");
+
+			int functionId = scriptCompiler->findFunction("test", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'test'");
+
+			const int n = 20;
+			int expected = (55 - 5) + 100 * 7 + n * (n - 1) / 2 + 1000;
+			ExecutionMode modes[] = { ExecutionMode::Interpreter, ExecutionMode::ThreadedCode };
+			for (auto mode : modes) {
+				program->setExecutionMode(mode);
+				ScriptParamBuffer paramBuffer(n);
+				ScriptTask scriptTask(program.get());
+				scriptTask.runFunction(functionId, &paramBuffer);
+				FF_EXPECT_EQ(expected, *(int*)scriptTask.getTaskResult(), L"fused conditions return wrong value");
+
+				// the loop in 'addTo' is not run
+				ScriptParamBuffer zeroBuffer(0);
+				scriptTask.runFunction(functionId, &zeroBuffer);
+				FF_EXPECT_EQ(expected - n * (n - 1) / 2, *(int*)scriptTask.getTaskResult(), L"fused conditions return wrong value");
+			}
+		}
+
+		FF_TEST_FUNCTION(CompareAndJump, KeepOtherConditions)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			const wchar_t* scriptCode =
+				L"bool isSmall(int x) {"
+				L"	bool res = x < 3;"
+				L"	return res;"
+				L"}"
+				L"int test(int n) {"
+				L"	int s = 0;"
+				L"	int i = 0;"
+				L"	bool run = true;"
+				L"	while(run) {"
+				L"		if(isSmall(i)) {"
+				L"			s += 10;"
+				L"		}"
+				L"		if(i < n && s > 0) {"
+				L"			s += 1;"
+				L"		}"
+				L"		i += 1;"
+				L"		run = i < n;"
+				L"	}"
+				L"	return s;"
+				L"}"
+				;
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+			// conditions those are not a single comparison are tested by jump commands
+			FF_EXPECT_EQ(0, countCompareAndJump(program.get()), L"only comparison conditions can be fused");
+
+			int functionId = scriptCompiler->findFunction("test", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'test'");
+
+			const int n = 10;
+			ScriptParamBuffer paramBuffer(n);
+			ScriptTask scriptTask(program.get());
+			scriptTask.runFunction(functionId, &paramBuffer);
+			FF_EXPECT_EQ(3 * 10 + n, *(int*)scriptTask.getTaskResult(), L"program returns wrong value");
+		}
+	}
+}
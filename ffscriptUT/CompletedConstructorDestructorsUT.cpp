@@ -1798,5 +1798,98 @@ namespace ffscriptUT
 			EXPECT_EQ(2, intDestructorCounter.getCount()) << L"Destrutor is run but result is not correct";
 			EXPECT_EQ(2, intCopyConstructorCounter.getCount()) << L"copy constructor is run but result is not correct";
 		}
+
+		TEST_F(CompletedConstructorDestructors, ManyObjectsInScope)
+		{
+			GlobalScopeRef rootScope = compiler.getGlobalScope();
+
+			ExcutionCounter constructorCounter, destructorCounter;
+			registerConstructor(&constructorCounter, typePoint.iType());
+			registerDestructor(&destructorCounter, typePoint.iType());
+
+			// more than 8 objects in a scope need more than one byte to mark their constructors
+			const wchar_t scriptCode[] =
+				L"void foo(bool early) {"
+				L"	Point p1;"
+				L"	if(early) {"
+				L"		return;"
+				L"	}"
+				L"	Point p2; Point p3; Point p4; Point p5; Point p6;"
+				L"	Point p7; Point p8; Point p9; Point p10;"
+				L"}"
+				;
+
+			scriptCompiler->beginUserLib();
+
+			auto program = compiler.compileProgram(scriptCode, scriptCode + sizeof(scriptCode) / sizeof(scriptCode[0]) - 1);
+			EXPECT_NE(nullptr, program) << L"Compile program failed";
+
+			int functionId = scriptCompiler->findFunction("foo", "bool");
+			EXPECT_TRUE(functionId >= 0) << L"cannot find function 'foo'";
+
+			ScriptParamBuffer earlyParam(true);
+			ScriptParamBuffer normalParam(false);
+			ScriptTask scriptTask(program);
+
+			// run several times to make sure the context is clean after each run
+			for (int i = 0; i < 3; i++) {
+				constructorCounter.resetCount();
+				destructorCounter.resetCount();
+
+				scriptTask.runFunction(functionId, &earlyParam);
+
+				// only objects those were constructed are destroyed when the function returns early
+				EXPECT_EQ(1, constructorCounter.getCount()) << L"Construtor is run but result is not correct";
+				EXPECT_EQ(1, destructorCounter.getCount()) << L"Destrutor is run but result is not correct";
+
+				constructorCounter.resetCount();
+				destructorCounter.resetCount();
+
+				scriptTask.runFunction(functionId, &normalParam);
+
+				EXPECT_EQ(10, constructorCounter.getCount()) << L"Construtor is run but result is not correct";
+				EXPECT_EQ(10, destructorCounter.getCount()) << L"Destrutor is run but result is not correct";
+			}
+		}
+
+		TEST_F(CompletedConstructorDestructors, DeepRecursionWithManyObjects)
+		{
+			ExcutionCounter constructorCounter, destructorCounter;
+			registerConstructor(&constructorCounter, typePoint.iType());
+			registerDestructor(&destructorCounter, typePoint.iType());
+
+			// constructor bitmaps of all running calls do not fit in the buffer of the context
+			const wchar_t scriptCode[] =
+				L"void foo(int n) {"
+				L"	Point p1; Point p2; Point p3; Point p4; Point p5; Point p6;"
+				L"	Point p7; Point p8; Point p9; Point p10; Point p11; Point p12;"
+				L"	Point p13; Point p14; Point p15; Point p16; Point p17;"
+				L"	if(n > 0) {"
+				L"		foo(n - 1);"
+				L"	}"
+				L"}"
+				;
+
+			scriptCompiler->beginUserLib();
+
+			auto program = compiler.compileProgram(scriptCode, scriptCode + sizeof(scriptCode) / sizeof(scriptCode[0]) - 1);
+			EXPECT_NE(nullptr, program) << L"Compile program failed";
+
+			int functionId = scriptCompiler->findFunction("foo", "int");
+			EXPECT_TRUE(functionId >= 0) << L"cannot find function 'foo'";
+
+			const int depth = 1500;
+			ScriptParamBuffer paramBuffer(depth - 1);
+			ScriptTask scriptTask(program);
+			for (int i = 0; i < 2; i++) {
+				constructorCounter.resetCount();
+				destructorCounter.resetCount();
+
+				scriptTask.runFunction(1024 * 1024, functionId, &paramBuffer);
+
+				EXPECT_EQ(17 * depth, constructorCounter.getCount()) << L"Construtor is run but result is not correct";
+				EXPECT_EQ(17 * depth, destructorCounter.getCount()) << L"Destrutor is run but result is not correct";
+			}
+		}
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,125 @@
+/******************************************************************
+* File:        ConstantFoldingUT.cpp
+* Description: Test cases for folding constant expressions and
+*              pruning if branches those have constant conditions.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include "fftest.hpp"
+
+#include "ExpresionParser.h"
+#include "FunctionRegisterHelper.h"
+#include "BasicFunction.h"
+#include "BasicType.h"
+#include "ScriptCompiler.h"
+#include "Expression.h"
+#include "ExpressionOptimizer.h"
+#include <CompilerSuite.h>
+#include <ScriptTask.h>
+#include <Program.h>
+
+using namespace std;
+using namespace ffscript;
+
+namespace ffscriptUT
+{
+	namespace ConstantFoldingUT
+	{
+		static ExecutableUnitRef compileAndFold(ScriptCompiler* scriptCompiler, const wchar_t* expression) {
+			ExpressionParser parser(scriptCompiler);
+			list<ExpUnitRef> units;
+			EExpressionResult eResult = parser.tokenize(expression, units);
+			FF_EXPECT_TRUE(eResult == EE_SUCCESS, L"parse string to units failed");
+
+			list<ExpressionRef> expList;
+			bool res = parser.compile(units, expList);
+			FF_EXPECT_TRUE(res, L"compile expression failed");
+
+			eResult = parser.link(expList.front().get());
+			FF_EXPECT_TRUE(eResult == EE_SUCCESS, L"link expression failed");
+
+			ExpressionOptimizer optimizer(scriptCompiler);
+			ExecutableUnitRef root = expList.front()->getRoot();
+			optimizer.foldConstants(root);
+
+			return root;
+		}
+
+		FF_TEST_FUNCTION(ConstantFolding, FoldOperators)
+		{
+			ScriptCompiler scriptCompiler;
+			FunctionRegisterHelper funcLibHelper(&scriptCompiler);
+			scriptCompiler.getTypeManager()->registerBasicTypes(&scriptCompiler);
+			scriptCompiler.getTypeManager()->registerBasicTypeCastFunctions(&scriptCompiler, funcLibHelper);
+			importBasicfunction(funcLibHelper);
+
+			auto root = compileAndFold(&scriptCompiler, L"(1 + 2) * 3 - 10 / 4");
+			FF_EXPECT_TRUE(root->getType() == EXP_UNIT_ID_CONST, L"'(1 + 2) * 3 - 10 / 4' must be folded");
+			FF_EXPECT_EQ(7, *(int*)root->Execute(), L"'(1 + 2) * 3 - 10 / 4' must be folded to 7");
+
+			root = compileAndFold(&scriptCompiler, L"1.5 * 2.0 < 2.5");
+			FF_EXPECT_TRUE(root->getType() == EXP_UNIT_ID_CONST, L"'1.5 * 2.0 < 2.5' must be folded");
+			FF_EXPECT_FALSE(*(bool*)root->Execute(), L"'1.5 * 2.0 < 2.5' must be folded to false");
+
+			// division by zero must be kept to run time
+			root = compileAndFold(&scriptCompiler, L"1 / 0");
+			FF_EXPECT_TRUE(root->getType() != EXP_UNIT_ID_CONST, L"'1 / 0' must not be folded");
+		}
+
+		FF_TEST_FUNCTION(ConstantFolding, RunFoldedProgram)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			const wchar_t* scriptCode =
+				L"double circle(double r) {"
+				L"	return 2 * 3.5 * r + (1 + 2) * 4;"
+				L"}"
+				L"int branches(int a) {"
+				L"	int b = 0;"
+				L"	if(1 > 2) {"
+				L"		b = 100;"
+				L"	}"
+				L"	else {"
+				L"		b = a * 2;"
+				L"	}"
+				L"	if(2 < 3) {"
+				L"		b = b + 1;"
+				L"	}"
+				L"	if(false) {"
+				L"		return -1;"
+				L"	}"
+				L"	return b;"
+				L"}"
+				;
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int functionId = scriptCompiler->findFunction("circle", "double");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'circle'");
+			{
+				double r = 1.5;
+				ScriptParamBuffer paramBuffer(r);
+				ScriptTask scriptTask(program.get());
+				scriptTask.runFunction(functionId, &paramBuffer);
+				FF_EXPECT_EQ(2 * 3.5 * r + (1 + 2) * 4, *(double*)scriptTask.getTaskResult(), L"folded expression returns wrong value");
+			}
+
+			functionId = scriptCompiler->findFunction("branches", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'branches'");
+			{
+				int a = 5;
+				ScriptParamBuffer paramBuffer(a);
+				ScriptTask scriptTask(program.get());
+				scriptTask.runFunction(functionId, &paramBuffer);
+				FF_EXPECT_EQ(a * 2 + 1, *(int*)scriptTask.getTaskResult(), L"constant conditions select wrong branches");
+			}
+		}
+	}
+}
@@ -0,0 +1,115 @@
+/******************************************************************
+* File:        ContextPoolUT.cpp
+* Description: Test cases for running functions of a program on
+*              contexts and runners those are reused by a pool.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include "fftest.hpp"
+
+#include <CompilerSuite.h>
+#include <ScriptTask.h>
+#include <Program.h>
+#include <ContextPool.h>
+#include <thread>
+
+using namespace std;
+using namespace ffscript;
+
+namespace ffscriptUT
+{
+	namespace ContextPoolUT
+	{
+		static const wchar_t* scriptCode =
+			L"int sum(int n) {"
+			L"	int res = 0;"
+			L"	while(n > 0) {"
+			L"		res += n;"
+			L"		n--;"
+			L"	}"
+			L"	return res;"
+			L"}"
+			L"double half(double x) {"
+			L"	return x / 2;"
+			L"}"
+			;
+
+		FF_TEST_FUNCTION(ContextPool, ReuseContextsAndRunners)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int sumId = scriptCompiler->findFunction("sum", "int");
+			FF_EXPECT_TRUE(sumId >= 0, L"cannot find function 'sum'");
+			int halfId = scriptCompiler->findFunction("half", "double");
+			FF_EXPECT_TRUE(halfId >= 0, L"cannot find function 'half'");
+
+			Context::makeCurrent(nullptr);
+			ContextPool pool(program.get(), 64 * 1024, 1);
+			FF_EXPECT_TRUE(Context::getCurrent() == nullptr, L"preparing contexts must not change current context of the thread");
+			FF_EXPECT_EQ(1, pool.getContextCount(), L"pool must prepare contexts when it is created");
+
+			for (int i = 0; i < 10; i++) {
+				FF_EXPECT_EQ(55, pool.invoke<int>(sumId, 10), L"function in pool returns wrong value");
+				FF_EXPECT_EQ(1.5, pool.invoke<double>(halfId, 3.0), L"function in pool returns wrong value");
+			}
+			FF_EXPECT_EQ(1, pool.getContextCount(), L"sequential calls must reuse same context");
+			FF_EXPECT_TRUE(pool.getRunner(sumId) == pool.getRunner(sumId), L"runner of a function must be cached");
+
+			{
+				// a context in use is not given to another caller
+				PooledContext context1(&pool);
+				PooledContext context2(&pool);
+				FF_EXPECT_TRUE(context1.get() != context2.get(), L"a context is acquired twice");
+				FF_EXPECT_EQ(2, pool.getContextCount(), L"pool must create a context when all contexts are in use");
+			}
+			FF_EXPECT_EQ(55, pool.invoke<int>(sumId, 10), L"function in pool returns wrong value");
+			FF_EXPECT_EQ(2, pool.getContextCount(), L"released contexts must be reused");
+		}
+
+		FF_TEST_FUNCTION(ContextPool, CallFromManyThreads)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int sumId = scriptCompiler->findFunction("sum", "int");
+			FF_EXPECT_TRUE(sumId >= 0, L"cannot find function 'sum'");
+
+			const int threadCount = 4;
+			ContextPool pool(program.get(), 64 * 1024, threadCount);
+			int wrongResults[threadCount] = { 0 };
+
+			vector<thread> threads;
+			for (int i = 0; i < threadCount; i++) {
+				threads.emplace_back([&pool, &wrongResults, sumId, i]() {
+					for (int n = 0; n < 1000; n++) {
+						int arg = n % 100;
+						if (pool.invoke<int>(sumId, arg) != arg * (arg + 1) / 2) {
+							wrongResults[i]++;
+						}
+					}
+				});
+			}
+			for (auto& t : threads) {
+				t.join();
+			}
+
+			for (int i = 0; i < threadCount; i++) {
+				FF_EXPECT_EQ(0, wrongResults[i], L"function in pool returns wrong value in a thread");
+			}
+			FF_EXPECT_TRUE(pool.getContextCount() <= threadCount, L"pool creates more contexts than callers");
+		}
+	}
+}
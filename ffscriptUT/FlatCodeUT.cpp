@@ -0,0 +1,323 @@
+/******************************************************************
+* File:        FlatCodeUT.cpp
+* Description: Test cases for running command trees those were
+*              flattened into linear sequences of records.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include "fftest.hpp"
+
+#include <CompilerSuite.h>
+#include <ScriptTask.h>
+#include <Program.h>
+#include <FlatCode.h>
+#include <sstream>
+
+using namespace std;
+using namespace ffscript;
+
+namespace ffscriptUT
+{
+	namespace FlatCodeUT
+	{
+		static const wchar_t* scriptCode =
+			L"int select(int a, int b) {"
+			L"	return a > b ? a - b : (a < b ? b - a : 0);"
+			L"}"
+			L"bool inRange(int a, double b) {"
+			L"	return (a > 0 && a < 10) || (b > 100.0 && a != 0);"
+			L"}"
+			L"bool mixedLogic(int a, double b) {"
+			L"	return a || b;"
+			L"}"
+			L"int sumArray(int n) {"
+			L"	array<int,10> values;"
+			L"	int i = 0;"
+			L"	while(i < 10) {"
+			L"		values[i] = i * n;"
+			L"		i++;"
+			L"	}"
+			L"	return values[2] + values[i - 1] * (n > 1 ? 2 : 1);"
+			L"}"
+			;
+
+		static int select(int a, int b) {
+			return a > b ? a - b : (a < b ? b - a : 0);
+		}
+
+		static bool inRange(int a, double b) {
+			return (a > 0 && a < 10) || (b > 100.0 && a != 0);
+		}
+
+		static int sumArray(int n) {
+			int values[10];
+			int i = 0;
+			while (i < 10) {
+				values[i] = i * n;
+				i++;
+			}
+			return values[2] + values[i - 1] * (n > 1 ? 2 : 1);
+		}
+
+		FF_TEST_FUNCTION(FlatCode, RunFlattenedTrees)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			auto flatCode = program->getFlatCode();
+			FF_EXPECT_TRUE(flatCode != nullptr, L"command trees of program must be flattened");
+			FF_EXPECT_TRUE(flatCode->getFlatCommandCount() > 0, L"no command tree was flattened");
+
+			int functionId = scriptCompiler->findFunction("select", "int,int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'select'");
+			int args[][2] = { { 7, 3 },{ 3, 7 },{ 5, 5 } };
+			for (auto& arg : args) {
+				ScriptParamBuffer paramBuffer(arg[0]);
+				paramBuffer.addParam(arg[1]);
+				ScriptTask scriptTask(program.get());
+				scriptTask.runFunction(functionId, &paramBuffer);
+				FF_EXPECT_EQ(select(arg[0], arg[1]), *(int*)scriptTask.getTaskResult(), L"flattened conditional operator returns wrong value");
+			}
+
+			functionId = scriptCompiler->findFunction("inRange", "int,double");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'inRange'");
+			int intArgs[] = { 0, 5, 10, 20 };
+			double doubleArgs[] = { 0.0, 200.0 };
+			for (int a : intArgs) {
+				for (double b : doubleArgs) {
+					ScriptParamBuffer paramBuffer(a);
+					paramBuffer.addParam(b);
+					ScriptTask scriptTask(program.get());
+					scriptTask.runFunction(functionId, &paramBuffer);
+					FF_EXPECT_EQ(inRange(a, b), *(bool*)scriptTask.getTaskResult(), L"flattened logic operators return wrong value");
+				}
+			}
+
+			functionId = scriptCompiler->findFunction("sumArray", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'sumArray'");
+			for (int n = 0; n < 3; n++) {
+				ScriptParamBuffer paramBuffer(n);
+				ScriptTask scriptTask(program.get());
+				scriptTask.runFunction(functionId, &paramBuffer);
+				FF_EXPECT_EQ(sumArray(n), *(int*)scriptTask.getTaskResult(), L"flattened element access returns wrong value");
+			}
+		}
+
+		FF_TEST_FUNCTION(FlatCode, LogicOperatorsOfMixedTypes)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int functionId = scriptCompiler->findFunction("mixedLogic", "int,double");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'mixedLogic'");
+
+			// second param must be read by its own type
+			int intArgs[] = { 0, 3 };
+			double doubleArgs[] = { 0.0, 0.5 };
+			for (int a : intArgs) {
+				for (double b : doubleArgs) {
+					ScriptParamBuffer paramBuffer(a);
+					paramBuffer.addParam(b);
+					ScriptTask scriptTask(program.get());
+					scriptTask.runFunction(functionId, &paramBuffer);
+					FF_EXPECT_EQ(a || b, *(bool*)scriptTask.getTaskResult(), L"logic operator of mixed types returns wrong value");
+				}
+			}
+		}
+
+		FF_TEST_FUNCTION(FlatCode, EnterFunctionsInSameLoop)
+		{
+			const wchar_t* recursiveCode =
+				L"int depth(int n) {"
+				L"	if(n == 0) {"
+				L"		return 0;"
+				L"	}"
+				L"	int r = depth(n - 1);"
+				L"	return r + 1;"
+				L"}"
+				L"int fact(int n) {"
+				L"	if(n <= 1) {"
+				L"		return 1;"
+				L"	}"
+				L"	return n * fact(n - 1);"
+				L"}"
+				L"int sumTo(int n) {"
+				L"	if(n == 0) {"
+				L"		return 0;"
+				L"	}"
+				L"	return sumTo(n - 1) + n;"
+				L"}"
+				L"int count(int n) {"
+				L"	return n > 0 ? count(n - 1) + 1 : 0;"
+				L"}"
+				;
+
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			unique_ptr<Program> program(compiler.compileProgram(recursiveCode, recursiveCode + wcslen(recursiveCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			// calls at the end of statements are run by the loop of the caller
+			int functionId = scriptCompiler->findFunction("depth", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'depth'");
+			int depths[] = { 0, 1, 10, 3000 };
+			for (int n : depths) {
+				ScriptParamBuffer paramBuffer(n);
+				ScriptTask scriptTask(program.get());
+				scriptTask.runFunction(functionId, &paramBuffer);
+				FF_EXPECT_EQ(n, *(int*)scriptTask.getTaskResult(), L"recursive function returns wrong value");
+			}
+
+			// calls inside expressions are entered too, the expression continues when they return
+			functionId = scriptCompiler->findFunction("fact", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'fact'");
+			ScriptParamBuffer paramBuffer(10);
+			ScriptTask scriptTask(program.get());
+			scriptTask.runFunction(functionId, &paramBuffer);
+			FF_EXPECT_EQ(3628800, *(int*)scriptTask.getTaskResult(), L"recursive function in expression returns wrong value");
+
+			ExecutionMode modes[] = { ExecutionMode::Interpreter, ExecutionMode::ThreadedCode };
+			for (auto mode : modes) {
+				program->setExecutionMode(mode);
+				int sumToId = scriptCompiler->findFunction("sumTo", "int");
+				int countId = scriptCompiler->findFunction("count", "int");
+				FF_EXPECT_TRUE(sumToId >= 0 && countId >= 0, L"cannot find recursive functions");
+				for (int n : depths) {
+					ScriptParamBuffer depthParam(n);
+					ScriptTask depthTask(program.get());
+					depthTask.runFunction(sumToId, &depthParam);
+					FF_EXPECT_EQ(n * (n + 1) / 2, *(int*)depthTask.getTaskResult(), L"recursive call in expression returns wrong value");
+					depthTask.runFunction(countId, &depthParam);
+					FF_EXPECT_EQ(n, *(int*)depthTask.getTaskResult(), L"recursive call in conditional operator returns wrong value");
+				}
+			}
+		}
+
+		FF_TEST_FUNCTION(FlatCode, TailCallsReuseFrame)
+		{
+			const wchar_t* tailCode =
+				L"int countTail(int n, int acc) {"
+				L"	if(n == 0) {"
+				L"		return acc;"
+				L"	}"
+				L"	return countTail(n - 1, acc + 1);"
+				L"}"
+				L"double halfTail(int n, double acc) {"
+				L"	if(n == 0) {"
+				L"		return acc;"
+				L"	}"
+				L"	int next = n - 1;"
+				L"	return halfTail(next, acc + 0.5);"
+				L"}"
+				;
+
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			unique_ptr<Program> program(compiler.compileProgram(tailCode, tailCode + wcslen(tailCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int countTailId = scriptCompiler->findFunction("countTail", "int,int");
+			int halfTailId = scriptCompiler->findFunction("halfTail", "int,double");
+			FF_EXPECT_TRUE(countTailId >= 0 && halfTailId >= 0, L"cannot find tail recursive functions");
+
+			// the deepest calls overflow the stack of the task if frames are not reused
+			int depths[] = { 0, 1, 10, 1000000 };
+			ExecutionMode modes[] = { ExecutionMode::Interpreter, ExecutionMode::ThreadedCode };
+			for (auto mode : modes) {
+				program->setExecutionMode(mode);
+				for (int n : depths) {
+					ScriptParamBuffer countParam(n);
+					countParam.addParam(0);
+					ScriptTask countTask(program.get());
+					countTask.runFunction(countTailId, &countParam);
+					FF_EXPECT_EQ(n, *(int*)countTask.getTaskResult(), L"tail call returns wrong value");
+
+					ScriptParamBuffer halfParam(n);
+					halfParam.addParam(1.0);
+					ScriptTask halfTask(program.get());
+					halfTask.runFunction(halfTailId, &halfParam);
+					FF_EXPECT_EQ(1.0 + n * 0.5, *(double*)halfTask.getTaskResult(), L"tail call from nested scope returns wrong value");
+				}
+			}
+		}
+
+		FF_TEST_FUNCTION(FlatCode, FuseByProfile)
+		{
+			const wchar_t* loopCode =
+				L"int loop(int n) {"
+				L"	int s = 0;"
+				L"	int i = 0;"
+				L"	while(i < n) {"
+				L"		s += i * 2;"
+				L"		i += 1;"
+				L"	}"
+				L"	return s;"
+				L"}"
+				;
+
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			unique_ptr<Program> program(compiler.compileProgram(loopCode, loopCode + wcslen(loopCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+			int functionId = scriptCompiler->findFunction("loop", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'loop'");
+
+			auto runLoop = [&](int n) {
+				ScriptParamBuffer paramBuffer(n);
+				ScriptTask scriptTask(program.get());
+				scriptTask.runFunction(functionId, &paramBuffer);
+				FF_EXPECT_EQ(n * (n - 1), *(int*)scriptTask.getTaskResult(), L"fused code returns wrong value");
+			};
+
+			// the default table fuses constant operands of 'i += 1' and 's += i * 2'
+			auto flatCode = program->getFlatCode();
+			FF_EXPECT_TRUE(flatCode->getFusedCount() > 0, L"default table must fuse the loop");
+			runLoop(100);
+
+			// count patterns in counting mode
+			FlatProfile profile;
+			program->fuseFlatCode(FusionTable::getDefault(), &profile);
+			FF_EXPECT_EQ(0, flatCode->getFusedCount(), L"nothing is fused in counting mode");
+			runLoop(100);
+			FusionPattern constOperand = { FlatOpCode::PushParam, FlatCommandKind::NativeOperator };
+			FF_EXPECT_TRUE(profile.getCount(constOperand) >= 200, L"patterns in the loop must be counted");
+
+			// the profile can be saved and used later
+			std::stringstream stream;
+			profile.save(stream);
+			FlatProfile loadedProfile;
+			FF_EXPECT_TRUE(loadedProfile.load(stream), L"load profile failed");
+			FF_EXPECT_EQ(profile.getCount(constOperand), loadedProfile.getCount(constOperand), L"loaded profile is mismatch with saved profile");
+
+			FusionTable fusionTable;
+			loadedProfile.buildFusionTable(fusionTable, 100);
+			FF_EXPECT_TRUE(fusionTable.contains(constOperand), L"frequent pattern must be in the table");
+			program->fuseFlatCode(fusionTable);
+			FF_EXPECT_TRUE(flatCode->getFusedCount() > 0, L"table of profile must fuse the loop");
+			runLoop(100);
+
+			// an empty table only lowers push commands
+			program->fuseFlatCode(FusionTable());
+			FF_EXPECT_EQ(0, flatCode->getFusedCount(), L"empty table must not fuse anything");
+			runLoop(10);
+		}
+	}
+}
@@ -663,5 +663,53 @@ namespace ffscriptUT
 
 			FF_EXPECT_FALSE(*funcRes, (L"program can run but return wrong value: " + std::to_wstring(*s)).c_str());
 		}
+
+		FF_TEST_FUNCTION(FunctionPointer, CallInLoop)
+		{
+			CompilerSuite compiler;
+
+			//the code does not contain any global scope'code and only a variable
+			//so does not need global memory
+			compiler.initialize(8);
+			GlobalScopeRef rootScope = compiler.getGlobalScope();
+			auto scriptCompiler = rootScope->getCompiler();
+			FunctionRegisterHelper funcLibHelper(scriptCompiler);
+			funcLibHelper.registFunction("test", "int", new BasicFunctionFactory<4>(EXP_UNIT_ID_USER_FUNC, FUNCTION_PRIORITY_USER_FUNCTION, "int", new FT::FunctionDelegate3<int, int>(test), scriptCompiler), true);
+
+			const wchar_t* scriptCode =
+				L"int twice(int a) {"
+				L"	return a * 2;"
+				L"}"
+				L"int foo() {"
+				L"	function<int(int)> f1 = test;"
+				L"	function<int(int)> f2 = twice;"
+				L"	int sum = 0;"
+				L"	int i = 0;"
+				L"	while(i < 1000) {"
+				L"		sum = sum + f1(i) + f2(i);"
+				L"		i++;"
+				L"	}"
+				L"	return sum;"
+				L"}"
+				;
+
+			scriptCompiler->beginUserLib();
+			Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+			FF_EXPECT_NE(nullptr, program, L"Compile program failed");
+
+			int functionId = scriptCompiler->findFunction("foo", "");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'foo'");
+
+			int expected = 0;
+			for (int i = 0; i < 1000; i++) {
+				expected += test(i) + i * 2;
+			}
+
+			ScriptTask scriptTask(program);
+			scriptTask.runFunction(functionId, nullptr);
+			int* funcRes = (int*)scriptTask.getTaskResult();
+
+			FF_EXPECT_EQ(expected, *funcRes, L"function objects called in a loop return wrong value");
+		}
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,346 @@
+/******************************************************************
+* File:        IncrementalCompileUT.cpp
+* Description: Test cases for recompiling changed functions of a
+*              compiled program and swapping them into the program.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include "fftest.hpp"
+
+#include <CompilerSuite.h>
+#include <ScriptTask.h>
+#include <Program.h>
+#include <GlobalScope.h>
+#include <ProgramCache.h>
+#include <ContextPool.h>
+#include <FunctionRegisterHelper.h>
+#include <Utils.h>
+#include <sstream>
+
+using namespace std;
+using namespace ffscript;
+
+namespace ffscriptUT
+{
+	namespace IncrementalCompileUT
+	{
+		static const wchar_t* scriptCode =
+			L"int base = 1;"
+			L"int scale(int n) {"
+			L"	int r = n * 2;"
+			L"	return r;"
+			L"}"
+			L"int twice(int n) {"
+			L"	return n + n;"
+			L"}"
+			L"int sum(int n) {"
+			L"	int s = base;"
+			L"	int i = 1;"
+			L"	while(i <= n) {"
+			L"		s += scale(i);"
+			L"		i += 1;"
+			L"	}"
+			L"	return s;"
+			L"}"
+			;
+
+		// body of function 'scale' is changed
+		static const wchar_t* updatedCode =
+			L"int base = 1;"
+			L"int scale(int n) {"
+			L"	int r = n * 3;"
+			L"	if(r > 10) {"
+			L"		r = r + twice(n);"
+			L"	}"
+			L"	return r;"
+			L"}"
+			L"int twice(int n) {"
+			L"	return n + n;"
+			L"}"
+			L"int sum(int n) {"
+			L"	int s = base;"
+			L"	int i = 1;"
+			L"	while(i <= n) {"
+			L"		s += scale(i);"
+			L"		i += 1;"
+			L"	}"
+			L"	return s;"
+			L"}"
+			;
+
+		static int runFunction(ScriptTask& scriptTask, int functionId, int n) {
+			ScriptParamBuffer paramBuffer(n);
+			scriptTask.runFunction(functionId, &paramBuffer);
+			auto result = scriptTask.getTaskResult();
+			return result ? *(int*)result : 0;
+		}
+
+		static int updatedScale(int n) {
+			int r = n * 3;
+			return r > 10 ? r + n + n : r;
+		}
+
+		FF_TEST_FUNCTION(IncrementalCompile, UpdateChangedFunction)
+		{
+			ExecutionMode modes[] = { ExecutionMode::Interpreter, ExecutionMode::ThreadedCode };
+			for (auto mode : modes) {
+				CompilerSuite compiler;
+				compiler.initialize(1024);
+				auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+				scriptCompiler->beginUserLib();
+
+				unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+				FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+				program->setExecutionMode(mode);
+				compiler.getGlobalScope()->runGlobalCode();
+
+				int scaleId = scriptCompiler->findFunction("scale", "int");
+				int sumId = scriptCompiler->findFunction("sum", "int");
+				FF_EXPECT_TRUE(scaleId >= 0 && sumId >= 0, L"cannot find functions of the program");
+
+				ScriptTask oldTask(program.get());
+				FF_EXPECT_EQ(10, runFunction(oldTask, scaleId, 5), L"function 'scale' returns wrong value");
+				FF_EXPECT_EQ(1 + 2 + 4 + 6 + 8 + 10, runFunction(oldTask, sumId, 5), L"function 'sum' returns wrong value");
+
+				bool updated = compiler.updateProgram(program.get(), updatedCode, updatedCode + wcslen(updatedCode));
+				FF_EXPECT_TRUE(updated, convertToWstring(scriptCompiler->getLastError()).c_str());
+				FF_EXPECT_EQ(scaleId, scriptCompiler->findFunction("scale", "int"), L"recompiled function must keep its id");
+
+				// calls in the other functions are redirected to the new code
+				int expectedSum = 1;
+				for (int i = 1; i <= 5; i++) {
+					expectedSum += updatedScale(i);
+				}
+				ScriptTask newTask(program.get());
+				FF_EXPECT_EQ(updatedScale(5), runFunction(newTask, scaleId, 5), L"new task must run the new code");
+				FF_EXPECT_EQ(expectedSum, runFunction(newTask, sumId, 5), L"calls must be redirected to the new code");
+
+				// the task created before the update runs the new code too
+				FF_EXPECT_EQ(updatedScale(5), runFunction(oldTask, scaleId, 5), L"old task must run the new code");
+
+				// the program can be updated again
+				updated = compiler.updateProgram(program.get(), scriptCode, scriptCode + wcslen(scriptCode));
+				FF_EXPECT_TRUE(updated, convertToWstring(scriptCompiler->getLastError()).c_str());
+				ScriptTask restoredTask(program.get());
+				FF_EXPECT_EQ(1 + 2 + 4 + 6 + 8 + 10, runFunction(restoredTask, sumId, 5), L"function 'sum' returns wrong value");
+
+				stringstream cacheStream;
+				ProgramCache programCache(&compiler);
+				FF_EXPECT_TRUE(programCache.save(program.get(), cacheStream) == false, L"program with recompiled functions must not be saved");
+
+				compiler.getGlobalScope()->cleanupGlobalMemory();
+			}
+		}
+
+		FF_TEST_FUNCTION(IncrementalCompile, RejectOtherChanges)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(1024);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+			scriptCompiler->beginUserLib();
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+			compiler.getGlobalScope()->runGlobalCode();
+			int sumId = scriptCompiler->findFunction("sum", "int");
+
+			// a global variable is changed
+			wstring changedGlobal(scriptCode);
+			changedGlobal.replace(changedGlobal.find(L"base = 1"), 8, L"base = 2");
+			bool updated = compiler.updateProgram(program.get(), changedGlobal.c_str(), changedGlobal.c_str() + changedGlobal.size());
+			FF_EXPECT_TRUE(updated == false, L"changed global declarations must be compiled again");
+
+			// a small function may be inlined in its callers
+			wstring changedInlinable(scriptCode);
+			changedInlinable.replace(changedInlinable.find(L"n + n"), 5, L"n * 4");
+			updated = compiler.updateProgram(program.get(), changedInlinable.c_str(), changedInlinable.c_str() + changedInlinable.size());
+			FF_EXPECT_TRUE(updated == false, L"changed inlinable functions must be compiled again");
+
+			// a body cannot be compiled
+			wstring brokenBody(scriptCode);
+			brokenBody.replace(brokenBody.find(L"n * 2"), 5, L"n * ;");
+			updated = compiler.updateProgram(program.get(), brokenBody.c_str(), brokenBody.c_str() + brokenBody.size());
+			FF_EXPECT_TRUE(updated == false, L"body with errors must not be swapped in");
+
+			// the program still runs the code it was compiled with
+			ScriptTask scriptTask(program.get());
+			FF_EXPECT_EQ(1 + 2 + 4 + 6 + 8 + 10, runFunction(scriptTask, sumId, 5), L"function 'sum' returns wrong value");
+
+			compiler.getGlobalScope()->cleanupGlobalMemory();
+		}
+
+		FF_TEST_FUNCTION(IncrementalCompile, SwapAllOrNothing)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(1024);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+			scriptCompiler->beginUserLib();
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+			compiler.getGlobalScope()->runGlobalCode();
+			int scaleId = scriptCompiler->findFunction("scale", "int");
+			int sumId = scriptCompiler->findFunction("sum", "int");
+
+			// function 'scale' can be compiled but function 'sum' cannot
+			wstring changedCode(scriptCode);
+			changedCode.replace(changedCode.find(L"n * 2"), 5, L"n * 5");
+			changedCode.replace(changedCode.find(L"s += scale(i)"), 13, L"s += scale(i) *");
+			bool updated = compiler.updateProgram(program.get(), changedCode.c_str(), changedCode.c_str() + changedCode.size());
+			FF_EXPECT_TRUE(updated == false, L"body with errors must not be swapped in");
+
+			ScriptTask scriptTask(program.get());
+			FF_EXPECT_EQ(10, runFunction(scriptTask, scaleId, 5), L"no function must be swapped in if one fails");
+			FF_EXPECT_EQ(0, program->getAppendedCodeCount(), L"code of failed update must be released");
+
+			// the functions are swapped in together when all of them are compiled
+			changedCode.replace(changedCode.find(L"s += scale(i) *"), 15, L"s += scale(i) * 2");
+			updated = compiler.updateProgram(program.get(), changedCode.c_str(), changedCode.c_str() + changedCode.size());
+			FF_EXPECT_TRUE(updated, convertToWstring(scriptCompiler->getLastError()).c_str());
+			ScriptTask newTask(program.get());
+			FF_EXPECT_EQ(25, runFunction(newTask, scaleId, 5), L"function 'scale' returns wrong value");
+			FF_EXPECT_EQ(1 + 2 * (5 + 10 + 15 + 20 + 25), runFunction(newTask, sumId, 5), L"function 'sum' returns wrong value");
+
+			compiler.getGlobalScope()->cleanupGlobalMemory();
+		}
+
+		FF_TEST_FUNCTION(IncrementalCompile, ReleaseReplacedCode)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(1024);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+			scriptCompiler->beginUserLib();
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+			compiler.getGlobalScope()->runGlobalCode();
+			int sumId = scriptCompiler->findFunction("sum", "int");
+
+			int expectedSum = 1;
+			for (int i = 1; i <= 5; i++) {
+				expectedSum += updatedScale(i);
+			}
+			for (int i = 0; i < 10; i++) {
+				const wchar_t* code = i % 2 ? scriptCode : updatedCode;
+				bool updated = compiler.updateProgram(program.get(), code, code + wcslen(code));
+				FF_EXPECT_TRUE(updated, convertToWstring(scriptCompiler->getLastError()).c_str());
+
+				ScriptTask scriptTask(program.get());
+				FF_EXPECT_EQ(i % 2 ? 1 + 2 + 4 + 6 + 8 + 10 : expectedSum, runFunction(scriptTask, sumId, 5), L"function 'sum' returns wrong value");
+				// no task runs the replaced code, only the current code is kept
+				FF_EXPECT_TRUE(program->getAppendedCodeCount() <= 1, L"replaced code must be released");
+			}
+
+			compiler.getGlobalScope()->cleanupGlobalMemory();
+		}
+
+		FF_TEST_FUNCTION(IncrementalCompile, RunnersAcrossUpdates)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(1024);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+			scriptCompiler->beginUserLib();
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+			compiler.getGlobalScope()->runGlobalCode();
+			int scaleId = scriptCompiler->findFunction("scale", "int");
+			int sumId = scriptCompiler->findFunction("sum", "int");
+
+			int expectedSum = 1;
+			for (int i = 1; i <= 5; i++) {
+				expectedSum += updatedScale(i);
+			}
+
+			// the runners are created before the updates and kept across them
+			ScriptTask scriptTask(program.get());
+			ContextPool pool(program.get(), 64 * 1024, 1);
+			FF_EXPECT_EQ(10, runFunction(scriptTask, scaleId, 5), L"function 'scale' returns wrong value");
+			FF_EXPECT_EQ(10, pool.invoke<int>(scaleId, 5), L"function 'scale' returns wrong value");
+
+			const wchar_t* codes[] = { updatedCode, scriptCode };
+			for (auto code : codes) {
+				bool updated = compiler.updateProgram(program.get(), code, code + wcslen(code));
+				FF_EXPECT_TRUE(updated, convertToWstring(scriptCompiler->getLastError()).c_str());
+
+				int expectedScale = code == updatedCode ? updatedScale(5) : 10;
+				int expectedResult = code == updatedCode ? expectedSum : 1 + 2 + 4 + 6 + 8 + 10;
+				FF_EXPECT_EQ(expectedScale, runFunction(scriptTask, scaleId, 5), L"task must run the last committed code");
+				FF_EXPECT_EQ(expectedResult, runFunction(scriptTask, sumId, 5), L"task must run the last committed code");
+				FF_EXPECT_EQ(expectedScale, pool.invoke<int>(scaleId, 5), L"pooled runner must run the last committed code");
+				FF_EXPECT_EQ(expectedResult, pool.invoke<int>(sumId, 5), L"pooled runner must run the last committed code");
+			}
+
+			compiler.getGlobalScope()->cleanupGlobalMemory();
+		}
+
+		static const wchar_t* reloadingCode =
+			L"int step(int n) {"
+			L"	int r = n * 2;"
+			L"	reload();"
+			L"	return r + 1;"
+			L"}"
+			;
+
+		static const wchar_t* reloadingUpdatedCode =
+			L"int step(int n) {"
+			L"	int r = n * 3;"
+			L"	reload();"
+			L"	return r + 1;"
+			L"}"
+			;
+
+		static CompilerSuite* s_reloadingCompiler = nullptr;
+		static Program* s_reloadingProgram = nullptr;
+		static int s_reloadedCodeCount = 0;
+
+		// update the program twice while the script that calls it is running
+		static void reload() {
+			if (s_reloadingProgram == nullptr) return;
+			const wchar_t* codes[] = { reloadingCode, reloadingUpdatedCode };
+			for (auto code : codes) {
+				if (s_reloadingCompiler->updateProgram(s_reloadingProgram, code, code + wcslen(code))) {
+					s_reloadedCodeCount = s_reloadingProgram->getAppendedCodeCount();
+				}
+			}
+		}
+
+		FF_TEST_FUNCTION(IncrementalCompile, KeepCodeOfRunningTask)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(1024);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+			FunctionRegisterHelper fb(scriptCompiler);
+			registerFunction(fb, &reload, "reload", "void", "");
+			scriptCompiler->beginUserLib();
+
+			unique_ptr<Program> program(compiler.compileProgram(reloadingCode, reloadingCode + wcslen(reloadingCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+			int stepId = scriptCompiler->findFunction("step", "int");
+
+			// the task runs appended code of the first update
+			bool updated = compiler.updateProgram(program.get(), reloadingUpdatedCode, reloadingUpdatedCode + wcslen(reloadingUpdatedCode));
+			FF_EXPECT_TRUE(updated, convertToWstring(scriptCompiler->getLastError()).c_str());
+
+			ScriptTask scriptTask(program.get());
+			s_reloadingCompiler = &compiler;
+			s_reloadingProgram = program.get();
+			s_reloadedCodeCount = 0;
+			int result = runFunction(scriptTask, stepId, 5);
+			s_reloadingProgram = nullptr;
+
+			FF_EXPECT_EQ(3, s_reloadedCodeCount, L"code replaced while a task runs it must be kept");
+			FF_EXPECT_EQ(5 * 3 + 1, result, L"running task must complete on the code it entered");
+
+			// the task is left, the next update releases the replaced code
+			updated = compiler.updateProgram(program.get(), reloadingCode, reloadingCode + wcslen(reloadingCode));
+			FF_EXPECT_TRUE(updated, convertToWstring(scriptCompiler->getLastError()).c_str());
+			FF_EXPECT_TRUE(program->getAppendedCodeCount() <= 1, L"replaced code must be released after tasks are left");
+			FF_EXPECT_EQ(5 * 2 + 1, runFunction(scriptTask, stepId, 5), L"task must run the last committed code");
+		}
+	}
+}
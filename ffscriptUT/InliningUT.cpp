@@ -0,0 +1,100 @@
+/******************************************************************
+* File:        InliningUT.cpp
+* Description: Test cases for inlining small script functions into
+*              their callers at compile time.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include "fftest.hpp"
+
+#include <CompilerSuite.h>
+#include <ScriptTask.h>
+#include <Program.h>
+#include <GlobalScope.h>
+
+using namespace std;
+using namespace ffscript;
+
+namespace ffscriptUT
+{
+	namespace InliningUT
+	{
+		FF_TEST_FUNCTION(Inlining, InlineSmallFunctions)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			const wchar_t* scriptCode =
+				L"float sq(float x) {"
+				L"	return x * x;"
+				L"}"
+				L"float sumsq(float x, float y) {"
+				L"	return sq(x) + sq(y);"
+				L"}"
+				L"int test(int a) {"
+				L"	float f = sumsq(a, a + 1) + sq(2.0);"
+				L"	return (int)f;"
+				L"}"
+				;
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+			// two calls in 'sumsq' and two calls in 'test'
+			FF_EXPECT_EQ(4, compiler.getGlobalScope()->getInlinedCallCount(), L"calls of small functions must be inlined");
+
+			int functionId = scriptCompiler->findFunction("test", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'test'");
+
+			int a = 3;
+			ScriptParamBuffer paramBuffer(a);
+			ScriptTask scriptTask(program.get());
+			scriptTask.runFunction(functionId, &paramBuffer);
+			FF_EXPECT_EQ(a * a + (a + 1) * (a + 1) + 4, *(int*)scriptTask.getTaskResult(), L"inlined functions return wrong value");
+		}
+
+		FF_TEST_FUNCTION(Inlining, KeepCallsOfOtherFunctions)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			const wchar_t* scriptCode =
+				L"int fact(int n) {"
+				L"	return n <= 1 ? 1 : n * fact(n - 1);"
+				L"}"
+				L"int twice(int n) {"
+				L"	return n + n;"
+				L"}"
+				L"int next(int& n) {"
+				L"	n = n + 1;"
+				L"	return n;"
+				L"}"
+				L"int test(int a) {"
+				L"	int b = a;"
+				L"	int c = twice(next(b)) + fact(4);"
+				L"	return c + b;"
+				L"}"
+				;
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+			// recursive functions, functions have statements and calls
+			// those have arguments with side effect are not inlined
+			FF_EXPECT_EQ(0, compiler.getGlobalScope()->getInlinedCallCount(), L"calls must not be inlined");
+
+			int functionId = scriptCompiler->findFunction("test", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'test'");
+
+			int a = 3;
+			ScriptParamBuffer paramBuffer(a);
+			ScriptTask scriptTask(program.get());
+			scriptTask.runFunction(functionId, &paramBuffer);
+			FF_EXPECT_EQ((a + 1) * 2 + 24 + (a + 1), *(int*)scriptTask.getTaskResult(), L"functions return wrong value");
+		}
+	}
+}
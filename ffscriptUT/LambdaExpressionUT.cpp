@@ -14,6 +14,7 @@
 #include <CompilerSuite.h>
 #include <ScriptTask.h>
 #include <Utils.h>
+#include <ClosureAllocator.h>
 #include <thread>
 
 using namespace std;
@@ -391,5 +392,59 @@ namespace ffscriptUT
 
             FF_EXPECT_TRUE(*funcRes == 1000000, L"program can run but return wrong value");
 		}
+
+		FF_TEST_FUNCTION(LambdaExpression, CreateLambdasInLoop)
+		{
+			CompilerSuite compiler;
+
+			//the code does not contain any global scope'code and only a variable
+			//so does not need global memory
+			compiler.initialize(8);
+			GlobalScopeRef rootScope = compiler.getGlobalScope();
+			auto scriptCompiler = rootScope->getCompiler();
+
+			const wchar_t* scriptCode =
+				L"int foo() {"
+				L"	int sum = 0;"
+				L"	int i = 0;"
+				L"	while(i < 100) {"
+				L"		f = [i](int a) -> int {"
+				L"			return i + a;"
+				L"		};"
+				L"		sum = f(sum);"
+				L"		i++;"
+				L"	}"
+				L"	return sum;"
+				L"}"
+				;
+
+			Program* program = compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode));
+			FF_EXPECT_NE(nullptr, program, L"Compile program failed");
+
+			int functionId = scriptCompiler->findFunction("foo", "");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'foo'");
+
+			ScriptTask scriptTask(program);
+			scriptTask.runFunction(functionId, nullptr);
+			int* funcRes = (int*)scriptTask.getTaskResult();
+
+			FF_EXPECT_EQ(99 * 100 / 2, *funcRes, L"program can run but return wrong value");
+		}
+
+		FF_TEST_FUNCTION(LambdaExpression, ReuseClosureBlocks)
+		{
+			void* block1 = ClosureAllocator::allocate(12);
+			ClosureAllocator::deallocate(block1, 12);
+
+			// a released block is reused for captured data in same size class
+			void* block2 = ClosureAllocator::allocate(16);
+			FF_EXPECT_EQ(block1, block2, L"released closure block is not reused");
+
+			// large blocks are not kept in free lists
+			void* block3 = ClosureAllocator::allocate(4096);
+			FF_EXPECT_NE(nullptr, block3, L"cannot allocate large closure block");
+			ClosureAllocator::deallocate(block3, 4096);
+			ClosureAllocator::deallocate(block2, 16);
+		}
 	};
-}
+}
\ No newline at end of file
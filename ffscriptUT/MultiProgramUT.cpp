@@ -25,6 +25,7 @@
 #include <future>
 #include <Program.h>
 #include <ScriptTask.h>
+#include <CompilerSuite.h>
 
 using namespace std;
 using namespace ffscript;
@@ -216,5 +217,141 @@ namespace ffscriptUT
 
 			FF_EXPECT_TRUE(*funcRes == cPlusPlusRes, L"program 2 can run but return wrong value");
 		}
+		FF_TEST_FUNCTION(MultiProgram, MultiContextInSameThread)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			const wchar_t* scriptCode =
+				L"int fibonaci(int n) {"
+				L"	if(n < 2) {"
+				L"		return n;"
+				L"	}"
+				L"	int res = fibonaci(n - 1) + fibonaci(n - 2);"
+				L"	return res;"
+				L"}"
+				;
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int functionId = scriptCompiler->findFunction("fibonaci", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'fibonaci'");
+
+			Context context1(64 * 1024);
+			Context context2(64 * 1024);
+			// the contexts are given to the runner directly, the thread does not need a current context
+			Context::makeCurrent(nullptr);
+
+			ScriptRunner scriptRunner(program.get(), functionId);
+			int n1 = 10;
+			int n2 = 15;
+			ScriptParamBuffer paramBuffer1(n1);
+			ScriptParamBuffer paramBuffer2(n2);
+			scriptRunner.runFunction(&context1, &paramBuffer1);
+			scriptRunner.runFunction(&context2, &paramBuffer2);
+
+			FF_EXPECT_TRUE(Context::getCurrent() == nullptr, L"running on a given context must not change current context of the thread");
+			FF_EXPECT_TRUE(*(int*)scriptRunner.getTaskResult(&context1) == fibonaci(n1), L"program can run but return wrong value on context 1");
+			FF_EXPECT_TRUE(*(int*)scriptRunner.getTaskResult(&context2) == fibonaci(n2), L"program can run but return wrong value on context 2");
+		}
+
+		FF_TEST_FUNCTION(MultiProgram, InvokeTypedFunction)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			const wchar_t* scriptCode =
+				L"long mix(int a, long b, double c, bool d) {"
+				L"	long res = a - b;"
+				L"	if(d) {"
+				L"		res = a + b;"
+				L"	}"
+				L"	if(c > 2.0) {"
+				L"		res = res + 1;"
+				L"	}"
+				L"	return res;"
+				L"}"
+				L"void clear(ref int a) {"
+				L"	*a = 0;"
+				L"}"
+				;
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int functionId = scriptCompiler->findFunction("mix", "int,long,double,bool");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'mix'");
+
+			Context context(64 * 1024);
+			ScriptRunner scriptRunner(program.get(), functionId);
+
+			long long b = 5000000000LL;
+			FF_EXPECT_EQ(7 + b + 1, scriptRunner.invoke<long long>(&context, 7, b, 3.0, true), L"typed invoke returns wrong value");
+			FF_EXPECT_EQ(7 - b, scriptRunner.invoke<long long>(&context, 7, b, 1.0, false), L"typed invoke returns wrong value");
+
+			// arguments those do not match the function are rejected
+			bool hasError = false;
+			try {
+				scriptRunner.invoke<long long>(&context, 7, 3.0, true);
+			}
+			catch (std::exception&) {
+				hasError = true;
+			}
+			FF_EXPECT_TRUE(hasError, L"invoke with wrong arguments must raise an error");
+
+			functionId = scriptCompiler->findFunction("clear", "ref int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'clear'");
+
+			int a = 10;
+			ScriptRunner clearRunner(program.get(), functionId);
+			clearRunner.invoke<void>(&context, &a);
+			FF_EXPECT_EQ(0, a, L"typed invoke passes wrong reference");
+		}
+
+		FF_TEST_FUNCTION(MultiProgram, InvokeFunctionReturnsRef)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(1024);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+			scriptCompiler->beginUserLib();
+
+			const wchar_t* scriptCode =
+				L"struct Point {"
+				L"	long x;"
+				L"	long y;"
+				L"}"
+				L"ref Point pick(ref Point a, ref Point b, bool first) {"
+				L"	if(first) {"
+				L"		return a;"
+				L"	}"
+				L"	return b;"
+				L"}"
+				;
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, convertToWstring(scriptCompiler->getLastError()).c_str());
+
+			int functionId = scriptCompiler->findFunction("pick", "ref Point,ref Point,bool");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'pick'");
+
+			struct Point {
+				long long x;
+				long long y;
+			};
+			Point a = { 1, 2 };
+			Point b = { 3, 4 };
+
+			// the result is returned as a reference, not as a copy of the struct
+			Context context(64 * 1024);
+			ScriptRunner scriptRunner(program.get(), functionId);
+			Point& first = scriptRunner.invoke<Point&>(&context, &a, &b, true);
+			FF_EXPECT_TRUE(&first == &a, L"typed invoke returns wrong reference");
+			Point& second = scriptRunner.invoke<Point&>(&context, &a, &b, false);
+			FF_EXPECT_TRUE(&second == &b, L"typed invoke returns wrong reference");
+			FF_EXPECT_EQ(4, (int)second.y, L"reference returned by typed invoke points to wrong data");
+		}
 	};
 }
\ No newline at end of file
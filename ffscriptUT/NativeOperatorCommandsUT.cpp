@@ -0,0 +1,202 @@
+/******************************************************************
+* File:        NativeOperatorCommandsUT.cpp
+* Description: Test cases for built-in operators of primitive types
+*              those are compiled to specialized commands instead of
+*              native function calls.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include "fftest.hpp"
+
+#include <CompilerSuite.h>
+#include <ScriptTask.h>
+#include <Program.h>
+#include <NativeOperatorCommands.hpp>
+
+using namespace std;
+using namespace ffscript;
+
+namespace ffscriptUT
+{
+	namespace NativeOperatorCommandsUT
+	{
+		FF_TEST_FUNCTION(NativeOperatorCommands, RegisterNativeCommands)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			const char* functions[][2] = {
+				{ "+", "int,int" },
+				{ "<", "long,long" },
+				{ "=", "float&,float" },
+				{ "+=", "double&,double" },
+				{ "post_fix_increase", "int&" },
+				{ "-", "double" },
+			};
+
+			for (auto& function : functions) {
+				int functionId = scriptCompiler->findFunction(function[0], function[1]);
+				FF_EXPECT_TRUE(functionId >= 0, L"cannot find built-in operator");
+				FF_EXPECT_TRUE(scriptCompiler->getNativeCommand(functionId) != nullptr, L"built-in operator must have a native command");
+			}
+
+			// mixed type operators still use native function objects
+			int functionId = scriptCompiler->findFunction("+", "int,long");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find built-in operator");
+			FF_EXPECT_TRUE(scriptCompiler->getNativeCommand(functionId) == nullptr, L"mixed type operator must not have a native command");
+		}
+
+		FF_TEST_FUNCTION(NativeOperatorCommands, RunPrimitiveOperators)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			const wchar_t* scriptCode =
+				L"int testInt(int a, int b) {"
+				L"	int c = a * b - a / b + a % b;"
+				L"	c += a;"
+				L"	c <<= 1;"
+				L"	c = -c;"
+				L"	int d = c++;"
+				L"	--c;"
+				L"	if(a < b || a == b) {"
+				L"		return 0;"
+				L"	}"
+				L"	return c + d;"
+				L"}"
+				L"long testLong(long a, long b) {"
+				L"	long c = a * b;"
+				L"	c -= b;"
+				L"	c++;"
+				L"	if(c >= a && c != b) {"
+				L"		return c;"
+				L"	}"
+				L"	return 0;"
+				L"}"
+				L"double testDouble(double a, double b) {"
+				L"	double c = a / b + a * b;"
+				L"	c *= 2.0;"
+				L"	if(c > a) {"
+				L"		c = c - b;"
+				L"	}"
+				L"	return c;"
+				L"}"
+				L"float testFloat(float a, float b) {"
+				L"	float c = a - b;"
+				L"	c /= b;"
+				L"	return -c;"
+				L"}"
+				;
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int functionId = scriptCompiler->findFunction("testInt", "int,int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'testInt'");
+			{
+				int a = 17, b = 5;
+				int c = a * b - a / b + a % b;
+				c += a;
+				c <<= 1;
+				c = -c;
+				int d = c++;
+				--c;
+				int expected = c + d;
+
+				ScriptParamBuffer paramBuffer(a);
+				paramBuffer.addParam(b);
+				ScriptTask scriptTask(program.get());
+				scriptTask.runFunction(functionId, &paramBuffer);
+				FF_EXPECT_EQ(expected, *(int*)scriptTask.getTaskResult(), L"operators on int return wrong value");
+			}
+
+			functionId = scriptCompiler->findFunction("testLong", "long,long");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'testLong'");
+			{
+				long long a = 3000000000LL, b = 3;
+				long long c = a * b;
+				c -= b;
+				c++;
+
+				ScriptParamBuffer paramBuffer(a);
+				paramBuffer.addParam(b);
+				ScriptTask scriptTask(program.get());
+				scriptTask.runFunction(functionId, &paramBuffer);
+				FF_EXPECT_EQ(c, *(long long*)scriptTask.getTaskResult(), L"operators on long return wrong value");
+			}
+
+			functionId = scriptCompiler->findFunction("testDouble", "double,double");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'testDouble'");
+			{
+				double a = 7.5, b = 2.5;
+				double c = a / b + a * b;
+				c *= 2.0;
+				if (c > a) {
+					c = c - b;
+				}
+
+				ScriptParamBuffer paramBuffer(a);
+				paramBuffer.addParam(b);
+				ScriptTask scriptTask(program.get());
+				scriptTask.runFunction(functionId, &paramBuffer);
+				FF_EXPECT_EQ(c, *(double*)scriptTask.getTaskResult(), L"operators on double return wrong value");
+			}
+
+			functionId = scriptCompiler->findFunction("testFloat", "float,float");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'testFloat'");
+			{
+				float a = 9.0f, b = 4.0f;
+				float c = a - b;
+				c /= b;
+
+				ScriptParamBuffer paramBuffer(a);
+				paramBuffer.addParam(b);
+				ScriptTask scriptTask(program.get());
+				scriptTask.runFunction(functionId, &paramBuffer);
+				FF_EXPECT_EQ(-c, *(float*)scriptTask.getTaskResult(), L"operators on float return wrong value");
+			}
+		}
+
+		FF_TEST_FUNCTION(NativeOperatorCommands, ReadVariablesDirectly)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			// variables are read directly by operator commands only when
+			// no later param can change them before the operator runs
+			const wchar_t* scriptCode =
+				L"int testOrder(int a) {"
+				L"	int b = a + (a = 3);"
+				L"	int c = (a = 4) + a;"
+				L"	c += b;"
+				L"	c = c * c - b;"
+				L"	return c;"
+				L"}"
+				;
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int functionId = scriptCompiler->findFunction("testOrder", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'testOrder'");
+
+			int a = 5;
+			int b = a + 3;
+			int c = 4 + 4;
+			c += b;
+			c = c * c - b;
+
+			ScriptParamBuffer paramBuffer(a);
+			ScriptTask scriptTask(program.get());
+			scriptTask.runFunction(functionId, &paramBuffer);
+			FF_EXPECT_EQ(c, *(int*)scriptTask.getTaskResult(), L"operator params are evaluated in wrong order");
+		}
+	}
+}
@@ -0,0 +1,72 @@
+/******************************************************************
+* File:        OverloadResolutionUT.cpp
+* Description: Test cases for choosing overloading functions those
+*              parameters are nested calls of overloading functions.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include "fftest.hpp"
+
+#include <CompilerSuite.h>
+#include <ScriptTask.h>
+#include <Program.h>
+#include <GlobalScope.h>
+#include <chrono>
+
+using namespace std;
+using namespace ffscript;
+
+namespace ffscriptUT
+{
+	namespace OverloadResolutionUT
+	{
+		FF_TEST_FUNCTION(OverloadResolution, NestedOverloadingCalls)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			// each call of 'g' has candidates of three return types, so every
+			// overloading function of 'h' is matched with 3^4 paths of parameters
+			const wchar_t* scriptCode =
+				L"int g(int a) {"
+				L"	return a + 1;"
+				L"}"
+				L"float g(float a) {"
+				L"	return a + 100;"
+				L"}"
+				L"double g(double a) {"
+				L"	return a + 10000;"
+				L"}"
+				L"int h(int a, int b, int c, int d) {"
+				L"	return a + b + c + d;"
+				L"}"
+				L"double h(double a, double b, double c, double d) {"
+				L"	return a * b * c * d;"
+				L"}"
+				L"int test() {"
+				L"	int s = h(g(g(g(1))), g(g(g(2))), g(g(g(3))), g(g(g(4))));"
+				L"	return s;"
+				L"}"
+				;
+
+			auto start = chrono::steady_clock::now();
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			auto compileTime = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+			FF_EXPECT_TRUE(compileTime < 5000, L"nested overloading calls take too long to compile");
+
+			int functionId = scriptCompiler->findFunction("test", "");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'test'");
+
+			ScriptTask scriptTask(program.get());
+			scriptTask.runFunction(functionId, nullptr);
+			// the exact overloading functions are chosen for all calls
+			FF_EXPECT_EQ(1 + 2 + 3 + 4 + 4 * 3, *(int*)scriptTask.getTaskResult(), L"wrong overloading functions are chosen");
+		}
+	}
+}
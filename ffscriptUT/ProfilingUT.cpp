@@ -0,0 +1,110 @@
+/******************************************************************
+* File:        ProfilingUT.cpp
+* Description: Test cases for recording call counts, running time of
+*              script functions and hit counts of commands by
+*              running a program on a profiling context.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include "fftest.hpp"
+
+#include <CompilerSuite.h>
+#include <ScriptRunner.h>
+#include <Program.h>
+#include <GlobalScope.h>
+#include <ProfilingContext.h>
+#include <sstream>
+
+using namespace std;
+using namespace ffscript;
+
+namespace ffscriptUT
+{
+	namespace ProfilingUT
+	{
+		FF_TEST_FUNCTION(Profiling, CountCallsAndCommands)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			const wchar_t* scriptCode =
+				L"int square(int x) {"
+				L"	int y = x * x;"
+				L"	return y;"
+				L"}"
+				L"int fib(int n) {"
+				L"	if (n < 2) {"
+				L"		return n;"
+				L"	}"
+				L"	return fib(n - 1) + fib(n - 2);"
+				L"}"
+				L"int test(int n) {"
+				L"	int s = 0;"
+				L"	int i = 0;"
+				L"	while (i < n) {"
+				L"		s += square(i);"
+				L"		i += 1;"
+				L"	}"
+				L"	return s + fib(10);"
+				L"}"
+				;
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int testId = scriptCompiler->findFunction("test", "int");
+			int squareId = scriptCompiler->findFunction("square", "int");
+			int fibId = scriptCompiler->findFunction("fib", "int");
+			FF_EXPECT_TRUE(testId >= 0 && squareId >= 0 && fibId >= 0, L"cannot find functions of the program");
+
+			const int n = 20;
+			ProfilingContext context(program.get(), 1024 * 1024);
+			ScriptRunner scriptRunner(program.get(), testId);
+
+			ScriptParamBuffer paramBuffer(n);
+			scriptRunner.runFunction(&context, &paramBuffer);
+			FF_EXPECT_EQ((n - 1) * n * (2 * n - 1) / 6 + 55, *(int*)scriptRunner.getTaskResult(&context), L"function run on profiling context returns wrong value");
+
+			auto testProfile = context.getFunctionProfile(testId);
+			auto squareProfile = context.getFunctionProfile(squareId);
+			auto fibProfile = context.getFunctionProfile(fibId);
+			FF_EXPECT_TRUE(testProfile && squareProfile && fibProfile, L"profiles of called functions must be recorded");
+			FF_EXPECT_EQ(1, (int)testProfile->callCount, L"wrong call count");
+			FF_EXPECT_EQ(n, (int)squareProfile->callCount, L"wrong call count");
+			// fib(10) calls fib 177 times in total
+			FF_EXPECT_EQ(177, (int)fibProfile->callCount, L"wrong call count of recursive function");
+			FF_EXPECT_EQ(0, fibProfile->activeCount, L"all calls must be finished");
+
+			FF_EXPECT_TRUE(testProfile->inclusiveTime >= testProfile->exclusiveTime, L"inclusive time must cover exclusive time");
+			FF_EXPECT_TRUE(testProfile->inclusiveTime >= fibProfile->inclusiveTime + squareProfile->inclusiveTime, L"inclusive time must cover called functions");
+			// recursive calls are not counted twice in inclusive time
+			FF_EXPECT_TRUE(fibProfile->inclusiveTime >= fibProfile->exclusiveTime, L"inclusive time of recursive function is wrong");
+			FF_EXPECT_TRUE(testProfile->inclusiveTime >= testProfile->exclusiveTime + fibProfile->inclusiveTime, L"inclusive time of recursive function is counted twice");
+
+			auto squareCode = program->getFunctionPlainCode(squareId);
+			FF_EXPECT_EQ(n, (int)context.getCommandHits(squareCode->first), L"wrong hit count of command");
+			FF_EXPECT_EQ(0, (int)context.getCommandHits(program->getEndCommand()), L"command is not run must have no hit");
+
+			auto funcLib = scriptCompiler->getFunctionLib().get();
+			stringstream stacks;
+			context.writeCollapsedStacks(stacks, funcLib);
+			FF_EXPECT_TRUE(stacks.str().find("test;square ") != string::npos, L"collapsed stacks must contain called function");
+			FF_EXPECT_TRUE(stacks.str().find("test;fib;fib;fib ") != string::npos, L"collapsed stacks must contain recursive calls");
+
+			stringstream json;
+			context.writeJsonSummary(json, funcLib);
+			FF_EXPECT_TRUE(json.str().find("\"square\": {\"id\": " + to_string(squareId) + ", \"calls\": " + to_string(n)) != string::npos, L"json summary must be keyed by function name");
+
+			// profiles are recorded again after reset
+			context.reset();
+			scriptRunner.runFunction(&context, &paramBuffer);
+			FF_EXPECT_EQ(n, (int)context.getFunctionProfile(squareId)->callCount, L"wrong call count after reset");
+			FF_EXPECT_EQ(n, (int)context.getCommandHits(squareCode->first), L"wrong hit count of command after reset");
+		}
+	}
+}
@@ -0,0 +1,276 @@
+/******************************************************************
+* File:        ProgramCacheUT.cpp
+* Description: Test cases for saving compiled programs to a binary
+*              stream and loading them back without parsing.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include "fftest.hpp"
+
+#include <CompilerSuite.h>
+#include <ScriptTask.h>
+#include <Program.h>
+#include <GlobalScope.h>
+#include <ProgramCache.h>
+#include <FunctionRegisterHelper.h>
+#include <Utils.h>
+#include <RawStringLib.h>
+#include <sstream>
+#include <string.h>
+
+using namespace std;
+using namespace ffscript;
+
+namespace ffscriptUT
+{
+	namespace ProgramCacheUT
+	{
+		static int scale(int x) {
+			return x * 3;
+		}
+
+		static void initializeCompiler(CompilerSuite& compiler) {
+			compiler.initialize(128);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			FunctionRegisterHelper fb(scriptCompiler);
+			fb.registFunction("scale", "int", createUserFunctionFactory(scriptCompiler, "int", scale));
+			scriptCompiler->beginUserLib();
+		}
+
+		static const wchar_t* scriptCode =
+			L"int base = 7;"
+			L"double ratio = 0.25;"
+			L"int fibonaci(int n) {"
+			L"	if(n < 2) {"
+			L"		return n;"
+			L"	}"
+			L"	return fibonaci(n - 1) + fibonaci(n - 2);"
+			L"}"
+			L"void addTo(int& s, int n) {"
+			L"	s = s + n;"
+			L"}"
+			L"int test(int n) {"
+			L"	int s = base;"
+			L"	int i = 0;"
+			L"	double d = 0;"
+			L"	while(true) {"
+			L"		i += 1;"
+			L"		if(i > n) {"
+			L"			break;"
+			L"		}"
+			L"		if(i == 3) {"
+			L"			continue;"
+			L"		}"
+			L"		addTo(s, scale(i));"
+			L"		d += ratio;"
+			L"	}"
+			L"	if(d > 1.0) {"
+			L"		s += 1000;"
+			L"	}"
+			L"	else {"
+			L"		s += 2000;"
+			L"	}"
+			L"	return s + fibonaci(10);"
+			L"}"
+			;
+
+		static int expectedResult(int n) {
+			int s = 7;
+			double d = 0;
+			for (int i = 1; i <= n; i++) {
+				if (i == 3) continue;
+				s += i * 3;
+				d += 0.25;
+			}
+			s += d > 1.0 ? 1000 : 2000;
+			return s + 55;
+		}
+
+		FF_TEST_FUNCTION(ProgramCache, SaveAndLoadProgram)
+		{
+			stringstream cacheStream;
+			{
+				CompilerSuite compiler;
+				initializeCompiler(compiler);
+				auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+				unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+				FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+				ProgramCache programCache(&compiler);
+				bool saved = programCache.save(program.get(), cacheStream);
+				FF_EXPECT_TRUE(saved, convertToWstring(scriptCompiler->getLastError()).c_str());
+			}
+
+			CompilerSuite compiler;
+			initializeCompiler(compiler);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			ProgramCache programCache(&compiler);
+			unique_ptr<Program> program(programCache.load(cacheStream));
+			FF_EXPECT_TRUE(program != nullptr, convertToWstring(scriptCompiler->getLastError()).c_str());
+
+			compiler.getGlobalScope()->runGlobalCode();
+
+			// script functions are registered as they are compiled
+			int functionId = scriptCompiler->findFunction("test", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'test'");
+
+			ExecutionMode modes[] = { ExecutionMode::Interpreter, ExecutionMode::ThreadedCode };
+			for (auto mode : modes) {
+				program->setExecutionMode(mode);
+				for (int n : { 2, 10 }) {
+					ScriptParamBuffer paramBuffer(n);
+					ScriptTask scriptTask(program.get());
+					scriptTask.runFunction(functionId, &paramBuffer);
+					FF_EXPECT_EQ(expectedResult(n), *(int*)scriptTask.getTaskResult(), L"loaded program returns wrong value");
+				}
+			}
+
+			compiler.getGlobalScope()->cleanupGlobalMemory();
+		}
+
+		FF_TEST_FUNCTION(ProgramCache, RejectInvalidStream)
+		{
+			CompilerSuite compiler;
+			initializeCompiler(compiler);
+
+			stringstream cacheStream("this is not a program cache");
+			ProgramCache programCache(&compiler);
+			FF_EXPECT_TRUE(programCache.load(cacheStream) == nullptr, L"invalid stream must not be loaded");
+		}
+
+		FF_TEST_FUNCTION(ProgramCache, RejectBrokenCounts)
+		{
+			CompilerSuite compiler;
+			initializeCompiler(compiler);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+			stringstream cacheStream;
+			ProgramCache programCache(&compiler);
+			FF_EXPECT_TRUE(programCache.save(program.get(), cacheStream), convertToWstring(scriptCompiler->getLastError()).c_str());
+			string cacheData = cacheStream.str();
+
+			// header is magic, version, pointer size, wide char size, global data size, global scope size
+			// and global constructor count, the count of global commands follows it
+			const size_t countPosition = 4 + 6 * sizeof(int);
+			int brokenCounts[] = { -1, 0x7FFFFFFF };
+			for (int brokenCount : brokenCounts) {
+				string brokenData = cacheData;
+				memcpy(&brokenData[countPosition], &brokenCount, sizeof(brokenCount));
+				stringstream brokenStream(brokenData);
+				FF_EXPECT_TRUE(programCache.load(brokenStream) == nullptr, L"count those does not fit in the stream must be rejected");
+			}
+
+			// the stream is cut in the middle of the code
+			stringstream truncatedStream(cacheData.substr(0, cacheData.size() / 2));
+			FF_EXPECT_TRUE(programCache.load(truncatedStream) == nullptr, L"truncated stream must not be loaded");
+		}
+
+		FF_TEST_FUNCTION(ProgramCache, RejectUnsupportedProgram)
+		{
+			CompilerSuite compiler;
+			initializeCompiler(compiler);
+
+			// lambdas are created at runtime, they cannot be saved
+			const wchar_t* lambdaCode =
+				L"int test() {"
+				L"	int n = 1;"
+				L"	int a;"
+				L"	f = [n](ref int a) { a[0] = n; };"
+				L"	f(ref(a));"
+				L"	return a;"
+				L"}"
+				;
+			unique_ptr<Program> program(compiler.compileProgram(lambdaCode, lambdaCode + wcslen(lambdaCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			stringstream cacheStream;
+			ProgramCache programCache(&compiler);
+			FF_EXPECT_TRUE(programCache.save(program.get(), cacheStream) == false, L"lambdas must not be saved");
+		}
+
+		static const wchar_t* objectCode =
+			L"struct Pair {"
+			L"	int first;"
+			L"	int second;"
+			L"}"
+			L"String label = \"n=\";"
+			L"int sum(Pair& p) {"
+			L"	return p.first + p.second;"
+			L"}"
+			L"int test(int n) {"
+			L"	Pair p;"
+			L"	p.first = n;"
+			L"	p.second = 2;"
+			L"	Pair q = {3, 4};"
+			L"	String s = label + n;"
+			L"	String expected = L\"n=\" + String(n);"
+			L"	if(compare(s, expected) != 0) {"
+			L"		return -1;"
+			L"	}"
+			L"	return sum(p) + sum(q);"
+			L"}"
+			;
+
+		static void initializeStringCompiler(CompilerSuite& compiler) {
+			compiler.initialize(128);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+			includeRawStringToCompiler(scriptCompiler);
+			scriptCompiler->beginUserLib();
+		}
+
+		FF_TEST_FUNCTION(ProgramCache, SaveAndLoadStructsAndStrings)
+		{
+			stringstream cacheStream;
+			{
+				CompilerSuite compiler;
+				initializeStringCompiler(compiler);
+				auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+				unique_ptr<Program> program(compiler.compileProgram(objectCode, objectCode + wcslen(objectCode)));
+				FF_EXPECT_TRUE(program != nullptr, convertToWstring(scriptCompiler->getLastError()).c_str());
+
+				ProgramCache programCache(&compiler);
+				bool saved = programCache.save(program.get(), cacheStream);
+				FF_EXPECT_TRUE(saved, convertToWstring(scriptCompiler->getLastError()).c_str());
+			}
+
+			CompilerSuite compiler;
+			initializeStringCompiler(compiler);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			ProgramCache programCache(&compiler);
+			unique_ptr<Program> program(programCache.load(cacheStream));
+			FF_EXPECT_TRUE(program != nullptr, convertToWstring(scriptCompiler->getLastError()).c_str());
+
+			// the struct is declared again when the program is loaded
+			FF_EXPECT_TRUE(scriptCompiler->getType("Pair") >= 0, L"struct 'Pair' is not loaded");
+
+			compiler.getGlobalScope()->runGlobalCode();
+
+			int functionId = scriptCompiler->findFunction("test", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'test'");
+
+			ExecutionMode modes[] = { ExecutionMode::Interpreter, ExecutionMode::ThreadedCode };
+			for (auto mode : modes) {
+				program->setExecutionMode(mode);
+				for (int n : { 5, 123 }) {
+					ScriptParamBuffer paramBuffer(n);
+					ScriptTask scriptTask(program.get());
+					scriptTask.runFunction(functionId, &paramBuffer);
+					FF_EXPECT_EQ(n + 9, *(int*)scriptTask.getTaskResult(), L"loaded program returns wrong value");
+				}
+			}
+
+			compiler.getGlobalScope()->cleanupGlobalMemory();
+		}
+	}
+}
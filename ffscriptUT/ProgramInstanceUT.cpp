@@ -0,0 +1,133 @@
+/******************************************************************
+* File:        ProgramInstanceUT.cpp
+* Description: Test cases for running one compiled program with
+*              global data of many program instances.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include "fftest.hpp"
+
+#include <CompilerSuite.h>
+#include <ScriptTask.h>
+#include <Program.h>
+#include <GlobalScope.h>
+#include <ProgramInstance.h>
+#include <Variable.h>
+
+using namespace std;
+using namespace ffscript;
+
+namespace ffscriptUT
+{
+	namespace ProgramInstanceUT
+	{
+		static const wchar_t* scriptCode =
+			L"int counter = 10;"
+			L"array<int, 3> values;"
+			L"void add(int n) {"
+			L"	counter = counter + n;"
+			L"	values[1] = counter;"
+			L"}"
+			L"int countTo(int n) {"
+			L"	int c = 0;"
+			L"	while(counter < n) {"
+			L"		counter += 1;"
+			L"		c += 1;"
+			L"	}"
+			L"	return c;"
+			L"}"
+			L"int get() {"
+			L"	return counter + values[1];"
+			L"}"
+			;
+
+		static int runFunction(ProgramInstance* instance, int functionId, int n) {
+			ScriptParamBuffer paramBuffer(n);
+			ScriptTask scriptTask(instance);
+			scriptTask.runFunction(functionId, &paramBuffer);
+			auto result = scriptTask.getTaskResult();
+			return result ? *(int*)result : 0;
+		}
+
+		FF_TEST_FUNCTION(ProgramInstance, RunInstancesSeparately)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(1024);
+			auto rootScope = compiler.getGlobalScope();
+			auto scriptCompiler = rootScope->getCompiler();
+			scriptCompiler->beginUserLib();
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int addId = scriptCompiler->findFunction("add", "int");
+			int countToId = scriptCompiler->findFunction("countTo", "int");
+			int getId = scriptCompiler->findFunction("get", "");
+			FF_EXPECT_TRUE(addId >= 0 && countToId >= 0 && getId >= 0, L"cannot find functions of the program");
+			int counterOffset = rootScope->findVariable("counter")->getOffset();
+
+			ExecutionMode modes[] = { ExecutionMode::Interpreter, ExecutionMode::ThreadedCode };
+			for (auto mode : modes) {
+				program->setExecutionMode(mode);
+
+				ProgramInstance instance1(program.get(), 1024);
+				ProgramInstance instance2(program.get(), 1024);
+				instance1.runGlobalCode();
+				instance2.runGlobalCode();
+
+				FF_EXPECT_EQ(10, *(int*)instance1.getGlobalAddress(counterOffset), L"global code of instance 1 is not run");
+				FF_EXPECT_EQ(10, *(int*)instance2.getGlobalAddress(counterOffset), L"global code of instance 2 is not run");
+
+				runFunction(&instance1, addId, 5);
+				runFunction(&instance2, addId, 100);
+
+				// each instance works on its own global variables
+				FF_EXPECT_EQ(30, runFunction(&instance1, getId, 0), L"instance 1 returns wrong value");
+				FF_EXPECT_EQ(220, runFunction(&instance2, getId, 0), L"instance 2 returns wrong value");
+
+				FF_EXPECT_EQ(5, runFunction(&instance1, countToId, 20), L"condition of instance 1 reads wrong global");
+				FF_EXPECT_EQ(0, runFunction(&instance2, countToId, 20), L"condition of instance 2 reads wrong global");
+				FF_EXPECT_EQ(20, *(int*)instance1.getGlobalAddress(counterOffset), L"instance 1 has wrong global value");
+				FF_EXPECT_EQ(110, *(int*)instance2.getGlobalAddress(counterOffset), L"instance 2 has wrong global value");
+
+				instance1.cleanupGlobalMemory();
+				instance2.cleanupGlobalMemory();
+			}
+		}
+
+		FF_TEST_FUNCTION(ProgramInstance, RunWithoutInstance)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(1024);
+			auto rootScope = compiler.getGlobalScope();
+			auto scriptCompiler = rootScope->getCompiler();
+			scriptCompiler->beginUserLib();
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int addId = scriptCompiler->findFunction("add", "int");
+			int getId = scriptCompiler->findFunction("get", "");
+
+			// an instance does not touch global data of the compiler's global scope
+			ProgramInstance instance(program.get(), 1024);
+			instance.runGlobalCode();
+			rootScope->runGlobalCode();
+
+			ScriptParamBuffer paramBuffer(7);
+			ScriptTask scriptTask(program.get());
+			scriptTask.runFunction(addId, &paramBuffer);
+			scriptTask.runFunction(getId, nullptr);
+			FF_EXPECT_EQ(34, *(int*)scriptTask.getTaskResult(), L"program returns wrong value");
+			int counterOffset = rootScope->findVariable("counter")->getOffset();
+			FF_EXPECT_EQ(10, *(int*)instance.getGlobalAddress(counterOffset), L"global data of the instance is changed");
+
+			instance.cleanupGlobalMemory();
+			rootScope->cleanupGlobalMemory();
+		}
+	}
+}
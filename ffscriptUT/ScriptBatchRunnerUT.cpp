@@ -0,0 +1,156 @@
+/******************************************************************
+* File:        ScriptBatchRunnerUT.cpp
+* Description: Test cases for running a script function over many
+*              inputs by worker threads of ScriptBatchRunner.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include "fftest.hpp"
+
+#include <CompilerSuite.h>
+#include <Program.h>
+#include <ScriptBatchRunner.h>
+#include <Context.h>
+
+using namespace std;
+using namespace ffscript;
+
+namespace ffscriptUT
+{
+	namespace ScriptBatchRunnerUT
+	{
+		static const wchar_t* scriptCode =
+			L"double score(int level, double health) {"
+			L"	double res = health * 2.0;"
+			L"	if(level > 10) {"
+			L"		res = res + 100.0;"
+			L"	}"
+			L"	return res;"
+			L"}"
+			L"int forever(int n) {"
+			L"	return forever(n + 1) + 1;"
+			L"}"
+			;
+
+		static double score(int level, double health) {
+			double res = health * 2.0;
+			if (level > 10) {
+				res = res + 100.0;
+			}
+			return res;
+		}
+
+		FF_TEST_FUNCTION(ScriptBatchRunner, RunOverInputs)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int functionId = scriptCompiler->findFunction("score", "int,double");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'score'");
+
+			const int count = 10000;
+			vector<tuple<int, double>> inputs;
+			for (int i = 0; i < count; i++) {
+				inputs.emplace_back(i % 20, i * 0.5);
+			}
+			vector<double> outputs(count);
+
+			ScriptBatchRunner batchRunner(program.get(), functionId, 3, 64 * 1024, 100);
+			FF_EXPECT_EQ(3, batchRunner.getWorkerCount(), L"batch runner creates wrong number of workers");
+
+			// workers and their contexts are reused for next batches
+			for (int n = 0; n < 3; n++) {
+				fill(outputs.begin(), outputs.end(), -1.0);
+				batchRunner.run(inputs.data(), outputs.data(), count);
+
+				int wrongResults = 0;
+				for (int i = 0; i < count; i++) {
+					if (outputs[i] != score(get<0>(inputs[i]), get<1>(inputs[i]))) {
+						wrongResults++;
+					}
+				}
+				FF_EXPECT_EQ(0, wrongResults, L"batch runner returns wrong values");
+			}
+		}
+
+		FF_TEST_FUNCTION(ScriptBatchRunner, RaiseErrorOfInputs)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int functionId = scriptCompiler->findFunction("forever", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'forever'");
+
+			const int count = 16;
+			vector<tuple<int>> inputs(count, make_tuple(0));
+			vector<int> outputs(count);
+
+			ScriptBatchRunner batchRunner(program.get(), functionId, 2, 4 * 1024, 4);
+
+			bool hasError = false;
+			try {
+				batchRunner.run(inputs.data(), outputs.data(), count);
+			}
+			catch (std::exception&) {
+				hasError = true;
+			}
+			FF_EXPECT_TRUE(hasError, L"error of the script must be thrown to the caller");
+
+			// the runner can still be used after an error
+			hasError = false;
+			try {
+				batchRunner.run(inputs.data(), outputs.data(), count);
+			}
+			catch (std::exception&) {
+				hasError = true;
+			}
+			FF_EXPECT_TRUE(hasError, L"error of the script must be thrown to the caller");
+		}
+
+		FF_TEST_FUNCTION(ScriptBatchRunner, ReuseContextAfterError)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int foreverId = scriptCompiler->findFunction("forever", "int");
+			FF_EXPECT_TRUE(foreverId >= 0, L"cannot find function 'forever'");
+			int scoreId = scriptCompiler->findFunction("score", "int,double");
+			FF_EXPECT_TRUE(scoreId >= 0, L"cannot find function 'score'");
+
+			// workers keep their contexts after an input raises an error,
+			// so the context must be clean for next inputs
+			Context context(4 * 1024);
+			ScriptRunner foreverRunner(program.get(), foreverId);
+			ScriptRunner scoreRunner(program.get(), scoreId);
+
+			for (int i = 0; i < 100; i++) {
+				bool hasError = false;
+				try {
+					foreverRunner.invoke<int>(&context, 0);
+				}
+				catch (std::exception&) {
+					hasError = true;
+				}
+				FF_EXPECT_TRUE(hasError, L"stack overflow must raise an error");
+				FF_EXPECT_EQ(0, context.getCurrentOffset(), L"context is not restored after an error");
+				FF_EXPECT_EQ(score(11, 1.0), scoreRunner.invoke<double>(&context, 11, 1.0), L"function returns wrong value after an error");
+			}
+		}
+	}
+}
@@ -0,0 +1,122 @@
+/******************************************************************
+* File:        SymbolTableUT.cpp
+* Description: Test cases for interning names to symbols and looking
+*              up registries of the compiler by the symbols.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include "fftest.hpp"
+
+#include <CompilerSuite.h>
+#include <SymbolTable.h>
+#include <FlatHashMap.hpp>
+#include <FuncLibrary.h>
+
+using namespace std;
+using namespace ffscript;
+
+namespace ffscriptUT
+{
+	namespace SymbolTableUT
+	{
+		FF_TEST_FUNCTION(SymbolTable, InternNames)
+		{
+			SymbolTable symbolTable;
+			FF_EXPECT_EQ(SymbolTable::INVALID_SYMBOL, symbolTable.find("sum"), L"name is not interned yet");
+
+			int sum = symbolTable.intern("sum");
+			int sumTo = symbolTable.intern("sumTo");
+			FF_EXPECT_TRUE(sum != sumTo, L"different names must have different symbols");
+			FF_EXPECT_EQ(sum, symbolTable.intern("sum"), L"a name must be interned once");
+			FF_EXPECT_EQ(sumTo, symbolTable.find("sumTo is a function", 5), L"a part of a text must be found");
+
+			// references to names are kept while the table grows
+			const string* sumName = &symbolTable.getName(sum);
+			for (int i = 0; i < 2000; i++) {
+				symbolTable.intern("function" + std::to_string(i));
+			}
+			FF_EXPECT_TRUE(sumName == &symbolTable.getName(sum), L"name must not be moved");
+			FF_EXPECT_EQ(sum, symbolTable.find("sum"), L"symbol must not be changed");
+			for (int i = 0; i < 2000; i++) {
+				auto name = "function" + std::to_string(i);
+				FF_EXPECT_TRUE(symbolTable.getName(symbolTable.find(name)) == name, L"interned name is not found");
+			}
+		}
+
+		FF_TEST_FUNCTION(SymbolTable, FlatHashMapInsertAndErase)
+		{
+			FlatHashMap<int, int> map;
+			for (int i = 0; i < 1000; i++) {
+				FF_EXPECT_TRUE(map.insert(i * 7, i).second, L"new key must be inserted");
+			}
+			FF_EXPECT_TRUE(map.insert(7, 100).second == false, L"existing key must not be inserted again");
+			FF_EXPECT_EQ(1, *map.find(7), L"existing value must not be changed");
+
+			// erase every other key, the remaining keys must still be found
+			for (int i = 0; i < 1000; i += 2) {
+				FF_EXPECT_TRUE(map.erase(i * 7), L"existing key must be erased");
+			}
+			FF_EXPECT_EQ(500, (int)map.size(), L"wrong number of items");
+			for (int i = 0; i < 1000; i++) {
+				auto value = map.find(i * 7);
+				bool found = i % 2 ? value != nullptr && *value == i : value == nullptr;
+				FF_EXPECT_TRUE(found, L"wrong item after erasing");
+			}
+
+			FlatHashMap<uint64_t, int> wideKeyMap;
+			wideKeyMap[((uint64_t)1 << 32) | 2] = 12;
+			wideKeyMap[((uint64_t)2 << 32) | 1] = 21;
+			FF_EXPECT_EQ(12, *wideKeyMap.find(((uint64_t)1 << 32) | 2), L"wrong value of a wide key");
+			FF_EXPECT_EQ(21, *wideKeyMap.find(((uint64_t)2 << 32) | 1), L"wrong value of a wide key");
+		}
+
+		FF_TEST_FUNCTION(SymbolTable, CompilerRegistriesShareSymbols)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(128);
+			auto scriptCompiler = compiler.getCompiler();
+
+			// a name is interned once for functions, types and keywords
+			int intSymbol = scriptCompiler->findSymbol("int");
+			FF_EXPECT_TRUE(intSymbol != SymbolTable::INVALID_SYMBOL, L"type name must be interned");
+			FF_EXPECT_EQ(intSymbol, scriptCompiler->getSymbolTable()->find("int"), L"registries must share the symbol table");
+			FF_EXPECT_EQ(KEYWORD_WHILE, scriptCompiler->findKeyword(scriptCompiler->findSymbol("while")), L"keyword is not found by its symbol");
+			FF_EXPECT_TRUE(scriptCompiler->findPredefinedOperator(scriptCompiler->findSymbol("+")) != nullptr, L"operator is not found by its symbol");
+
+			// a name that is not registered does not have a symbol
+			FF_EXPECT_EQ(SymbolTable::INVALID_SYMBOL, scriptCompiler->findSymbol("notRegisteredName"), L"lookup must not intern names");
+			FF_EXPECT_EQ(KEYWORD_UNKNOWN, scriptCompiler->findKeyword("notRegisteredName"), L"unknown keyword must not be found");
+		}
+
+		FF_TEST_FUNCTION(SymbolTable, ReuseEmptiedOverloadingGroups)
+		{
+			auto symbolTable = std::make_shared<SymbolTable>();
+			FuncLibrary funcLibrary(symbolTable);
+			std::vector<ScriptType> paramTypes;
+
+			FF_EXPECT_TRUE(funcLibrary.mapFunction("oldFunction", paramTypes, 1), L"function must be mapped");
+			auto oldGroup = funcLibrary.findOverloadingFuncRoot("oldFunction");
+			FF_EXPECT_TRUE(oldGroup != nullptr && oldGroup->size() == 1, L"function is not found");
+
+			// a group emptied by unmapping its functions is reused by the next name
+			funcLibrary.unmapFunction("oldFunction", 1);
+			FF_EXPECT_TRUE(funcLibrary.findOverloadingFuncRoot("oldFunction") == nullptr, L"empty group must be removed");
+			FF_EXPECT_TRUE(funcLibrary.findFunctionInfo(1) == nullptr, L"unmapped function must not be found by id");
+			FF_EXPECT_EQ(0, (int)funcLibrary.getFunctionCount(), L"unmapped function must be removed");
+
+			FF_EXPECT_TRUE(funcLibrary.mapFunction("newFunction", paramTypes, 2), L"function must be mapped");
+			auto newGroup = funcLibrary.findOverloadingFuncRoot("newFunction");
+			FF_EXPECT_TRUE(newGroup == oldGroup, L"empty group must be reused");
+			FF_EXPECT_TRUE(newGroup->size() == 1 && newGroup->front().functionId == 2, L"reused group must only have the new function");
+
+			// the name is interned once, mapping it again uses the same symbol
+			size_t symbolCount = symbolTable->size();
+			FF_EXPECT_TRUE(funcLibrary.mapFunction("oldFunction", paramTypes, 3), L"function must be mapped again");
+			FF_EXPECT_EQ(symbolCount, symbolTable->size(), L"name must not be interned again");
+		}
+	}
+}
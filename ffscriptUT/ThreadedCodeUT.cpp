@@ -0,0 +1,250 @@
+/******************************************************************
+* File:        ThreadedCodeUT.cpp
+* Description: Test cases for running compiled code of C Lambda
+*              scripting language in threaded code execution mode.
+* Author:      Vincent Pham
+*
+* Copyright (c) 2018 VincentPT.
+** Distributed under the MIT License (http://opensource.org/licenses/MIT)
+**
+*
+**********************************************************************/
+#include "fftest.hpp"
+
+#include <CompilerSuite.h>
+#include <ScriptTask.h>
+#include <Program.h>
+#include <ThreadedCode.h>
+#include <FunctionRegisterHelper.h>
+
+using namespace std;
+using namespace ffscript;
+
+namespace ffscriptUT
+{
+	namespace ThreadedCodeUT
+	{
+		int runIntFunction(Program* program, int functionId, int n) {
+			ScriptParamBuffer paramBuffer(n);
+			ScriptTask scriptTask(program);
+			scriptTask.runFunction(functionId, &paramBuffer);
+			return *(int*)scriptTask.getTaskResult();
+		}
+
+		FF_TEST_FUNCTION(ThreadedCode, LowerCodeAfterCompile)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			const wchar_t* scriptCode =
+				L"int sum(int n) {"
+				L"	int s = 0;"
+				L"	while(n > 0) {"
+				L"		s = s + n;"
+				L"		n = n - 1;"
+				L"	}"
+				L"	return s;"
+				L"}"
+				;
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			FF_EXPECT_TRUE(program->getExecutionMode() == ExecutionMode::Interpreter, L"default execution mode must be interpreter");
+			FF_EXPECT_TRUE(program->getThreadedCode() == nullptr, L"threaded code must not be built in interpreter mode");
+
+			program->setExecutionMode(ExecutionMode::ThreadedCode);
+			auto threadedCode = program->getThreadedCode();
+			FF_EXPECT_TRUE(threadedCode != nullptr, L"threaded code must be built after selecting threaded code mode");
+			FF_EXPECT_TRUE(threadedCode->getCodeBegin() == program->getFirstCommand(), L"threaded code must map to the program code");
+			FF_EXPECT_TRUE(threadedCode->getLoweredCount() > 0, L"the loop must contain lowered instructions");
+
+			int functionId = scriptCompiler->findFunction("sum", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'sum'");
+			FF_EXPECT_TRUE(runIntFunction(program.get(), functionId, 100) == 5050, L"program can run but return wrong value");
+
+			program->setExecutionMode(ExecutionMode::Interpreter);
+			FF_EXPECT_TRUE(program->getThreadedCode() == nullptr, L"threaded code must be released in interpreter mode");
+			FF_EXPECT_TRUE(runIntFunction(program.get(), functionId, 100) == 5050, L"program can run but return wrong value");
+		}
+
+		FF_TEST_FUNCTION(ThreadedCode, SameResultAsInterpreter)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			const wchar_t* scriptCode =
+				L"int fibonaci(int n) {"
+				L"	if(n < 2) {"
+				L"		return n;"
+				L"	}"
+				L"	return fibonaci(n - 1) + fibonaci(n - 2);"
+				L"}"
+				L"int foo(int n) {"
+				L"	int s = 0;"
+				L"	int i = 0;"
+				L"	while(i < n) {"
+				L"		if(i % 3 == 0) {"
+				L"			s += i;"
+				L"		}"
+				L"		else if(i % 3 == 1) {"
+				L"			s -= 1;"
+				L"		}"
+				L"		else {"
+				L"			s += fibonaci(i % 10);"
+				L"		}"
+				L"		i++;"
+				L"	}"
+				L"	return s;"
+				L"}"
+				;
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int functionId = scriptCompiler->findFunction("foo", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'foo'");
+
+			const int n = 1000;
+			int interpreterRes = runIntFunction(program.get(), functionId, n);
+
+			program->setExecutionMode(ExecutionMode::ThreadedCode);
+			int threadedCodeRes = runIntFunction(program.get(), functionId, n);
+
+			int expectedRes = 0;
+			auto fibonaci = [](int n) {
+				int a = 0, b = 1;
+				for (int i = 0; i < n; i++) {
+					int c = a + b;
+					a = b;
+					b = c;
+				}
+				return a;
+			};
+			for (int i = 0; i < n; i++) {
+				if (i % 3 == 0) expectedRes += i;
+				else if (i % 3 == 1) expectedRes -= 1;
+				else expectedRes += fibonaci(i % 10);
+			}
+
+			FF_EXPECT_TRUE(interpreterRes == expectedRes, L"program can run but return wrong value");
+			FF_EXPECT_TRUE(threadedCodeRes == interpreterRes, L"threaded code must return the same value as interpreter");
+		}
+
+		static double mix(int a, double b, int c) {
+			return a * b - c;
+		}
+
+		class Accumulator {
+			int _base;
+		public:
+			Accumulator(int base) : _base(base) {}
+			int add(int a, double b) const {
+				return _base + a + (int)b;
+			}
+		};
+
+		FF_TEST_FUNCTION(ThreadedCode, CallNativeFunctions)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			// registered global and member functions are called by native call instructions
+			Accumulator accumulator(100);
+			FunctionRegisterHelper fb(scriptCompiler);
+			registerFunction(fb, mix, "mix", "double", "int,double,int");
+			registerFunction(fb, &accumulator, &Accumulator::add, "add", "int", "int,double");
+			scriptCompiler->beginUserLib();
+
+			const wchar_t* scriptCode =
+				L"int foo(int n) {"
+				L"	double s = 0;"
+				L"	int i = 0;"
+				L"	while(i < n) {"
+				L"		s = s + mix(i, 0.5, 1);"
+				L"		i++;"
+				L"	}"
+				L"	return add((int)s, 2.5);"
+				L"}"
+				;
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int functionId = scriptCompiler->findFunction("foo", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'foo'");
+
+			const int n = 100;
+			double s = 0;
+			for (int i = 0; i < n; i++) {
+				s = s + mix(i, 0.5, 1);
+			}
+			int expectedRes = accumulator.add((int)s, 2.5);
+
+			FF_EXPECT_EQ(expectedRes, runIntFunction(program.get(), functionId, n), L"native functions return wrong value in interpreter mode");
+			program->setExecutionMode(ExecutionMode::ThreadedCode);
+			FF_EXPECT_EQ(expectedRes, runIntFunction(program.get(), functionId, n), L"native functions return wrong value in threaded code mode");
+		}
+
+		static int s_recordedValue = 0;
+
+		static int seed() {
+			return 3;
+		}
+
+		static void record(int value) {
+			s_recordedValue = value;
+		}
+
+		FF_TEST_FUNCTION(ThreadedCode, CallStaticNativeFunctions)
+		{
+			CompilerSuite compiler;
+			compiler.initialize(8);
+			auto scriptCompiler = compiler.getGlobalScope()->getCompiler();
+
+			// targets are template arguments, the function objects call them directly
+			FunctionRegisterHelper fb(scriptCompiler);
+			registerFunction<decltype(&mix), &mix>(fb, "mix", "double", "int,double,int");
+			registerFunction<decltype(&seed), &seed>(fb, "seed", "int", "");
+			registerFunction<decltype(&record), &record>(fb, "record", "void", "int");
+			scriptCompiler->beginUserLib();
+
+			const wchar_t* scriptCode =
+				L"int foo(int n) {"
+				L"	double s = seed();"
+				L"	int i = 0;"
+				L"	while(i < n) {"
+				L"		s = s + mix(i, 0.5, 1);"
+				L"		i++;"
+				L"	}"
+				L"	record((int)s);"
+				L"	return (int)s;"
+				L"}"
+				;
+
+			unique_ptr<Program> program(compiler.compileProgram(scriptCode, scriptCode + wcslen(scriptCode)));
+			FF_EXPECT_TRUE(program != nullptr, L"compile program failed");
+
+			int functionId = scriptCompiler->findFunction("foo", "int");
+			FF_EXPECT_TRUE(functionId >= 0, L"cannot find function 'foo'");
+
+			const int n = 100;
+			double s = seed();
+			for (int i = 0; i < n; i++) {
+				s = s + mix(i, 0.5, 1);
+			}
+			int expectedRes = (int)s;
+
+			s_recordedValue = 0;
+			FF_EXPECT_EQ(expectedRes, runIntFunction(program.get(), functionId, n), L"native functions return wrong value in interpreter mode");
+			FF_EXPECT_EQ(expectedRes, s_recordedValue, L"void native function is not called");
+			program->setExecutionMode(ExecutionMode::ThreadedCode);
+			s_recordedValue = 0;
+			FF_EXPECT_EQ(expectedRes, runIntFunction(program.get(), functionId, n), L"native functions return wrong value in threaded code mode");
+			FF_EXPECT_EQ(expectedRes, s_recordedValue, L"void native function is not called");
+		}
+	}
+}